@@ -11,8 +11,8 @@ class AnimatedEntity :
 public:
     AnimatedEntity( SceneObjectFactory* factory, const SharedPtr<Mesh> &mesh, const DeferredMaterial &material );
     
-    virtual void submitRenderer( Renderer& renderer ) override;
-    virtual void submitShadowCasters(Renderer& renderer) override;
+    virtual void submitRenderer( Renderer& renderer, const SceneSnapshot::ObjectEntry &entry ) override;
+    virtual void submitShadowCasters( Renderer& renderer, const SceneSnapshot::ObjectEntry &entry ) override;
     
     void setCastShadow( bool castShadow ) {
         mCastShadow = castShadow;
@@ -21,7 +21,7 @@ public:
     virtual ~ComputeParticleSystem();
     
     virtual void update( float dt ) override;
-    virtual void submitRenderer( Renderer& renderer ) override;
+    virtual void submitRenderer( Renderer& renderer, const SceneSnapshot::ObjectEntry &entry ) override;
     
     float getSpeed() {
         return mSpeed;
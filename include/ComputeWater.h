@@ -19,7 +19,7 @@ public:
     virtual ~ComputeWater();
     
     virtual void update( float dt );
-    virtual void submitRenderer( Renderer &renderer );
+    virtual void submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry );
     
     SharedPtr<Texture> getSimTexture() {
         return mSimTexture;
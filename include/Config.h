@@ -72,6 +72,8 @@ struct Config
                  ssaoBufferHeight = 640;
     
     unsigned int shadowMapSize = 1024;
+    // memory (MB) the cached point light shadow maps may use, 0 disables the cache
+    unsigned int shadowMapCacheSize = 96;
                  
     float fov = 90.f,
           nearPlane = 0.1f,
@@ -81,6 +83,27 @@ struct Config
     
     bool openglDebug = false;
     
+    // render on a separate thread, the main thread records up to 'frameLatency' (1 or 2) frames ahead
+    bool renderThread = false;
+    unsigned int frameLatency = 1;
+    
+    // shade the lights without shadows in one full screen pass over a cluster grid
+    bool clusteredLights = false;
+    
+    // draw the entities that shares mesh & material with one instanced draw,
+    // needs the instanced program in the resource pack
+    bool instancing = true;
+    // the instanced draws of the g-buffer pass are made with one multi draw indirect call,
+    // needs instancing, the indirect program & ARB_multi_draw_indirect/ARB_shader_draw_parameters
+    bool multiDrawIndirect = true;
+    
+    // render to a smaller part of the g-buffer when the gpu time is over the target (ms),
+    // the scale of each axis stays within [min,max]
+    bool dynamicResolution = false;
+    float dynamicResolutionTarget = 16.6f,
+          dynamicResolutionMinScale = 0.5f,
+          dynamicResolutionMaxScale = 1.f;
+          
     // scene config
     std::string startScene;
     
@@ -98,6 +98,11 @@ private:
     std::vector<DebugNormalDraw> mNormalDraws;
     std::vector<DebugTextureDraw> mTextureDraws;
     
+    // copies of the lists above that the render thread draws from
+    std::vector<DebugWireDraw> mRenderWireFramesDraws;
+    std::vector<DebugNormalDraw> mRenderNormalDraws;
+    std::vector<DebugTextureDraw> mRenderTextureDraws;
+    
     SharedPtr<Mesh> mSphereMesh,
                     mConeMesh,
                     mBoxMesh;
@@ -21,8 +21,8 @@ class DeferredEntity :
 public:
     DeferredEntity( SceneObjectFactory* factory, Root *root, const SharedPtr<Mesh> &mesh, const DeferredMaterial &material );
     
-    virtual void submitRenderer( Renderer& renderer ) override;
-    virtual void submitShadowCasters(Renderer& renderer) override;
+    virtual void submitRenderer( Renderer& renderer, const SceneSnapshot::ObjectEntry &entry ) override;
+    virtual void submitShadowCasters( Renderer& renderer, const SceneSnapshot::ObjectEntry &entry ) override;
     
     SharedPtr<Mesh> getMesh() {
         return mMesh;
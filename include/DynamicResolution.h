@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+
+/** class DynamicResolution
+ *      Picks how much of the g-buffer is rendered to from the gpu frame times, the scale
+ *      is used on both axes so the pixel count goes with scale².
+ *      There is some hysteresis so it doesn't flicker between two sizes: the smoothed time
+ *      has to be over the target for 'framesToDrop' frames in a row before the scale is
+ *      lowered, and under target*raiseThreshold for 'framesToRaise' frames before it's
+ *      raised. After a change it waits 'cooldownFrames' frames, the timer queries lags
+ *      a few frames behind so the first times are still from the old size.
+ *      Only the logic lives here so it can be fed made up timings, the renderer applies it.
+ */
+class DynamicResolution {
+public:
+    struct Settings {
+        // ms
+        float targetTime = 16.6f;
+        float minScale = 0.5f,
+              maxScale = 1.f;
+        float raiseThreshold = 0.8f;
+        
+        unsigned int framesToDrop = 3,
+                     framesToRaise = 30,
+                     cooldownFrames = 4;
+                     
+        // how much a new time counts in the smoothed time
+        float smoothing = 0.25f;
+        // the most the scale changes at once
+        float maxStep = 0.1f;
+    };
+    
+public:
+    // starts at the max scale
+    void setSettings( const Settings &settings );
+    const Settings& getSettings() const {
+        return mSettings;
+    }
+    
+    // back to the max scale & forgets the times
+    void reset();
+    
+    // the gpu time (ms) of a finished frame, returns the scale to use from now on.
+    // Times <= 0 are ignored, the timer has no result yet
+    float addFrameTime( float gpuTime );
+    
+    float getScale() const {
+        return mScale;
+    }
+    float getSmoothedTime() const {
+        return mSmoothedTime;
+    }
+    
+    // the part of a buffer of 'bufferSize' that's rendered to, at least 1x1
+    glm::uvec2 getRenderSize( const glm::uvec2 &bufferSize ) const;
+    
+private:
+    void changeScale();
+    
+private:
+    Settings mSettings;
+    
+    float mScale = 1.f,
+          mSmoothedTime = 0.f;
+    unsigned int mOverFrames = 0,
+                 mUnderFrames = 0,
+                 mCooldown = 0;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+/** class FrameArena
+ *      Linear allocator for data that only lives for one frame. Allocations are
+ *      bumped out of a chunk & nothing is freed until reset, which makes all of
+ *      it available again. If a frame needed more than one chunk they are merged
+ *      into one on reset, so after a few frames a frame is served from a single
+ *      chunk & the memory use stays constant.
+ *      Not thread safe, a frame is only written by one thread at the time.
+ */
+class FrameArena {
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 256*1024;
+    
+public:
+    FrameArena( const FrameArena& ) = delete;
+    FrameArena( FrameArena&& ) = delete;
+    FrameArena& operator = ( const FrameArena& ) = delete;
+    FrameArena& operator = ( FrameArena&& ) = delete;
+    
+public:
+    FrameArena( size_t chunkSize = DEFAULT_CHUNK_SIZE );
+    ~FrameArena();
+    
+    void* allocate( size_t size, size_t aligment );
+    // everything allocated must be dead by now
+    void reset();
+    
+    // bytes handed out since the last reset, padding included
+    size_t getUsed() const {
+        return mUsed;
+    }
+    // the most that was used in one frame
+    size_t getHighWaterMark() const {
+        return mHighWaterMark > mUsed ? mHighWaterMark : mUsed;
+    }
+    // bytes held in chunks
+    size_t getCapacity() const {
+        return mCapacity;
+    }
+    
+private:
+    struct Chunk {
+        char *memory;
+        size_t size,
+               used;
+    };
+    
+    void addChunk( size_t size );
+    
+private:
+    size_t mChunkSize;
+    std::vector<Chunk> mChunks;
+    
+    size_t mUsed = 0,
+           mHighWaterMark = 0,
+           mCapacity = 0;
+};
+
+/** class FrameArenaAllocator
+ *      Standard allocator that takes its memory from a FrameArena,
+ *      deallocate does nothing since the arena is reset as a whole.
+ */
+template< typename Type >
+class FrameArenaAllocator {
+public:
+    typedef Type value_type;
+    
+public:
+    FrameArenaAllocator( FrameArena *arena ) :
+        mArena(arena)
+    {}
+    template< typename Other >
+    FrameArenaAllocator( const FrameArenaAllocator<Other> &other ) :
+        mArena(other.getArena())
+    {}
+    
+    Type* allocate( size_t count ) {
+        return static_cast<Type*>( mArena->allocate(sizeof(Type)*count, alignof(Type)) );
+    }
+    void deallocate( Type *ptr, size_t count ) {}
+    
+    FrameArena* getArena() const {
+        return mArena;
+    }
+    
+    template< typename Other >
+    friend bool operator == ( const FrameArenaAllocator &a1, const FrameArenaAllocator<Other> &a2 ) {
+        return a1.getArena() == a2.getArena();
+    }
+    template< typename Other >
+    friend bool operator != ( const FrameArenaAllocator &a1, const FrameArenaAllocator<Other> &a2 ) {
+        return a1.getArena() != a2.getArena();
+    }
+    
+private:
+    FrameArena *mArena;
+};
+
+template< typename Type >
+using FrameVector = std::vector<Type, FrameArenaAllocator<Type>>;
+
+// destroys the content & lets go of the memory, must be done before the arena is reset.
+// returns the size it had
+template< typename Type >
+size_t releaseFrameVector( FrameVector<Type> &vector )
+{
+    size_t size = vector.size();
+    FrameVector<Type> empty( vector.get_allocator() );
+    vector.swap( empty );
+    return size;
+}
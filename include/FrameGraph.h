@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Texture.h"
+#include "FixedSizeTypes.h"
+
+#include <glm/vec2.hpp>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stddef.h>
+
+struct FrameGraphTextureDesc {
+    TextureType type;
+    glm::uvec2 size;
+};
+
+/** class FrameGraph
+ *      The passes of a frame & the textures they read & write. The passes are declared
+ *      up front, 'compile' then works out the rest:
+ *        - the order, passes writing the same resource runs in the order they were added.
+ *          A pass reads the version of a resource written by the last pass added before it
+ *          & runs before the later writers, if no pass before it writes the resource it runs
+ *          after the last writer instead. Otherwise the order they were added in only breaks ties.
+ *        - culling, passes that doesn't lead to an output (or imported resource) are dropped.
+ *        - the lifetime of each transient texture, from the first to the last pass using it.
+ *        - aliasing, transients with the same type & size whose lifetimes doesn't overlap
+ *          shares a texture. Gl can't place two textures in the same memory, so sharing
+ *          the texture object is as close as it gets.
+ *        - barriers, glMemoryBarrier is needed after a texture was written as an image.
+ *      No gl calls are made here, the renderer creates the textures & runs the passes.
+ */
+class FrameGraph {
+public:
+    typedef UInt32 ResourceId;
+    typedef UInt32 PassId;
+    typedef std::function<void()> Execute;
+    
+    static const UInt32 INVALID_ID = ~UInt32(0);
+    
+    enum class Access {
+        RenderTarget,
+        Sampled,
+        Image
+    };
+    
+    // the renderer maps them to the glMemoryBarrier bits
+    enum Barrier {
+        BARRIER_NONE = 0,
+        BARRIER_FRAMEBUFFER = 1<<0,
+        BARRIER_TEXTURE_FETCH = 1<<1,
+        BARRIER_IMAGE_ACCESS = 1<<2,
+        BARRIER_ALL = BARRIER_FRAMEBUFFER | BARRIER_TEXTURE_FETCH | BARRIER_IMAGE_ACCESS
+    };
+    
+public:
+    void clear();
+    
+    ResourceId addTransient( const std::string &name, const FrameGraphTextureDesc &desc );
+    // owned by someone else (like the window), never aliased & the passes writing it are never culled
+    ResourceId addImported( const std::string &name );
+    // the passes writing it are never culled
+    void markOutput( ResourceId resource );
+    
+    PassId addPass( const std::string &name, const Execute &execute );
+    void read( PassId pass, ResourceId resource, Access access );
+    void write( PassId pass, ResourceId resource, Access access );
+    
+    // false if the passes depends on each other in a cycle
+    bool compile();
+    
+    // the passes that wasn't culled, valid after compile
+    const std::vector<PassId>& getExecutionOrder() const {
+        return mOrder;
+    }
+    bool isCulled( PassId pass ) const {
+        return mPasses[pass].culled;
+    }
+    // Barrier bits to issue before the pass
+    UInt32 getBarriers( PassId pass ) const {
+        return mPasses[pass].barriers;
+    }
+    const std::string& getPassName( PassId pass ) const {
+        return mPasses[pass].name;
+    }
+    void executePass( PassId pass ) const {
+        mPasses[pass].execute();
+    }
+    
+    // index into getTextures, INVALID_ID for imported & unused resources
+    UInt32 getTextureIndex( ResourceId resource ) const {
+        return mResources[resource].texture;
+    }
+    // the textures to create
+    const std::vector<FrameGraphTextureDesc>& getTextures() const {
+        return mTextures;
+    }
+    
+    // bytes the used transients would need with a texture each & the bytes of the shared textures
+    size_t getTransientMemory() const {
+        return mTransientMemory;
+    }
+    size_t getAllocatedMemory() const {
+        return mAllocatedMemory;
+    }
+    
+    // a guess, gl doesn't tell how the driver stores it
+    static size_t GetTextureMemory( const FrameGraphTextureDesc &desc );
+    
+private:
+    struct ResourceAccess {
+        ResourceId resource;
+        Access access;
+    };
+    struct Pass {
+        std::string name;
+        Execute execute;
+        std::vector<ResourceAccess> reads, writes;
+        
+        UInt32 barriers = BARRIER_NONE;
+        bool culled = false;
+    };
+    struct Resource {
+        std::string name;
+        FrameGraphTextureDesc desc;
+        bool imported = false,
+             output = false;
+             
+        UInt32 texture = INVALID_ID;
+    };
+    
+private:
+    bool sortPasses();
+    void cullPasses();
+    void aliasTextures();
+    void findBarriers();
+    
+private:
+    std::vector<Pass> mPasses;
+    std::vector<Resource> mResources;
+    
+    std::vector<PassId> mOrder;
+    std::vector<FrameGraphTextureDesc> mTextures;
+    
+    size_t mTransientMemory = 0,
+           mAllocatedMemory = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+/** class GLRenderDevice
+ *      The default device, forwards every call to the current gl context.
+ */
+class GLRenderDevice :
+    public RenderDevice
+{
+public:
+    virtual GLint getInteger( GLenum name ) override;
+    
+    virtual GLuint genBuffer() override;
+    virtual void deleteBuffer( GLuint buffer ) override;
+    virtual void bindBuffer( GLenum target, GLuint buffer ) override;
+    virtual void bindBufferBase( GLenum target, GLuint index, GLuint buffer ) override;
+    virtual void bindBufferRange( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size ) override;
+    virtual void bufferData( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) override;
+    virtual void bufferStorage( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags ) override;
+    virtual GLint getBufferParameter( GLenum target, GLenum name ) override;
+    virtual void* mapBuffer( GLenum target, GLenum access ) override;
+    virtual void* mapBufferRange( GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access ) override;
+    virtual void flushMappedBufferRange( GLenum target, GLintptr offset, GLsizeiptr length ) override;
+    virtual void unmapBuffer( GLenum target ) override;
+    virtual void getBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, void *data ) override;
+    
+    virtual GLuint genTexture() override;
+    virtual void deleteTexture( GLuint texture ) override;
+    virtual void activeTexture( GLenum unit ) override;
+    virtual void bindTexture( GLenum target, GLuint texture ) override;
+    virtual void texStorage2D( GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height ) override;
+    virtual void texSubImage2D( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels ) override;
+    virtual void texParameteri( GLenum target, GLenum name, GLint param ) override;
+    virtual void generateMipmap( GLenum target ) override;
+    virtual void copyImageSubData2D( GLuint src, GLuint dst, GLsizei width, GLsizei height ) override;
+    virtual void bindImageTexture( GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format ) override;
+    
+    virtual GLuint genFramebuffer() override;
+    virtual void deleteFramebuffer( GLuint framebuffer ) override;
+    virtual void bindFramebuffer( GLenum target, GLuint framebuffer ) override;
+    virtual void framebufferTexture( GLenum target, GLenum attachment, GLuint texture, GLint level ) override;
+    virtual GLenum checkFramebufferStatus( GLenum target ) override;
+    virtual void drawBuffers( GLsizei count, const GLenum *buffers ) override;
+    
+    virtual GLuint genVertexArray() override;
+    virtual void deleteVertexArray( GLuint vao ) override;
+    virtual void bindVertexArray( GLuint vao ) override;
+    virtual void enableVertexAttribArray( GLuint index ) override;
+    virtual void vertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset ) override;
+    
+    virtual void useProgram( GLuint program ) override;
+    virtual void deleteProgram( GLuint program ) override;
+    virtual GLint getUniformLocation( GLuint program, const char *name ) override;
+    virtual void uniform1i( GLint location, GLint value ) override;
+    virtual void uniform1f( GLint location, GLfloat value ) override;
+    
+    virtual void enable( GLenum cap ) override;
+    virtual void disable( GLenum cap ) override;
+    virtual void blendFunc( GLenum src, GLenum dst ) override;
+    virtual void depthMask( GLboolean write ) override;
+    virtual void depthFunc( GLenum func ) override;
+    virtual void cullFace( GLenum face ) override;
+    virtual void colorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a ) override;
+    virtual void colorMaski( GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a ) override;
+    virtual void viewport( GLint x, GLint y, GLsizei width, GLsizei height ) override;
+    virtual void clear( GLbitfield mask ) override;
+    
+    virtual void drawArrays( GLenum mode, GLint first, GLsizei count ) override;
+    virtual void drawElements( GLenum mode, GLsizei count, GLenum type, const void *offset ) override;
+    virtual void drawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount ) override;
+    virtual void drawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount ) override;
+    virtual void drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex ) override;
+    virtual void drawElementsInstancedBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount, GLint baseVertex ) override;
+    virtual void multiDrawElementsIndirect( GLenum mode, GLenum type, const void *offset, GLsizei drawCount, GLsizei stride ) override;
+    virtual void dispatchCompute( GLuint x, GLuint y, GLuint z ) override;
+    virtual void memoryBarrier( GLbitfield barriers ) override;
+    
+    virtual void genQueries( GLsizei count, GLuint *queries ) override;
+    virtual void beginQuery( GLenum target, GLuint query ) override;
+    virtual void endQuery( GLenum target ) override;
+    virtual void beginConditionalRender( GLuint query, GLenum mode ) override;
+    virtual void endConditionalRender() override;
+    virtual void deleteQueries( GLsizei count, const GLuint *queries ) override;
+    virtual void queryCounter( GLuint query, GLenum target ) override;
+    virtual GLint getQueryObject( GLuint query, GLenum name ) override;
+    virtual UInt64 getQueryObjectui64( GLuint query, GLenum name ) override;
+    
+    virtual GLsync fenceSync() override;
+    virtual GLenum clientWaitSync( GLsync sync, GLbitfield flags, UInt64 timeout ) override;
+    virtual void deleteSync( GLsync sync ) override;
+};
@@ -30,4 +30,7 @@ typedef double      GLclampd;   /* double precision float in [0,1] */
 typedef ptrdiff_t GLsizeiptr;
 typedef ptrdiff_t GLintptr;
 
+// from glext.h (GL_ARB_sync)
+typedef struct __GLsync *GLsync;
+
 }
\ No newline at end of file
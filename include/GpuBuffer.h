@@ -4,6 +4,7 @@
 
 #include "GLTypes.h"
 #include "SharedPtr.h"
+#include "ResourceHandle.h"
 
 // Don't change the values in BufferUsage & BufferUpdate,
 // they are used in 'usageAndUpdateToGL' in GpuBuffer.cpp
@@ -34,7 +35,8 @@ enum class BufferType {
     Vertexes,
     Indexes,
     Uniforms,
-    ShaderStorage
+    ShaderStorage,
+    DrawIndirect
 };
 
 class GpuBuffer {
@@ -42,7 +44,7 @@ public:
     static SharedPtr<GpuBuffer> CreateBuffer( BufferType type, size_t size, BufferUsage usage, BufferUpdate update );
     
 public:
-    GpuBuffer() = default;
+    GpuBuffer();
     GpuBuffer( const GpuBuffer& ) = delete;
     GpuBuffer( GpuBuffer &&move );
     ~GpuBuffer();
@@ -98,6 +100,10 @@ public:
     GLuint getGLBuffer() {
         return mBuffer;
     }
+    // a moved to buffer gets a new handle
+    GpuBufferHandle getHandle() {
+        return mHandle;
+    }
     
     
 private:
@@ -112,4 +118,5 @@ private:
     BufferType mType = BufferType::Vertexes;
     GLuint mBuffer = 0;
     size_t mSize;
+    GpuBufferHandle mHandle;
 };
\ No newline at end of file
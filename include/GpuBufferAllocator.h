@@ -7,16 +7,15 @@
 
 struct GpuBufferResource {
     GLuint glBuffer = 0;
-    // if not null, the buffer is mapped
+    // if not null, the buffer is mapped from 'flushedFromOffset'
     void *mapped = nullptr;
     
     size_t size = 0;
     size_t flushedFromOffset = 0,
-           allocatedToOffset = 0,
-           lastUsed = 0;
+           allocatedToOffset = 0;
 };
 
-class GpuSubBuffer 
+class GpuSubBuffer
 {
     friend class GpuBufferAllocator;
     GpuSubBuffer( GpuBufferResource *buffer, size_t offset, size_t size );
@@ -26,6 +25,7 @@ public:
     GpuSubBuffer( const GpuSubBuffer& ) = default;
     GpuSubBuffer& operator = ( const GpuSubBuffer& ) = default;
     
+    // only until the allocator is flushed
     void setContent( const void *content, size_t size );
     
     template< typename Type >
@@ -33,11 +33,35 @@ public:
         setContent( &content, sizeof(Type) );
     }
     
+    bool isValid() const {
+        return mBuffer != nullptr;
+    }
+    GLuint getGLBuffer() const {
+        return mBuffer ? mBuffer->glBuffer : 0;
+    }
+    size_t getOffset() const {
+        return mOffset;
+    }
+    size_t getSize() const {
+        return mSize;
+    }
+    
 private:
     GpuBufferResource *mBuffer = nullptr;
     size_t mOffset=0, mSize=0;
 };
 
+/** class GpuBufferAllocator
+ *      Sub allocates from a few big gl buffers, so things that are used together
+ *      can share a buffer & be drawn without binding a new one.
+ *      The allocations are put after each other in a buffer (StackAllocationPattern)
+ *      & a new buffer is made when none have room left. Memory isn't given back one
+ *      allocation at a time, only all of it with 'clear'.
+ *      The unflushed part of a buffer is mapped while allocating & written to with
+ *      GpuSubBuffer::setContent, 'flush' unmaps it so the gpu can use it. The buffers
+ *      are only bound to GL_COPY_WRITE_BUFFER here, so writing to an index buffer
+ *      doesn't change the bound vao.
+ */
 class GpuBufferAllocator {
     GpuBufferAllocator() = delete;
     GpuBufferAllocator( const GpuBufferAllocator& ) = delete;
@@ -46,16 +70,18 @@ class GpuBufferAllocator {
     GpuBufferAllocator& operator = ( GpuBufferAllocator&& ) = delete;
     
 public:
-    GpuBufferAllocator( GLenum bufferType, GLenum usage, size_t defaultBufferSize );
+    // 'usage' as for glBufferData
+    GpuBufferAllocator( GLenum usage, size_t defaultBufferSize );
     ~GpuBufferAllocator();
     
-    // flush allocated buffers, 
+    // flush allocated buffers,
     // any buffers allocated before this is uploaded to the gpu and is no longer changable
     void flush();
     
     // clear any allocations, all allocations before this is no longer valid
     void clear();
     
+    // the aligment doesn't have to be a power of two
     GpuSubBuffer allocateBuffer( size_t size, size_t allignment = 1 );
     
 protected:
@@ -75,7 +101,7 @@ protected:
     void destroyBuffer( BufferInfo &info );
     
 protected:
-    GLenum mBufferType, mUsage;
+    GLenum mUsage;
     size_t mDefaultBufferSize;
     
     // I'm using list since we keep points to the buffers, so we don't want them relocated.
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "GLTypes.h"
+#include "FixedSizeTypes.h"
+#include "ValueHistory.h"
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <stddef.h>
+
+class RenderDevice;
+
+/** class GpuPassTimer
+ *      Measures how long the passes of a frame takes on the gpu with timestamp queries.
+ *      Each frame has its own queries in a ring of 'latency' frames & a frame is only read
+ *      once GL_QUERY_RESULT_AVAILABLE is set for the query it issued last, so the cpu never waits
+ *      for the gpu. If the gpu is more than 'latency' frames behind the frame isn't timed.
+ *      A pass that's timed more than once in a frame (one per shadow map) is summed, the
+ *      time per call is kept as well. Passes can be nested, the outer time includes the inner.
+ *      The timing is done where the gl context is current, the histories can be read anywhere.
+ */
+class GpuPassTimer {
+public:
+    struct PassHistory {
+        std::string name;
+        // ms per frame & per call
+        ValueHistory<float> times,
+                            callTimes;
+        // if it has been timed more than once in a frame
+        bool repeated = false;
+    };
+    
+public:
+    GpuPassTimer( const GpuPassTimer& ) = delete;
+    GpuPassTimer( GpuPassTimer&& ) = delete;
+    GpuPassTimer& operator = ( const GpuPassTimer& ) = delete;
+    GpuPassTimer& operator = ( GpuPassTimer&& ) = delete;
+    
+public:
+    GpuPassTimer( size_t historyLength, unsigned int latency = 4, size_t maxPassesPerFrame = 128 );
+    ~GpuPassTimer();
+    
+    // reads the frames that are done & starts timing a new one
+    void beginFrame();
+    void endFrame();
+    
+    void beginPass( const char *name );
+    void endPass();
+    
+    // in the order the passes were first timed
+    std::vector<PassHistory> getHistories();
+    // ms, the last frame that was read, 'readFrames' is set to the number of frames read so far,
+    // it's unchanged while no new frame is read (a skipped frame)
+    float getLastTime( const std::string &name, UInt64 *readFrames = nullptr );
+    // frames that wasn't timed since the gpu was too far behind
+    size_t getSkippedFrames() {
+        return mSkippedFrames;
+    }
+    
+private:
+    struct Pass {
+        size_t history;
+        GLuint begin, end;
+    };
+    struct Frame {
+        std::vector<Pass> passes;
+        size_t usedQueries = 0;
+        // the query issued last, with nested passes it's not the last one allocated
+        GLuint lastQuery = 0;
+        bool pending = false;
+    };
+    
+    size_t getHistoryIndex( const char *name );
+    void readFrame( Frame &frame );
+    
+private:
+    RenderDevice *mDevice;
+    size_t mHistoryLength,
+           mMaxQueriesPerFrame;
+           
+    std::vector<GLuint> mQueries;
+    std::vector<Frame> mFrames;
+    size_t mCurrentFrame = 0;
+    // false while the current frame isn't timed
+    bool mTiming = false;
+    std::vector<size_t> mOpenPasses;
+    std::atomic<size_t> mSkippedFrames{0};
+    // same order as mHistories, only used by the timing side
+    std::vector<std::string> mNames;
+    
+    // per frame scratch, summed time & call count per history
+    std::vector<UInt64> mFrameTimes;
+    std::vector<size_t> mFrameCalls;
+    
+    std::vector<PassHistory> mHistories;
+    std::vector<float> mLastTimes;
+    UInt64 mReadFrames = 0;
+    // guards mHistories, mLastTimes & mReadFrames
+    std::mutex mMutex;
+};
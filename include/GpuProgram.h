@@ -2,6 +2,7 @@
 
 #include "GLTypes.h"
 #include "SharedPtr.h"
+#include "ResourceHandle.h"
 #include "UniformBlock.h"
 
 #include <vector>
@@ -57,7 +58,11 @@ public:
     GLuint getGLProgram() {
         return mProgram;
     }
+    GpuProgramHandle getHandle() {
+        return mHandle;
+    }
     
 private:
     GLuint mProgram;
+    GpuProgramHandle mHandle;
 };
\ No newline at end of file
@@ -6,12 +6,17 @@
 #include "GLTypes.h"
 
 #include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
 
 class Log;
 class Root;
 class FrameListener;
 class Renderer;
 class Camera;
+class RenderThread;
+class GpuPassTimer;
 
 typedef void* SDL_GLContext;
 typedef struct SDL_Window SDL_Window;
@@ -28,6 +33,18 @@ public:
     virtual bool handleSDLEvent( const SDL_Event &event ) override;
     void render();
     
+    // hands the gl context over to a render thread, which renders the frames recorded
+    // by render with 'frameLatency' (1 or 2) frames delay.
+    // while it's running all gl calls must go through runOnRenderThread
+    void startRenderThread( unsigned int frameLatency );
+    void stopRenderThread();
+    bool hasRenderThread() {
+        return mRenderThread != nullptr;
+    }
+    
+    // queues the task on the render thread, or runs it right away if there is none
+    void runOnRenderThread( const std::function<void()> &task );
+    
     void addFrameListener( FrameListener *listener );
     void removeFrameListener( FrameListener *listener );
     
@@ -37,10 +54,22 @@ public:
     const ValueHistory<float> getGpuTimeHistory() {
         return mGpuTimes;
     }
+    // time spent rendering a frame on the render thread & the time
+    // the main thread waited for it, both are 0 without a render thread
+    const ValueHistory<float>& getRenderThreadTimeHistory() {
+        return mRenderThreadTimes;
+    }
+    const ValueHistory<float>& getRenderWaitTimeHistory() {
+        return mRenderWaitTimes;
+    }
     
     Renderer* getRenderer() {
         return mRenderer;
     }
+    // the passes are timed on the render thread, see GpuPassTimer
+    GpuPassTimer* getPassTimer() {
+        return mPassTimer;
+    }
     
 private:
     void fireFrameBegun();
@@ -55,15 +84,22 @@ private:
     SDL_GLContext mGLContext = nullptr;
     
     Renderer *mRenderer = nullptr;
+    RenderThread *mRenderThread = nullptr;
     Log *mLog = nullptr;
     
     std::vector<FrameListener*> mFrameListeners;
     std::vector<Camera*> mCameras;
     
-    size_t mNumOfQuaryObjects;
-    std::vector<GLuint> mTimeQuaryObjects;
-    
-    int mCurrentQuary = 0;
+    // used from the render thread, the histories can be read from any thread
+    GpuPassTimer *mPassTimer = nullptr;
     
-    ValueHistory<float> mGpuTimes;
+    ValueHistory<float> mGpuTimes,
+                        mRenderThreadTimes,
+                        mRenderWaitTimes;
+    // written by the render thread, the frames the timer had read when the time was taken
+    // so a time is only used once
+    float mLastGpuTime = 0.f;
+    UInt64 mLastGpuFrame = 0,
+           mUsedGpuFrame = 0;
+    std::mutex mGpuTimeMutex;
 };
\ No newline at end of file
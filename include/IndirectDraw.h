@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FixedSizeTypes.h"
+
+#include <vector>
+#include <stddef.h>
+
+struct SubMesh;
+class VertexArrayObject;
+
+// layout defined by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    UInt32 count,
+           instanceCount,
+           firstIndex,
+           baseVertex,
+           baseInstance;
+};
+
+/** class IndirectCommandBuilder
+ *      Builds the command arrays for glMultiDrawElementsIndirect on the cpu.
+ *      Draws are grouped into buckets, all draws in a bucket shares the same
+ *      state (program, textures, vao & index buffer) and is issued with one call.
+ *      Every command also gets an entry in the draw data array, the shader
+ *      finds it with 'gl_DrawID + first command of the bucket', it holds the
+ *      index of the first instance for the command.
+ *      addGroup starts the buckets by itself, a new one is started whenever the
+ *      state differs from the last group's.
+ *      No gl calls are made here, the renderer uploads the arrays.
+ */
+class IndirectCommandBuilder {
+public:
+    struct Bucket {
+        UInt32 firstCommand, 
+               commandCount;
+        // whatever the caller needs to restore the state for the bucket
+        UInt32 userData;
+    };
+    // what the draws of a bucket shares, the values of the texture handles & the buffers
+    struct BucketState {
+        UInt32 diffuseTexture = 0,
+               normalMap = 0;
+        const VertexArrayObject *vao = nullptr;
+        UInt32 indexBuffer = 0;
+        
+        bool operator == ( const BucketState &other ) const {
+            return diffuseTexture == other.diffuseTexture && normalMap == other.normalMap &&
+                   vao == other.vao && indexBuffer == other.indexBuffer;
+        }
+    };
+    
+public:
+    void clear();
+    
+    // the following draws will be added to a new bucket
+    void beginBucket( UInt32 userData );
+    // adds one command per submesh, only for indexed meshes
+    void addDraw( const std::vector<SubMesh> &subMeshes, UInt32 instanceCount, UInt32 firstInstance );
+    // adds the draws of an instance group, in a new bucket with 'userData' if the state changed
+    void addGroup( const BucketState &state, const std::vector<SubMesh> &subMeshes, UInt32 instanceCount, UInt32 firstInstance, UInt32 userData );
+    
+    const std::vector<DrawElementsIndirectCommand>& getCommands() const {
+        return mCommands;
+    }
+    const std::vector<UInt32>& getDrawData() const {
+        return mDrawData;
+    }
+    const std::vector<Bucket>& getBuckets() const {
+        return mBuckets;
+    }
+    
+private:
+    std::vector<DrawElementsIndirectCommand> mCommands;
+    std::vector<UInt32> mDrawData;
+    std::vector<Bucket> mBuckets;
+    // the state of the last group, only valid while there are buckets
+    BucketState mBucketState;
+};
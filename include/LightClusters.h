@@ -0,0 +1,94 @@
+#pragma once
+
+#include "FixedSizeTypes.h"
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+#include <stddef.h>
+
+class WorkerPool;
+
+/** class LightClusterBuilder
+ *      Bins point lights into clusters (froxels), the view frustum is split into
+ *      screen space tiles & exponentially spaced depth slices. Each cluster gets
+ *      an (offset,count) pair into one shared light index list, so a full screen
+ *      pass can find the lights touching a pixel from its tile & depth.
+ *      A light is tested against the view space bounding box of every cluster
+ *      its bounds could touch, the indices in a cluster are in light order.
+ *      No gl calls are made here, the renderer uploads the arrays.
+ */
+class LightClusterBuilder {
+public:
+    // in view space
+    struct Light {
+        glm::vec3 position;
+        float radius;
+    };
+    // layout matches the shader storage block
+    struct Cluster {
+        UInt32 offset,
+               count;
+    };
+    
+public:
+    LightClusterBuilder();
+    
+    // x,y = tiles, z = depth slices
+    void setGridSize( const glm::uvec3 &gridSize );
+    const glm::uvec3& getGridSize() const {
+        return mGridSize;
+    }
+    
+    // the projection must be a symmetric perspective projection (like glm::perspective),
+    // lights outside [nearPlane,farPlane] are skipped. The lights are split across the pool if given.
+    void build( const Light *lights, size_t lightCount, const glm::mat4 &projectionMatrix, float nearPlane, float farPlane, WorkerPool *pool = nullptr );
+    
+    const std::vector<Cluster>& getClusters() const {
+        return mClusters;
+    }
+    const std::vector<UInt32>& getLightIndices() const {
+        return mLightIndices;
+    }
+    
+    size_t getClusterIndex( UInt32 x, UInt32 y, UInt32 slice ) const {
+        return (slice*mGridSize.y + y)*mGridSize.x + x;
+    }
+    // the slice for a view space depth (distance along -z) is floor(log(depth)*scale + bias)
+    UInt32 getSlice( float depth ) const;
+    float getSliceScale() const {
+        return mSliceScale;
+    }
+    float getSliceBias() const {
+        return mSliceBias;
+    }
+    
+private:
+    struct ClusterLightPair {
+        UInt32 cluster,
+               light;
+    };
+    
+    void binLights( const Light *lights, size_t first, size_t last, std::vector<ClusterLightPair> &pairs ) const;
+    
+private:
+    glm::uvec3 mGridSize;
+    
+    float mNearPlane = 0.f,
+          mFarPlane = 0.f,
+          mSliceScale = 0.f,
+          mSliceBias = 0.f;
+          
+    // x/depth & y/depth of the tile edges, gridSize+1 each
+    std::vector<float> mTileEdgesX,
+                       mTileEdgesY;
+    // view space depth of the slice edges, slices+1
+    std::vector<float> mSliceEdges;
+    
+    // one list per thread, merged in thread order
+    std::vector<std::vector<ClusterLightPair>> mThreadPairs;
+    
+    std::vector<Cluster> mClusters;
+    std::vector<UInt32> mLightIndices;
+};
@@ -67,7 +67,7 @@ public:
         return mIntensity;
     }
     
-    virtual void submitRenderer( Renderer &renderer );
+    virtual void submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry );
     
 private:
     Root *mRoot;
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "GpuBuffer.h"
+#include "GpuBufferAllocator.h"
 #include "SharedPtr.h"
 #include "VertexArrayObject.h"
 #include "BoundingSphere.h"
+#include "ResourceHandle.h"
 
 #include <string>
 #include <vector>
@@ -16,7 +18,10 @@ class ResourceManager;
 class Material;
 
 struct SubMesh {
+    // vertexStart is the first index for indexed meshes
     size_t vertexStart, vertexCount;
+    // added to the indexes, the meshes that shares buffers has their vertexes after each other
+    size_t baseVertex = 0;
 };
 
 class Mesh {
@@ -38,10 +43,40 @@ public:
           const std::vector<SubMesh> &subMeshes,
           const BoundingSphere &bounds
         );
+    // the geometry is in buffers shared with other meshes, the vao has the index buffer bound
+    Mesh( const SharedPtr<VertexArrayObject> &vao,
+          const GpuSubBuffer &vertexes,
+          const GpuSubBuffer &indexes,
+          const std::vector<SubMesh> &subMeshes,
+          const BoundingSphere &bounds
+        );
+    ~Mesh();
+    
+    Mesh( const Mesh& ) = delete;
+    Mesh( Mesh&& ) = delete;
+    Mesh& operator = ( const Mesh& ) = delete;
+    Mesh& operator = ( Mesh&& ) = delete;
     
-    SharedPtr<VertexArrayObject> getVertexArrayObject();
-    SharedPtr<GpuBuffer> getVertexBuffer();
-    SharedPtr<GpuBuffer> getIndexBuffer();
+    // by reference, the renderer calls these for every draw
+    const SharedPtr<VertexArrayObject>& getVertexArrayObject();
+    const SharedPtr<GpuBuffer>& getVertexBuffer();
+    // null if the mesh isn't indexed or the buffers are shared
+    const SharedPtr<GpuBuffer>& getIndexBuffer();
+    
+    bool isIndexed() {
+        return mIndexBuffer || mIndexes.isValid();
+    }
+    // the gl buffer the indexes are in, in both cases
+    GLuint getIndexGLBuffer() {
+        return mIndexBuffer ? mIndexBuffer->getGLBuffer() : mIndexes.getGLBuffer();
+    }
+    // where the geometry is in the shared buffers, invalid if the mesh has buffers of its own
+    const GpuSubBuffer& getSharedVertexes() {
+        return mVertexes;
+    }
+    const GpuSubBuffer& getSharedIndexes() {
+        return mIndexes;
+    }
     
     const std::vector<SubMesh>& getSubMeshes();
     
@@ -54,13 +89,29 @@ public:
     const BoundingSphere& getBoundingSphere() {
         return mBoundingSphere;
     }
+    MeshHandle getHandle() {
+        return mHandle;
+    }
+    
+    // the draws of the meshes the StaticBatcher merged into this one, 0 if it isn't a batch
+    void setMergedDraws( size_t draws ) {
+        mMergedDraws = draws;
+    }
+    size_t getMergedDraws() {
+        return mMergedDraws;
+    }
     
 private:
     SharedPtr<VertexArrayObject> mVertexArrayObject;
     SharedPtr<GpuBuffer> mVertexBuffer, mIndexBuffer;
+    // where the geometry is if the buffers are shared
+    GpuSubBuffer mVertexes, mIndexes;
     
     std::vector<SubMesh> mSubMeshes;
     
     std::string mName;
     BoundingSphere mBoundingSphere;
+    MeshHandle mHandle;
+    
+    size_t mMergedDraws = 0;
 };
\ No newline at end of file
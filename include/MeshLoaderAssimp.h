@@ -6,10 +6,16 @@
 
 
 class Mesh;
+class StaticMeshBuffers;
 
 class MeshLoaderAssimp
 {
 public:
+    // the static meshes are put in 'staticBuffers' if it isn't null
+    explicit MeshLoaderAssimp( StaticMeshBuffers *staticBuffers = nullptr );
+    
     SharedPtr<Mesh> loadFile( const std::string &filename );
     
+private:
+    StaticMeshBuffers *mStaticBuffers;
 };
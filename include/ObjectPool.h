@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+struct ObjectPoolStatistics {
+    size_t liveObjects = 0,
+           peakObjects = 0,
+           slabCount = 0;
+};
+
+/** class ObjectPool
+ *      Allocates objects of one type from fixed size slabs, each slab holds
+ *      'SlabSize' objects. Destroyed objects are put into a free list and
+ *      there memory is reused by later allocations.
+ *      Slabs are only released when the pool is destroyed, so the pool must
+ *      outlive every object created by it.
+ */
+template< typename Type, size_t SlabSize = 64 >
+class ObjectPool {
+public:
+    ObjectPool() = default;
+    ~ObjectPool() = default;
+    
+    ObjectPool( const ObjectPool& ) = delete;
+    ObjectPool( ObjectPool&& ) = delete;
+    ObjectPool& operator = ( const ObjectPool& ) = delete;
+    ObjectPool& operator = ( ObjectPool&& ) = delete;
+    
+    template< typename ...Args >
+    Type* create( Args&&... args ) {
+        if( mFreeList == nullptr ) {
+            allocateSlab();
+        }
+        
+        Slot *slot = mFreeList;
+        mFreeList = slot->next;
+        
+        Type *object;
+        try {
+            object = new (&slot->storage) Type( std::forward<Args>(args)... );
+        } catch( ... ) {
+            slot->next = mFreeList;
+            mFreeList = slot;
+            throw;
+        }
+        
+        mStatistics.liveObjects++;
+        if( mStatistics.liveObjects > mStatistics.peakObjects ) {
+            mStatistics.peakObjects = mStatistics.liveObjects;
+        }
+        return object;
+    }
+    
+    // object must have been created by this pool
+    void destroy( Type *object ) {
+        if( object == nullptr ) {
+            return;
+        }
+        object->~Type();
+        
+        Slot *slot = reinterpret_cast<Slot*>( object );
+        slot->next = mFreeList;
+        mFreeList = slot;
+        
+        mStatistics.liveObjects--;
+    }
+    
+    const ObjectPoolStatistics& getStatistics() const {
+        return mStatistics;
+    }
+    
+private:
+    union Slot {
+        Slot *next;
+        typename std::aligned_storage<sizeof(Type),alignof(Type)>::type storage;
+    };
+    
+    void allocateSlab() {
+        Slot *slab = new Slot[SlabSize];
+        mSlabs.emplace_back( slab );
+        
+        // link the slots in order, so the objects are created in memory order
+        for( size_t i=0; i < SlabSize-1; ++i ) {
+            slab[i].next = &slab[i+1];
+        }
+        slab[SlabSize-1].next = mFreeList;
+        mFreeList = slab;
+        
+        mStatistics.slabCount++;
+    }
+    
+private:
+    std::vector<std::unique_ptr<Slot[]>> mSlabs;
+    Slot *mFreeList = nullptr;
+    ObjectPoolStatistics mStatistics;
+};
@@ -9,9 +9,6 @@ public:
     PulsingObject( SceneObjectFactory* factory, Root* root, const SharedPtr< Mesh >& mesh, const DeferredMaterial& material );
     virtual void update( float dt ) override;
     
-    virtual void submitRenderer( Renderer &renderer );
-    virtual void submitShadowCasters( Renderer &renderer );
-    
     void setMaxScale( float maxScale ) {
         mMaxScale = maxScale;
     }
@@ -29,6 +26,5 @@ public:
 private:
     float mMaxScale = 2.f,
           mMinScale = 0.5f,
-          mOffset = 0.f,
-          mScale = 1.f;
+          mOffset = 0.f;
 };
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "FixedSizeTypes.h"
+
+#include <stddef.h>
+#include <vector>
+
+/** radixSort
+ *      Stable LSD radix sort of 'values' on the UInt64 key returned by 'getKey',
+ *      8 bits per pass. Only the lowest 'keyBits' bits of the key are looked at,
+ *      and passes where every value has the same digit are skipped.
+ *      'temp' is scratch memory, it's kept by the caller so it can be reused.
+ */
+template< typename Type, typename Allocator, typename GetKey >
+void radixSort( std::vector<Type,Allocator> &values, std::vector<Type,Allocator> &temp, GetKey getKey, unsigned int keyBits = 64 )
+{
+    if( values.size() < 2 ) {
+        return;
+    }
+    temp.resize( values.size() );
+    
+    for( unsigned int shift=0; shift < keyBits; shift += 8 ) {
+        size_t offsets[256] = {};
+        for( const Type &value : values ) {
+            offsets[(getKey(value) >> shift) & 0xFF]++;
+        }
+        
+        if( offsets[(getKey(values.front()) >> shift) & 0xFF] == values.size() ) {
+            continue;
+        }
+        
+        size_t offset = 0;
+        for( size_t &count : offsets ) {
+            size_t tmp = count;
+            count = offset;
+            offset += tmp;
+        }
+        
+        for( const Type &value : values ) {
+            temp[offsets[(getKey(value) >> shift) & 0xFF]++] = value;
+        }
+        values.swap( temp );
+    }
+}
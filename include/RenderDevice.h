@@ -0,0 +1,123 @@
+#pragma once
+
+#include "GLTypes.h"
+#include "FixedSizeTypes.h"
+
+/** class RenderDevice
+ *      Thin interface over the gl calls used by the renderer and the gpu resources
+ *      (Texture, GpuBuffer, FrameBuffer, VertexArrayObject, GpuProgram & the
+ *      UniformBufferAllocator). The functions map one to one to the gl functions
+ *      with the same name.
+ *      GetDevice returns the device in use, by default that's the GLRenderDevice.
+ *      A RecordingRenderDevice can be set instead to run the cpu side of the renderer
+ *      without a gl context. The Renderer puts its RenderStateCache in front of the
+ *      device it was created with, for as long as it lives.
+ */
+class RenderDevice {
+public:
+    static RenderDevice* GetDevice();
+    // nullptr restores the default gl device
+    static void SetDevice( RenderDevice *device );
+    
+public:
+    RenderDevice() = default;
+    virtual ~RenderDevice() = default;
+    
+    RenderDevice( const RenderDevice& ) = delete;
+    RenderDevice( RenderDevice&& ) = delete;
+    RenderDevice& operator = ( const RenderDevice& ) = delete;
+    RenderDevice& operator = ( RenderDevice&& ) = delete;
+    
+    virtual GLint getInteger( GLenum name ) = 0;
+    
+    // buffers
+    virtual GLuint genBuffer() = 0;
+    virtual void deleteBuffer( GLuint buffer ) = 0;
+    virtual void bindBuffer( GLenum target, GLuint buffer ) = 0;
+    virtual void bindBufferBase( GLenum target, GLuint index, GLuint buffer ) = 0;
+    virtual void bindBufferRange( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size ) = 0;
+    virtual void bufferData( GLenum target, GLsizeiptr size, const void *data, GLenum usage ) = 0;
+    virtual void bufferStorage( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags ) = 0;
+    virtual GLint getBufferParameter( GLenum target, GLenum name ) = 0;
+    virtual void* mapBuffer( GLenum target, GLenum access ) = 0;
+    virtual void* mapBufferRange( GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access ) = 0;
+    virtual void flushMappedBufferRange( GLenum target, GLintptr offset, GLsizeiptr length ) = 0;
+    virtual void unmapBuffer( GLenum target ) = 0;
+    // waits for the gpu, only for load time
+    virtual void getBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, void *data ) = 0;
+    
+    // textures
+    virtual GLuint genTexture() = 0;
+    virtual void deleteTexture( GLuint texture ) = 0;
+    virtual void activeTexture( GLenum unit ) = 0;
+    virtual void bindTexture( GLenum target, GLuint texture ) = 0;
+    // same as activeTexture(GL_TEXTURE0+unit) followed by bindTexture
+    virtual void bindTextureUnit( GLuint unit, GLenum target, GLuint texture );
+    virtual void texStorage2D( GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height ) = 0;
+    virtual void texSubImage2D( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels ) = 0;
+    virtual void texParameteri( GLenum target, GLenum name, GLint param ) = 0;
+    virtual void generateMipmap( GLenum target ) = 0;
+    virtual void copyImageSubData2D( GLuint src, GLuint dst, GLsizei width, GLsizei height ) = 0;
+    virtual void bindImageTexture( GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format ) = 0;
+    
+    // framebuffers
+    virtual GLuint genFramebuffer() = 0;
+    virtual void deleteFramebuffer( GLuint framebuffer ) = 0;
+    virtual void bindFramebuffer( GLenum target, GLuint framebuffer ) = 0;
+    virtual void framebufferTexture( GLenum target, GLenum attachment, GLuint texture, GLint level ) = 0;
+    virtual GLenum checkFramebufferStatus( GLenum target ) = 0;
+    virtual void drawBuffers( GLsizei count, const GLenum *buffers ) = 0;
+    
+    // vertex arrays
+    virtual GLuint genVertexArray() = 0;
+    virtual void deleteVertexArray( GLuint vao ) = 0;
+    virtual void bindVertexArray( GLuint vao ) = 0;
+    virtual void enableVertexAttribArray( GLuint index ) = 0;
+    virtual void vertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset ) = 0;
+    
+    // programs
+    virtual void useProgram( GLuint program ) = 0;
+    virtual void deleteProgram( GLuint program ) = 0;
+    virtual GLint getUniformLocation( GLuint program, const char *name ) = 0;
+    virtual void uniform1i( GLint location, GLint value ) = 0;
+    virtual void uniform1f( GLint location, GLfloat value ) = 0;
+    
+    // fixed function state
+    virtual void enable( GLenum cap ) = 0;
+    virtual void disable( GLenum cap ) = 0;
+    virtual void blendFunc( GLenum src, GLenum dst ) = 0;
+    virtual void depthMask( GLboolean write ) = 0;
+    virtual void depthFunc( GLenum func ) = 0;
+    virtual void cullFace( GLenum face ) = 0;
+    virtual void colorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a ) = 0;
+    virtual void colorMaski( GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a ) = 0;
+    virtual void viewport( GLint x, GLint y, GLsizei width, GLsizei height ) = 0;
+    virtual void clear( GLbitfield mask ) = 0;
+    
+    // draws
+    virtual void drawArrays( GLenum mode, GLint first, GLsizei count ) = 0;
+    virtual void drawElements( GLenum mode, GLsizei count, GLenum type, const void *offset ) = 0;
+    virtual void drawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount ) = 0;
+    virtual void drawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount ) = 0;
+    virtual void drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex ) = 0;
+    virtual void drawElementsInstancedBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount, GLint baseVertex ) = 0;
+    virtual void multiDrawElementsIndirect( GLenum mode, GLenum type, const void *offset, GLsizei drawCount, GLsizei stride ) = 0;
+    virtual void dispatchCompute( GLuint x, GLuint y, GLuint z ) = 0;
+    virtual void memoryBarrier( GLbitfield barriers ) = 0;
+    
+    // queries
+    virtual void genQueries( GLsizei count, GLuint *queries ) = 0;
+    virtual void beginQuery( GLenum target, GLuint query ) = 0;
+    virtual void endQuery( GLenum target ) = 0;
+    virtual void beginConditionalRender( GLuint query, GLenum mode ) = 0;
+    virtual void endConditionalRender() = 0;
+    virtual void deleteQueries( GLsizei count, const GLuint *queries ) = 0;
+    virtual void queryCounter( GLuint query, GLenum target ) = 0;
+    virtual GLint getQueryObject( GLuint query, GLenum name ) = 0;
+    virtual UInt64 getQueryObjectui64( GLuint query, GLenum name ) = 0;
+    
+    // sync objects
+    virtual GLsync fenceSync() = 0;
+    virtual GLenum clientWaitSync( GLsync sync, GLbitfield flags, UInt64 timeout ) = 0;
+    virtual void deleteSync( GLsync sync ) = 0;
+};
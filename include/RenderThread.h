@@ -0,0 +1,76 @@
+#pragma once
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+
+typedef void* SDL_GLContext;
+typedef struct SDL_Window SDL_Window;
+
+/** class RenderThread
+ *      Owns the gl context while it's running & executes the tasks queued on it in order.
+ *      The main thread records a frame by queuing its gl work & then calls endFrame,
+ *      which queues the buffer swap. endFrame blocks while more than 'frameLatency'
+ *      frames are waiting to be swapped, so the main thread can be at most that many
+ *      frames ahead of the gpu.
+ *      The context is made current on the render thread when it starts & released
+ *      when it's destroyed, after all queued tasks are done.
+ */
+class RenderThread {
+public:
+    typedef std::function<void()> Task;
+    
+public:
+    RenderThread( const RenderThread& ) = delete;
+    RenderThread( RenderThread&& ) = delete;
+    RenderThread& operator = ( const RenderThread& ) = delete;
+    RenderThread& operator = ( RenderThread&& ) = delete;
+    
+public:
+    // the context must not be current on any thread
+    RenderThread( SDL_Window *window, SDL_GLContext context, unsigned int frameLatency );
+    ~RenderThread();
+    
+    // the task must not be empty
+    void enqueue( const Task &task );
+    void endFrame();
+    
+    unsigned int getFrameLatency() const {
+        return mFrameLatency;
+    }
+    
+    // time (ms) the render thread spent on the last finished frame, swap excluded
+    float getFrameTime() const {
+        return mFrameTime;
+    }
+    // time (ms) the last endFrame was blocked
+    float getWaitTime() const {
+        return mWaitTime;
+    }
+    
+private:
+    void threadMain();
+    
+private:
+    SDL_Window *mWindow;
+    SDL_GLContext mContext;
+    unsigned int mFrameLatency;
+    
+    std::mutex mMutex;
+    std::condition_variable mTaskCondition,
+                            mFrameCondition;
+                            
+    std::deque<Task> mTasks;
+    // frames that endFrame was called for but isn't swapped yet
+    size_t mQueuedFrames = 0;
+    bool mQuit = false;
+    
+    std::atomic<float> mFrameTime,
+                       mWaitTime;
+                       
+    std::thread mThread;
+};
@@ -7,12 +7,25 @@
 #include "Material.h"
 #include "Frustrum.h"
 #include "ValueHistory.h"
+#include "FixedSizeTypes.h"
+#include "IndirectDraw.h"
+#include "LightClusters.h"
+#include "ShadowMapCache.h"
+#include "FrameArena.h"
+#include "DynamicResolution.h"
+#include "ResourceHandle.h"
+#include "BoundingSphere.h"
+#include "UniformBlockDefinitions.h"
+#include "FrameGraph.h"
+#include "SceneSnapshot.h"
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 #include <vector>
+#include <mutex>
+#include <atomic>
 
 class Frustrum;
 class Renderable;
@@ -28,32 +41,38 @@ class Material;
 class Scene;
 class UniformBufferAllocator;
 class GpuProgram;
+class RenderDevice;
+class RenderStateCache;
+class UniformStagingBuffer;
+class WorkerPool;
+class RenderThread;
+class GpuPassTimer;
 
 
+// the resources are referenced by handle & resolved when the frame is rendered,
+// an entry is skipped if one of them has been destroyed by then
 struct CustomRenderableSettings {
-    SharedPtr<GpuProgram> program;
-    SharedPtr<Texture> textures[8];
-    SharedPtr<VertexArrayObject> vao;
-    SharedPtr<GpuBuffer> indexbuffer;
+    GpuProgramHandle program;
+    TextureHandle textures[8];
+    VertexArrayHandle vao;
+    GpuBufferHandle indexbuffer;
     UniformBuffer uniforms[8];
     
     BlendMode blendMode = BlendMode::Replace;
     
     Renderable *renderable = nullptr;
     
+    // lower queues are rendered first, must fit in 16 bits
     int queue = 0;
-    
-    
-    friend bool operator < ( const CustomRenderableSettings &s1, const CustomRenderableSettings &s2 ) {
-        return s1.queue < s2.queue;
-    }
 };
 
 class Renderer {
 private:
     enum SpecialBuffers {
         SB_SpecailBuffer_Bit = (1<<10),
-        SB_SceneUniforms = 1 | SB_SpecailBuffer_Bit
+        SB_SceneUniforms = 1 | SB_SpecailBuffer_Bit,
+        // uniforms written by a worker thread, relocated before rendering
+        SB_StagedUniforms = 2 | SB_SpecailBuffer_Bit
     };
     
 public:
@@ -65,23 +84,80 @@ public:
                drawnPointShadowMap = 0,
                drawnEntities = 0;
                
+        // shadow maps rendered this frame & reused from the cache
+        size_t renderedShadowMaps = 0,
+               cachedShadowMaps = 0;
+        // cube faces set in the shadow meshes face masks, out of 6 per mesh. Each mesh is still one
+        // draw for all faces, what this saves depends on the shadow shader skipping the other faces
+        size_t flaggedShadowFaces = 0;
+               
         size_t customRenderables = 0;
+        
+        // state changes in the deferred pass
+        size_t textureBinds = 0,
+               meshBinds = 0,
+               skippedBinds = 0;
+               
+        // instanced draws in the deferred pass, one per (mesh,material) group
+        size_t instanceGroups = 0;
+        // glMultiDrawElementsIndirect calls
+        size_t indirectDraws = 0;
+        
+        // submitted static batches & the draws of the entities merged into them,
+        // the batching saved the difference
+        size_t staticBatches = 0,
+               mergedDraws = 0;
+               
+        // state changes passed on to gl & dropped by the RenderStateCache
+        size_t stateCallsIssued = 0,
+               stateCallsSkipped = 0;
+               
+        // threads used for submitRenderer & the time it took (ms)
+        size_t submitThreads = 0;
+        float submitTime = 0.f;
+        
+        // bytes of per frame data in the frame arena & the most any frame has used
+        size_t frameMemory = 0,
+               frameMemoryHighWater = 0;
+               
+        // light indices in the cluster grid & the time to build it (ms), 0 without clustered lights
+        size_t clusteredLightIndices = 0;
+        float lightClusterTime = 0.f;
+        
+        // the part of the g-buffer that was rendered to, 1 without dynamic resolution
+        float renderScale = 1.f;
+        
+        // bytes of the frame graph's render targets, & what they would be without aliasing
+        size_t renderTargetMemory = 0,
+               unaliasedRenderTargetMemory = 0;
     };
     
 public:
     Renderer( Root *root );
     ~Renderer();
     
+    // records the scene, it's rendered right away or on the render thread when one is set
     void renderScene( Scene *scene, Camera *camera );
     
+    // while set, everything recorded is rendered on the render thread & uniforms acquired
+    // on the main thread are staged in cpu memory until the frame is rendered
+    void setRenderThread( RenderThread *renderThread ) {
+        mRenderThread = renderThread;
+    }
+    
+    // binds a buffer from aquireUniformBuffer (or getSceneUniforms), renderables
+    // should use this since the buffer may have been staged
+    void bindUniformBuffer( GLuint index, const UniformBuffer &buffer );
+    
+    // the add functions & aquireUniformBuffer are called from worker threads while
+    // the objects are submitted, they must not touch gl or the allocator directly there
     void addMesh( const SharedPtr<Mesh> &mesh, const DeferredMaterial &material, const glm::mat4 &modelMatrix );
-    void addPointLight( UniformBuffer uniforms, const glm::mat4 &modelMatrix, const glm::vec3 &position, float radius, bool shadows );
+    // 'owner' identifies the light between frames so its shadow map can be cached, nullptr renders it every frame
+    void addPointLight( const PointLightUniforms &uniforms, const glm::mat4 &modelMatrix, const glm::vec3 &position, float radius, bool shadows, const void *owner = nullptr );
     void addCustomRenderable( const CustomRenderableSettings &settings );
     
     void addShadowMesh( const SharedPtr<Mesh> &mesh, const glm::mat4 &modelMatrix );
     
-    void render();
-    
     UniformBuffer aquireUniformBuffer( size_t size );
     
     UniformBuffer getSceneUniforms() {
@@ -107,15 +183,85 @@ public:
     bool getUseOcclusionQuarries() {
         return mUseOcclusionQuaries;
     }
+    // needs the instanced program in the resource pack
+    void setUseInstancing( bool useInstancing ) {
+        mUseInstancing = useInstancing;
+    }
+    bool getUseInstancing() {
+        return mUseInstancing;
+    }
+    bool isInstancingSupported() {
+        return mDeferred.entityInstancedProgram != nullptr;
+    }
+    // only used together with instancing
+    void setUseMultiDrawIndirect( bool useMultiDrawIndirect ) {
+        mUseMultiDrawIndirect = useMultiDrawIndirect;
+    }
+    bool getUseMultiDrawIndirect() {
+        return mUseMultiDrawIndirect;
+    }
+    bool isMultiDrawIndirectSupported() {
+        return mIndirect.supported;
+    }
+    void setUseParallelSubmission( bool useParallelSubmission ) {
+        mUseParallelSubmission = useParallelSubmission;
+    }
+    bool getUseParallelSubmission() {
+        return mUseParallelSubmission;
+    }
+    // lights without shadows are binned into clusters on the cpu & shaded in one full screen pass,
+    // needs the clustered light program in the resource pack
+    void setUseClusteredLights( bool useClusteredLights ) {
+        mUseClusteredLights = useClusteredLights;
+    }
+    bool getUseClusteredLights() {
+        return mUseClusteredLights;
+    }
+    bool isClusteredLightsSupported() {
+        return (bool)mClustered.program;
+    }
+    // the ssao passes are added to the frame graph, without it the ambient light isn't occluded
+    void setUseSSAO( bool useSSAO ) {
+        mUseSSAO = useSSAO;
+    }
+    bool getUseSSAO() {
+        return mUseSSAO;
+    }
+    // shadow maps are only re-rendered when the light or a caster moved, as long as they fit in the cache
+    void setUseShadowMapCache( bool useShadowMapCache ) {
+        mShadows.useCache = useShadowMapCache;
+    }
+    bool getUseShadowMapCache() {
+        return mShadows.useCache;
+    }
+    // the g-buffer is rendered at a lower resolution when the gpu is over the target time,
+    // the copy to the window scales it up
+    void setUseDynamicResolution( bool useDynamicResolution );
+    bool getUseDynamicResolution() {
+        return mUseDynamicResolution;
+    }
+    // the gpu time (ms) of a finished frame, drives the dynamic resolution, each time is only added once
+    void addGpuFrameTime( float gpuTime );
+    
+    // custom renderables can time their own passes with it, only from render
+    GpuPassTimer* getPassTimer() {
+        return mPassTimer;
+    }
+    RenderStateCache* getStateCache() {
+        return mStateCache;
+    }
     
+    // from the last rendered frame
     RendererStatistics getStatistics() {
+        std::lock_guard<std::mutex> lock( mStatisticsMutex );
         return mPrevFrameStatistics;
     }
-    const ValueHistory<float>& getMemoryUsageHistory() {
+    ValueHistory<float> getMemoryUsageHistory() {
+        std::lock_guard<std::mutex> lock( mStatisticsMutex );
         return mMemUsageHistory;
     }
     
-    
+    // only replaced by rebuildFrameGraph, while the main thread waits, so they can be read while recording
     SharedPtr<Texture> getGBufferNormalTexture() {
         return mGBuffer.normalTexture;
     }
@@ -135,14 +281,36 @@ private:
     void initShadows();
     void initOther();
     
+    // the textures & framebuffers of the passes are made here, they change with the ssao
+    void buildFrameGraph( bool useSSAO );
+    // from the main thread, blocks until the render thread has rebuilt it
+    void rebuildFrameGraph( bool useSSAO );
+    SharedPtr<Texture> createTransientTexture( const FrameGraphTextureDesc &desc );
+    
+    struct FrameData;
+    struct PointLightInfo;
+    
+    FrameData* getRecordFrame();
+    void renderFrame( FrameData *frame );
+    void resetFrame( FrameData *frame );
+    void uploadStagedUniforms();
+    void relocateUniforms( UniformBuffer &buffer );
+    
+    void render();
     void renderDeferred();
+    void renderSSAOScene();
     void renderSSAO();
+    void renderSSAOBlur();
     void renderLights();
+    void renderClusteredLights();
     void renderOther();
     void renderCustom();
     void renderWireframes();
     
-    void drawMesh( const SharedPtr<Mesh> &mesh );
+    void drawMesh( Mesh *mesh );
+    void bindMesh( Mesh *mesh );
+    void bindTexture( TextureHandle texture, int unit );
+    void drawSubMeshes( Mesh *mesh );
     void setBlendMode( BlendMode mode );
     void bindUniforms( GLuint index, const UniformBuffer &buffer ) {
         bindUniforms( index, buffer.getBuffer(), buffer.getOffset(), buffer.getSize() );
@@ -152,18 +320,52 @@ private:
     
     void prepereShadowCasters();
     void renderPointLightShadowMap( unsigned int first, unsigned int last );
+    void cullShadowCasterFaces( PointLightInfo &light );
+    SharedPtr<Texture> createShadowMapTexture();
     
     void quaryForObjects( const Frustrum &frustrum );
     
+    void submitObjects();
+    void mergeSubmitLists();
+    
+    void buildLightClusters( Camera *camera );
+    void sortEntities();
+    void sortCustomRenderables();
+    bool useInstancing();
+    void allocateEntityUniforms();
+    void buildInstanceGroups();
+    bool buildIndirectCommands();
+    void drawSubMeshesInstanced( Mesh *mesh, GLsizei instanceCount );
+    
 private:
+    // the per draw data holds handles instead of SharedPtr's so recording a draw
+    // doesn't touch any reference counts, they are resolved when the frame is rendered
     struct EntityInfo {
-        SharedPtr<Mesh> mesh;
+        MeshHandle mesh;
+        glm::mat4 modelMatrix;
+        // only allocated when the entities isn't drawn instanced
         GLuint buffer, offset;
         
-        DeferredMaterial material;
+        TextureHandle diffuseTexture,
+                      normalMap;
+        UInt64 sortKey;
+    };
+    struct SortEntry {
+        UInt64 key;
+        UInt32 index;
+    };
+    struct InstanceGroup {
+        // range in mEntityOrder, also the range in the instance buffer
+        UInt32 first, count;
     };
     struct ShadowMeshInfo {
-        SharedPtr<Mesh> mesh;
+        MeshHandle mesh;
+        glm::mat4 modelMatrix;
+        // in world space, the faces are culled while recording & the mesh can't be resolved there
+        BoundingSphere bounds;
+        // the cube faces the mesh touches
+        UInt32 faceMask;
+        // only aquired if the shadow map is rendered this frame
         UniformBuffer buffer;
     };
     
@@ -171,31 +373,126 @@ private:
         UniformBuffer uniforms, shadowUniform;
         unsigned int firstShadowCaster, lastShadowCaster;
         
-        glm::mat4 viewProjMatrix;
+        const void *owner;
+        // slot in the shadow map cache, the shared map is used for ShadowMapCache::NO_SLOT
+        UInt32 shadowSlot;
+        bool renderShadowMap;
+        
+        // the shadow faces are oriented by the whole transform, not only the position
+        glm::mat4 modelMatrix, viewProjMatrix;
         glm::vec3 position;
         float radius;
+        
+        // one per cube face, same order as PointLightShadowUniforms::viewProjMatrix
+        Frustrum faceFrustrums[6];
     };
     struct PointLightNoShadowInfo {
         UniformBuffer uniforms;
     };
     
+    // what a worker thread submitted, merged into the frame after the submission
+    struct SubmitList {
+        std::vector<EntityInfo> entities;
+        std::vector<PointLightInfo> pointLights;
+        std::vector<PointLightNoShadowInfo> pointLightsNoShadow;
+        std::vector<LightClusterBuilder::Light> clusterLights;
+        std::vector<ClusteredPointLight> clusteredPointLights;
+        std::vector<CustomRenderableSettings> customRenderables;
+        
+        size_t staticBatches = 0,
+               mergedDraws = 0;
+    };
+    
+    // everything recorded for one renderScene
+    struct FrameData {
+        FrameData() :
+            entities(FrameArenaAllocator<EntityInfo>(&arena)),
+            entityOrder(FrameArenaAllocator<SortEntry>(&arena)),
+            sortBuffer(FrameArenaAllocator<SortEntry>(&arena)),
+            customRenderables(FrameArenaAllocator<CustomRenderableSettings>(&arena)),
+            customOrder(FrameArenaAllocator<SortEntry>(&arena)),
+            pointLights(FrameArenaAllocator<PointLightInfo>(&arena)),
+            pointLightsNoShadow(FrameArenaAllocator<PointLightNoShadowInfo>(&arena)),
+            shadowMeshes(FrameArenaAllocator<ShadowMeshInfo>(&arena)),
+            clusterLights(FrameArenaAllocator<LightClusterBuilder::Light>(&arena)),
+            clusteredPointLights(FrameArenaAllocator<ClusteredPointLight>(&arena))
+        {}
+        
+        // the lists below live in the arena, it's reset once the frame is rendered
+        FrameArena arena;
+        
+        FrameVector<EntityInfo> entities;
+        // draw order for entities, sorted by EntityInfo::sortKey
+        FrameVector<SortEntry> entityOrder,
+                               sortBuffer;
+        // in submission order, customOrder is the render order
+        FrameVector<CustomRenderableSettings> customRenderables;
+        FrameVector<SortEntry> customOrder;
+        
+        FrameVector<PointLightInfo> pointLights;
+        FrameVector<PointLightNoShadowInfo> pointLightsNoShadow;
+        FrameVector<ShadowMeshInfo> shadowMeshes;
+        
+        // with clustered lights the lights without shadows are added here instead,
+        // clusterLights[i] is the bounds of clusteredPointLights[i]
+        bool useClusteredLights = false;
+        FrameVector<LightClusterBuilder::Light> clusterLights;
+        FrameVector<ClusteredPointLight> clusteredPointLights;
+        LightClusterBuilder lightClusters;
+        UniformBuffer clusterUniforms;
+        
+        // the part of the g-buffer the frame is rendered to
+        glm::uvec2 renderSize;
+        bool useSSAO = false;
+        
+        // the settings the frame is rendered with, the debug ui changes them on the main thread
+        bool useInstancing = false,
+             useMultiDrawIndirect = false,
+             useOcclusionQuaries = false,
+             renderWireframe = false;
+             
+        UniformBuffer sceneUniforms, 
+                      ambientUniforms;
+        SharedPtr<Texture> skybox;
+        
+        // [0] is used by the main thread when there is a render thread,
+        // [n] by worker thread n while the objects are submitted
+        std::vector<UniformStagingBuffer*> uniforms;
+        
+        // the submission statistics
+        RendererStatistics statistics;
+        
+        // true from the recording until the frame is rendered
+        std::atomic<bool> pending{false};
+    };
+    
 private:
     Root *mRoot;
+    // set as the device while the renderer lives, in front of the one it was created with
+    RenderStateCache *mStateCache;
+    RenderDevice *mDevice;
     UniformBufferAllocator *mAllocator;
+    RenderThread *mRenderThread = nullptr;
+    GpuPassTimer *mPassTimer;
+    
+    // reused once rendered, a new frame is only created when all of them are waiting to be rendered
+    std::vector<FrameData*> mFrames;
+    // the frame being recorded (main thread) & the frame being rendered
+    FrameData *mRecordFrame = nullptr,
+              *mFrame = nullptr;
+              
+    // used while recording
     Scene *mCurrentScene = nullptr;
     Camera *mCurrentCamera = nullptr;
     
-    std::vector<SceneObject*> mQuaryResult;
-    std::vector<EntityInfo> mEntities;
-    std::vector<CustomRenderableSettings> mCustomRenderable;
+    // valid until the scene is updated, the objects are submitted with the transforms in the entries
+    std::vector<const SceneSnapshot::ObjectEntry*> mQuaryResult;
+    glm::mat4 mSortViewMatrix;
+    float mSortDepthScale = 0.f;
     
-    std::vector<PointLightInfo> mPointLights;
-    std::vector<PointLightNoShadowInfo> mPointLightsNoShadow;
-    
-    std::vector<ShadowMeshInfo> mShadowMeshes;
-    
-    UniformBuffer mSceneUniforms, 
-                  mAmbientUniforms;
+    WorkerPool *mWorkerPool;
+    // one per worker thread, the main thread adds directly to the frame
+    std::vector<SubmitList> mSubmitLists;
     
     struct { // GBuffer data
         SharedPtr<FrameBuffer> framebuffer,
@@ -221,14 +518,16 @@ private:
                            randTexture,
                            ssaoTexture,
                            ssaoBlured;
-                           
-        
+        // white, bound instead of the blured ssao when it's off
+        SharedPtr<Texture> noOcclusionTexture;
                            
         glm::uvec2 frameBufferSize;
     } mSSAO;
     
     struct { // Deferred data
         SharedPtr<GpuProgram> entityDeferredProgram,
+                              entityInstancedProgram,
+                              entityIndirectProgram,
                               pointLightProgram,
                               pointLightNoShadowProgram,
                               ambientLightProgram,
@@ -238,6 +537,31 @@ private:
         SharedPtr<Mesh> sphereMesh;
     } mDeferred;
     
+    struct { // Clustered light data
+        SharedPtr<GpuProgram> program;
+        SharedPtr<GpuBuffer> lightBuffer,
+                             clusterBuffer,
+                             indexBuffer;
+    } mClustered;
+    
+    struct { // Instancing data
+        SharedPtr<GpuBuffer> matrixBuffer;
+        std::vector<glm::mat4> matrices;
+        std::vector<InstanceGroup> groups;
+        
+        GLint instanceOffsetLocation = -1;
+    } mInstancing;
+    
+    struct { // Multi draw indirect data
+        IndirectCommandBuilder builder;
+        SharedPtr<GpuBuffer> commandBuffer,
+                             drawDataBuffer;
+                             
+        GLint drawOffsetLocation = -1;
+        bool supported = false,
+             useThisFrame = false;
+    } mIndirect;
+    
     struct {
         SharedPtr<GpuProgram> pointLightShadowCasterProgram;
         SharedPtr<Texture> pointLightShadowTexture;
@@ -245,6 +569,13 @@ private:
         SharedPtr<FrameBuffer> pointLightShadowFrameBuffer;
         
         glm::uvec2 frameBufferSize;
+        
+        // the slots are handed out while recording, the maps are created by the render side
+        // the first time a slot is rendered
+        ShadowMapCache cache;
+        std::vector<SharedPtr<Texture>> cachedTextures;
+        std::vector<SharedPtr<FrameBuffer>> cachedFrameBuffers;
+        bool useCache = true;
     } mShadows;
     
     struct {
@@ -253,10 +584,24 @@ private:
         SharedPtr<Mesh> cubeMesh;
     } mOther;
     
+    // the render targets (except the cached shadow maps) are transient textures in the graph,
+    // mFrameGraphTextures are the textures they are aliased onto
+    FrameGraph mFrameGraph;
+    std::vector<SharedPtr<Texture>> mFrameGraphTextures;
+    bool mFrameGraphSSAO = false;
+    
     glm::uvec2 mWindowSize;
     
     bool mRenderWireframe = false,
-         mUseOcclusionQuaries = false;
+         mUseOcclusionQuaries = false,
+         mUseInstancing = true,
+         mUseMultiDrawIndirect = true,
+         mUseParallelSubmission = true,
+         mUseClusteredLights = false,
+         mUseDynamicResolution = false,
+         mUseSSAO = false;
+         
+    DynamicResolution mDynamicResolution;
     
     std::vector<GLuint> mOcclusionQuaries;
         
@@ -264,4 +609,6 @@ private:
                        mPrevFrameStatistics;
                        
     ValueHistory<float> mMemUsageHistory;
+    // guards mPrevFrameStatistics & mMemUsageHistory, they are written by the render thread
+    std::mutex mStatisticsMutex;
 };
\ No newline at end of file
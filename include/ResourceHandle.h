@@ -0,0 +1,188 @@
+#pragma once
+
+#include "FixedSizeTypes.h"
+#include "SharedPtr.h"
+
+#include <vector>
+#include <mutex>
+#include <cassert>
+
+class Mesh;
+class Texture;
+class GpuProgram;
+class VertexArrayObject;
+class GpuBuffer;
+
+/** struct ResourceHandle
+ *      32 bit reference to a resource, the low 20 bits are a slot in the HandleTable
+ *      for the type & the high 12 bits the generation the slot had when the handle was made.
+ *      The slot gets a new generation when the resource is destroyed, so an old handle
+ *      resolves to nullptr instead of whatever reuses the slot.
+ *      The default handle is null, it never resolves to anything.
+ */
+template< typename Type >
+struct ResourceHandle {
+    UInt32 value = 0;
+    
+    explicit operator bool () const {
+        return value != 0;
+    }
+    
+    friend bool operator == ( const ResourceHandle &h1, const ResourceHandle &h2 ) {
+        return h1.value == h2.value;
+    }
+    friend bool operator != ( const ResourceHandle &h1, const ResourceHandle &h2 ) {
+        return h1.value != h2.value;
+    }
+};
+
+typedef ResourceHandle<Mesh> MeshHandle;
+typedef ResourceHandle<Texture> TextureHandle;
+typedef ResourceHandle<GpuProgram> GpuProgramHandle;
+typedef ResourceHandle<VertexArrayObject> VertexArrayHandle;
+typedef ResourceHandle<GpuBuffer> GpuBufferHandle;
+
+/** class HandleTable
+ *      Dense table of the live resources of one type, the resources adds themselves
+ *      when they are created & removes themselves when they are destroyed. It doesn't
+ *      own anything, the ResourceManager (or whoever holds the SharedPtr) does.
+ *      The resources are created & destroyed on the main thread while the render thread
+ *      resolves the handles of the frame it draws, so Add, Remove & Resolve locks the table.
+ *      A resolved pointer is only safe to use while the table stays locked, the renderer
+ *      holds a ResourceTablesLock around each pass it draws & resolves with Get, which
+ *      doesn't lock again. A resource destroyed meanwhile blocks in Remove until the pass is done.
+ */
+template< typename Type >
+class HandleTable {
+public:
+    static const UInt32 INDEX_BITS = 20,
+                        INDEX_MASK = (1u << INDEX_BITS) - 1,
+                        GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+                        
+public:
+    static ResourceHandle<Type> Add( Type *resource ) {
+        assert( resource != nullptr );
+        std::lock_guard<std::recursive_mutex> lock( sTable.mMutex );
+        
+        UInt32 index;
+        if( !sTable.mFreeSlots.empty() ) {
+            index = sTable.mFreeSlots.back();
+            sTable.mFreeSlots.pop_back();
+        }
+        else {
+            index = sTable.mSlots.size();
+            assert( index <= INDEX_MASK && "out of resource handles" );
+            
+            // generation 0 is never used, so the null handle can't resolve
+            Slot slot;
+                slot.resource = nullptr;
+                slot.generation = 1;
+            sTable.mSlots.push_back( slot );
+        }
+        
+        Slot &slot = sTable.mSlots[index];
+        slot.resource = resource;
+        
+        ResourceHandle<Type> handle;
+            handle.value = (slot.generation << INDEX_BITS) | index;
+        return handle;
+    }
+    static void Remove( ResourceHandle<Type> handle ) {
+        std::lock_guard<std::recursive_mutex> lock( sTable.mMutex );
+        assert( Resolve(handle) != nullptr );
+        
+        UInt32 index = handle.value & INDEX_MASK;
+        Slot &slot = sTable.mSlots[index];
+        slot.resource = nullptr;
+        slot.generation++;
+        if( slot.generation > GENERATION_MASK ) {
+            slot.generation = 1;
+        }
+        sTable.mFreeSlots.push_back( index );
+    }
+    
+    // nullptr for a null handle or if the resource has been destroyed
+    static Type* Resolve( ResourceHandle<Type> handle ) {
+        std::lock_guard<std::recursive_mutex> lock( sTable.mMutex );
+        return sTable.find( handle );
+    }
+    // as Resolve, for the draw path, the calling thread must hold the table locked
+    static Type* Get( ResourceHandle<Type> handle ) {
+        assert( tLockDepth > 0 && "HandleTable::Get - the table isn't locked by this thread" );
+        return sTable.find( handle );
+    }
+    
+    // recursive, the thread holding it may still create & destroy resources
+    static void Lock() {
+        sTable.mMutex.lock();
+        tLockDepth++;
+    }
+    static void Unlock() {
+        assert( tLockDepth > 0 );
+        tLockDepth--;
+        sTable.mMutex.unlock();
+    }
+    
+private:
+    struct Slot {
+        Type *resource;
+        UInt32 generation;
+    };
+    
+private:
+    Type* find( ResourceHandle<Type> handle ) const {
+        UInt32 index = handle.value & INDEX_MASK;
+        if( index >= mSlots.size() ) {
+            return nullptr;
+        }
+        const Slot &slot = mSlots[index];
+        return (slot.generation == (handle.value >> INDEX_BITS)) ? slot.resource : nullptr;
+    }
+    
+private:
+    static HandleTable sTable;
+    // the number of times the calling thread has locked the table
+    static thread_local UInt32 tLockDepth;
+    
+    std::recursive_mutex mMutex;
+    std::vector<Slot> mSlots;
+    std::vector<UInt32> mFreeSlots;
+};
+
+template< typename Type >
+HandleTable<Type> HandleTable<Type>::sTable;
+template< typename Type >
+thread_local UInt32 HandleTable<Type>::tLockDepth = 0;
+
+/** class ResourceTablesLock
+ *      Locks the tables of every resource type, always in the same order, so the
+ *      resources resolved while it lives can't be removed from under the holder.
+ */
+class ResourceTablesLock {
+public:
+    ResourceTablesLock( const ResourceTablesLock& ) = delete;
+    ResourceTablesLock& operator = ( const ResourceTablesLock& ) = delete;
+    
+public:
+    ResourceTablesLock() {
+        HandleTable<Mesh>::Lock();
+        HandleTable<Texture>::Lock();
+        HandleTable<GpuProgram>::Lock();
+        HandleTable<VertexArrayObject>::Lock();
+        HandleTable<GpuBuffer>::Lock();
+    }
+    ~ResourceTablesLock() {
+        HandleTable<GpuBuffer>::Unlock();
+        HandleTable<VertexArrayObject>::Unlock();
+        HandleTable<GpuProgram>::Unlock();
+        HandleTable<Texture>::Unlock();
+        HandleTable<Mesh>::Unlock();
+    }
+};
+
+// null handle for a null pointer
+template< typename Type >
+ResourceHandle<Type> getResourceHandle( const SharedPtr<Type> &resource )
+{
+    return resource ? resource->getHandle() : ResourceHandle<Type>();
+}
@@ -12,6 +12,7 @@ class Texture;
 class Material;
 class GpuProgram;
 class Log;
+class StaticMeshBuffers;
 
 
 /** class ResourceManager
@@ -44,6 +45,11 @@ public:
     SharedPtr<Texture> getTextureAutoPack( const std::string &name );
     SharedPtr<Mesh> getMeshAutoPack( const std::string &name );
     
+    // where the static meshes puts their geometry
+    StaticMeshBuffers* getStaticMeshBuffers() {
+        return mStaticMeshBuffers;
+    }
+    
 private:
     void loadCompressedResourcePack( const std::string &name, const std::string &path );
     void loadUncompressedResourcePack( const std::string &name, const std::string &path );
@@ -66,4 +72,5 @@ private:
     Log *mLog;
     std::vector<std::string> mResourcePaths;
     ResourcePackMap mResourcePacks;
+    StaticMeshBuffers *mStaticMeshBuffers = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <cassert>
+#include <stddef.h>
+
+/** class RingAllocator
+ *      Bookkeeping for memory that's shared by the frames in flight, it only hands out
+ *      offsets so it doesn't know about gl (the UniformBufferAllocator owns the memory).
+ *      Allocations are made from the head & the memory used by a frame is kept until
+ *      'releaseFrame' is called for it, the owner does that once the gpu is done with
+ *      the frame. An allocation that doesn't fit before the end wraps to the start,
+ *      the skipped bytes are counted to the frame so they are freed with it.
+ */
+class RingAllocator {
+public:
+    static const size_t INVALID_OFFSET = ~size_t(0);
+    
+public:
+    RingAllocator( size_t size, size_t aligment ) :
+        mSize(size),
+        mAligment(aligment)
+    {
+        assert( aligment > 0 && size > 0 && size % aligment == 0 );
+    }
+    
+    // the offset of the memory, INVALID_OFFSET if it would overwrite a frame in flight
+    size_t allocate( size_t size )
+    {
+        if( mUsed == 0 ) {
+            // nothing in use, start over so big allocations don't have to wrap
+            mHead = 0;
+        }
+        
+        size_t offset = align( mHead );
+        if( offset + size > mSize ) {
+            offset = 0;
+        }
+        
+        // the bytes skipped for aligment or wrapping are used as well
+        size_t used = (offset >= mHead) ? (offset - mHead + size) : (mSize - mHead + size);
+        if( mUsed + used > mSize ) {
+            return INVALID_OFFSET;
+        }
+        
+        mHead = (offset + size) % mSize;
+        mUsed += used;
+        mFrameUsed += used;
+        
+        return offset;
+    }
+    
+    // the memory allocated since the last call belongs to a frame in flight now,
+    // returns the bytes it used
+    size_t endFrame()
+    {
+        size_t used = mFrameUsed;
+        mFrames.push_back( used );
+        mFrameUsed = 0;
+        
+        return used;
+    }
+    
+    // the oldest frame in flight is done, its memory can be reused
+    void releaseFrame()
+    {
+        assert( !mFrames.empty() && "RingAllocator::releaseFrame - no frame is in flight" );
+        
+        mUsed -= mFrames.front();
+        mFrames.pop_front();
+    }
+    
+    size_t getFramesInFlight() const {
+        return mFrames.size();
+    }
+    size_t getSize() const {
+        return mSize;
+    }
+    // by the frames in flight & the current frame
+    size_t getUsed() const {
+        return mUsed;
+    }
+    
+private:
+    size_t align( size_t offset ) const {
+        return ((offset + mAligment - 1) / mAligment) * mAligment;
+    }
+    
+private:
+    size_t mSize, mAligment;
+    
+    size_t mHead = 0,
+           mUsed = 0,
+           mFrameUsed = 0;
+    // bytes used by each frame in flight, oldest first
+    std::deque<size_t> mFrames;
+};
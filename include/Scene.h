@@ -9,6 +9,7 @@
 #include "SharedPtr.h"
 #include "UniquePtr.h"
 #include "BoundingSphere.h"
+#include "SceneSnapshot.h"
 
 class Texture;
 class Root;
@@ -32,7 +33,8 @@ public:
     
     void update( float dt );
     
-    void quarySceneObjects( const Frustrum &frustrum, std::vector<SceneObject*> &result );
+    // the entries stays valid until the next update
+    void quarySceneObjects( const Frustrum &frustrum, std::vector<const SceneSnapshot::ObjectEntry*> &result );
     
     void forEachObject( const std::function<void(SceneObject*)> &callback );
     
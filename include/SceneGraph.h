@@ -1,5 +1,8 @@
 #include "SceneNode.h"
+#include "SceneObjectPool.h"
+#include "SceneSnapshot.h"
 #include "UniquePtr.h"
+#include "FixedSizeTypes.h"
 
 #include <vector>
 #include <functional>
@@ -19,6 +22,9 @@ public:
     }
     
     void update( float dt );
+    // places the objects added since the last update into the graph,
+    // called by update but can be called directly after adding a lot of objects.
+    void insertNewObjects();
     
     void forEachObject( const std::function<void(SceneObject*)> &callback );
     void quaryObjects( const Frustrum &frustrum, std::vector<SceneObject*> &result );
@@ -26,11 +32,35 @@ public:
     SceneNode* getRootNode() {
         return mRootNode.get();
     }
+    SceneObjectPool* getObjectPool() {
+        return &mObjectPool;
+    }
+    // the snapshot published by the last update, it stays valid & unchanged
+    // until the end of the next update.
+    const SceneSnapshot* getSnapshot() {
+        return &mSnapshots[mFrontSnapshot];
+    }
     
 private:
+    // a node key is the path from the root to a node, 3 bits per level with
+    // the first level in the highest bits, followed by the level in the lowest bits.
+    // sorting by key places objects in the same subtree next to each other.
+    // 5 level bits & 19 levels of 3 bits uses 62 of the 64 bits, so a key can't reach deeper
+    // than 19 levels below the root. Objects smaller than the nodes on that level are kept in them.
+    typedef UInt64 NodeKey;
+    static const int NODE_KEY_LEVEL_BITS = 5,
+                     NODE_KEY_MAX_LEVEL = 19;
+                     
+    NodeKey getNodeKey( const BoundingSphere &bounds );
+    SceneNode* getOrCreateNodeForKey( NodeKey key );
     SceneNode* getOrCreateNodeForBound( const BoundingSphere &bounds );
     SceneNode* createChildrenForNode( SceneNode *node );
     void cleanEmptyNodes( SceneNode *node );
+    void updateTransforms( const std::vector<SceneObject*> &objects );
+    
+    void recordObjectChange( SceneObject *object, SceneNode *node );
+    void recordObjectRemoved( SceneObject *object );
+    void publishSnapshot();
     
     void quaryObjectsForNode( SceneNode *node, const Frustrum &frustrum, std::vector<SceneObject*> &result );
     void nodeFullyInsideFrustrum( SceneNode *node, std::vector<SceneObject*> &result );
@@ -48,6 +78,8 @@ private:
     
 private:
     Root *mRoot;
+    // holds the transform & bounds for all objects in the graph
+    SceneObjectPool mObjectPool;
     SceneNodePtr mRootNode;
     glm::vec3 mRootPosition;
     std::vector<SceneNode*> mSceneNodes;
@@ -55,6 +87,29 @@ private:
     
     std::vector<SceneObject*> mDirtyObjects,
                               mNewObjects;
+    std::vector<SceneObjectPool::Handle> mDirtyHandles;
+    
+    struct NewObjectInfo {
+        NodeKey key;
+        SceneObject *object;
+    };
+    std::vector<NewObjectInfo> mNewObjectInfos,
+                               mNewObjectSortBuffer;
+    std::vector<SceneObject*> mNodeObjects;
+    
+    // changes since the last publish, the changes from the publish before
+    // that is kept as well since the back snapshot hasn't seen them yet.
+    struct SnapshotObjectChange {
+        SceneObjectPool::Handle handle;
+        SceneSnapshot::ObjectEntry entry;
+    };
+    std::vector<SnapshotObjectChange> mObjectChanges,
+                                      mPrevObjectChanges;
+    std::vector<UInt32> mNodeChanges,
+                        mPrevNodeChanges;
+                        
+    SceneSnapshot mSnapshots[2];
+    int mFrontSnapshot = 0;
     
     int mMinNodeLevel = -2,
         mMaxNodeLevel;
@@ -4,6 +4,7 @@
 #include "SharedPtr.h"
 
 #include <map>
+#include <functional>
 
 class Scene;
 class Camera;
@@ -30,6 +31,7 @@ public:
     void addFactory( const std::string &type, SceneObjectFactory *factory, bool takeOwnership );
     void removeFactory( const std::string &type );
     SceneObjectFactory* getFactory( const std::string &type );
+    void forEachFactory( const std::function<void(const std::string&,SceneObjectFactory*)> &callback );
     
 private:
     struct SceneObjectFactoryInfo {
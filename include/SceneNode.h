@@ -1,8 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <stddef.h>
 
 #include "BoundingSphere.h"
+#include "SceneObjectPool.h"
 
 class SceneGraph;
 class SceneObject;
@@ -11,13 +13,16 @@ class SceneNode {
     friend class SceneGraph;
 public:
     
-    void _init( SceneGraph *graph, SceneNode *parent ) {
+    void _init( SceneGraph *graph, SceneNode *parent, unsigned int index ) {
         mGraph = graph;
         mParent = parent;
+        mIndex = index;
     }
     void _destroy();
     
     void addObject( SceneObject *object );
+    // adds several objects at once, cheaper than calling addObject for each
+    void addObjects( SceneObject *const *objects, size_t count );
     void removeObject( SceneObject *object );
     
     void update( float dt );
@@ -34,6 +39,10 @@ public:
     const BoundingSphere& getBounds() {
         return mBounds;
     }
+    // index of the node in the scene graph, stays the same for the lifetime of the node
+    unsigned int getIndex() {
+        return mIndex;
+    }
     
     // internal
     void _setChildren( SceneNode *children ) {
@@ -46,6 +55,8 @@ public:
 private:
     struct ObjectInfo {
         SceneObject *object = nullptr;
+        // the objects entry in the graphs object pool
+        SceneObjectPool::Handle handle = SceneObjectPool::INVALID_HANDLE;
         bool isDead = false;
         
         friend bool operator < ( const ObjectInfo &i1, const ObjectInfo &i2 ) {
@@ -66,6 +77,7 @@ private:
     SceneGraph *mGraph;
     // children must either be null, or pointing to an array with 8 entries
     SceneNode *mParent, *mChildren = nullptr;
+    unsigned int mIndex = 0;
     
     std::vector<ObjectInfo> mObjects;
     unsigned int mDeadObjectCount = 0;
@@ -5,6 +5,8 @@
 #include <glm/gtc/quaternion.hpp>
 
 #include "BoundingSphere.h"
+#include "SceneObjectPool.h"
+#include "SceneSnapshot.h"
 
 class SceneGraph;
 class SceneObjectFactory;
@@ -15,51 +17,65 @@ class Renderable;
 
 class SceneObject {
 public:
-    SceneObject( SceneObjectFactory *factory ) :
-        mFactory(factory)
-    {}
-    virtual ~SceneObject() = default;
+    SceneObject( SceneObjectFactory *factory );
+    virtual ~SceneObject();
+    
+    SceneObject( const SceneObject& ) = delete;
+    SceneObject( SceneObject&& ) = delete;
+    SceneObject& operator = ( const SceneObject& ) = delete;
+    SceneObject& operator = ( SceneObject&& ) = delete;
    
+    // runs on the main thread, gl work must go through GraphicsManager::runOnRenderThread
     virtual void update( float dt ) {}
     
-    virtual void submitRenderer( Renderer &renderer ) {}
-    virtual void submitShadowCasters( Renderer &renderer ) {}
+    // 'entry' is the object in the published snapshot, the transform is read from it
+    // since the submission can run on the workers while the main thread moves objects
+    virtual void submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry ) {}
+    virtual void submitShadowCasters( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry ) {}
     
     SceneObject* clone();
     
     void setPosition( const glm::vec3 &position ) {
-        mPosition = position;
+        mPool->setPosition( mHandle, position );
         markDirty();
     }
     void setOrientation( const glm::quat &orientation ) {
-        mOrientation = orientation;
+        mPool->setOrientation( mHandle, orientation );
+        markDirty();
+    }
+    // non uniform scale, applied before the orientation
+    void setScale( const glm::vec3 &scale ) {
+        mPool->setScale( mHandle, scale );
         markDirty();
     }
     void setRenderQueue( unsigned int queue ) {
         mRenderQueue = queue;
     }
     const glm::vec3& getPosition() {
-        return mPosition;
+        return mPool->getPosition( mHandle );
     }
     const glm::quat& getOrientation() {
-        return mOrientation;
+        return mPool->getOrientation( mHandle );
+    }
+    const glm::vec3& getScale() {
+        return mPool->getScale( mHandle );
     }
     const glm::mat4& getTransform() {
-        return mTransform;
+        return mPool->getTransform( mHandle );
     }
     unsigned int getRenderQueue() {
         return mRenderQueue;
     }
     
     void setBoundingSphere( const BoundingSphere &bounds ) {
-        mBoundingSphere = bounds;
+        mPool->setBoundingSphere( mHandle, bounds );
         mDirty = true;
     }
     const BoundingSphere& getBoundingSphere() {
-        return mBoundingSphere;
+        return mPool->getBoundingSphere( mHandle );
     }
     const BoundingSphere& getTransformedBoundingSphere() {
-        return mTransformedBoundingSphere;
+        return mPool->getTransformedBoundingSphere( mHandle );
     }
     
     bool isDirty() {
@@ -68,6 +84,18 @@ public:
     // updates the transform & takes the object from the dirty stage
     // don't call this manaly
     void _updateTransform();
+    // used by the scene graph after it has updated the transform in the pool
+    void _clearDirty() {
+        mDirty = false;
+    }
+    // moves the spatial state of the object into 'pool'
+    void _setPool( SceneObjectPool *pool );
+    SceneObjectPool* _getPool() {
+        return mPool;
+    }
+    SceneObjectPool::Handle _getHandle() {
+        return mHandle;
+    }
     void _setParent( SceneNode *node ) {
         mParent = node;
     }
@@ -97,13 +125,10 @@ private:
     SceneNode *mParent = nullptr;
     SceneObjectFactory *mFactory;
     
-    glm::vec3 mPosition;
-    glm::quat mOrientation;
-    
-    glm::mat4 mTransform;
+    // position, orientation, scale, transform & bounds lives in the pool
+    SceneObjectPool *mPool;
+    SceneObjectPool::Handle mHandle;
     
     unsigned int mRenderQueue = 0;
     bool mDirty = false, mAutoDelete = false;
-    BoundingSphere mBoundingSphere,
-                   mTransformedBoundingSphere;
 };
\ No newline at end of file
@@ -2,8 +2,21 @@
 
 #include <yaml-cxx/Node.h>
 
+#include "UniquePtr.h"
+#include "SharedPtr.h"
+#include "ObjectPool.h"
+
 class Root;
 class SceneObject;
+class DeferredEntity;
+class ComputeParticleSystem;
+class PointLight;
+class SpotLight;
+class RandomMovingObjects;
+class PulsingObject;
+class ComputeWater;
+class Mesh;
+struct DeferredMaterial;
 
 class SceneObjectFactory {
 public:
@@ -19,6 +32,11 @@ public:
     // this factory must have created the object
     virtual SceneObject* cloneObject( SceneObject *object ) = 0;
     virtual void destroyObject( SceneObject *object );
+    
+    // statistics for the pools the objects are allocated from
+    virtual ObjectPoolStatistics getPoolStatistics() {
+        return ObjectPoolStatistics();
+    }
 };
 
 
@@ -27,11 +45,19 @@ class DeferredEntityFactory :
 {
 public:
     DeferredEntityFactory( Root *root );
+    ~DeferredEntityFactory();
     virtual SceneObject* createObject( const Yaml::Node &node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    // for entities that doesn't come from a scene file, like the static batches
+    DeferredEntity* createEntity( const SharedPtr<Mesh> &mesh, const DeferredMaterial &material );
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<DeferredEntity>> mEntityPool;
 };
 
 class ComputeParticleFactory :
@@ -39,11 +65,16 @@ class ComputeParticleFactory :
 {
 public:
     ComputeParticleFactory( Root *root );
+    ~ComputeParticleFactory();
     virtual SceneObject* createObject( const Yaml::Node& node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<ComputeParticleSystem>> mParticleSystemPool;
 };
 
 class LightFactory :
@@ -51,11 +82,17 @@ class LightFactory :
 {
 public:
     LightFactory( Root *root );
+    ~LightFactory();
     virtual SceneObject* createObject( const Yaml::Node& node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<PointLight>> mPointLightPool;
+    UniquePtr<ObjectPool<SpotLight>> mSpotLightPool;
 };
 
 class RandomMovingObjectFactory :
@@ -63,11 +100,16 @@ class RandomMovingObjectFactory :
 {
 public:
     RandomMovingObjectFactory( Root *root );
+    ~RandomMovingObjectFactory();
     virtual SceneObject* createObject( const Yaml::Node& node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<RandomMovingObjects>> mObjectsPool;
 };
 
 class PulsingObjectFactory :
@@ -75,11 +117,16 @@ class PulsingObjectFactory :
 {
 public:
     PulsingObjectFactory( Root *root );
+    ~PulsingObjectFactory();
     virtual SceneObject* createObject( const Yaml::Node& node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<PulsingObject>> mPulsingObjectPool;
 };
 
 class ComputeWaterFactory :
@@ -87,10 +134,15 @@ class ComputeWaterFactory :
 {
 public:
     ComputeWaterFactory( Root *root );
+    ~ComputeWaterFactory();
     
     virtual SceneObject* createObject( const Yaml::Node& node ) override;
     virtual SceneObject* cloneObject( SceneObject *object ) override;
+    virtual void destroyObject( SceneObject *object ) override;
+    
+    virtual ObjectPoolStatistics getPoolStatistics() override;
     
 private:
     Root *mRoot;
+    UniquePtr<ObjectPool<ComputeWater>> mWaterPool;
 };
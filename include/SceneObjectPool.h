@@ -0,0 +1,112 @@
+#pragma once
+
+#include "BoundingSphere.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstddef>
+
+class SceneObject;
+
+/** class SceneObjectPool
+ *      Holds the spatial state of scene objects (position, orientation,
+ *      transform & bounds) in one contiguous array per field, so systems
+ *      that only care about transforms or bounds can walk them without
+ *      touching the objects themselves.
+ *      An object refers to its entry with a handle, the handle stays valid
+ *      until it's released. Released handles are reused by later allocations.
+ *      Every SceneGraph owns a pool, objects that isn't part of a graph
+ *      lives in the detached pool.
+ *      Transforms are updated in batches, 4 entries at a time with SSE when
+ *      it's available.
+ */
+class SceneObjectPool {
+public:
+    typedef unsigned int Handle;
+    static const Handle INVALID_HANDLE = ~0u;
+    
+    static SceneObjectPool* GetDetachedPool();
+    
+public:
+    SceneObjectPool() = default;
+    
+    SceneObjectPool( const SceneObjectPool& ) = delete;
+    SceneObjectPool( SceneObjectPool&& ) = delete;
+    SceneObjectPool& operator = ( const SceneObjectPool& ) = delete;
+    SceneObjectPool& operator = ( SceneObjectPool&& ) = delete;
+    
+    Handle allocate( SceneObject *owner );
+    void release( Handle handle );
+    
+    // moves the entry 'handle' from 'pool' into this pool,
+    // the old handle is released and the new handle is returned
+    Handle moveFrom( SceneObjectPool *pool, Handle handle );
+    
+    // recalculates the transform & transformed bounds for the entries
+    // the transform is translate * rotate * scale, the bounds radius is
+    // scaled by the largest scale axis
+    void updateTransforms( const Handle *handles, size_t count );
+    
+    void setPosition( Handle handle, const glm::vec3 &position ) {
+        mPositions[handle] = position;
+    }
+    void setOrientation( Handle handle, const glm::quat &orientation ) {
+        mOrientations[handle] = orientation;
+    }
+    void setScale( Handle handle, const glm::vec3 &scale ) {
+        mScales[handle] = scale;
+    }
+    void setBoundingSphere( Handle handle, const BoundingSphere &bounds ) {
+        mBounds[handle] = bounds;
+    }
+    
+    // references returned are valid until the next call to allocate
+    const glm::vec3& getPosition( Handle handle ) const {
+        return mPositions[handle];
+    }
+    const glm::quat& getOrientation( Handle handle ) const {
+        return mOrientations[handle];
+    }
+    const glm::vec3& getScale( Handle handle ) const {
+        return mScales[handle];
+    }
+    const glm::mat4& getTransform( Handle handle ) const {
+        return mTransforms[handle];
+    }
+    const BoundingSphere& getBoundingSphere( Handle handle ) const {
+        return mBounds[handle];
+    }
+    const BoundingSphere& getTransformedBoundingSphere( Handle handle ) const {
+        return mTransformedBounds[handle];
+    }
+    SceneObject* getOwner( Handle handle ) const {
+        return mOwners[handle];
+    }
+    
+    // number of slots, including released ones (their owner is null)
+    size_t getSize() const {
+        return mOwners.size();
+    }
+    size_t getLiveCount() const {
+        return mOwners.size() - mFreeHandles.size();
+    }
+    
+private:
+    void updateTransform( Handle handle );
+    void updateTransforms4( const Handle *handles );
+    
+private:
+    std::vector<SceneObject*> mOwners;
+    
+    std::vector<glm::vec3> mPositions,
+                           mScales;
+    std::vector<glm::quat> mOrientations;
+    std::vector<glm::mat4> mTransforms;
+    std::vector<BoundingSphere> mBounds,
+                                mTransformedBounds;
+    
+    std::vector<Handle> mFreeHandles;
+};
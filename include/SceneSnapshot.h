@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BoundingSphere.h"
+#include "SceneObjectPool.h"
+#include "FixedSizeTypes.h"
+
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+
+class SceneObject;
+class Frustrum;
+
+/** class SceneSnapshot
+ *      A read only copy of the scene graph's spatial state, the bounds of every
+ *      object & which node it belongs to, together with the node hierarchy.
+ *      The scene graph keeps two snapshots and publishes one of them at the
+ *      end of every update, queries against the published snapshot never touch
+ *      the graph, so they can run while the next update is in progress.
+ *      Objects are indexed by there handle in the graph's object pool.
+ *      The objects of each node are linked together, so a query walks down the
+ *      hierarchy, skips whole subtrees outside the frustrum & doesn't allocate.
+ *      The quaries returns the entries, the renderer submits the objects with
+ *      the transform in them instead of reading the object pool.
+ */
+class SceneSnapshot {
+public:
+    static const UInt32 INVALID_NODE = ~0u;
+    
+    struct ObjectEntry {
+        // null if the slot isn't used
+        SceneObject *object = nullptr;
+        glm::mat4 transform;
+        BoundingSphere bounds;
+        UInt32 node = INVALID_NODE;
+    };
+    struct NodeEntry {
+        BoundingSphere bounds;
+        // children are always created 8 at a time & stored after each other
+        UInt32 firstChild = INVALID_NODE;
+    };
+    
+public:
+    void quaryObjects( const Frustrum &frustrum, std::vector<const ObjectEntry*> &result ) const;
+    // every object, without culling
+    void getObjects( std::vector<const ObjectEntry*> &result ) const;
+    
+    size_t getObjectCount() const {
+        return mObjectCount;
+    }
+    size_t getNodeCount() const {
+        return mNodes.size();
+    }
+    
+    // used by the scene graph to bring the snapshot up to date
+    void _setObject( SceneObjectPool::Handle handle, const ObjectEntry &entry );
+    void _setNode( UInt32 index, const NodeEntry &entry );
+    
+private:
+    void quaryNode( UInt32 index, const Frustrum &frustrum, std::vector<const ObjectEntry*> &result ) const;
+    void addSubtree( UInt32 index, std::vector<const ObjectEntry*> &result ) const;
+    
+    void linkObject( SceneObjectPool::Handle handle, UInt32 node );
+    void unlinkObject( SceneObjectPool::Handle handle );
+    
+private:
+    std::vector<ObjectEntry> mObjects;
+    std::vector<NodeEntry> mNodes;
+    size_t mObjectCount = 0;
+    
+    // the objects of a node as a list, indexed by handle & node index
+    std::vector<SceneObjectPool::Handle> mNextInNode,
+                                         mPrevInNode,
+                                         mFirstInNode;
+};
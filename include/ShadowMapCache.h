@@ -0,0 +1,54 @@
+#pragma once
+
+#include "FixedSizeTypes.h"
+
+#include <vector>
+#include <unordered_map>
+#include <stddef.h>
+
+/** class ShadowMapCache
+ *      Keeps track of which light owns which of a fixed number of shadow map slots.
+ *      Every light that casts shadows asks for a slot each frame with a signature
+ *      of everything its shadow map depends on (light transform, radius & the casters
+ *      transforms), the map only has to be re-rendered if the signature changed or
+ *      the light got a new slot. When every slot is taken the least recently used
+ *      one is given away, slots used in the current frame are never evicted.
+ *      Only the bookkeeping lives here, the renderer owns the textures.
+ */
+class ShadowMapCache {
+public:
+    static const UInt32 NO_SLOT = ~UInt32(0);
+    
+    struct Request {
+        // NO_SLOT if every slot is already used this frame
+        UInt32 slot;
+        bool render;
+    };
+    
+public:
+    // drops everything cached
+    void setSlotCount( size_t slotCount );
+    size_t getSlotCount() const {
+        return mSlots.size();
+    }
+    
+    void beginFrame();
+    Request aquireSlot( const void *light, UInt64 signature );
+    
+    // FNV-1a, used to build the signatures
+    static UInt64 HashBytes( const void *data, size_t size, UInt64 hash = 14695981039346656037ull );
+    
+private:
+    struct Slot {
+        const void *light = nullptr;
+        UInt64 signature = 0,
+               lastUsed = 0;
+        bool valid = false;
+    };
+    
+private:
+    std::vector<Slot> mSlots;
+    std::unordered_map<const void*, UInt32> mLightSlots;
+    // starts at 1 so a free slot (lastUsed = 0) is always the oldest
+    UInt64 mFrame = 1;
+};
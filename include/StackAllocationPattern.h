@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+
+/** class StackAllocationPattern
+ *      Offsets for allocations in a range of 'size' bytes that are only freed all at once,
+ *      every allocation is put on top of the last one. It only does the bookkeeping,
+ *      the GpuBufferAllocator uses it for its gl buffers.
+ *      The aligment doesn't have to be a power of two, so a vertex buffer can be aligned
+ *      to the vertex size & the offset turned into a base vertex.
+ */
+class StackAllocationPattern {
+public:
+    explicit StackAllocationPattern( size_t size = 0 ) :
+        mSize(size)
+    {}
+    
+    // false if it doesn't fit, 'offset' is only set if it does
+    bool allocate( size_t size, size_t aligment, size_t &offset )
+    {
+        size_t start = ((mTop + aligment - 1) / aligment) * aligment;
+        if( start + size > mSize || start < mTop ) {
+            return false;
+        }
+        
+        offset = start;
+        mTop = start + size;
+        return true;
+    }
+    
+    // frees all allocations
+    void clear() {
+        mTop = 0;
+    }
+    
+    size_t getSize() const {
+        return mSize;
+    }
+    // including the padding for the aligment
+    size_t getUsed() const {
+        return mTop;
+    }
+    
+private:
+    size_t mSize,
+           mTop = 0;
+};
@@ -8,5 +8,8 @@ struct StartupMesurements {
           debugStartup = 0.f,
           resourceStartup = 0.f,
           sceneStartup = 0.f,
+          sceneLoad = 0.f,
+          sceneGraphBuild = 0.f,
+          staticBatching = 0.f,
           totalTime = 0.f;
 };
\ No newline at end of file
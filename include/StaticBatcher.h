@@ -0,0 +1,80 @@
+#pragma once
+
+#include "SharedPtr.h"
+#include "Mesh.h"
+
+#include <vector>
+#include <map>
+#include <stddef.h>
+
+class Root;
+class SceneObject;
+class DeferredEntity;
+class DeferredEntityFactory;
+class StaticMeshBuffers;
+
+static const float DEFAULT_STATIC_BATCH_CHUNK_SIZE = 32.f;
+// keeps a batch well within one of the static vertex buffers
+static const size_t MAX_STATIC_BATCH_VERTEXES = 1024*256;
+
+/** class StaticBatcher
+ *      Merges the static DeferredEntities of a scene when it's loaded, so a level with
+ *      thousands of entities doesn't need a draw for each of them.
+ *      The entities are grouped by material, render queue & if they cast shadows, & each
+ *      group is split by a grid of 'chunkSize' cubes (by the center of the entities bounds),
+ *      so the batches has bounds of their own & can still be culled.
+ *      The geometry of a chunk is moved to world space & put in the StaticMeshBuffers as one
+ *      mesh, drawn by a DeferredEntity without a transform. Only meshes in the shared buffers
+ *      are merged, their geometry is read back from the gpu.
+ *      With instancing enabled the entities that shares mesh & material with another one
+ *      are left as they are, the renderer already draws them with one instanced draw.
+ *      Entities with an empty mesh are never merged.
+ *      The merged entities are destroyed, so they mustn't have been added to a scene.
+ */
+class StaticBatcher {
+public:
+    StaticBatcher( const StaticBatcher& ) = delete;
+    StaticBatcher( StaticBatcher&& ) = delete;
+    StaticBatcher& operator = ( const StaticBatcher& ) = delete;
+    StaticBatcher& operator = ( StaticBatcher&& ) = delete;
+    
+public:
+    StaticBatcher( Root *root, float chunkSize = DEFAULT_STATIC_BATCH_CHUNK_SIZE );
+    
+    // the merged entities in 'objects' are replaced by the batches, the rest are left as they are
+    void batchObjects( std::vector<SceneObject*> &objects );
+    
+    size_t getBatchCount() {
+        return mBatchCount;
+    }
+    size_t getMergedEntities() {
+        return mMergedEntities;
+    }
+    
+private:
+    struct Geometry {
+        std::vector<Mesh::Vertex> vertexes;
+        std::vector<GLuint> indexes;
+    };
+    
+private:
+    bool canBatch( SceneObject *object );
+    const Geometry& getGeometry( Mesh *mesh );
+    
+    // the entities has the same material & all of them fits in one batch
+    DeferredEntity* mergeEntities( const std::vector<DeferredEntity*> &entities );
+    
+private:
+    Root *mRoot;
+    DeferredEntityFactory *mFactory;
+    StaticMeshBuffers *mStaticBuffers;
+    float mChunkSize;
+    // the config has instancing enabled
+    bool mSkipInstanced;
+    
+    // the meshes are shared by many entities, so they're only read back once
+    std::map<Mesh*,Geometry> mGeometry;
+    
+    size_t mBatchCount = 0,
+           mMergedEntities = 0;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "GpuBufferAllocator.h"
+#include "SharedPtr.h"
+#include "Mesh.h"
+
+#include <vector>
+#include <map>
+#include <utility>
+
+class VertexArrayObject;
+
+static const size_t DEFAULT_STATIC_VERTEX_BUFFER_SIZE = 1024*1024*32, // 32 MB, ~600k vertexes
+                    DEFAULT_STATIC_INDEX_BUFFER_SIZE = 1024*1024*16; // 16 MB, ~4M indexes
+                    
+/** class StaticMeshBuffers
+ *      The geometry of the static meshes, they share a few big vertex & index buffers
+ *      from GpuBufferAllocators (Mesh::Vertex & 32 bit indexes). Each pair of buffers
+ *      has one vao that also has the index buffer bound, the meshes in it are drawn with
+ *      a base vertex so switching between them doesn't bind anything.
+ *      Like the allocators the memory isn't given back when a mesh is destroyed,
+ *      the ResourceManager owns it & it's freed when the manager is destroyed.
+ */
+class StaticMeshBuffers {
+public:
+    struct Allocation {
+        SharedPtr<VertexArrayObject> vao;
+        GpuSubBuffer vertexes, indexes;
+        
+        // where the geometry begins, in vertexes & indexes
+        size_t baseVertex, firstIndex;
+    };
+    
+public:
+    StaticMeshBuffers( const StaticMeshBuffers& ) = delete;
+    StaticMeshBuffers( StaticMeshBuffers&& ) = delete;
+    StaticMeshBuffers& operator = ( const StaticMeshBuffers& ) = delete;
+    StaticMeshBuffers& operator = ( StaticMeshBuffers&& ) = delete;
+    
+public:
+    StaticMeshBuffers( size_t vertexBufferSize=DEFAULT_STATIC_VERTEX_BUFFER_SIZE, size_t indexBufferSize=DEFAULT_STATIC_INDEX_BUFFER_SIZE );
+    
+    // copies the geometry to the gpu, the indexes are relative to the first vertex
+    Allocation addGeometry( const std::vector<Mesh::Vertex> &vertexes, const std::vector<GLuint> &indexes );
+    // reads the geometry of a mesh in the shared buffers back, the indexes are relative to the first vertex.
+    // It waits for the gpu, so it's only for load time (the StaticBatcher)
+    void readGeometry( Mesh *mesh, std::vector<Mesh::Vertex> &vertexes, std::vector<GLuint> &indexes );
+    
+private:
+    const SharedPtr<VertexArrayObject>& getVAO( GLuint vertexBuffer, GLuint indexBuffer );
+    
+private:
+    GpuBufferAllocator mVertexAllocator,
+                       mIndexAllocator;
+                       
+    // (vertex buffer, index buffer) -> vao
+    std::map<std::pair<GLuint,GLuint>,SharedPtr<VertexArrayObject>> mVAOs;
+};
@@ -3,6 +3,7 @@
 
 #include "GLTypes.h"
 #include "SharedPtr.h"
+#include "ResourceHandle.h"
 
 #include <glm/vec2.hpp>
 
@@ -65,6 +66,9 @@ public:
     glm::uvec2 getSize() {
         return mSize;
     }
+    TextureHandle getHandle() {
+        return mHandle;
+    }
     
     bool isCubeMap();
     
@@ -74,6 +78,7 @@ private:
     GLuint mGLTexture;
     TextureType mType;
     glm::uvec2 mSize;
+    TextureHandle mHandle;
 };
 
 #endif
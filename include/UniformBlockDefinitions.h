@@ -22,6 +22,11 @@ struct SceneRenderUniforms {
     glm::vec3 cameraPosition;
     float _dummy1[1];
     
+    // the part of the g-buffer that's rendered to (DynamicResolution), full screen
+    // passes that reads the g-buffer must scale their texture coordinates by it
+    glm::vec2 renderScale;
+    float _dummy2[2];
+    
     static const UniformBlockLayout& GetUniformBlockLayout();
 };
 
@@ -67,6 +72,23 @@ struct BoxLightUniforms {
     static const UniformBlockLayout& GetUniformBlockLayout();
 };
 
+// std430 layout, one per light in the clustered light pass
+struct ClusteredPointLight {
+    glm::vec3 position; // view space
+    float intensity;
+    glm::vec3 color;
+    float innerRadius;
+    float outerRadius;
+    float dummy0[3];
+};
+
+struct ClusteredLightUniforms {
+    glm::uvec4 gridSize; // x,y = tiles, z = depth slices
+    glm::vec2 tileSize; // in pixels
+    // slice = floor(log(view depth)*x + y)
+    glm::vec2 sliceScaleBias;
+};
+
 struct PointLightShadowUniforms {
     glm::mat4 viewProjMatrix[6];
     glm::vec3 lightPosition;
@@ -76,5 +98,8 @@ struct PointLightShadowUniforms {
 
 struct ShadowCasterUniforms {
     glm::mat4 modelMatrix;
+    // bit i is set if the caster touches cube face i, the shader can skip the other faces
+    unsigned int faceMask;
+    unsigned int dummy0[3];
 };
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "GLTypes.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cassert>
+#include <stddef.h>
+
+/** class UniformBlockRegion
+ *      A region of uniform memory set aside for a frame, handed out in blocks to the threads
+ *      writing uniforms with a single atomic add per block. It only keeps the offsets so
+ *      it doesn't know about gl (the UniformBufferAllocator reserves the memory).
+ *      The cursor keeps counting after the region is used up & when it's cleared, so the
+ *      next region can be sized from how much this one was asked for.
+ */
+class UniformBlockRegion {
+public:
+    struct Block {
+        GLuint buffer = 0;
+        size_t offset = 0;
+        // nullptr when the region is used up
+        void *memory = nullptr;
+    };
+    
+public:
+    UniformBlockRegion( size_t aligment ) :
+        mAligment(aligment)
+    {
+        assert( aligment > 0 );
+    }
+    
+    // 'size' must be aligned, must not be called while blocks are aquired
+    void reserve( GLuint buffer, size_t offset, void *memory, size_t size )
+    {
+        assert( size > 0 && size % mAligment == 0 );
+        mBuffer = buffer;
+        mOffset = offset;
+        mMemory = (char*)memory;
+        mSize = size;
+        mCursor = 0;
+    }
+    // nothing is reserved after this, the cursor is kept
+    void clear()
+    {
+        mSize = 0;
+    }
+    
+    // thread safe, a block of at least 'size' bytes
+    Block aquireBlock( size_t size )
+    {
+        size = align( size );
+        size_t offset = mCursor.fetch_add( size );
+        
+        Block block;
+        if( offset + size <= mSize ) {
+            block.buffer = mBuffer;
+            block.offset = mOffset + offset;
+            block.memory = mMemory + offset;
+        }
+        return block;
+    }
+    
+    bool isReserved() const {
+        return mSize != 0;
+    }
+    GLuint getBuffer() const {
+        return mBuffer;
+    }
+    size_t getSize() const {
+        return mSize;
+    }
+    // bytes asked for since the region was reserved, can be more than the size
+    size_t getAsked() const {
+        return mCursor.load();
+    }
+    // bytes of the region that wasn't handed out
+    size_t getUnused() const {
+        return mSize - std::min( mCursor.load(), mSize );
+    }
+    
+private:
+    size_t align( size_t size ) const {
+        return ((size + mAligment - 1) / mAligment) * mAligment;
+    }
+    
+private:
+    size_t mAligment;
+    
+    GLuint mBuffer = 0;
+    size_t mOffset = 0;
+    char *mMemory = nullptr;
+    size_t mSize = 0;
+    std::atomic<size_t> mCursor{0};
+};
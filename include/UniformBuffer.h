@@ -29,6 +29,9 @@ public:
     GLuint getOffset() const {
         return mOffset;
     }
+    void* getMemory() const {
+        return mMemory;
+    }
     
 private:
     GLuint mBuffer = 0,
@@ -1,16 +1,46 @@
 #pragma once
 
 #include <vector>
+#include <deque>
+#include <atomic>
+#include <algorithm>
 
 #include "SharedPtr.h"
 #include "GLinclude.h"
+#include "RenderDevice.h"
+#include "RingAllocator.h"
+#include "UniformBlockRegion.h"
 
 
 // static const size_t DEFAULT_UNIFORM_BUFFER_SIZE = 524288, // 0.5 MB
 static const size_t DEFAULT_UNIFORM_BUFFER_SIZE = 1024*128, // 128 KB
                     DEFAULT_UNIFORM_BUFFER_CLEAN_UP_TIME = 100; // to clean up unused buffers every 100 frame seems resonable
 
+static const size_t DEFAULT_UNIFORM_RING_FRAME_SIZE = 1024*512, // 0.5 MB
+                    DEFAULT_UNIFORM_FRAMES_IN_FLIGHT = 3,
+                    MIN_UNIFORM_BLOCK_REGION_SIZE = 1024*64; // 64 KB
 
+// ns, how long to wait on a fence before checking it again
+static const UInt64 UNIFORM_FENCE_WAIT_TIMEOUT = 1000000000;
+
+
+/** class UniformBufferAllocator
+ *      Hands out memory for uniforms that's written by the cpu & read by the gpu in the same frame.
+ *      With ARB_buffer_storage it's one persistent & coherent mapped buffer that's used as a ring,
+ *      big enough for 'framesInFlight' frames. It's never unmapped, instead a fence is placed at
+ *      the end of each frame & the ring memory of the frame is reused once its fence is signaled.
+ *      The offsets are handed out by a RingAllocator, it doesn't know about gl.
+ *      If a frame doesn't fit the ring waits for the gpu, if it still doesn't fit with no frame
+ *      in flight the ring is replaced with one twice as big.
+ *      Other threads can't use getMemory, instead 'reserveBlocks' sets aside a region of the ring
+ *      for the frame & the UniformBlockRegion hands out blocks of it with a single atomic add, the
+ *      threads then allocate from their own block. The region is sized from how much the last one
+ *      was asked for, so the frame after one that ran out gets a bigger one.
+ *      The region has to be reserved where getMemory is used before the frame is recorded, so
+ *      with a render thread (the frames are recorded ahead on the main thread) blocks aren't used.
+ *      Without ARB_buffer_storage the buffers are mapped on the first use in a frame & unmapped
+ *      in 'flush', a new buffer is made when none have room left. Blocks can't be used then.
+ */
 class UniformBufferAllocator {
 public:
     UniformBufferAllocator( const UniformBufferAllocator& ) = delete;
@@ -26,28 +56,51 @@ public:
     };
     
 public:
-    UniformBufferAllocator( size_t defaultBufferSize=DEFAULT_UNIFORM_BUFFER_SIZE, size_t unusedCleanupTime=DEFAULT_UNIFORM_BUFFER_CLEAN_UP_TIME ) :
+    UniformBufferAllocator( size_t defaultBufferSize=DEFAULT_UNIFORM_BUFFER_SIZE, size_t unusedCleanupTime=DEFAULT_UNIFORM_BUFFER_CLEAN_UP_TIME,
+                            size_t ringFrameSize=DEFAULT_UNIFORM_RING_FRAME_SIZE, size_t framesInFlight=DEFAULT_UNIFORM_FRAMES_IN_FLIGHT ) :
+        mDevice(RenderDevice::GetDevice()),
         mDefaultBufferSize(defaultBufferSize),
-        mUnusedCleanupTime(unusedCleanupTime)
+        mUnusedCleanupTime(unusedCleanupTime),
+        mFramesInFlight(framesInFlight),
+        mAligment(mDevice->getInteger(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)),
+        mRing(alignSize(ringFrameSize*framesInFlight), mAligment),
+        mBlocks(mAligment)
     {
-        GLint aligment;
-        glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &aligment );
-        mAligment = aligment;
+        mPersistent = GLEW_ARB_buffer_storage;
+        if( mPersistent ) {
+            createRing( mRing.getSize() );
+        }
     }
     
     ~UniformBufferAllocator()
     {
+        if( mPersistent ) {
+            for( FrameInFlight &frame : mFrames ) {
+                mDevice->deleteSync( frame.fence );
+                mRetiredBuffers.insert( mRetiredBuffers.end(), frame.retiredBuffers.begin(), frame.retiredBuffers.end() );
+            }
+            // deleting a buffer unmaps it
+            mRetiredBuffers.push_back( mRingBuffer );
+            for( GLuint buffer : mRetiredBuffers ) {
+                mDevice->deleteBuffer( buffer );
+            }
+        }
+        
         for( BufferInfo &info : mBuffers ) {
             if( info.mapped != nullptr ) {
-                glBindBuffer( GL_UNIFORM_BUFFER, info.buffer );
-                glUnmapBuffer( GL_UNIFORM_BUFFER );
+                mDevice->bindBuffer( GL_UNIFORM_BUFFER, info.buffer );
+                mDevice->unmapBuffer( GL_UNIFORM_BUFFER );
             }
-            glDeleteBuffers( 1, &info.buffer );
+            mDevice->deleteBuffer( info.buffer );
         }
     }
     
     AllocationResult getMemory( size_t size )
     {
+        if( mPersistent ) {
+            return allocateFromRing( size );
+        }
+        
         for( BufferInfo &info : mBuffers ) {
             if( info.mapped == nullptr && size < info.size ) {
                 // if we are not mapped and we can hold a uniform of specified size
@@ -68,10 +121,10 @@ public:
             buffer.offset = 0;
             buffer.unused = 0;
         
-        glGenBuffers( 1, &buffer.buffer );
-        glBindBuffer( GL_UNIFORM_BUFFER, buffer.buffer );
+        buffer.buffer = mDevice->genBuffer();
+        mDevice->bindBuffer( GL_UNIFORM_BUFFER, buffer.buffer );
 
-        glBufferData( GL_UNIFORM_BUFFER, bufSize, NULL, GL_DYNAMIC_DRAW );
+        mDevice->bufferData( GL_UNIFORM_BUFFER, bufSize, NULL, GL_DYNAMIC_DRAW );
         mBuffers.push_back( buffer );
         
         BufferInfo &tmp = mBuffers.back();
@@ -80,26 +133,94 @@ public:
         return allocateFromBuffer( tmp, size );
     }
     
-    size_t flushAndReset()
+    size_t getAligment() const {
+        return mAligment;
+    }
+    
+    // sets aside memory for the blocks of this frame, returns false if blocks can't be used.
+    // Must be called where getMemory is used, before any thread aquires a block,
+    // the Renderer only does so without a render thread
+    bool reserveBlocks()
     {
-        size_t memUsage = 0;
-        for( BufferInfo &info : mBuffers ) 
-        {
+        if( !mPersistent ) {
+            return false;
+        }
+        if( mBlocks.isReserved() ) {
+            // already reserved this frame
+            return true;
+        }
+        
+        // the cursor also counts the first block each thread asked for after the region ran out,
+        // the rest of what they needed isn't known so it's at least doubled then
+        size_t asked = mBlocks.getAsked();
+        size_t size = (asked > mLastRegionSize) ? std::max(asked, mLastRegionSize*2) : asked + asked/4;
+        
+        mLastRegionSize = alignSize( std::max(MIN_UNIFORM_BLOCK_REGION_SIZE, size) );
+        AllocationResult region = allocateFromRing( mLastRegionSize );
+        mBlocks.reserve( region.buffer, region.offset, region.memory, mLastRegionSize );
+        
+        return true;
+    }
+    
+    // the blocks are aquired from here by any thread, once reserveBlocks returned true
+    UniformBlockRegion* getBlockRegion() {
+        return &mBlocks;
+    }
+    
+    // before the gpu uses the memory, it can still be allocated from after this
+    void flush()
+    {
+        if( mPersistent ) {
+            // the memory is coherent, nothing needs to be flushed
+            return;
+        }
+        
+        for( BufferInfo &info : mBuffers ) {
             if( info.mapped ) {
-                glBindBuffer( GL_UNIFORM_BUFFER, info.buffer );
-                glFlushMappedBufferRange( GL_UNIFORM_BUFFER, 0, info.offset );
-                glUnmapBuffer( GL_UNIFORM_BUFFER );
-                memUsage += info.offset;
+                mDevice->bindBuffer( GL_UNIFORM_BUFFER, info.buffer );
+                mDevice->flushMappedBufferRange( GL_UNIFORM_BUFFER, 0, info.offset );
+                mDevice->unmapBuffer( GL_UNIFORM_BUFFER );
+                mFrameMemUsage += info.offset;
                 
                 info.mapped = nullptr;
                 info.offset = 0;
             }
-            else {
-                // we didn't map this buffer... mark it as unused
-                info.unused++;
+        }
+        mDevice->bindBuffer( GL_UNIFORM_BUFFER, 0 );
+    }
+    
+    // after the last draw that uses the memory of the frame, returns how much memory it used
+    size_t endFrame()
+    {
+        if( mPersistent ) {
+            FrameInFlight frame;
+                frame.fence = mDevice->fenceSync();
+                frame.retiredBuffers.swap( mRetiredBuffers );
+            mFrames.push_back( frame );
+            
+            // the part of the region that wasn't handed out isn't counted, if the ring was replaced
+            // after the region was reserved it's in the retired ring & the new one doesn't count it
+            size_t unusedRegion = 0;
+            if( mBlocks.isReserved() && mBlocks.getBuffer() == mRingBuffer ) {
+                unusedRegion = mBlocks.getUnused();
             }
+            size_t ringUsage = mRing.endFrame();
+            size_t memUsage = ringUsage - std::min( unusedRegion, ringUsage );
+            mBlocks.clear();
+            
+            releaseFrames( false );
+            
+            return memUsage;
+        }
+        
+        flush();
+        size_t memUsage = mFrameMemUsage;
+        mFrameMemUsage = 0;
+        
+        for( BufferInfo &info : mBuffers ) {
+            // reset when the buffer is mapped
+            info.unused++;
         }
-        glBindBuffer( GL_UNIFORM_BUFFER, 0 );
         
         if( !mBuffers.empty() ) {
             // clean up 'dead' buffers, aka buffers that haven't been used for a time
@@ -129,15 +250,20 @@ private:
         void *mapped;
         size_t offset, unused;
     };
+    struct FrameInFlight {
+        GLsync fence;
+        // rings that were replaced during the frame
+        std::vector<GLuint> retiredBuffers;
+    };
     
 private:
     void mapBuffer( BufferInfo &info ) 
     {
-        glBindBuffer( GL_UNIFORM_BUFFER, info.buffer );
-        info.mapped = glMapBufferRange( GL_UNIFORM_BUFFER, 0, info.size, 
-                                        GL_MAP_WRITE_BIT |  // we are going to write to the mapped memory
-                                        GL_MAP_INVALIDATE_BUFFER_BIT |  // we don't care of what is currently in there (we are going to overwrite it)
-                                        GL_MAP_FLUSH_EXPLICIT_BIT ); // we will tell opengl what parts of the buffer we wrote to
+        mDevice->bindBuffer( GL_UNIFORM_BUFFER, info.buffer );
+        info.mapped = mDevice->mapBufferRange( GL_UNIFORM_BUFFER, 0, info.size, 
+                                               GL_MAP_WRITE_BIT |  // we are going to write to the mapped memory
+                                               GL_MAP_INVALIDATE_BUFFER_BIT |  // we don't care of what is currently in there (we are going to overwrite it)
+                                               GL_MAP_FLUSH_EXPLICIT_BIT ); // we will tell opengl what parts of the buffer we wrote to
         info.offset = 0;
         info.unused = 0;
         
@@ -158,8 +284,112 @@ private:
         
         return result;
     }
+    
+    size_t alignSize( size_t size ) const
+    {
+        return ((size + mAligment - 1) / mAligment) * mAligment;
+    }
+    
+    void createRing( size_t size )
+    {
+        mRing = RingAllocator( size, mAligment );
+        
+        mRingBuffer = mDevice->genBuffer();
+        mDevice->bindBuffer( GL_UNIFORM_BUFFER, mRingBuffer );
+        
+        GLbitfield flags = GL_MAP_WRITE_BIT |  // we are going to write to the mapped memory
+                           GL_MAP_PERSISTENT_BIT |  // it stays mapped while the gpu uses it
+                           GL_MAP_COHERENT_BIT; // the writes are seen by the gpu without flushing
+        mDevice->bufferStorage( GL_UNIFORM_BUFFER, size, NULL, flags );
+        mRingMemory = (char*)mDevice->mapBufferRange( GL_UNIFORM_BUFFER, 0, size, flags );
+        mDevice->bindBuffer( GL_UNIFORM_BUFFER, 0 );
+    }
+    
+    AllocationResult allocateFromRing( size_t size )
+    {
+        size_t offset = mRing.allocate( size );
+        while( offset == RingAllocator::INVALID_OFFSET && !mFrames.empty() ) {
+            // the cpu is ahead of the gpu by more than the ring holds
+            releaseFrames( true );
+            offset = mRing.allocate( size );
+        }
+        
+        if( offset == RingAllocator::INVALID_OFFSET ) {
+            // too small for a single frame, the current frame still uses the old buffer
+            // so it's kept until the frame is done
+            mRetiredBuffers.push_back( mRingBuffer );
+            createRing( alignSize(std::max(mRing.getSize()*2, size*mFramesInFlight)) );
+            
+            offset = mRing.allocate( size );
+            assert( offset != RingAllocator::INVALID_OFFSET );
+        }
+        
+        AllocationResult result;
+            result.buffer = mRingBuffer;
+            result.offset = offset;
+            result.memory = mRingMemory + offset;
+        return result;
+    }
+    
+    // releases the frames the gpu is done with, the oldest is waited for if 'waitForOldest'
+    void releaseFrames( bool waitForOldest )
+    {
+        while( !mFrames.empty() ) {
+            FrameInFlight &frame = mFrames.front();
+            if( !isSignaled(frame.fence, waitForOldest) ) {
+                break;
+            }
+            waitForOldest = false;
+            
+            mDevice->deleteSync( frame.fence );
+            for( GLuint buffer : frame.retiredBuffers ) {
+                mDevice->deleteBuffer( buffer );
+            }
+            
+            mFrames.pop_front();
+            mRing.releaseFrame();
+        }
+    }
+    
+    bool isSignaled( GLsync fence, bool wait )
+    {
+        GLbitfield flags = wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+        UInt64 timeout = wait ? UNIFORM_FENCE_WAIT_TIMEOUT : 0;
+        
+        while( true ) {
+            GLenum result = mDevice->clientWaitSync( fence, flags, timeout );
+            if( result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED ) {
+                return true;
+            }
+            if( result == GL_WAIT_FAILED ) {
+                // the fence will never be signaled, waiting for it would hang
+                return true;
+            }
+            if( !wait ) {
+                return false;
+            }
+        }
+    }
+    
 private:
+    RenderDevice *mDevice;
     std::vector<BufferInfo> mBuffers;
-    size_t mDefaultBufferSize, mUnusedCleanupTime;
+    size_t mDefaultBufferSize, mUnusedCleanupTime, mFramesInFlight;
     size_t mAligment;
+    
+    bool mPersistent;
+    GLuint mRingBuffer = 0;
+    char *mRingMemory = nullptr;
+    RingAllocator mRing;
+    
+    // where the blocks are handed out from, only reserved while a frame uses blocks
+    UniformBlockRegion mBlocks;
+    size_t mLastRegionSize = 0;
+    
+    // unmapped this frame, without ARB_buffer_storage
+    size_t mFrameMemUsage = 0;
+    // oldest first
+    std::deque<FrameInFlight> mFrames;
+    // rings replaced during the current frame
+    std::vector<GLuint> mRetiredBuffers;
 };
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "UniformBuffer.h"
+#include "UniformBufferAllocator.h"
+#include "UniformBlockRegion.h"
+
+
+static const size_t DEFAULT_UNIFORM_STAGING_CHUNK_SIZE = 1024*32, // 32 KB, needs to be smaller than DEFAULT_UNIFORM_BUFFER_SIZE
+                    DEFAULT_UNIFORM_BLOCK_SIZE = 1024*16; // 16 KB
+
+
+/** class UniformStagingBuffer
+ *      Cpu memory for uniforms written by threads that can't map gl buffers.
+ *      The memory is handed out from chunks in the same way as the UniformBufferAllocator,
+ *      the returned UniformBuffers has 'stagedBuffer' as their buffer.
+ *      Once all uniforms are written, 'upload' copies every used chunk into memory
+ *      from the allocator (on the thread owning the gl context) and 'relocate'
+ *      turns a staged UniformBuffer into one pointing into the gl buffer.
+ *      Several staging buffers can share the same 'stagedBuffer', relocate only
+ *      changes the buffers that points into its own chunks.
+ *      If the allocator has reserved blocks for the frame (setBlockRegion) the uniforms
+ *      are written straight into a block instead & only staged once the blocks run out,
+ *      those uniforms already points at the gl buffer so relocate leaves them be.
+ */
+class UniformStagingBuffer {
+public:
+    UniformStagingBuffer( GLuint stagedBuffer, size_t aligment, size_t chunkSize=DEFAULT_UNIFORM_STAGING_CHUNK_SIZE ) :
+        mStagedBuffer(stagedBuffer),
+        mAligment(aligment),
+        mChunkSize(chunkSize)
+    {}
+    
+    // the region must be reserved for the frame, nullptr to only stage
+    void setBlockRegion( UniformBlockRegion *region )
+    {
+        mBlockRegion = region;
+        mBlock = UniformBlockRegion::Block();
+        mBlockSize = mBlockUsed = 0;
+    }
+    
+    UniformBuffer allocate( size_t size )
+    {
+        if( mBlockRegion && (mBlockUsed + size <= mBlockSize || aquireBlock(size)) ) {
+            size_t offset = mBlockUsed;
+            mBlockUsed += size;
+            
+            // the blocks are aligned, so only the offset in the block needs to be
+            size_t correction = mAligment - mBlockUsed % mAligment;
+            correction %= mAligment;
+            mBlockUsed = std::min( mBlockUsed+correction, mBlockSize );
+            
+            return UniformBuffer( mBlock.buffer, (char*)mBlock.memory+offset, size, mBlock.offset+offset );
+        }
+        
+        if( mCurrentChunk < mChunks.size() ) {
+            Chunk &chunk = mChunks[mCurrentChunk];
+            if( (chunk.used + size) > chunk.memory.size() ) {
+                mCurrentChunk++;
+            }
+        }
+        if( mCurrentChunk == mChunks.size() ) {
+            mChunks.emplace_back();
+            mChunks.back().memory.resize( std::max(mChunkSize,size) );
+        }
+        else if( mChunks[mCurrentChunk].memory.size() < size ) {
+            mChunks[mCurrentChunk].memory.resize( size );
+        }
+        
+        Chunk &chunk = mChunks[mCurrentChunk];
+        
+        size_t offset = chunk.used;
+        chunk.used += size;
+        
+        // keep the next allocation aligned, the chunk is copied to an aligned offset
+        size_t correction = mAligment - chunk.used % mAligment;
+        correction %= mAligment;
+        chunk.used = std::min( chunk.used+correction, chunk.memory.size() );
+        
+        return UniformBuffer( mStagedBuffer, chunk.memory.data()+offset, size, offset );
+    }
+    
+    // copies the used chunks to the gl buffers, must be done before relocate
+    void upload( UniformBufferAllocator *allocator )
+    {
+        for( size_t i=0; i <= mCurrentChunk && i < mChunks.size(); ++i ) {
+            Chunk &chunk = mChunks[i];
+            if( chunk.used == 0 ) {
+                continue;
+            }
+            
+            auto result = allocator->getMemory( chunk.used );
+            std::copy( chunk.memory.begin(), chunk.memory.begin()+chunk.used, (char*)result.memory );
+            
+            chunk.buffer = result.buffer;
+            chunk.offset = result.offset;
+            chunk.mapped = (char*)result.memory;
+        }
+    }
+    
+    // points 'buffer' to where it was uploaded, returns false if it wasn't staged here
+    bool relocate( UniformBuffer &buffer ) const
+    {
+        if( buffer.getBuffer() != mStagedBuffer ) {
+            return false;
+        }
+        
+        const char *memory = (const char*)buffer.getMemory();
+        for( size_t i=0; i <= mCurrentChunk && i < mChunks.size(); ++i ) {
+            const Chunk &chunk = mChunks[i];
+            const char *begin = chunk.memory.data();
+            
+            if( memory >= begin && memory < begin+chunk.used ) {
+                size_t offset = memory - begin;
+                buffer = UniformBuffer( chunk.buffer, chunk.mapped+offset, buffer.getSize(), chunk.offset+offset );
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // keeps the chunks for the next frame
+    void reset()
+    {
+        setBlockRegion( nullptr );
+        
+        for( Chunk &chunk : mChunks ) {
+            chunk.used = 0;
+        }
+        mCurrentChunk = 0;
+    }
+    
+private:
+    bool aquireBlock( size_t size )
+    {
+        size_t blockSize = std::max( DEFAULT_UNIFORM_BLOCK_SIZE, size );
+        mBlock = mBlockRegion->aquireBlock( blockSize );
+        if( mBlock.memory == nullptr ) {
+            // the region is used up, stage the rest of the frame
+            setBlockRegion( nullptr );
+            return false;
+        }
+        
+        mBlockSize = blockSize;
+        mBlockUsed = 0;
+        return true;
+    }
+    
+private:
+    struct Chunk {
+        std::vector<char> memory;
+        size_t used = 0;
+        
+        // where the chunk was uploaded
+        GLuint buffer = 0;
+        size_t offset = 0;
+        char *mapped = nullptr;
+    };
+    
+private:
+    GLuint mStagedBuffer;
+    size_t mAligment, mChunkSize;
+    
+    std::vector<Chunk> mChunks;
+    size_t mCurrentChunk = 0;
+    
+    UniformBlockRegion *mBlockRegion = nullptr;
+    UniformBlockRegion::Block mBlock;
+    size_t mBlockSize = 0,
+           mBlockUsed = 0;
+};
@@ -1,10 +1,11 @@
 #pragma once
 
 #include "GLTypes.h"
+#include "ResourceHandle.h"
 
 class VertexArrayObject {
 public:
-    VertexArrayObject() = default;
+    VertexArrayObject();
     VertexArrayObject( const VertexArrayObject& ) = delete;
     VertexArrayObject( VertexArrayObject &&move );
     ~VertexArrayObject();
@@ -17,10 +18,19 @@ public:
     void bindVAO();
     void unbindVAO();
     
+    GLuint getGLVAO() {
+        return mVAO;
+    }
+    // a moved to object gets a new handle
+    VertexArrayHandle getHandle() {
+        return mHandle;
+    }
+    
 private:
     void createVAO();
     void destroyVAO();
     
 private:
     GLuint mVAO = 0;
+    VertexArrayHandle mHandle;
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+/** class WorkerPool
+ *      A fixed set of threads that runs a range job split into one part per thread.
+ *      The calling thread takes part as thread 0, so the pool has getThreadCount()-1
+ *      actual workers. Only one job is run at a time and parallelFor returns when
+ *      every part is done, the jobs must not throw.
+ */
+class WorkerPool {
+public:
+    // (first, last, thread) - runs the range [first,last) on the given thread
+    typedef std::function<void(size_t,size_t,size_t)> Job;
+    
+public:
+    WorkerPool( const WorkerPool& ) = delete;
+    WorkerPool( WorkerPool&& ) = delete;
+    WorkerPool& operator = ( const WorkerPool& ) = delete;
+    WorkerPool& operator = ( WorkerPool&& ) = delete;
+    
+public:
+    // 0 uses one thread per hardware thread
+    WorkerPool( size_t threadCount = 0 );
+    ~WorkerPool();
+    
+    size_t getThreadCount() const {
+        return mWorkers.size() + 1;
+    }
+    
+    // splits [0,count) into getThreadCount() ranges of about the same size,
+    // empty ranges aren't run
+    void parallelFor( size_t count, const Job &job );
+    
+private:
+    void workerMain( size_t thread );
+    void runRange( size_t thread );
+    
+private:
+    std::vector<std::thread> mWorkers;
+    
+    std::mutex mMutex;
+    std::condition_variable mStartCondition,
+                            mDoneCondition;
+                            
+    const Job *mJob = nullptr;
+    size_t mCount = 0,
+           mGeneration = 0,
+           mPending = 0;
+    bool mQuit = false;
+};
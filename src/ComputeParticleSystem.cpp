@@ -133,57 +133,75 @@ void ComputeParticleSystem::update( float dt )
     // to keep our precision up
     mCurrentTime = glm::mod( mCurrentTime, 64.f );
     
-    glm::mat4 transform = getTransform();
-    glm::vec4 *attractors = mAttractorBuffer->mapBuffer<glm::vec4>( BufferUsage::WriteOnly );
+    // everything the simulation needs is copied, the gl part may run later on the render thread
+    struct {
+        std::vector<glm::vec4> attractors;
+        glm::mat4 transform;
+        float dt, distMod, weightMod, lifeTime, damping;
+        unsigned int groupCount;
+    } params;
+    
+    params.attractors.resize( mAttractorCount );
     for (unsigned int i = 0; i < mAttractorCount; ++i) {
-        attractors[i] = glm::vec4( 
+        params.attractors[i] = glm::vec4( 
             glm::sin( mCurrentTime*(i+2)*0.06f+i*0.2f)*glm::cos( mCurrentTime*(i+7)*0.04f ),
             glm::sin( mCurrentTime*(i+3)*0.04f+i*0.5f)*glm::sin( mCurrentTime*(i+5)*0.02f ),
             glm::cos( mCurrentTime*(i+5)*0.02f+i*0.8f)*glm::cos( mCurrentTime*(i+9)*0.06f ),
             mAttractorWeights[i]
         );
     }
-    mAttractorBuffer->unmapBuffer();
-    
-    mSimulation->bindProgram();
-    
-    mParticleBuffer->bindIndexed( 0 );
-    mStartPositionBuffer->bindIndexed( 1 );
-    mAttractorBuffer->bindIndexed( 2 );
-    
-    glUniform1f( mSimulationLoc.dt, dt * mSpeed );
-    glUniform1f( mSimulationLoc.distMod, mDistMod );
-    glUniform1f( mSimulationLoc.weightMod, mWeightMod );
-    glUniform1f( mSimulationLoc.lifeTime, 1.f/mLifeTime );
-    glUniform1f( mSimulationLoc.damping, mDamping );
-    glUniformMatrix4fv( mSimulationLoc.modelMatrix, 1, GL_FALSE, glm::value_ptr(transform) );
-    glUniform1ui( mSimulationLoc.attractorCount, mAttractorCount );
-    
-    glDispatchCompute( mParticleGroupCount, 1, 1 );
-    
-    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
-    
+    params.transform = getTransform();
+    params.dt = dt * mSpeed;
+    params.distMod = mDistMod;
+    params.weightMod = mWeightMod;
+    params.lifeTime = 1.f/mLifeTime;
+    params.damping = mDamping;
+    params.groupCount = mParticleGroupCount;
+    
+    mRoot->getGraphicsManager()->runOnRenderThread( [this,params]() {
+        glm::vec4 *attractors = mAttractorBuffer->mapBuffer<glm::vec4>( BufferUsage::WriteOnly );
+        std::copy( params.attractors.begin(), params.attractors.end(), attractors );
+        mAttractorBuffer->unmapBuffer();
+        
+        mSimulation->bindProgram();
+        
+        mParticleBuffer->bindIndexed( 0 );
+        mStartPositionBuffer->bindIndexed( 1 );
+        mAttractorBuffer->bindIndexed( 2 );
+        
+        glUniform1f( mSimulationLoc.dt, params.dt );
+        glUniform1f( mSimulationLoc.distMod, params.distMod );
+        glUniform1f( mSimulationLoc.weightMod, params.weightMod );
+        glUniform1f( mSimulationLoc.lifeTime, params.lifeTime );
+        glUniform1f( mSimulationLoc.damping, params.damping );
+        glUniformMatrix4fv( mSimulationLoc.modelMatrix, 1, GL_FALSE, glm::value_ptr(params.transform) );
+        glUniform1ui( mSimulationLoc.attractorCount, params.attractors.size() );
+        
+        glDispatchCompute( params.groupCount, 1, 1 );
+        
+        glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+    } );
 }
 
-void ComputeParticleSystem::submitRenderer( Renderer &renderer )
+void ComputeParticleSystem::submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry )
 {
     RenderingUniformBlock uniforms;
-        uniforms.modelMatrix = getTransform();
+        uniforms.modelMatrix = entry.transform;
         uniforms.intensityAndSize = glm::vec2( mIntensity, mPointSize );
     
     CustomRenderableSettings settings;
         settings.blendMode = BlendMode::AddjectiveBlend;
-        settings.vao = mVAO;
+        settings.vao = getResourceHandle( mVAO );
         settings.uniforms[0] = mRenderer->getSceneUniforms();
         settings.uniforms[1] = mRenderer->aquireUniformBuffer( uniforms );
-        settings.program = mShader;
+        settings.program = getResourceHandle( mShader );
         settings.renderable = mParticleRenderable;
     mRenderer->addCustomRenderable( settings );
     
     if( mShowAttractors ) {
-        settings.program = mAttractorShader;
+        settings.program = getResourceHandle( mAttractorShader );
         settings.renderable = mAttractorRenderable;
-        settings.vao = mAttractorVAO;
+        settings.vao = getResourceHandle( mAttractorVAO );
         
         mRenderer->addCustomRenderable( settings );
     }
@@ -1,6 +1,7 @@
 #include "ComputeWater.h"
 #include "Renderable.h"
 #include "Root.h"
+#include "GraphicsManager.h"
 #include "ResourceManager.h"
 #include "Renderer.h"
 #include "GLinclude.h"
@@ -54,14 +55,18 @@ ComputeWater::~ComputeWater()
 
 void ComputeWater::update( float dt )
 {
-    mWaterSimulation->bindProgram();
-    glBindImageTexture( 0, mSimTexture->getGLTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8 );
-    
     mCurrentTime += dt;
-    GLuint loc = glGetUniformLocation( mWaterSimulation->getGLProgram(), "time" );
-    glUniform1f( loc, mCurrentTime );
     
-    glDispatchCompute( 512/4, 512/2, 1 );
+    float currentTime = mCurrentTime;
+    mRoot->getGraphicsManager()->runOnRenderThread( [this,currentTime]() {
+        mWaterSimulation->bindProgram();
+        glBindImageTexture( 0, mSimTexture->getGLTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8 );
+        
+        GLuint loc = glGetUniformLocation( mWaterSimulation->getGLProgram(), "time" );
+        glUniform1f( loc, currentTime );
+        
+        glDispatchCompute( 512/4, 512/2, 1 );
+    } );
 }
 
 void ComputeWater::setWaterSizeScale( float waterSizeScale )
@@ -73,10 +78,10 @@ void ComputeWater::setWaterSizeScale( float waterSizeScale )
     setBoundingSphere( BoundingSphere(glm::vec3(), radius) );
 }
 
-void ComputeWater::submitRenderer( Renderer &renderer )
+void ComputeWater::submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry )
 {
     RenderingUniforms uniforms;
-    uniforms.modelMatrix = glm::scale( getTransform(), glm::vec3(mWaterSizeScale) );
+    uniforms.modelMatrix = glm::scale( entry.transform, glm::vec3(mWaterSizeScale) );
     uniforms.depthFalloff = mDepthFalloff;
     uniforms.heightScale = mHeightScale;
     uniforms.scrollDirection = glm::vec2(0.02,0.02);
@@ -89,21 +94,21 @@ void ComputeWater::submitRenderer( Renderer &renderer )
     uniforms.lightColor = mLightColor;
     
     CustomRenderableSettings settings;
-        settings.vao = mVAO;
+        settings.vao = getResourceHandle( mVAO );
         settings.uniforms[0] = renderer.getSceneUniforms();
         settings.uniforms[1] = renderer.aquireUniformBuffer( uniforms );
-        settings.textures[0] = renderer.getGBufferDepthTexture();
-        settings.textures[1] = renderer.getGBufferLitDiffuseTexture();
-        settings.textures[2] = mSimTexture;
-        settings.textures[4] = mNormalTexture;
+        settings.textures[0] = getResourceHandle( renderer.getGBufferDepthTexture() );
+        settings.textures[1] = getResourceHandle( renderer.getGBufferLitDiffuseTexture() );
+        settings.textures[2] = getResourceHandle( mSimTexture );
+        settings.textures[4] = getResourceHandle( mNormalTexture );
         settings.renderable = mRenderable;
         settings.blendMode = BlendMode::Replace;
         
     if( mUseWireFrame || renderer.getRenderWireFrame() ) {
-        settings.program = mWaterWireShader;
+        settings.program = getResourceHandle( mWaterWireShader );
     }
     else {
-        settings.program = mWaterShader;
+        settings.program = getResourceHandle( mWaterShader );
     }
     renderer.addCustomRenderable( settings );
 }
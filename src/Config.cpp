@@ -44,6 +44,9 @@ void Config::load( const std::string &filename )
         else if( StringUtils::equalCaseInsensitive(key,"ShadowMapSize") ) {
             shadowMapSize = value.asValue().getValue<unsigned int>();
         }
+        else if( StringUtils::equalCaseInsensitive(key,"ShadowMapCacheSize") ) {
+            shadowMapCacheSize = value.asValue().getValue<unsigned int>();
+        }
         else if( StringUtils::equalCaseInsensitive(key,"Fov") ) {
             fov = value.asValue().getValue<float>();
         }
@@ -59,6 +62,33 @@ void Config::load( const std::string &filename )
         else if( StringUtils::equalCaseInsensitive(key,"OpenGLDebug") ) {
             openglDebug = value.asValue().getValue<bool>();
         }
+        else if( StringUtils::equalCaseInsensitive(key,"RenderThread") ) {
+            renderThread = value.asValue().getValue<bool>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"FrameLatency") ) {
+            frameLatency = value.asValue().getValue<unsigned int>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"ClusteredLights") ) {
+            clusteredLights = value.asValue().getValue<bool>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"Instancing") ) {
+            instancing = value.asValue().getValue<bool>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"MultiDrawIndirect") ) {
+            multiDrawIndirect = value.asValue().getValue<bool>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"DynamicResolution") ) {
+            dynamicResolution = value.asValue().getValue<bool>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"DynamicResolutionTarget") ) {
+            dynamicResolutionTarget = value.asValue().getValue<float>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"DynamicResolutionMinScale") ) {
+            dynamicResolutionMinScale = value.asValue().getValue<float>();
+        }
+        else if( StringUtils::equalCaseInsensitive(key,"DynamicResolutionMaxScale") ) {
+            dynamicResolutionMaxScale = value.asValue().getValue<float>();
+        }
         else if( StringUtils::equalCaseInsensitive(key,"ValueHistoryLenght") ) {
             valueHistoryLenght = value.asValue().getValue<int>();
         }
@@ -12,6 +12,7 @@
 #include "Renderer.h"
 #include "Texture.h"
 #include "FrameListener.h"
+#include "GpuPassTimer.h"
 
 #include <iostream>
 
@@ -26,6 +27,7 @@ public:
         mNormalShader(normalShader),
         mTexturShader(textureShader)
     {
+        mDrawer = drawer;
         mGraphicsMgr = drawer->mRoot->getGraphicsManager();
         mRenderer = mGraphicsMgr->getRenderer();
         
@@ -41,20 +43,31 @@ public:
     }
     
     virtual void onFrameBegun() {
+        // the draws are rendered from the render thread, so it gets its own copy of this frames lists
+        DebugDrawer *drawer = mDrawer;
+        std::vector<DebugWireDraw> wireFrameDraws = drawer->mWireFramesDraws;
+        std::vector<DebugNormalDraw> normalDraws = drawer->mNormalDraws;
+        std::vector<DebugTextureDraw> textureDraws = drawer->mTextureDraws;
+        mGraphicsMgr->runOnRenderThread( [drawer,wireFrameDraws,normalDraws,textureDraws]() mutable {
+            drawer->mRenderWireFramesDraws = std::move( wireFrameDraws );
+            drawer->mRenderNormalDraws = std::move( normalDraws );
+            drawer->mRenderTextureDraws = std::move( textureDraws );
+        } );
+        
         CustomRenderableSettings settings;
             settings.blendMode = BlendMode::Replace;
-            settings.program = mWireFrameShader;
+            settings.program = getResourceHandle( mWireFrameShader );
             settings.renderable = &mWireRenderable;
             settings.queue = 5;
         mRenderer->addCustomRenderable( settings );
         
-        settings.program = mNormalShader;
+        settings.program = getResourceHandle( mNormalShader );
         settings.renderable = &mNormalRenderable;
         mRenderer->addCustomRenderable( settings );
         
         settings.blendMode = BlendMode::AlphaBlend;
         settings.queue = 6;
-        settings.program = mTexturShader;
+        settings.program = getResourceHandle( mTexturShader );
         settings.renderable = &mTextureRenderable;
         mRenderer->addCustomRenderable( settings );
     }
@@ -84,6 +97,7 @@ private:
         
     
 private:
+    DebugDrawer *mDrawer;
     GraphicsManager *mGraphicsMgr;
     Renderer *mRenderer;
     SharedPtr<GpuProgram> mWireFrameShader,
@@ -126,6 +140,11 @@ void DebugDrawer::destroy()
     
     mWireFramesDraws.clear();
     mNormalDraws.clear();
+    mTextureDraws.clear();
+    
+    mRenderWireFramesDraws.clear();
+    mRenderNormalDraws.clear();
+    mRenderTextureDraws.clear();
 }
 
 void DebugDrawer::update( float dt )
@@ -205,27 +224,39 @@ void DebugDrawer::drawTexture( const glm::vec2 &position, const glm::vec2 &size,
 
 void DebugDrawer::renderWireFrames()
 {
-    for( const DebugWireDraw &draw : mWireFramesDraws ) {
-        glBindBufferRange( GL_UNIFORM_BUFFER, 1, draw.uniforms.getBuffer(), draw.uniforms.getOffset(), draw.uniforms.getSize() );
+    mRenderer->getPassTimer()->beginPass( "Debug" );
+    
+    for( const DebugWireDraw &draw : mRenderWireFramesDraws ) {
+        mRenderer->bindUniformBuffer( 1, draw.uniforms );
         renderMesh( draw.mesh, GL_TRIANGLES );
     }
+    
+    mRenderer->getPassTimer()->endPass();
 }
 
 void DebugDrawer::renderNormals()
 {
-    for( const DebugNormalDraw &draw : mNormalDraws ) {
-        glBindBufferRange( GL_UNIFORM_BUFFER, 1, draw.uniforms.getBuffer(), draw.uniforms.getOffset(), draw.uniforms.getSize() );
+    mRenderer->getPassTimer()->beginPass( "Debug" );
+    
+    for( const DebugNormalDraw &draw : mRenderNormalDraws ) {
+        mRenderer->bindUniformBuffer( 1, draw.uniforms );
         renderMesh( draw.mesh, GL_POINTS );
     }
+    
+    mRenderer->getPassTimer()->endPass();
 }
 
 void DebugDrawer::renderTextures()
 {
-    for( const DebugTextureDraw &draw : mTextureDraws ) {
-        glBindBufferRange( GL_UNIFORM_BUFFER, 1, draw.uniforms.getBuffer(), draw.uniforms.getOffset(), draw.uniforms.getSize() );
+    mRenderer->getPassTimer()->beginPass( "Debug" );
+    
+    for( const DebugTextureDraw &draw : mRenderTextureDraws ) {
+        mRenderer->bindUniformBuffer( 1, draw.uniforms );
         draw.texture->bindTexture( 0 );
         glDrawArrays( GL_POINTS, 0, 1 );
     }
+    
+    mRenderer->getPassTimer()->endPass();
 }
 
 
@@ -240,8 +271,8 @@ void DebugDrawer::renderMesh( const SharedPtr<Mesh> &mesh, GLenum mode )
     
     for( const SubMesh &submesh : mesh->getSubMeshes() )
     {
-        if( indexBuffer ) {
-            glDrawElements( mode, submesh.vertexCount, GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(sizeof(GLint)*submesh.vertexStart) );
+        if( mesh->isIndexed() ) {
+            glDrawElementsBaseVertex( mode, submesh.vertexCount, GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(sizeof(GLint)*submesh.vertexStart), submesh.baseVertex );
         }
         else {
             glDrawArrays( mode, submesh.vertexStart, submesh.vertexCount );
@@ -251,4 +282,3 @@ void DebugDrawer::renderMesh( const SharedPtr<Mesh> &mesh, GLenum mode )
 }
 
 
-           
\ No newline at end of file
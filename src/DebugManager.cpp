@@ -19,9 +19,12 @@
 #include "SceneGraph.h"
 #include "Renderable.h"
 #include "Renderer.h"
+#include "RenderStateCache.h"
 #include "SceneObject.h"
+#include "SceneObjectFactory.h"
 #include "LightObject.h"
 #include "DebugLogListener.h"
+#include "GpuPassTimer.h"
 
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
@@ -97,10 +100,13 @@ public:
     
     virtual void onFrameBegun() override
     {
+        // the gui is built on this thread, the render thread gets a copy of the vertices
+        mDebugMgr->paintDebugOverlay();
+        
         CustomRenderableSettings settings;
-            settings.vao = mVAO;
-            settings.program = mShader;
-            settings.textures[0] = mTexture;
+            settings.vao = getResourceHandle( mVAO );
+            settings.program = getResourceHandle( mShader );
+            settings.textures[0] = getResourceHandle( mTexture );
             settings.uniforms[0] = mRenderer->aquireUniformBuffer( mDebugMgr->mUniforms );
             settings.blendMode = BlendMode::AlphaBlend;
             settings.renderable = &mRenderable;
@@ -117,7 +123,9 @@ private:
         
         virtual void render( Renderer &renderer )
         {
+            renderer.getPassTimer()->beginPass( "Debug" );
             debugMgr->render( );
+            renderer.getPassTimer()->endPass();
         }
     } mRenderable;
     
@@ -234,6 +242,9 @@ void DebugManager::update( float dt )
                 ImGui::Value( "Debug", mesurements->debugStartup );
                 ImGui::Value( "Resources", mesurements->resourceStartup );
                 ImGui::Value( "Scene", mesurements->sceneStartup );
+                ImGui::Value( "Scene Load", mesurements->sceneLoad );
+                ImGui::Value( "SceneGraph Build", mesurements->sceneGraphBuild );
+                ImGui::Value( "Static Batching", mesurements->staticBatching );
             }
             
             if( ImGui::CollapsingHeader("Mesurements") ) {
@@ -243,6 +254,10 @@ void DebugManager::update( float dt )
                 ImGui::PlotLines( "Frame Time", mRoot->getFrameTimeHistory(), 1.f, 1.f, ImVec2(0,70) );
                 ImGui::PlotLines( "Frame Rate", mRoot->getFrameRateHistory(), 10.f, 0.f, ImVec2(0,70) );
                 ImGui::PlotLines( "Gpu Time", graphicsMgr->getGpuTimeHistory(), 1.0f, 1.0f, ImVec2(0,70) );
+                if( graphicsMgr->hasRenderThread() ) {
+                    ImGui::PlotLines( "Render Thread", graphicsMgr->getRenderThreadTimeHistory(), 1.0f, 1.0f, ImVec2(0,70) );
+                    ImGui::PlotLines( "Render Wait", graphicsMgr->getRenderWaitTimeHistory(), 1.0f, 1.0f, ImVec2(0,70) );
+                }
                 
                 const auto &memUsage = renderer->getMemoryUsageHistory();
                 ImGui::PlotLines( "Mem Usage", [&]( int i ){ return memUsage.getValue(i) / 1024.f; }, memUsage.getSize(), 1.0f, 1.0f, ImVec2(0,70) );
@@ -254,8 +269,70 @@ void DebugManager::update( float dt )
                 ImGui::Value( "Drawn PointLights", (int)statistics.drawnPointLights );
                 ImGui::SameLine();
                 ImGui::Value( "Shadow meshes", (int)statistics.drawnPointShadowMap );
+                ImGui::SameLine();
+                ImGui::Value( "Faces flagged", (int)statistics.flaggedShadowFaces );
+                ImGui::Value( "Shadow Maps Rendered", (int)statistics.renderedShadowMaps );
+                ImGui::SameLine();
+                ImGui::Value( "Cached", (int)statistics.cachedShadowMaps );
                 ImGui::Value( "Drawn PointLights/WoS", (int)statistics.drawnPointLightsNoShadow );
                 ImGui::Value( "Custom Rendereables", (int)statistics.customRenderables );
+                ImGui::Value( "Texture Binds", (int)statistics.textureBinds );
+                ImGui::SameLine();
+                ImGui::Value( "Mesh Binds", (int)statistics.meshBinds );
+                ImGui::SameLine();
+                ImGui::Value( "Skipped Binds", (int)statistics.skippedBinds );
+                ImGui::Value( "Instance Groups", (int)statistics.instanceGroups );
+                ImGui::SameLine();
+                ImGui::Value( "Indirect Draws", (int)statistics.indirectDraws );
+                ImGui::Value( "Static Batches", (int)statistics.staticBatches );
+                ImGui::SameLine();
+                ImGui::Value( "Draws Saved", (int)(statistics.mergedDraws - statistics.staticBatches) );
+                ImGui::Value( "State Calls Issued", (int)statistics.stateCallsIssued );
+                ImGui::SameLine();
+                ImGui::Value( "Skipped", (int)statistics.stateCallsSkipped );
+                ImGui::Value( "Submit Threads", (int)statistics.submitThreads );
+                ImGui::SameLine();
+                ImGui::Value( "Submit Time", statistics.submitTime );
+                ImGui::Value( "Frame Memory (KB)", statistics.frameMemory / 1024.f );
+                ImGui::SameLine();
+                ImGui::Value( "High Water (KB)", statistics.frameMemoryHighWater / 1024.f );
+                ImGui::Value( "Clustered Light Indices", (int)statistics.clusteredLightIndices );
+                ImGui::SameLine();
+                ImGui::Value( "Cluster Time", statistics.lightClusterTime );
+                ImGui::Value( "Render Scale", statistics.renderScale );
+                ImGui::Value( "Render Targets (MB)", statistics.renderTargetMemory / (1024.f*1024.f) );
+                ImGui::SameLine();
+                ImGui::Value( "Without Aliasing (MB)", statistics.unaliasedRenderTargetMemory / (1024.f*1024.f) );
+            }
+            
+            if( ImGui::CollapsingHeader("Gpu Passes") ) {
+                GpuPassTimer *passTimer = mRoot->getGraphicsManager()->getPassTimer();
+                
+                // nested passes includes the passes inside them
+                for( const GpuPassTimer::PassHistory &history : passTimer->getHistories() ) {
+                    ImGui::PlotLines( history.name.c_str(), history.times, 0.1f, 0.1f, ImVec2(0,50) );
+                    if( history.repeated ) {
+                        std::string label = history.name + " (each)";
+                        ImGui::PlotLines( label.c_str(), history.callTimes, 0.1f, 0.1f, ImVec2(0,50) );
+                    }
+                }
+                ImGui::Value( "Skipped Frames", (int)passTimer->getSkippedFrames() );
+            }
+            
+            if( ImGui::CollapsingHeader("Object Pools") ) {
+                SceneManager *sceneMgr = mRoot->getSceneManager();
+                sceneMgr->forEachFactory(
+                    [&]( const std::string &type, SceneObjectFactory *factory ) {
+                        ObjectPoolStatistics statistics = factory->getPoolStatistics();
+                        
+                        ImGui::Text( "%s", type.c_str() );
+                        ImGui::Value( "Live", (int)statistics.liveObjects );
+                        ImGui::SameLine();
+                        ImGui::Value( "Peak", (int)statistics.peakObjects );
+                        ImGui::SameLine();
+                        ImGui::Value( "Slabs", (int)statistics.slabCount );
+                    }
+                );
             }
             
             if( ImGui::CollapsingHeader("Logs") ) {
@@ -361,6 +438,57 @@ void DebugManager::update( float dt )
                         renderer->setUseOcclusionQuarries( useOcclusionQuarries );
                     }
                     
+                    bool useInstancing = renderer->getUseInstancing();
+                    if( ImGui::Checkbox("Use Instancing", &useInstancing) ) {
+                        renderer->setUseInstancing( useInstancing );
+                    }
+                    if( !renderer->isInstancingSupported() ) {
+                        ImGui::SameLine();
+                        ImGui::Text( "(no instanced program)" );
+                    }
+                    
+                    bool useMultiDrawIndirect = renderer->getUseMultiDrawIndirect();
+                    if( ImGui::Checkbox("Use Multi Draw Indirect", &useMultiDrawIndirect) ) {
+                        renderer->setUseMultiDrawIndirect( useMultiDrawIndirect );
+                    }
+                    if( !renderer->isMultiDrawIndirectSupported() ) {
+                        ImGui::SameLine();
+                        ImGui::Text( "(not supported)" );
+                    }
+                    
+                    RenderStateCache *stateCache = renderer->getStateCache();
+                    bool useStateCache = stateCache->isEnabled();
+                    if( ImGui::Checkbox("Use State Cache", &useStateCache) ) {
+                        stateCache->setEnabled( useStateCache );
+                    }
+                    
+                    bool useParallelSubmission = renderer->getUseParallelSubmission();
+                    if( ImGui::Checkbox("Use Parallel Submission", &useParallelSubmission) ) {
+                        renderer->setUseParallelSubmission( useParallelSubmission );
+                    }
+                    
+                    bool useShadowMapCache = renderer->getUseShadowMapCache();
+                    if( ImGui::Checkbox("Use Shadow Map Cache", &useShadowMapCache) ) {
+                        renderer->setUseShadowMapCache( useShadowMapCache );
+                    }
+                    
+                    bool useSSAO = renderer->getUseSSAO();
+                    if( ImGui::Checkbox("Use SSAO", &useSSAO) ) {
+                        renderer->setUseSSAO( useSSAO );
+                    }
+                    
+                    bool useDynamicResolution = renderer->getUseDynamicResolution();
+                    if( ImGui::Checkbox("Use Dynamic Resolution", &useDynamicResolution) ) {
+                        renderer->setUseDynamicResolution( useDynamicResolution );
+                    }
+                    
+                    if( renderer->isClusteredLightsSupported() ) {
+                        bool useClusteredLights = renderer->getUseClusteredLights();
+                        if( ImGui::Checkbox("Use Clustered Lights", &useClusteredLights) ) {
+                            renderer->setUseClusteredLights( useClusteredLights );
+                        }
+                    }
+                    
                     bool useFrustrumCulling = scene->getUseFrustrumCulling();
                     if( ImGui::Checkbox("Use Frustrum Culling", &useFrustrumCulling) ) {
                         scene->setUseFrustrumCulling( useFrustrumCulling );
@@ -539,13 +667,6 @@ bool DebugManager::handleSDLEvent( const SDL_Event &event )
     return false;
 }
 
-void DebugManager::paintDebugOverlay()
-{
-    if( mIsDebugVisible ) {
-        ImGui::Render();
-    }
-}
-
 struct DrawInfo {
     glm::vec2 scissorPos, scissorSize;
     size_t vertexStart, vertexCount;
@@ -554,23 +675,56 @@ struct DrawInfo {
 struct ImGuiRenderData {
     DebugManager *debugMgr;
     SharedPtr<GpuBuffer> vertexBuffer;
+    // filled by ImGui::Render on the main thread
+    std::vector<ImDrawVert> vertices;
     std::vector<DrawInfo> draws;
+    // the copy that's drawn from the render thread
+    std::vector<ImDrawVert> renderVertices;
+    std::vector<DrawInfo> renderDraws;
 };
 
-
-void DebugManager::render()
+void DebugManager::paintDebugOverlay()
 {
+    ImGuiIO &io = ImGui::GetIO();
+    ImGuiRenderData *renderData = static_cast<ImGuiRenderData*>(io.UserData);
+    
+    renderData->vertices.clear();
+    renderData->draws.clear();
+    
     if( mIsDebugVisible ) {
         ImGui::Render();
+    }
+    
+    std::vector<ImDrawVert> vertices = renderData->vertices;
+    std::vector<DrawInfo> draws = renderData->draws;
+    mRoot->getGraphicsManager()->runOnRenderThread( [renderData,vertices,draws]() mutable {
+        renderData->renderVertices = std::move( vertices );
+        renderData->renderDraws = std::move( draws );
+    } );
+}
+
+void DebugManager::render()
+{
+    ImGuiIO &io = ImGui::GetIO();
+    ImGuiRenderData *renderData = static_cast<ImGuiRenderData*>(io.UserData);
+    
+    if( !renderData->renderDraws.empty() ) {
+        size_t neededBufferSize = renderData->renderVertices.size() * sizeof(ImDrawVert);
+        size_t bufferSize = renderData->vertexBuffer->getSize();
+        if( neededBufferSize > bufferSize ) {
+            bufferSize = neededBufferSize + 5000;
+            renderData->vertexBuffer->setSize( bufferSize );
+        }
         
-        ImGuiIO &io = ImGui::GetIO();
-        ImGuiRenderData *renderData = static_cast<ImGuiRenderData*>(io.UserData);
+        ImDrawVert *bufferData = renderData->vertexBuffer->mapBuffer<ImDrawVert>( BufferUsage::WriteOnly );
+        memcpy( bufferData, renderData->renderVertices.data(), neededBufferSize );
+        renderData->vertexBuffer->unmapBuffer();
         
         glEnable( GL_SCISSOR_TEST );
         glDisable( GL_CULL_FACE );
         glDisable( GL_DEPTH_TEST );
         
-        for( const DrawInfo &draw : renderData->draws )
+        for( const DrawInfo &draw : renderData->renderDraws )
         {
             glScissor( draw.scissorPos.x, mHeight-draw.scissorPos.y, draw.scissorSize.x, draw.scissorSize.y );
             glDrawArrays( GL_TRIANGLES, draw.vertexStart, draw.vertexCount );
@@ -717,27 +871,14 @@ void RenderImGuiDrawLists( ImDrawList** const draw_lists, int count )
     ImGuiIO &io = ImGui::GetIO();
     ImGuiRenderData *renderData = static_cast<ImGuiRenderData*>(io.UserData);
     
-    size_t totalVertexCount = 0;
-    for( int i=0; i < count; ++i ) {
-        totalVertexCount += draw_lists[i]->vtx_buffer.size();
-    }
-    
-    size_t neededBufferSize = totalVertexCount * sizeof(ImDrawVert);
-    size_t bufferSize = renderData->vertexBuffer->getSize();
-    if( neededBufferSize > bufferSize ) {
-        bufferSize = neededBufferSize + 5000;
-        renderData->vertexBuffer->setSize( bufferSize );
-    }
-    
+    // this runs on the main thread, the vertices are uploaded in DebugManager::render
+    renderData->vertices.clear();
     renderData->draws.clear();
     
-    ImDrawVert *bufferData = renderData->vertexBuffer->mapBuffer<ImDrawVert>(BufferUsage::WriteOnly ) ;
     for( int i=0; i < count; ++i ) {
         const ImDrawList *drawList = draw_lists[i];
-        memcpy( bufferData, &drawList->vtx_buffer[0], drawList->vtx_buffer.size()*sizeof(ImDrawVert) );
-        bufferData += drawList->vtx_buffer.size();
+        renderData->vertices.insert( renderData->vertices.end(), drawList->vtx_buffer.begin(), drawList->vtx_buffer.end() );
     }
-    renderData->vertexBuffer->unmapBuffer();
     
     size_t vertexStart = 0;
     for( int i=0; i < count; ++i ) {
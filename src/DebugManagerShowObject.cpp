@@ -44,6 +44,11 @@ void DebugManager::showSceneObject( float dt, SceneObject *object )
         orientation *= glm::quat(rotation*dt);
         object->setOrientation( orientation );
     }
+    
+    glm::vec3 scale = object->getScale();
+    if( ImGui::InputFloat3("Scale", glm::value_ptr(scale)) ) {
+        object->setScale( scale );
+    }
     ImGui::Checkbox( "Show BoundingSphere", &debugDrawInfo.bounds );
     ImGui::SameLine();
     ImGui::Checkbox( "Show Parent Nodes", &debugDrawInfo.parentSceneNodes );
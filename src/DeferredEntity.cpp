@@ -23,14 +23,14 @@ DeferredEntity::DeferredEntity( SceneObjectFactory* factory, Root *root, const S
     const auto &submeshes = mMesh->getSubMeshes();
 }
 
-void DeferredEntity::submitRenderer( Renderer &renderer )
+void DeferredEntity::submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry )
 {
-    renderer.addMesh( mMesh, mMaterial, getTransform() );
+    renderer.addMesh( mMesh, mMaterial, entry.transform );
 }
 
-void DeferredEntity::submitShadowCasters( Renderer &renderer )
+void DeferredEntity::submitShadowCasters( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry )
 {
     if( mCastShadow ) {
-        renderer.addShadowMesh( mMesh, getTransform() );
+        renderer.addShadowMesh( mMesh, entry.transform );
     }
 }
@@ -0,0 +1,87 @@
+#include "DynamicResolution.h"
+
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+
+#include <cassert>
+
+void DynamicResolution::setSettings( const Settings &settings )
+{
+    assert( settings.targetTime > 0.f );
+    assert( settings.minScale > 0.f && settings.minScale <= settings.maxScale && settings.maxScale <= 1.f );
+    assert( settings.raiseThreshold > 0.f && settings.raiseThreshold < 1.f );
+    
+    mSettings = settings;
+    reset();
+}
+
+void DynamicResolution::reset()
+{
+    mScale = mSettings.maxScale;
+    mSmoothedTime = 0.f;
+    mOverFrames = 0;
+    mUnderFrames = 0;
+    mCooldown = 0;
+}
+
+float DynamicResolution::addFrameTime( float gpuTime )
+{
+    if( gpuTime <= 0.f ) {
+        return mScale;
+    }
+    
+    if( mSmoothedTime == 0.f ) {
+        mSmoothedTime = gpuTime;
+    }
+    else {
+        mSmoothedTime = glm::mix( mSmoothedTime, gpuTime, mSettings.smoothing );
+    }
+    
+    // the smoothed time is still updated, so it has caught up when the cooldown is over
+    if( mCooldown > 0 ) {
+        mCooldown--;
+        return mScale;
+    }
+    
+    if( mSmoothedTime > mSettings.targetTime ) {
+        mOverFrames++;
+        mUnderFrames = 0;
+    }
+    else if( mSmoothedTime < mSettings.targetTime * mSettings.raiseThreshold ) {
+        mUnderFrames++;
+        mOverFrames = 0;
+    }
+    else {
+        mOverFrames = 0;
+        mUnderFrames = 0;
+    }
+    
+    if( (mOverFrames >= mSettings.framesToDrop && mScale > mSettings.minScale) ||
+        (mUnderFrames >= mSettings.framesToRaise && mScale < mSettings.maxScale) )
+    {
+        changeScale();
+    }
+    
+    return mScale;
+}
+
+glm::uvec2 DynamicResolution::getRenderSize( const glm::uvec2 &bufferSize ) const
+{
+    glm::vec2 size = glm::vec2(bufferSize) * mScale;
+    return glm::max( glm::uvec2(size + 0.5f), glm::uvec2(1) );
+}
+
+void DynamicResolution::changeScale()
+{
+    // aim for the middle of the band where nothing happens, aiming for the target
+    // would put it right at the edge & the next slow frame would drop it again
+    float aim = mSettings.targetTime * (1.f + mSettings.raiseThreshold) * 0.5f;
+    float scale = mScale * glm::sqrt( aim / mSmoothedTime );
+    
+    scale = glm::clamp( scale, mScale - mSettings.maxStep, mScale + mSettings.maxStep );
+    mScale = glm::clamp( scale, mSettings.minScale, mSettings.maxScale );
+    
+    mOverFrames = 0;
+    mUnderFrames = 0;
+    mCooldown = mSettings.cooldownFrames;
+}
@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cassert>
+
+FrameArena::FrameArena( size_t chunkSize ) :
+    mChunkSize(chunkSize)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for( Chunk &chunk : mChunks ) {
+        delete[] chunk.memory;
+    }
+}
+
+void* FrameArena::allocate( size_t size, size_t aligment )
+{
+    assert( aligment != 0 && (aligment & (aligment-1)) == 0 && "the aligment must be a power of 2" );
+    
+    if( !mChunks.empty() ) {
+        Chunk &chunk = mChunks.back();
+        size_t start = (chunk.used + aligment - 1) & ~(aligment - 1);
+        if( start + size <= chunk.size ) {
+            mUsed += start + size - chunk.used;
+            chunk.used = start + size;
+            return chunk.memory + start;
+        }
+    }
+    
+    // new[] is aligned for any fundamental type, so the start of a chunk is fine
+    addChunk( std::max(mChunkSize, size) );
+    
+    Chunk &chunk = mChunks.back();
+    chunk.used = size;
+    mUsed += size;
+    return chunk.memory;
+}
+
+void FrameArena::reset()
+{
+    mHighWaterMark = std::max( mHighWaterMark, mUsed );
+    mUsed = 0;
+    
+    if( mChunks.size() > 1 ) {
+        // the frame didn't fit in one chunk, replace them with one that fits all of it
+        size_t capacity = mCapacity;
+        for( Chunk &chunk : mChunks ) {
+            delete[] chunk.memory;
+        }
+        mChunks.clear();
+        mCapacity = 0;
+        
+        addChunk( capacity );
+    }
+    
+    for( Chunk &chunk : mChunks ) {
+        chunk.used = 0;
+    }
+}
+
+void FrameArena::addChunk( size_t size )
+{
+    Chunk chunk;
+        chunk.memory = new char[size];
+        chunk.size = size;
+        chunk.used = 0;
+    mChunks.push_back( chunk );
+    
+    mCapacity += size;
+}
@@ -3,40 +3,40 @@
 
 #include "GLinclude.h"
 #include "DebugLevel.h"
+#include "RenderDevice.h"
 
 #include <cassert>
 
 GLuint getBoundFrameBuffer() {
-    GLint framebuffer;
-    glGetIntegerv( GL_FRAMEBUFFER_BINDING, &framebuffer );
-    return framebuffer;
+    return RenderDevice::GetDevice()->getInteger( GL_FRAMEBUFFER_BINDING );
 }
 
 FrameBuffer::FrameBuffer()
 {
-    glGenFramebuffers( 1, &mFrameBuffer );
+    mFrameBuffer = RenderDevice::GetDevice()->genFramebuffer();
 }
 
 FrameBuffer::~FrameBuffer()
 {
-    glDeleteFramebuffers( 1, &mFrameBuffer );
+    RenderDevice::GetDevice()->deleteFramebuffer( mFrameBuffer );
 }
 
 
 void FrameBuffer::attachColorTexture( const SharedPtr<Texture> &texture, int index )
 {
     assert( index >= 0 && index < 8 );
-    glBindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
-    glFramebufferTexture( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+index, texture->getGLTexture(), 0 );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
+    device->framebufferTexture( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0+index, texture->getGLTexture(), 0 );
     
-    GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+    GLenum status = device->checkFramebufferStatus( GL_FRAMEBUFFER );
     
-    glColorMaski( index, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+    device->colorMaski( index, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
     mAttachedTextures[index] = texture;
     
     updateDrawBuffers();
     
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    device->bindFramebuffer( GL_FRAMEBUFFER, 0 );
     
     if( status != GL_FRAMEBUFFER_COMPLETE ) {
         throw std::runtime_error( "Failed to attach color texture to framebuffer!" );
@@ -46,13 +46,14 @@ void FrameBuffer::attachColorTexture( const SharedPtr<Texture> &texture, int ind
 
 void FrameBuffer::setDepthTexture( const SharedPtr<Texture> &texture )
 {
-    glBindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
-    glFramebufferTexture( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture->getGLTexture(), 0 );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
+    device->framebufferTexture( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture->getGLTexture(), 0 );
     
-    GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
+    GLenum status = device->checkFramebufferStatus( GL_FRAMEBUFFER );
     
     updateDrawBuffers();
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    device->bindFramebuffer( GL_FRAMEBUFFER, 0 );
     
     if( status != GL_FRAMEBUFFER_COMPLETE ) {
         throw std::runtime_error( "Failed to attach depth texture to framebuffer!" );
@@ -64,7 +65,7 @@ void FrameBuffer::setDepthTexture( const SharedPtr<Texture> &texture )
 
 void FrameBuffer::bindFrameBuffer()
 {
-    glBindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
+    RenderDevice::GetDevice()->bindFramebuffer( GL_FRAMEBUFFER, mFrameBuffer );
 }
 
 void FrameBuffer::unbindFrameBuffer()
@@ -72,7 +73,7 @@ void FrameBuffer::unbindFrameBuffer()
 #ifdef USE_DEBUG_NORMAL
     assert( getBoundFrameBuffer() == mFrameBuffer );
 #endif
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    RenderDevice::GetDevice()->bindFramebuffer( GL_FRAMEBUFFER, 0 );
 }
 
 void FrameBuffer::updateDrawBuffers()
@@ -86,5 +87,5 @@ void FrameBuffer::updateDrawBuffers()
             drawBuffers[i] = GL_NONE;
         }
     }
-    glDrawBuffers( 8, drawBuffers ); 
+    RenderDevice::GetDevice()->drawBuffers( 8, drawBuffers ); 
 }
@@ -0,0 +1,338 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <map>
+#include <cassert>
+
+static UInt32 accessToBarrier( FrameGraph::Access access )
+{
+    switch( access ) {
+    case( FrameGraph::Access::RenderTarget ):
+        return FrameGraph::BARRIER_FRAMEBUFFER;
+    case( FrameGraph::Access::Sampled ):
+        return FrameGraph::BARRIER_TEXTURE_FETCH;
+    case( FrameGraph::Access::Image ):
+        return FrameGraph::BARRIER_IMAGE_ACCESS;
+    }
+    return FrameGraph::BARRIER_ALL;
+}
+
+void FrameGraph::clear()
+{
+    mPasses.clear();
+    mResources.clear();
+    mOrder.clear();
+    mTextures.clear();
+    
+    mTransientMemory = 0;
+    mAllocatedMemory = 0;
+}
+
+FrameGraph::ResourceId FrameGraph::addTransient( const std::string &name, const FrameGraphTextureDesc &desc )
+{
+    Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+    mResources.push_back( resource );
+    
+    return mResources.size() - 1;
+}
+
+FrameGraph::ResourceId FrameGraph::addImported( const std::string &name )
+{
+    Resource resource;
+        resource.name = name;
+        resource.imported = true;
+    mResources.push_back( resource );
+    
+    return mResources.size() - 1;
+}
+
+void FrameGraph::markOutput( ResourceId resource )
+{
+    assert( resource < mResources.size() );
+    mResources[resource].output = true;
+}
+
+FrameGraph::PassId FrameGraph::addPass( const std::string &name, const Execute &execute )
+{
+    Pass pass;
+        pass.name = name;
+        pass.execute = execute;
+    mPasses.push_back( pass );
+    
+    return mPasses.size() - 1;
+}
+
+void FrameGraph::read( PassId pass, ResourceId resource, Access access )
+{
+    assert( pass < mPasses.size() && resource < mResources.size() );
+    
+    ResourceAccess entry;
+        entry.resource = resource;
+        entry.access = access;
+    mPasses[pass].reads.push_back( entry );
+}
+
+void FrameGraph::write( PassId pass, ResourceId resource, Access access )
+{
+    assert( pass < mPasses.size() && resource < mResources.size() );
+    
+    ResourceAccess entry;
+        entry.resource = resource;
+        entry.access = access;
+    mPasses[pass].writes.push_back( entry );
+}
+
+bool FrameGraph::compile()
+{
+    if( !sortPasses() ) {
+        return false;
+    }
+    cullPasses();
+    aliasTextures();
+    findBarriers();
+    
+    return true;
+}
+
+bool FrameGraph::sortPasses()
+{
+    size_t passCount = mPasses.size();
+    
+    std::vector<std::vector<PassId>> dependents( passCount );
+    std::vector<UInt32> dependencyCount( passCount, 0 );
+    auto addDependency = [&]( PassId first, PassId then ) {
+        dependents[first].push_back( then );
+        dependencyCount[then]++;
+    };
+    
+    // the passes writing each resource, in the order they were added
+    std::vector<std::vector<PassId>> writers( mResources.size() );
+    for( PassId i=0; i < passCount; ++i ) {
+        for( const ResourceAccess &write : mPasses[i].writes ) {
+            std::vector<PassId> &resourceWriters = writers[write.resource];
+            if( resourceWriters.empty() || resourceWriters.back() != i ) {
+                resourceWriters.push_back( i );
+            }
+        }
+    }
+    
+    for( const std::vector<PassId> &resourceWriters : writers ) {
+        for( size_t i=1; i < resourceWriters.size(); ++i ) {
+            addDependency( resourceWriters[i-1], resourceWriters[i] );
+        }
+    }
+    for( PassId i=0; i < passCount; ++i ) {
+        for( const ResourceAccess &read : mPasses[i].reads ) {
+            const std::vector<PassId> &resourceWriters = writers[read.resource];
+            
+            // a pass reads what the last writer added before it wrote, or its own write
+            auto next = std::lower_bound( resourceWriters.begin(), resourceWriters.end(), i );
+            bool writesItself = next != resourceWriters.end() && *next == i;
+            if( next != resourceWriters.begin() || writesItself ) {
+                if( next != resourceWriters.begin() ) {
+                    addDependency( *(next-1), i );
+                }
+                // & the writers added after it waits until it's read, the writer chain orders the rest
+                if( writesItself ) {
+                    ++next;
+                }
+                if( next != resourceWriters.end() ) {
+                    addDependency( i, *next );
+                }
+            }
+            else if( !resourceWriters.empty() ) {
+                // nothing before it writes the resource, it reads what the passes added after it makes
+                addDependency( resourceWriters.back(), i );
+            }
+        }
+    }
+    
+    // there is only a handful of passes, so the first ready pass is simply searched for
+    mOrder.clear();
+    std::vector<bool> sorted( passCount, false );
+    for( size_t n=0; n < passCount; ++n ) {
+        PassId next = INVALID_ID;
+        for( PassId i=0; i < passCount; ++i ) {
+            if( !sorted[i] && dependencyCount[i] == 0 ) {
+                next = i;
+                break;
+            }
+        }
+        if( next == INVALID_ID ) {
+            mOrder.clear();
+            return false;
+        }
+        
+        sorted[next] = true;
+        mOrder.push_back( next );
+        for( PassId dependent : dependents[next] ) {
+            dependencyCount[dependent]--;
+        }
+    }
+    
+    return true;
+}
+
+void FrameGraph::cullPasses()
+{
+    std::vector<bool> needed( mResources.size() );
+    for( size_t i=0; i < mResources.size(); ++i ) {
+        needed[i] = mResources[i].output || mResources[i].imported;
+    }
+    
+    // backwards, so the readers of a resource are seen before its writers
+    for( auto iter = mOrder.rbegin(); iter != mOrder.rend(); ++iter ) {
+        Pass &pass = mPasses[*iter];
+        
+        pass.culled = true;
+        for( const ResourceAccess &write : pass.writes ) {
+            if( needed[write.resource] ) {
+                pass.culled = false;
+            }
+        }
+        if( pass.culled ) {
+            continue;
+        }
+        
+        for( const ResourceAccess &read : pass.reads ) {
+            needed[read.resource] = true;
+        }
+    }
+    
+    mOrder.erase( std::remove_if(mOrder.begin(), mOrder.end(), [this]( PassId pass ) {
+        return mPasses[pass].culled;
+    }), mOrder.end() );
+}
+
+void FrameGraph::aliasTextures()
+{
+    // the first & last position in the execution order a resource is used
+    struct Lifetime {
+        UInt32 first = INVALID_ID,
+               last = 0;
+    };
+    std::vector<Lifetime> lifetimes( mResources.size() );
+    
+    for( UInt32 i=0; i < mOrder.size(); ++i ) {
+        const Pass &pass = mPasses[mOrder[i]];
+        
+        auto use = [&]( const ResourceAccess &access ) {
+            Lifetime &lifetime = lifetimes[access.resource];
+            lifetime.first = std::min( lifetime.first, i );
+            lifetime.last = std::max( lifetime.last, i );
+        };
+        std::for_each( pass.reads.begin(), pass.reads.end(), use );
+        std::for_each( pass.writes.begin(), pass.writes.end(), use );
+    }
+    
+    std::vector<ResourceId> transients;
+    for( ResourceId i=0; i < mResources.size(); ++i ) {
+        mResources[i].texture = INVALID_ID;
+        if( !mResources[i].imported && lifetimes[i].first != INVALID_ID ) {
+            transients.push_back( i );
+        }
+    }
+    std::stable_sort( transients.begin(), transients.end(), [&]( ResourceId a, ResourceId b ) {
+        return lifetimes[a].first < lifetimes[b].first;
+    });
+    
+    mTextures.clear();
+    mTransientMemory = 0;
+    mAllocatedMemory = 0;
+    
+    // the last position each texture is used, a texture is free for resources that starts after it
+    std::vector<UInt32> textureLastUse;
+    for( ResourceId id : transients ) {
+        Resource &resource = mResources[id];
+        const Lifetime &lifetime = lifetimes[id];
+        size_t memory = GetTextureMemory( resource.desc );
+        
+        UInt32 texture = INVALID_ID;
+        for( UInt32 i=0; i < mTextures.size(); ++i ) {
+            bool sameDesc = mTextures[i].type == resource.desc.type && mTextures[i].size == resource.desc.size;
+            if( sameDesc && textureLastUse[i] < lifetime.first ) {
+                texture = i;
+                break;
+            }
+        }
+        if( texture == INVALID_ID ) {
+            texture = mTextures.size();
+            mTextures.push_back( resource.desc );
+            textureLastUse.push_back( 0 );
+            mAllocatedMemory += memory;
+        }
+        
+        textureLastUse[texture] = lifetime.last;
+        resource.texture = texture;
+        mTransientMemory += memory;
+    }
+}
+
+void FrameGraph::findBarriers()
+{
+    // the barrier bits still missing since the texture was written as an image,
+    // aliased resources shares the entry of their texture
+    std::map<UInt32,UInt32> pending;
+    auto slot = [this]( ResourceId resource ) -> UInt32 {
+        UInt32 texture = mResources[resource].texture;
+        return (texture != INVALID_ID) ? texture : UInt32(mTextures.size() + resource);
+    };
+    
+    for( PassId id : mOrder ) {
+        Pass &pass = mPasses[id];
+        
+        pass.barriers = BARRIER_NONE;
+        auto check = [&]( const ResourceAccess &access ) {
+            auto iter = pending.find( slot(access.resource) );
+            if( iter != pending.end() ) {
+                pass.barriers |= iter->second & accessToBarrier( access.access );
+            }
+        };
+        std::for_each( pass.reads.begin(), pass.reads.end(), check );
+        std::for_each( pass.writes.begin(), pass.writes.end(), check );
+        
+        // a barrier covers all memory
+        if( pass.barriers != BARRIER_NONE ) {
+            for( auto &entry : pending ) {
+                entry.second &= ~pass.barriers;
+            }
+        }
+        
+        for( const ResourceAccess &write : pass.writes ) {
+            if( write.access == Access::Image ) {
+                pending[slot(write.resource)] = BARRIER_ALL;
+            }
+        }
+    }
+}
+
+size_t FrameGraph::GetTextureMemory( const FrameGraphTextureDesc &desc )
+{
+    size_t bytesPerPixel = 4;
+    switch( desc.type ) {
+    case( TextureType::Red ):
+        bytesPerPixel = 1;
+        break;
+    case( TextureType::RG ):
+    case( TextureType::Red16 ):
+    case( TextureType::Depth ):
+    case( TextureType::CubeMap_Depth ):
+        bytesPerPixel = 2;
+        break;
+    case( TextureType::RGB16 ):
+    case( TextureType::RGBA16 ):
+    case( TextureType::RGBF ):
+    case( TextureType::RGBAF ):
+        bytesPerPixel = 8;
+        break;
+    default:
+        // the 3 channel formats are padded to 4 by the drivers
+        bytesPerPixel = 4;
+        break;
+    }
+    
+    size_t faces = (desc.type == TextureType::CubeMap_RGB || desc.type == TextureType::CubeMap_Depth) ? 6 : 1;
+    return size_t(desc.size.x) * desc.size.y * bytesPerPixel * faces;
+}
@@ -0,0 +1,374 @@
+#include "GLRenderDevice.h"
+#include "GLinclude.h"
+
+GLint GLRenderDevice::getInteger( GLenum name )
+{
+    GLint value = 0;
+    glGetIntegerv( name, &value );
+    return value;
+}
+
+GLuint GLRenderDevice::genBuffer()
+{
+    GLuint buffer;
+    glGenBuffers( 1, &buffer );
+    return buffer;
+}
+
+void GLRenderDevice::deleteBuffer( GLuint buffer )
+{
+    glDeleteBuffers( 1, &buffer );
+}
+
+void GLRenderDevice::bindBuffer( GLenum target, GLuint buffer )
+{
+    glBindBuffer( target, buffer );
+}
+
+void GLRenderDevice::bindBufferBase( GLenum target, GLuint index, GLuint buffer )
+{
+    glBindBufferBase( target, index, buffer );
+}
+
+void GLRenderDevice::bindBufferRange( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size )
+{
+    glBindBufferRange( target, index, buffer, offset, size );
+}
+
+void GLRenderDevice::bufferData( GLenum target, GLsizeiptr size, const void *data, GLenum usage )
+{
+    glBufferData( target, size, data, usage );
+}
+
+void GLRenderDevice::bufferStorage( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags )
+{
+    glBufferStorage( target, size, data, flags );
+}
+
+GLint GLRenderDevice::getBufferParameter( GLenum target, GLenum name )
+{
+    GLint value = 0;
+    glGetBufferParameteriv( target, name, &value );
+    return value;
+}
+
+void* GLRenderDevice::mapBuffer( GLenum target, GLenum access )
+{
+    return glMapBuffer( target, access );
+}
+
+void* GLRenderDevice::mapBufferRange( GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access )
+{
+    return glMapBufferRange( target, offset, length, access );
+}
+
+void GLRenderDevice::flushMappedBufferRange( GLenum target, GLintptr offset, GLsizeiptr length )
+{
+    glFlushMappedBufferRange( target, offset, length );
+}
+
+void GLRenderDevice::unmapBuffer( GLenum target )
+{
+    glUnmapBuffer( target );
+}
+
+void GLRenderDevice::getBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, void *data )
+{
+    glGetBufferSubData( target, offset, size, data );
+}
+
+GLuint GLRenderDevice::genTexture()
+{
+    GLuint texture;
+    glGenTextures( 1, &texture );
+    return texture;
+}
+
+void GLRenderDevice::deleteTexture( GLuint texture )
+{
+    glDeleteTextures( 1, &texture );
+}
+
+void GLRenderDevice::activeTexture( GLenum unit )
+{
+    glActiveTexture( unit );
+}
+
+void GLRenderDevice::bindTexture( GLenum target, GLuint texture )
+{
+    glBindTexture( target, texture );
+}
+
+void GLRenderDevice::texStorage2D( GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height )
+{
+    glTexStorage2D( target, levels, internalFormat, width, height );
+}
+
+void GLRenderDevice::texSubImage2D( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels )
+{
+    glTexSubImage2D( target, level, x, y, width, height, format, type, pixels );
+}
+
+void GLRenderDevice::texParameteri( GLenum target, GLenum name, GLint param )
+{
+    glTexParameteri( target, name, param );
+}
+
+void GLRenderDevice::generateMipmap( GLenum target )
+{
+    glGenerateMipmap( target );
+}
+
+void GLRenderDevice::copyImageSubData2D( GLuint src, GLuint dst, GLsizei width, GLsizei height )
+{
+    glCopyImageSubData( src, GL_TEXTURE_2D, 0, 0, 0, 0, dst, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1 );
+}
+
+void GLRenderDevice::bindImageTexture( GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format )
+{
+    glBindImageTexture( unit, texture, level, layered, layer, access, format );
+}
+
+GLuint GLRenderDevice::genFramebuffer()
+{
+    GLuint framebuffer;
+    glGenFramebuffers( 1, &framebuffer );
+    return framebuffer;
+}
+
+void GLRenderDevice::deleteFramebuffer( GLuint framebuffer )
+{
+    glDeleteFramebuffers( 1, &framebuffer );
+}
+
+void GLRenderDevice::bindFramebuffer( GLenum target, GLuint framebuffer )
+{
+    glBindFramebuffer( target, framebuffer );
+}
+
+void GLRenderDevice::framebufferTexture( GLenum target, GLenum attachment, GLuint texture, GLint level )
+{
+    glFramebufferTexture( target, attachment, texture, level );
+}
+
+GLenum GLRenderDevice::checkFramebufferStatus( GLenum target )
+{
+    return glCheckFramebufferStatus( target );
+}
+
+void GLRenderDevice::drawBuffers( GLsizei count, const GLenum *buffers )
+{
+    glDrawBuffers( count, buffers );
+}
+
+GLuint GLRenderDevice::genVertexArray()
+{
+    GLuint vao;
+    glGenVertexArrays( 1, &vao );
+    return vao;
+}
+
+void GLRenderDevice::deleteVertexArray( GLuint vao )
+{
+    glDeleteVertexArrays( 1, &vao );
+}
+
+void GLRenderDevice::bindVertexArray( GLuint vao )
+{
+    glBindVertexArray( vao );
+}
+
+void GLRenderDevice::enableVertexAttribArray( GLuint index )
+{
+    glEnableVertexAttribArray( index );
+}
+
+void GLRenderDevice::vertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset )
+{
+    glVertexAttribPointer( index, size, type, normalized, stride, offset );
+}
+
+void GLRenderDevice::useProgram( GLuint program )
+{
+    glUseProgram( program );
+}
+
+void GLRenderDevice::deleteProgram( GLuint program )
+{
+    glDeleteProgram( program );
+}
+
+GLint GLRenderDevice::getUniformLocation( GLuint program, const char *name )
+{
+    return glGetUniformLocation( program, name );
+}
+
+void GLRenderDevice::uniform1i( GLint location, GLint value )
+{
+    glUniform1i( location, value );
+}
+
+void GLRenderDevice::uniform1f( GLint location, GLfloat value )
+{
+    glUniform1f( location, value );
+}
+
+void GLRenderDevice::enable( GLenum cap )
+{
+    glEnable( cap );
+}
+
+void GLRenderDevice::disable( GLenum cap )
+{
+    glDisable( cap );
+}
+
+void GLRenderDevice::blendFunc( GLenum src, GLenum dst )
+{
+    glBlendFunc( src, dst );
+}
+
+void GLRenderDevice::depthMask( GLboolean write )
+{
+    glDepthMask( write );
+}
+
+void GLRenderDevice::depthFunc( GLenum func )
+{
+    glDepthFunc( func );
+}
+
+void GLRenderDevice::cullFace( GLenum face )
+{
+    glCullFace( face );
+}
+
+void GLRenderDevice::colorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    glColorMask( r, g, b, a );
+}
+
+void GLRenderDevice::colorMaski( GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    glColorMaski( index, r, g, b, a );
+}
+
+void GLRenderDevice::viewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    glViewport( x, y, width, height );
+}
+
+void GLRenderDevice::clear( GLbitfield mask )
+{
+    glClear( mask );
+}
+
+void GLRenderDevice::drawArrays( GLenum mode, GLint first, GLsizei count )
+{
+    glDrawArrays( mode, first, count );
+}
+
+void GLRenderDevice::drawElements( GLenum mode, GLsizei count, GLenum type, const void *offset )
+{
+    glDrawElements( mode, count, type, offset );
+}
+
+void GLRenderDevice::drawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount )
+{
+    glDrawArraysInstanced( mode, first, count, instanceCount );
+}
+
+void GLRenderDevice::drawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount )
+{
+    glDrawElementsInstanced( mode, count, type, offset, instanceCount );
+}
+
+void GLRenderDevice::drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex )
+{
+    // some glew versions declares the offset as non const
+    glDrawElementsBaseVertex( mode, count, type, const_cast<void*>(offset), baseVertex );
+}
+
+void GLRenderDevice::drawElementsInstancedBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount, GLint baseVertex )
+{
+    glDrawElementsInstancedBaseVertex( mode, count, type, offset, instanceCount, baseVertex );
+}
+
+void GLRenderDevice::multiDrawElementsIndirect( GLenum mode, GLenum type, const void *offset, GLsizei drawCount, GLsizei stride )
+{
+    glMultiDrawElementsIndirect( mode, type, offset, drawCount, stride );
+}
+
+void GLRenderDevice::dispatchCompute( GLuint x, GLuint y, GLuint z )
+{
+    glDispatchCompute( x, y, z );
+}
+
+void GLRenderDevice::memoryBarrier( GLbitfield barriers )
+{
+    glMemoryBarrier( barriers );
+}
+
+void GLRenderDevice::genQueries( GLsizei count, GLuint *queries )
+{
+    glGenQueries( count, queries );
+}
+
+void GLRenderDevice::beginQuery( GLenum target, GLuint query )
+{
+    glBeginQuery( target, query );
+}
+
+void GLRenderDevice::endQuery( GLenum target )
+{
+    glEndQuery( target );
+}
+
+void GLRenderDevice::beginConditionalRender( GLuint query, GLenum mode )
+{
+    glBeginConditionalRender( query, mode );
+}
+
+void GLRenderDevice::endConditionalRender()
+{
+    glEndConditionalRender();
+}
+
+void GLRenderDevice::deleteQueries( GLsizei count, const GLuint *queries )
+{
+    glDeleteQueries( count, queries );
+}
+
+void GLRenderDevice::queryCounter( GLuint query, GLenum target )
+{
+    glQueryCounter( query, target );
+}
+
+GLint GLRenderDevice::getQueryObject( GLuint query, GLenum name )
+{
+    GLint result = 0;
+    glGetQueryObjectiv( query, name, &result );
+    return result;
+}
+
+UInt64 GLRenderDevice::getQueryObjectui64( GLuint query, GLenum name )
+{
+    GLuint64 result = 0;
+    glGetQueryObjectui64v( query, name, &result );
+    return result;
+}
+
+GLsync GLRenderDevice::fenceSync()
+{
+    return glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
+
+GLenum GLRenderDevice::clientWaitSync( GLsync sync, GLbitfield flags, UInt64 timeout )
+{
+    return glClientWaitSync( sync, flags, timeout );
+}
+
+void GLRenderDevice::deleteSync( GLsync sync )
+{
+    glDeleteSync( sync );
+}
@@ -1,6 +1,7 @@
 #include "GpuBuffer.h"
 #include "GLinclude.h"
 #include "DebugLevel.h"
+#include "RenderDevice.h"
 
 #include <cassert>
 
@@ -23,16 +24,12 @@ GLuint getBoundBuffer( GLenum target )
     default:
         assert( false && "Invalid target!" );
     }
-    GLint boundBuffer;
-    glGetIntegerv( target, &boundBuffer );
-    return boundBuffer;
+    return RenderDevice::GetDevice()->getInteger( target );
 }
 
 bool isMappedBuffer( GLenum target )
 {
-    GLint isMapped;
-    glGetBufferParameteriv( target, GL_BUFFER_MAPPED, &isMapped );
-    return isMapped == GL_TRUE;
+    return RenderDevice::GetDevice()->getBufferParameter( target, GL_BUFFER_MAPPED ) == GL_TRUE;
 }
 
 
@@ -81,62 +78,77 @@ GLenum bufferTypeToGL( BufferType type )
         return GL_UNIFORM_BUFFER;
     case( BufferType::ShaderStorage ):
         return GL_SHADER_STORAGE_BUFFER;
+    case( BufferType::DrawIndirect ):
+        return GL_DRAW_INDIRECT_BUFFER;
     }
     assert( false && "Add the type to the switch :)" );
     return 0;
 }
 
+GpuBuffer::GpuBuffer()
+{
+    mHandle = HandleTable<GpuBuffer>::Add( this );
+}
+
 GpuBuffer::GpuBuffer( BufferType type, size_t size, BufferUsage usage, BufferUpdate update ) :
     mUsage(usage),
     mUpdate(update),
     mType(type),
     mSize(size)
 {
+    mHandle = HandleTable<GpuBuffer>::Add( this );
+    
+    RenderDevice *device = RenderDevice::GetDevice();
     GLenum bufferType = bufferTypeToGL( mType );
     
     createBuffer();
-    glBindBuffer( bufferType, mBuffer );
+    device->bindBuffer( bufferType, mBuffer );
     
     GLenum bufferUsage = usageAndUpdateToGL( mUsage, mUpdate );
-    glBufferData( bufferType, size, NULL, bufferUsage );
+    device->bufferData( bufferType, size, NULL, bufferUsage );
     
-    glBindBuffer( bufferType, 0 );
+    device->bindBuffer( bufferType, 0 );
 }
 
 GpuBuffer::GpuBuffer( GpuBuffer&& move ) :
     mBuffer(move.mBuffer)
 {
     move.mBuffer = 0;
+    mHandle = HandleTable<GpuBuffer>::Add( this );
 }
 
 GpuBuffer::~GpuBuffer()
 {
+    HandleTable<GpuBuffer>::Remove( mHandle );
     destoyBuffer();
 }
 
 void GpuBuffer::createBuffer()
 {
     assert( mBuffer == 0 );
-    glGenBuffers( 1, &mBuffer );
+    mBuffer = RenderDevice::GetDevice()->genBuffer();
 }
 
 void GpuBuffer::destoyBuffer()
 {
-    glDeleteBuffers( 1, &mBuffer );
+    if( mBuffer != 0 ) {
+        RenderDevice::GetDevice()->deleteBuffer( mBuffer );
+    }
 }
 
 void GpuBuffer::setSize( size_t size )
 {
+    RenderDevice *device = RenderDevice::GetDevice();
     GLenum bufferType = bufferTypeToGL( mType );
     if( mBuffer == 0 ) {
         createBuffer();
     }
     
-    glBindBuffer( bufferType, mBuffer );
+    device->bindBuffer( bufferType, mBuffer );
     GLenum usage = usageAndUpdateToGL( mUsage, mUpdate );
-    glBufferData( bufferType, size, NULL, usage );
+    device->bufferData( bufferType, size, NULL, usage );
     mSize = size;
-    glBindBuffer( bufferType, 0 );
+    device->bindBuffer( bufferType, 0 );
 }
 
 void *GpuBuffer::mapBuffer( BufferUsage access )
@@ -144,8 +156,9 @@ void *GpuBuffer::mapBuffer( BufferUsage access )
     GLenum bufferType = bufferTypeToGL( mType );
     GLenum usage = usageToGL( access );
 
-    glBindBuffer( bufferType, mBuffer );
-    return glMapBuffer( bufferType, usage );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindBuffer( bufferType, mBuffer );
+    return device->mapBuffer( bufferType, usage );
 }
 
 void GpuBuffer::unmapBuffer()
@@ -155,15 +168,16 @@ void GpuBuffer::unmapBuffer()
     // hmm getBoundBuffer doesn't work if we are mapped :/
     assert( getBoundBuffer(bufferType) == mBuffer && isMappedBuffer(bufferType) );
 #endif
-    glUnmapBuffer( bufferType );
-    glBindBuffer( bufferType, 0 );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->unmapBuffer( bufferType );
+    device->bindBuffer( bufferType, 0 );
 }
 
 void GpuBuffer::bindBuffer()
 {
     GLenum bufferType = bufferTypeToGL( mType );
 
-    glBindBuffer( bufferType, mBuffer );
+    RenderDevice::GetDevice()->bindBuffer( bufferType, mBuffer );
 }
 
 void GpuBuffer::unbindBuffer()
@@ -172,7 +186,7 @@ void GpuBuffer::unbindBuffer()
 #ifdef USE_DEBUG_NORMAL
     assert( getBoundBuffer(bufferType) == mBuffer );
 #endif
-    glBindBuffer( bufferType, 0 );
+    RenderDevice::GetDevice()->bindBuffer( bufferType, 0 );
 }
 
 void GpuBuffer::bindIndexed( GLuint index )
@@ -184,14 +198,14 @@ void GpuBuffer::bindIndexed( GLuint index )
 #endif
     bindBuffer();
     GLenum type = bufferTypeToGL( mType  );
-    glBindBufferBase( type, index, mBuffer );
+    RenderDevice::GetDevice()->bindBufferBase( type, index, mBuffer );
     unbindBuffer();
 }
 
 void GpuBuffer::bindBufferAs( BufferType type )
 {
     GLenum bufferType = bufferTypeToGL(type);
-    glBindBuffer( bufferType, mBuffer );   
+    RenderDevice::GetDevice()->bindBuffer( bufferType, mBuffer );   
 }
 
 void GpuBuffer::unbindBufferAs( BufferType type )
@@ -200,21 +214,22 @@ void GpuBuffer::unbindBufferAs( BufferType type )
 #ifdef USE_DEBUG_NORMAL
     assert( getBoundBuffer(bufferType) == mBuffer );
 #endif
-    glBindBuffer( bufferType, 0 );
+    RenderDevice::GetDevice()->bindBuffer( bufferType, 0 );
 }
 
 void GpuBuffer::uploadData( const void *data, size_t size )
 {
     if( mBuffer == 0 ) createBuffer();
     
+    RenderDevice *device = RenderDevice::GetDevice();
     GLenum usage = usageAndUpdateToGL( mUsage, mUpdate );
     GLenum bufferType = bufferTypeToGL( mType );
     
-    glBindBuffer( bufferType, mBuffer );
-    glBufferData( bufferType, size, data, usage );
+    device->bindBuffer( bufferType, mBuffer );
+    device->bufferData( bufferType, size, data, usage );
     mSize = size;
     
-    glBindBuffer( bufferType, 0 );
+    device->bindBuffer( bufferType, 0 );
 }
 
 
@@ -0,0 +1,170 @@
+#include "GpuBufferAllocator.h"
+#include "GLinclude.h"
+#include "RenderDevice.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+GpuSubBuffer::GpuSubBuffer( GpuBufferResource *buffer, size_t offset, size_t size ) :
+    mBuffer(buffer),
+    mOffset(offset),
+    mSize(size)
+{
+}
+
+void GpuSubBuffer::setContent( const void *content, size_t size )
+{
+    assert( mBuffer && mBuffer->mapped && "GpuSubBuffer::setContent - the buffer has been flushed" );
+    assert( size <= mSize && mOffset >= mBuffer->flushedFromOffset );
+    
+    char *memory = (char*)mBuffer->mapped + (mOffset - mBuffer->flushedFromOffset);
+    std::memcpy( memory, content, size );
+}
+
+GpuBufferAllocator::GpuBufferAllocator( GLenum usage, size_t defaultBufferSize ) :
+    mUsage(usage),
+    mDefaultBufferSize(defaultBufferSize)
+{
+}
+
+GpuBufferAllocator::~GpuBufferAllocator()
+{
+    for( BufferInfo &info : mBuffers ) {
+        destroyBuffer( info );
+    }
+}
+
+void GpuBufferAllocator::flush()
+{
+    for( BufferInfo &info : mBuffers ) {
+        flushBuffer( info );
+    }
+}
+
+void GpuBufferAllocator::clear()
+{
+    for( BufferInfo &info : mBuffers ) {
+        clearBuffer( info );
+    }
+}
+
+GpuSubBuffer GpuBufferAllocator::allocateBuffer( size_t size, size_t allignment )
+{
+    assert( size > 0 && allignment > 0 );
+    
+    GpuSubBuffer result;
+    for( BufferInfo &info : mBuffers ) {
+        if( tryAllocateFromBuffer(info, size, allignment, result) ) {
+            return result;
+        }
+    }
+    
+    // none of the buffers has room, the new one is at least big enough for this
+    mBuffers.emplace_back();
+    BufferInfo &info = mBuffers.back();
+    createBuffer( info, std::max(mDefaultBufferSize, size) );
+    
+    bool allocated = tryAllocateFromBuffer( info, size, allignment, result );
+    assert( allocated );
+    
+    return result;
+}
+
+void GpuBufferAllocator::mapBuffer( BufferInfo &info )
+{
+    GpuBufferResource &buffer = info.buffer;
+    assert( buffer.mapped == nullptr );
+    
+    // the gpu has never seen the part after the flushed memory, so there is nothing to wait for
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, buffer.glBuffer );
+    buffer.mapped = device->mapBufferRange( GL_COPY_WRITE_BUFFER, buffer.flushedFromOffset, buffer.size - buffer.flushedFromOffset,
+                                            GL_MAP_WRITE_BIT |
+                                            GL_MAP_INVALIDATE_RANGE_BIT |
+                                            GL_MAP_FLUSH_EXPLICIT_BIT |
+                                            GL_MAP_UNSYNCHRONIZED_BIT );
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+void GpuBufferAllocator::unmapBuffer( BufferInfo &info )
+{
+    GpuBufferResource &buffer = info.buffer;
+    if( buffer.mapped == nullptr ) {
+        return;
+    }
+    
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, buffer.glBuffer );
+    device->unmapBuffer( GL_COPY_WRITE_BUFFER );
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    
+    buffer.mapped = nullptr;
+}
+
+void GpuBufferAllocator::flushBuffer( BufferInfo &info )
+{
+    GpuBufferResource &buffer = info.buffer;
+    if( buffer.mapped == nullptr ) {
+        return;
+    }
+    
+    // relative to the start of the mapping
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, buffer.glBuffer );
+    device->flushMappedBufferRange( GL_COPY_WRITE_BUFFER, 0, buffer.allocatedToOffset - buffer.flushedFromOffset );
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    
+    unmapBuffer( info );
+    buffer.flushedFromOffset = buffer.allocatedToOffset;
+}
+
+void GpuBufferAllocator::clearBuffer( BufferInfo &info )
+{
+    unmapBuffer( info );
+    
+    info.allocator.clear();
+    info.buffer.flushedFromOffset = 0;
+    info.buffer.allocatedToOffset = 0;
+}
+
+bool GpuBufferAllocator::tryAllocateFromBuffer( BufferInfo &info, size_t size, size_t allignment, GpuSubBuffer &result )
+{
+    size_t offset;
+    if( !info.allocator.allocate(size, allignment, offset) ) {
+        return false;
+    }
+    
+    GpuBufferResource &buffer = info.buffer;
+    if( buffer.mapped == nullptr ) {
+        mapBuffer( info );
+    }
+    buffer.allocatedToOffset = info.allocator.getUsed();
+    
+    result = GpuSubBuffer( &buffer, offset, size );
+    return true;
+}
+
+void GpuBufferAllocator::createBuffer( BufferInfo &info, size_t size )
+{
+    RenderDevice *device = RenderDevice::GetDevice();
+    
+    GpuBufferResource &buffer = info.buffer;
+    buffer.glBuffer = device->genBuffer();
+    buffer.size = size;
+    
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, buffer.glBuffer );
+    device->bufferData( GL_COPY_WRITE_BUFFER, size, NULL, mUsage );
+    device->bindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    
+    info.allocator = StackAllocationPattern( size );
+}
+
+void GpuBufferAllocator::destroyBuffer( BufferInfo &info )
+{
+    // deleting the buffer unmaps it
+    RenderDevice::GetDevice()->deleteBuffer( info.buffer.glBuffer );
+    
+    info.buffer = GpuBufferResource();
+    info.allocator = StackAllocationPattern();
+}
@@ -0,0 +1,179 @@
+#include "GpuPassTimer.h"
+#include "RenderDevice.h"
+#include "GLinclude.h"
+
+#include <cassert>
+
+GpuPassTimer::GpuPassTimer( size_t historyLength, unsigned int latency, size_t maxPassesPerFrame ) :
+    mDevice(RenderDevice::GetDevice()),
+    mHistoryLength(historyLength),
+    mMaxQueriesPerFrame(maxPassesPerFrame*2)
+{
+    assert( latency > 0 && maxPassesPerFrame > 0 );
+    
+    mFrames.resize( latency );
+    mQueries.resize( latency * mMaxQueriesPerFrame );
+    mDevice->genQueries( mQueries.size(), mQueries.data() );
+}
+
+GpuPassTimer::~GpuPassTimer()
+{
+    mDevice->deleteQueries( mQueries.size(), mQueries.data() );
+}
+
+void GpuPassTimer::beginFrame()
+{
+    assert( !mTiming && "GpuPassTimer::beginFrame - the last frame wasn't ended" );
+    
+    // oldest first, so the histories stay in order
+    for( size_t i=1; i <= mFrames.size(); ++i ) {
+        Frame &frame = mFrames[(mCurrentFrame + i) % mFrames.size()];
+        if( !frame.pending ) {
+            continue;
+        }
+        
+        // the timestamps are written in the order they were issued, if the last is there all of them are
+        if( mDevice->getQueryObject(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE) == GL_FALSE ) {
+            // the frames after this one can't be done either
+            break;
+        }
+        readFrame( frame );
+    }
+    
+    mCurrentFrame = (mCurrentFrame + 1) % mFrames.size();
+    Frame &frame = mFrames[mCurrentFrame];
+    if( frame.pending ) {
+        // reusing its queries would mean waiting for them
+        mSkippedFrames++;
+        return;
+    }
+    
+    frame.passes.clear();
+    frame.usedQueries = 0;
+    frame.lastQuery = 0;
+    mTiming = true;
+}
+
+void GpuPassTimer::endFrame()
+{
+    if( !mTiming ) {
+        return;
+    }
+    assert( mOpenPasses.empty() && "GpuPassTimer::endFrame - a pass wasn't ended" );
+    
+    Frame &frame = mFrames[mCurrentFrame];
+    frame.pending = frame.usedQueries > 0;
+    mTiming = false;
+}
+
+void GpuPassTimer::beginPass( const char *name )
+{
+    if( !mTiming ) {
+        return;
+    }
+    
+    Frame &frame = mFrames[mCurrentFrame];
+    if( frame.usedQueries + 2 > mMaxQueriesPerFrame ) {
+        // out of queries, the pass isn't timed but endPass must still match
+        mOpenPasses.push_back( ~size_t(0) );
+        return;
+    }
+    
+    Pass pass;
+        pass.history = getHistoryIndex( name );
+        pass.begin = mQueries[mCurrentFrame * mMaxQueriesPerFrame + frame.usedQueries++];
+        pass.end = mQueries[mCurrentFrame * mMaxQueriesPerFrame + frame.usedQueries++];
+    mDevice->queryCounter( pass.begin, GL_TIMESTAMP );
+    frame.lastQuery = pass.begin;
+    
+    mOpenPasses.push_back( frame.passes.size() );
+    frame.passes.push_back( pass );
+}
+
+void GpuPassTimer::endPass()
+{
+    if( !mTiming ) {
+        return;
+    }
+    assert( !mOpenPasses.empty() && "GpuPassTimer::endPass - no pass was begun" );
+    
+    size_t index = mOpenPasses.back();
+    mOpenPasses.pop_back();
+    if( index != ~size_t(0) ) {
+        Frame &frame = mFrames[mCurrentFrame];
+        mDevice->queryCounter( frame.passes[index].end, GL_TIMESTAMP );
+        frame.lastQuery = frame.passes[index].end;
+    }
+}
+
+std::vector<GpuPassTimer::PassHistory> GpuPassTimer::getHistories()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mHistories;
+}
+
+float GpuPassTimer::getLastTime( const std::string &name, UInt64 *readFrames )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    if( readFrames ) {
+        *readFrames = mReadFrames;
+    }
+    for( size_t i=0; i < mHistories.size(); ++i ) {
+        if( mHistories[i].name == name ) {
+            return mLastTimes[i];
+        }
+    }
+    return 0.f;
+}
+
+size_t GpuPassTimer::getHistoryIndex( const char *name )
+{
+    for( size_t i=0; i < mNames.size(); ++i ) {
+        if( mNames[i] == name ) {
+            return i;
+        }
+    }
+    
+    mNames.push_back( name );
+    mFrameTimes.push_back( 0 );
+    mFrameCalls.push_back( 0 );
+    
+    PassHistory history;
+        history.name = name;
+        history.times.setSize( mHistoryLength );
+        history.callTimes.setSize( mHistoryLength );
+        
+    std::lock_guard<std::mutex> lock( mMutex );
+    mHistories.push_back( history );
+    mLastTimes.push_back( 0.f );
+    
+    return mNames.size()-1;
+}
+
+void GpuPassTimer::readFrame( Frame &frame )
+{
+    for( const Pass &pass : frame.passes ) {
+        UInt64 begin = mDevice->getQueryObjectui64( pass.begin, GL_QUERY_RESULT ),
+               end = mDevice->getQueryObjectui64( pass.end, GL_QUERY_RESULT );
+               
+        mFrameTimes[pass.history] += (end > begin) ? end - begin : 0;
+        mFrameCalls[pass.history]++;
+    }
+    frame.pending = false;
+    
+    // passes that wasn't used in the frame gets a 0, so all histories are in step
+    std::lock_guard<std::mutex> lock( mMutex );
+    mReadFrames++;
+    for( size_t i=0; i < mHistories.size(); ++i ) {
+        PassHistory &history = mHistories[i];
+        
+        float time = mFrameTimes[i] / 1000000.f;
+        history.times.pushValue( time );
+        history.callTimes.pushValue( mFrameCalls[i] ? time / mFrameCalls[i] : 0.f );
+        history.repeated = history.repeated || mFrameCalls[i] > 1;
+        mLastTimes[i] = time;
+        
+        mFrameTimes[i] = 0;
+        mFrameCalls[i] = 0;
+    }
+}
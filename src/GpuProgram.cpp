@@ -5,26 +5,29 @@
 #include "DefaultGpuProgramLocations.h"
 #include "UniformBlockDefinitions.h"
 #include "UniformBlock.h"
+#include "RenderDevice.h"
 #include "yaml-cxx/YamlCxx.h"
 
 GpuProgram::GpuProgram( GLuint program ) :
     mProgram(program)
 {
+    mHandle = HandleTable<GpuProgram>::Add( this );
 }
 
 GpuProgram::~GpuProgram()
 {
-    glDeleteProgram( mProgram );
+    HandleTable<GpuProgram>::Remove( mHandle );
+    RenderDevice::GetDevice()->deleteProgram( mProgram );
 }
 
 void GpuProgram::bindProgram()
 {
-    glUseProgram( mProgram );
+    RenderDevice::GetDevice()->useProgram( mProgram );
 }
 
 void GpuProgram::unbindProgram()
 {
-    glUseProgram( 0 );
+    RenderDevice::GetDevice()->useProgram( 0 );
 }
 
 SharedPtr<GpuProgram> GpuProgram::LoadProgram( const std::string &filename )
@@ -157,7 +160,9 @@ SharedPtr<GpuProgram> GpuProgramBuilder::buildProgram()
         }
     }
     
-    glUseProgram( glprogram );
+    // through the device, so the state cache knows what's bound
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->useProgram( glprogram );
     for( const auto &entry : mSamplers ) {
         const std::string &name = entry.first;
         GLuint unit = entry.second;
@@ -167,7 +172,7 @@ SharedPtr<GpuProgram> GpuProgramBuilder::buildProgram()
             glUniform1i( loc, unit );
         }
     }
-    glUseProgram( 0 );
+    device->useProgram( 0 );
     
     return program;
 }
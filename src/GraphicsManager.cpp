@@ -8,6 +8,8 @@
 #include "Renderer.h"
 #include "Camera.h"
 #include "Log.h"
+#include "RenderThread.h"
+#include "GpuPassTimer.h"
 
 #include <SDL2/SDL.h>
 
@@ -82,20 +84,10 @@ bool GraphicsManager::init( Root *root )
     mesurements->graphicsStartup = initTimer.getTimeAsSeconds();
     
     mGpuTimes.setSize( config->valueHistoryLenght );
+    mRenderThreadTimes.setSize( config->valueHistoryLenght );
+    mRenderWaitTimes.setSize( config->valueHistoryLenght );
     
-    mNumOfQuaryObjects = 3;
-    
-    mTimeQuaryObjects.resize( mNumOfQuaryObjects );
-    
-    glGenQueries( mNumOfQuaryObjects, &mTimeQuaryObjects[0] );
-    
-    // this is to suppress warnings from the graphics driver - 
-    // for trying to quary a object that doesn't have a value get,
-    // this is easier that to keep track of how many of them I've used
-    for( size_t i=0; i < mNumOfQuaryObjects; ++i ) {
-        glBeginQuery( GL_TIME_ELAPSED, mTimeQuaryObjects[i] );
-        glEndQuery( GL_TIME_ELAPSED );
-    }
+    mPassTimer = new GpuPassTimer( config->valueHistoryLenght );
     
     
     { // log supported extensions
@@ -118,11 +110,14 @@ bool GraphicsManager::init( Root *root )
 
 void GraphicsManager::destroy()
 {
-    glDeleteQueries( mNumOfQuaryObjects, &mTimeQuaryObjects[0] );
+    stopRenderThread();
     
     delete mRenderer;
     mRenderer = nullptr;
     
+    delete mPassTimer;
+    mPassTimer = nullptr;
+    
     SDL_GL_DeleteContext( mGLContext );
     SDL_DestroyWindow( mWindow );
     
@@ -141,9 +136,12 @@ void GraphicsManager::update( float dt )
 
 void GraphicsManager::render()
 {
-    glBeginQuery( GL_TIME_ELAPSED, mTimeQuaryObjects[mCurrentQuary] );
-    
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    runOnRenderThread( [this]() {
+        mPassTimer->beginFrame();
+        mPassTimer->beginPass( "Frame" );
+        
+        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    } );
     
     fireFrameBegun();
     
@@ -155,20 +153,84 @@ void GraphicsManager::render()
     
     fireFrameEnded();
     
-    {
-        glEndQuery( GL_TIME_ELAPSED );
+    runOnRenderThread( [this]() {
+        mPassTimer->endPass();
+        mPassTimer->endFrame();
         
-        GLint result = -1;
-        int index = (mCurrentQuary+1)%mNumOfQuaryObjects;
-        glGetQueryObjectiv( mTimeQuaryObjects[index], GL_QUERY_RESULT, &result );
+        // from the last frame the gpu has finished, nothing is waited for
+        UInt64 readFrames;
+        float gpuTime = mPassTimer->getLastTime( "Frame", &readFrames );
         
-        mGpuTimes.pushValue( (double)(result) / 1000000.0 );
+        std::lock_guard<std::mutex> lock( mGpuTimeMutex );
+        mLastGpuTime = gpuTime;
+        mLastGpuFrame = readFrames;
+    } );
+    
+    if( mRenderThread ) {
+        mRenderThread->endFrame();
         
-        mCurrentQuary++;
-        mCurrentQuary %= mNumOfQuaryObjects;
+        mRenderThreadTimes.pushValue( mRenderThread->getFrameTime() );
+        mRenderWaitTimes.pushValue( mRenderThread->getWaitTime() );
+    }
+    else {
+        SDL_GL_SwapWindow(mWindow);
+        
+        mRenderThreadTimes.pushValue( 0.f );
+        mRenderWaitTimes.pushValue( 0.f );
     }
     
-    SDL_GL_SwapWindow(mWindow);
+    // when the timer skipped a frame or the render thread hasn't read one since the last
+    // frame there is no new time, the same time would be counted twice by the dynamic resolution
+    float gpuTime = 0.f;
+    bool newGpuTime = false;
+    {
+        std::lock_guard<std::mutex> lock( mGpuTimeMutex );
+        newGpuTime = mLastGpuFrame != mUsedGpuFrame;
+        mUsedGpuFrame = mLastGpuFrame;
+        gpuTime = mLastGpuTime;
+    }
+    if( newGpuTime ) {
+        mGpuTimes.pushValue( gpuTime );
+        mRenderer->addGpuFrameTime( gpuTime );
+    }
+}
+
+void GraphicsManager::startRenderThread( unsigned int frameLatency )
+{
+    if( mRenderThread ) {
+        return;
+    }
+    
+    frameLatency = std::max( 1u, std::min(frameLatency, 2u) );
+    mLog->stream(LogSeverity::Information, "GraphicsManager") << "Starting the render thread, frame latency: " << frameLatency;
+    
+    SDL_GL_MakeCurrent( mWindow, nullptr );
+    mRenderThread = new RenderThread( mWindow, mGLContext, frameLatency );
+    mRenderer->setRenderThread( mRenderThread );
+}
+
+void GraphicsManager::stopRenderThread()
+{
+    if( !mRenderThread ) {
+        return;
+    }
+    
+    // waits for the queued frames
+    delete mRenderThread;
+    mRenderThread = nullptr;
+    mRenderer->setRenderThread( nullptr );
+    
+    SDL_GL_MakeCurrent( mWindow, mGLContext );
+}
+
+void GraphicsManager::runOnRenderThread( const std::function<void()> &task )
+{
+    if( mRenderThread ) {
+        mRenderThread->enqueue( task );
+    }
+    else {
+        task();
+    }
 }
 
 bool GraphicsManager::handleSDLEvent( const SDL_Event &event )
@@ -0,0 +1,48 @@
+#include "IndirectDraw.h"
+#include "Mesh.h"
+
+#include <cassert>
+
+void IndirectCommandBuilder::clear()
+{
+    mCommands.clear();
+    mDrawData.clear();
+    mBuckets.clear();
+}
+
+void IndirectCommandBuilder::beginBucket( UInt32 userData )
+{
+    Bucket bucket;
+        bucket.firstCommand = mCommands.size();
+        bucket.commandCount = 0;
+        bucket.userData = userData;
+    mBuckets.push_back( bucket );
+}
+
+void IndirectCommandBuilder::addDraw( const std::vector<SubMesh> &subMeshes, UInt32 instanceCount, UInt32 firstInstance )
+{
+    assert( !mBuckets.empty() && "beginBucket must be called before addDraw" );
+    Bucket &bucket = mBuckets.back();
+    
+    for( const SubMesh &submesh : subMeshes ) {
+        DrawElementsIndirectCommand command;
+            command.count = submesh.vertexCount;
+            command.instanceCount = instanceCount;
+            command.firstIndex = submesh.vertexStart;
+            command.baseVertex = submesh.baseVertex;
+            command.baseInstance = 0;
+        mCommands.push_back( command );
+        mDrawData.push_back( firstInstance );
+        
+        bucket.commandCount++;
+    }
+}
+
+void IndirectCommandBuilder::addGroup( const BucketState &state, const std::vector<SubMesh> &subMeshes, UInt32 instanceCount, UInt32 firstInstance, UInt32 userData )
+{
+    if( mBuckets.empty() || !(state == mBucketState) ) {
+        beginBucket( userData );
+        mBucketState = state;
+    }
+    addDraw( subMeshes, instanceCount, firstInstance );
+}
@@ -0,0 +1,166 @@
+#include "LightClusters.h"
+#include "WorkerPool.h"
+
+#include <glm/common.hpp>
+#include <glm/exponential.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+LightClusterBuilder::LightClusterBuilder() :
+    mGridSize(16,9,24)
+{
+}
+
+void LightClusterBuilder::setGridSize( const glm::uvec3 &gridSize )
+{
+    assert( gridSize.x > 0 && gridSize.y > 0 && gridSize.z > 0 );
+    mGridSize = gridSize;
+}
+
+UInt32 LightClusterBuilder::getSlice( float depth ) const
+{
+    float slice = glm::log( std::max(depth,mNearPlane) ) * mSliceScale + mSliceBias;
+    return glm::clamp<int>( (int)slice, 0, mGridSize.z-1 );
+}
+
+void LightClusterBuilder::build( const Light *lights, size_t lightCount, const glm::mat4 &projectionMatrix, float nearPlane, float farPlane, WorkerPool *pool )
+{
+    assert( nearPlane > 0.f && farPlane > nearPlane );
+    
+    mNearPlane = nearPlane;
+    mFarPlane = farPlane;
+    
+    float logRange = glm::log( farPlane / nearPlane );
+    mSliceScale = mGridSize.z / logRange;
+    mSliceBias = -(mGridSize.z * glm::log(nearPlane)) / logRange;
+    
+    mSliceEdges.resize( mGridSize.z+1 );
+    for( UInt32 i=0; i <= mGridSize.z; ++i ) {
+        mSliceEdges[i] = nearPlane * glm::pow( farPlane / nearPlane, float(i) / mGridSize.z );
+    }
+    
+    // ndc.x = projection[0][0] * x / depth, so the tile edges are stored as x / depth
+    mTileEdgesX.resize( mGridSize.x+1 );
+    for( UInt32 i=0; i <= mGridSize.x; ++i ) {
+        mTileEdgesX[i] = (2.f * i / mGridSize.x - 1.f) / projectionMatrix[0][0];
+    }
+    mTileEdgesY.resize( mGridSize.y+1 );
+    for( UInt32 i=0; i <= mGridSize.y; ++i ) {
+        mTileEdgesY[i] = (2.f * i / mGridSize.y - 1.f) / projectionMatrix[1][1];
+    }
+    
+    size_t threadCount = pool ? pool->getThreadCount() : 1;
+    mThreadPairs.resize( threadCount );
+    for( std::vector<ClusterLightPair> &pairs : mThreadPairs ) {
+        pairs.clear();
+    }
+    
+    if( pool ) {
+        pool->parallelFor( lightCount, [&]( size_t first, size_t last, size_t thread ) {
+            binLights( lights, first, last, mThreadPairs[thread] );
+        } );
+    }
+    else {
+        binLights( lights, 0, lightCount, mThreadPairs[0] );
+    }
+    
+    // count, prefix sum & scatter. The threads got increasing light ranges,
+    // so going through them in order keeps the indices sorted in every cluster.
+    mClusters.assign( mGridSize.x*mGridSize.y*mGridSize.z, Cluster{0,0} );
+    
+    size_t pairCount = 0;
+    for( const std::vector<ClusterLightPair> &pairs : mThreadPairs ) {
+        for( const ClusterLightPair &pair : pairs ) {
+            mClusters[pair.cluster].count++;
+        }
+        pairCount += pairs.size();
+    }
+    
+    UInt32 offset = 0;
+    for( Cluster &cluster : mClusters ) {
+        cluster.offset = offset;
+        offset += cluster.count;
+        cluster.count = 0;
+    }
+    
+    mLightIndices.resize( pairCount );
+    for( const std::vector<ClusterLightPair> &pairs : mThreadPairs ) {
+        for( const ClusterLightPair &pair : pairs ) {
+            Cluster &cluster = mClusters[pair.cluster];
+            mLightIndices[cluster.offset + cluster.count] = pair.light;
+            cluster.count++;
+        }
+    }
+}
+
+void LightClusterBuilder::binLights( const Light *lights, size_t first, size_t last, std::vector<ClusterLightPair> &pairs ) const
+{
+    for( size_t i=first; i < last; ++i ) {
+        const Light &light = lights[i];
+        
+        float depth = -light.position.z,
+              radius = light.radius;
+        float minDepth = std::max( depth-radius, mNearPlane ),
+              maxDepth = std::min( depth+radius, mFarPlane );
+        if( minDepth > maxDepth ) {
+            continue;
+        }
+        
+        // x / depth over the lights bounding box is smallest/largest at one of the corners
+        float minX = std::min( (light.position.x-radius) / minDepth, (light.position.x-radius) / maxDepth ),
+              maxX = std::max( (light.position.x+radius) / minDepth, (light.position.x+radius) / maxDepth ),
+              minY = std::min( (light.position.y-radius) / minDepth, (light.position.y-radius) / maxDepth ),
+              maxY = std::max( (light.position.y+radius) / minDepth, (light.position.y+radius) / maxDepth );
+              
+        if( maxX < mTileEdgesX.front() || minX > mTileEdgesX.back() ||
+            maxY < mTileEdgesY.front() || minY > mTileEdgesY.back() )
+        {
+            continue;
+        }
+        
+        // the edges are increasing, the first tile is the last edge at or below the min
+        UInt32 firstX = std::max<long>( std::upper_bound(mTileEdgesX.begin(), mTileEdgesX.end(), minX) - mTileEdgesX.begin() - 1, 0 ),
+               lastX = std::min<long>( std::lower_bound(mTileEdgesX.begin(), mTileEdgesX.end(), maxX) - mTileEdgesX.begin(), mGridSize.x ),
+               firstY = std::max<long>( std::upper_bound(mTileEdgesY.begin(), mTileEdgesY.end(), minY) - mTileEdgesY.begin() - 1, 0 ),
+               lastY = std::min<long>( std::lower_bound(mTileEdgesY.begin(), mTileEdgesY.end(), maxY) - mTileEdgesY.begin(), mGridSize.y ),
+               firstSlice = getSlice( minDepth ),
+               lastSlice = getSlice( maxDepth );
+               
+        float radius2 = radius*radius;
+        for( UInt32 z=firstSlice; z <= lastSlice; ++z ) {
+            float nearDepth = mSliceEdges[z],
+                  farDepth = mSliceEdges[z+1];
+                  
+            // squared distance from the light to the clusters bounding box, one axis at the time
+            float dz = glm::clamp( depth, nearDepth, farDepth ) - depth;
+            float distZ = dz*dz;
+            if( distZ > radius2 ) {
+                continue;
+            }
+            
+            for( UInt32 y=firstY; y < lastY; ++y ) {
+                float boxMinY = std::min( mTileEdgesY[y]*nearDepth, mTileEdgesY[y]*farDepth ),
+                      boxMaxY = std::max( mTileEdgesY[y+1]*nearDepth, mTileEdgesY[y+1]*farDepth );
+                float dy = glm::clamp( light.position.y, boxMinY, boxMaxY ) - light.position.y;
+                float distYZ = distZ + dy*dy;
+                if( distYZ > radius2 ) {
+                    continue;
+                }
+                
+                for( UInt32 x=firstX; x < lastX; ++x ) {
+                    float boxMinX = std::min( mTileEdgesX[x]*nearDepth, mTileEdgesX[x]*farDepth ),
+                          boxMaxX = std::max( mTileEdgesX[x+1]*nearDepth, mTileEdgesX[x+1]*farDepth );
+                    float dx = glm::clamp( light.position.x, boxMinX, boxMaxX ) - light.position.x;
+                    
+                    if( distYZ + dx*dx <= radius2 ) {
+                        ClusterLightPair pair;
+                            pair.cluster = getClusterIndex( x, y, z );
+                            pair.light = i;
+                        pairs.push_back( pair );
+                    }
+                }
+            }
+        }
+    }
+}
@@ -18,15 +18,17 @@ PointLight::PointLight( SceneObjectFactory* factory, Root *root ) :
     setCastShadow( true );
 }
 
-void PointLight::submitRenderer( Renderer &renderer )
+void PointLight::submitRenderer( Renderer &renderer, const SceneSnapshot::ObjectEntry &entry )
 {
     PointLightUniforms uniforms;
         uniforms.color = getColor();
         uniforms.intensity = mIntensity;
-        uniforms.modelMatrix = glm::scale( getTransform(), glm::vec3(mOuterRadius) );
+        uniforms.modelMatrix = glm::scale( entry.transform, glm::vec3(mOuterRadius) );
         uniforms.radius = glm::vec2(mInnerRadius,mOuterRadius);
         
-    renderer.addPointLight( renderer.aquireUniformBuffer(uniforms), getTransform(), getPosition(), mOuterRadius, getCastShadow() );
+    // lights has no parent, the position is the translation of the transform
+    glm::vec3 position = glm::vec3( entry.transform[3] );
+    renderer.addPointLight( uniforms, entry.transform, position, mOuterRadius, getCastShadow(), this );
 }
 
 
@@ -26,19 +26,39 @@ Mesh::Mesh( const SharedPtr<VertexArrayObject> &vao,
     mSubMeshes(subMeshes),
     mBoundingSphere(bounds)
 {
+    mHandle = HandleTable<Mesh>::Add( this );
 }
 
-SharedPtr<VertexArrayObject> Mesh::getVertexArrayObject()
+Mesh::Mesh( const SharedPtr<VertexArrayObject> &vao, 
+            const GpuSubBuffer &vertexes, 
+            const GpuSubBuffer &indexes, 
+            const std::vector<SubMesh> &subMeshes,
+            const BoundingSphere &bounds ) :
+    mVertexArrayObject(vao),
+    mVertexes(vertexes),
+    mIndexes(indexes),
+    mSubMeshes(subMeshes),
+    mBoundingSphere(bounds)
+{
+    mHandle = HandleTable<Mesh>::Add( this );
+}
+
+Mesh::~Mesh()
+{
+    HandleTable<Mesh>::Remove( mHandle );
+}
+
+const SharedPtr<VertexArrayObject>& Mesh::getVertexArrayObject()
 {
     return mVertexArrayObject;
 }
 
-SharedPtr<GpuBuffer> Mesh::getVertexBuffer()
+const SharedPtr<GpuBuffer>& Mesh::getVertexBuffer()
 {
     return mVertexBuffer;
 }
 
-SharedPtr<GpuBuffer> Mesh::getIndexBuffer()
+const SharedPtr<GpuBuffer>& Mesh::getIndexBuffer()
 {
     return mIndexBuffer;
 }
@@ -51,6 +71,6 @@ const std::vector<SubMesh> &Mesh::getSubMeshes()
 SharedPtr<Mesh> Mesh::LoadMeshFromFile( const std::string &filename, 
                                         ResourceManager *resourceMgr )
 {
-    MeshLoaderAssimp loader;
+    MeshLoaderAssimp loader( resourceMgr ? resourceMgr->getStaticMeshBuffers() : nullptr );
     return loader.loadFile( filename );
 }
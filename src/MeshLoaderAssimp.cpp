@@ -3,6 +3,7 @@
 #include "GpuBuffer.h"
 #include "Mesh.h"
 #include "Skeleton.h"
+#include "StaticMeshBuffers.h"
 
 #include "GLinclude.h"
 
@@ -27,13 +28,18 @@
 
 void countVertexesAndIndexes( const aiScene *scene, int &vertexCount, int &indexCount );
 
-SharedPtr<Mesh> loadMesh( const aiScene *scene );
+SharedPtr<Mesh> loadMesh( const aiScene *scene, StaticMeshBuffers *staticBuffers );
 SharedPtr<Mesh> loadAnimatedMesh( const aiScene *scene );
 
 template< typename Vertex >
 BoundingSphere calculateBounds( Vertex *vertexes, int count );
 
 
+MeshLoaderAssimp::MeshLoaderAssimp( StaticMeshBuffers *staticBuffers ) :
+    mStaticBuffers(staticBuffers)
+{
+}
+
 SharedPtr<Mesh> MeshLoaderAssimp::loadFile( const std::string &filename )
 {
     Assimp::Importer importer;
@@ -52,7 +58,7 @@ SharedPtr<Mesh> MeshLoaderAssimp::loadFile( const std::string &filename )
         return loadAnimatedMesh( scene );
     }
     else {
-        return loadMesh( scene );
+        return loadMesh( scene, mStaticBuffers );
     }
 }
 
@@ -85,9 +91,10 @@ BoundingSphere calculateBounds( Vertex *vertexes, int count )
     return BoundingSphere( center, radius );
 }
 
+// the indexes are relative to the first vertex
 template< typename Vertex, typename Callable >
-void buildMesh( const aiScene *scene, std::vector<SubMesh> &submeshes, SharedPtr<GpuBuffer> &vertexBuffer,
-                                                                 SharedPtr<GpuBuffer> &indexBuffer,
+void buildMesh( const aiScene *scene, std::vector<SubMesh> &submeshes, std::vector<Vertex> &vertexes,
+                                                                 std::vector<GLuint> &indexes,
                                                                  BoundingSphere &bounds, Callable parseVertex )
 {
     int vertexCount = 0,
@@ -95,11 +102,8 @@ void buildMesh( const aiScene *scene, std::vector<SubMesh> &submeshes, SharedPtr
                  
     countVertexesAndIndexes( scene, vertexCount, indexCount );
     
-    vertexBuffer = GpuBuffer::CreateBuffer( BufferType::Vertexes, sizeof(Vertex) * vertexCount, BufferUsage::WriteOnly, BufferUpdate::Static );
-    indexBuffer = GpuBuffer::CreateBuffer( BufferType::Indexes, sizeof(GLuint) * indexCount, BufferUsage::WriteOnly, BufferUpdate::Static );
-    
-    Vertex *vertexes = vertexBuffer->mapBuffer<Vertex>( BufferUsage::WriteOnly );
-    GLuint *indexes = indexBuffer->mapBuffer<GLuint>( BufferUsage::WriteOnly );
+    vertexes.resize( vertexCount );
+    indexes.resize( indexCount );
     
     unsigned int curVertex = 0, curIndex = 0;
     for( unsigned int i=0; i < scene->mNumMeshes; ++i ) {
@@ -130,10 +134,19 @@ void buildMesh( const aiScene *scene, std::vector<SubMesh> &submeshes, SharedPtr
         submeshes.push_back( submesh );
     }
     
-    bounds = calculateBounds( vertexes, vertexCount );
+    bounds = calculateBounds( vertexes.data(), vertexCount );
+}
+
+// for meshes that has buffers of their own
+template< typename Vertex >
+void uploadMesh( const std::vector<Vertex> &vertexes, const std::vector<GLuint> &indexes, SharedPtr<GpuBuffer> &vertexBuffer,
+                                                                                          SharedPtr<GpuBuffer> &indexBuffer )
+{
+    vertexBuffer = GpuBuffer::CreateBuffer( BufferType::Vertexes, sizeof(Vertex) * vertexes.size(), BufferUsage::WriteOnly, BufferUpdate::Static );
+    indexBuffer = GpuBuffer::CreateBuffer( BufferType::Indexes, sizeof(GLuint) * indexes.size(), BufferUsage::WriteOnly, BufferUpdate::Static );
     
-    indexBuffer->unmapBuffer();
-    vertexBuffer->unmapBuffer();
+    vertexBuffer->setContent( vertexes.data(), vertexes.size() );
+    indexBuffer->setContent( indexes.data(), indexes.size() );
 }
 
 glm::vec2 toGlm( const aiVector2D &v ) {
@@ -155,24 +168,18 @@ glm::quat toGlm( const aiQuaternion &quat )
 }
 
 
-SharedPtr<Mesh> loadMesh( const aiScene *scene )
+SharedPtr<Mesh> loadMesh( const aiScene *scene, StaticMeshBuffers *staticBuffers )
 {
-    struct Vertex {
-        glm::vec3 position,
-                  normal,
-                  tangent,
-                  bitangent;
-        glm::vec2 texcoord;
-    };
+    typedef Mesh::Vertex Vertex;
     
-    SharedPtr<GpuBuffer> vertexBuffer;
-    SharedPtr<GpuBuffer> indexBuffer;
+    std::vector<Vertex> vertexes;
+    std::vector<GLuint> indexes;
     BoundingSphere bounds;
     
     std::vector<SubMesh> submeshes;
     submeshes.reserve( scene->mNumMeshes );
     
-    buildMesh<Vertex>( scene, submeshes, vertexBuffer, indexBuffer, bounds, 
+    buildMesh<Vertex>( scene, submeshes, vertexes, indexes, bounds, 
         []( unsigned int i, const aiMesh *mesh, Vertex &vertex ) {
             vertex.position  = toGlm(mesh->mVertices[i]);
             vertex.normal    = toGlm(mesh->mNormals[i]);
@@ -182,6 +189,21 @@ SharedPtr<Mesh> loadMesh( const aiScene *scene )
         }
     );
     
+    if( staticBuffers ) {
+        StaticMeshBuffers::Allocation allocation = staticBuffers->addGeometry( vertexes, indexes );
+        
+        for( SubMesh &submesh : submeshes ) {
+            submesh.vertexStart += allocation.firstIndex;
+            submesh.baseVertex = allocation.baseVertex;
+        }
+        
+        return makeSharedPtr<Mesh>( allocation.vao, allocation.vertexes, allocation.indexes, submeshes, bounds );
+    }
+    
+    SharedPtr<GpuBuffer> vertexBuffer;
+    SharedPtr<GpuBuffer> indexBuffer;
+    uploadMesh( vertexes, indexes, vertexBuffer, indexBuffer );
+    
     SharedPtr<VertexArrayObject> vao = makeSharedPtr<VertexArrayObject>();
     
     vao->bindVAO();
@@ -211,8 +233,8 @@ SharedPtr<Mesh> loadAnimatedMesh( const aiScene *scene )
         float weights[4];
     };
     
-    SharedPtr<GpuBuffer> vertexBuffer;
-    SharedPtr<GpuBuffer> indexBuffer;
+    std::vector<Vertex> vertexes;
+    std::vector<GLuint> indexes;
     BoundingSphere bounds;
     
     std::vector<SubMesh> submeshes;
@@ -276,7 +298,7 @@ SharedPtr<Mesh> loadAnimatedMesh( const aiScene *scene )
         }
     }
     
-    buildMesh<Vertex>( scene, submeshes, vertexBuffer, indexBuffer, bounds, 
+    buildMesh<Vertex>( scene, submeshes, vertexes, indexes, bounds, 
         [&]( unsigned int i, const aiMesh *mesh, Vertex &vertex ) {
             vertex.position  = toGlm(mesh->mVertices[i]);
             vertex.normal    = toGlm(mesh->mNormals[i]);
@@ -434,6 +456,11 @@ SharedPtr<Mesh> loadAnimatedMesh( const aiScene *scene )
     }
     
     
+    // the animated meshes has another vertex layout, so they keep their own buffers
+    SharedPtr<GpuBuffer> vertexBuffer;
+    SharedPtr<GpuBuffer> indexBuffer;
+    uploadMesh( vertexes, indexes, vertexBuffer, indexBuffer );
+    
     SharedPtr<VertexArrayObject> vao = makeSharedPtr<VertexArrayObject>();
     
     vao->bindVAO();
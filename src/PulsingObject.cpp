@@ -15,24 +15,10 @@ void PulsingObject::update( float dt )
     
     mOffset += dt;
     mOffset = glm::mod( mOffset, glm::pi<float>()*2.f );
-    mScale = glm::sin(mOffset) * (mMaxScale - mMinScale) + mMinScale;
+    float scale = glm::sin(mOffset) * (mMaxScale - mMinScale) + mMinScale;
     
-    BoundingSphere bounds = getMesh()->getBoundingSphere();
-    
-    // not correct if bounds.getCenter() != (0,0,0)
-    setBoundingSphere( BoundingSphere(glm::vec3(),bounds.getRadius()*mScale) );
-}
-
-void PulsingObject::submitRenderer( Renderer &renderer )
-{
-    renderer.addMesh( getMesh(), getMaterial(), glm::scale(getTransform(),glm::vec3(mScale)) );
-}
-
-void PulsingObject::submitShadowCasters(Renderer& renderer)
-{
-    if( getCastShadow() ) {
-        renderer.addShadowMesh( getMesh(), glm::scale(getTransform(),glm::vec3(mScale)) );
-    }
+    // the scene graph scales the bounds & transform for us
+    setScale( glm::vec3(scale) );
 }
 
 
@@ -0,0 +1,515 @@
+#include "RecordingRenderDevice.h"
+#include "GLinclude.h"
+
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+
+// the value most desktop drivers reports
+static const GLint UNIFORM_BUFFER_OFFSET_ALIGNMENT = 256;
+
+static GLenum bindingToTarget( GLenum binding )
+{
+    switch( binding ) {
+    case( GL_ARRAY_BUFFER_BINDING ):
+        return GL_ARRAY_BUFFER;
+    case( GL_ELEMENT_ARRAY_BUFFER_BINDING ):
+        return GL_ELEMENT_ARRAY_BUFFER;
+    case( GL_UNIFORM_BUFFER_BINDING ):
+        return GL_UNIFORM_BUFFER;
+    case( GL_SHADER_STORAGE_BUFFER_BINDING ):
+        return GL_SHADER_STORAGE_BUFFER;
+    case( GL_DRAW_INDIRECT_BUFFER_BINDING ):
+        return GL_DRAW_INDIRECT_BUFFER;
+    case( GL_TEXTURE_BINDING_2D ):
+        return GL_TEXTURE_2D;
+    case( GL_TEXTURE_BINDING_CUBE_MAP ):
+        return GL_TEXTURE_CUBE_MAP;
+    }
+    return 0;
+}
+
+GLint RecordingRenderDevice::getInteger( GLenum name )
+{
+    switch( name ) {
+    case( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT ):
+        return UNIFORM_BUFFER_OFFSET_ALIGNMENT;
+    case( GL_CURRENT_PROGRAM ):
+        return mState.program;
+    case( GL_VERTEX_ARRAY_BINDING ):
+        return mState.vao;
+    case( GL_FRAMEBUFFER_BINDING ):
+        return mState.framebuffer;
+    case( GL_TEXTURE_BINDING_2D ):
+    case( GL_TEXTURE_BINDING_CUBE_MAP ): {
+        auto iter = mState.textures.find( std::make_pair(mState.activeUnit,bindingToTarget(name)) );
+        return iter != mState.textures.end() ? iter->second : 0;
+    }
+    default: {
+        GLenum target = bindingToTarget( name );
+        auto iter = mState.buffers.find( target );
+        return iter != mState.buffers.end() ? iter->second : 0;
+    }
+    }
+}
+
+GLuint RecordingRenderDevice::genBuffer()
+{
+    countCall( mCounters.resourceCalls );
+    GLuint buffer = mNextName++;
+    mBuffers[buffer];
+    return buffer;
+}
+
+void RecordingRenderDevice::deleteBuffer( GLuint buffer )
+{
+    countCall( mCounters.resourceCalls );
+    mBuffers.erase( buffer );
+}
+
+void RecordingRenderDevice::bindBuffer( GLenum target, GLuint buffer )
+{
+    GLuint &bound = mState.buffers[target];
+    countCall( mCounters.bindCalls, bound == buffer );
+    bound = buffer;
+    
+    if( target == GL_ELEMENT_ARRAY_BUFFER ) {
+        mVAOElementBuffers[mState.vao] = buffer;
+    }
+}
+
+void RecordingRenderDevice::bindBufferBase( GLenum target, GLuint index, GLuint buffer )
+{
+    bindBufferRange( target, index, buffer, 0, -1 );
+}
+
+void RecordingRenderDevice::bindBufferRange( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size )
+{
+    auto key = std::make_pair( target, index );
+    auto iter = mState.indexedBuffers.find( key );
+    
+    bool redundant = iter != mState.indexedBuffers.end() && 
+                     iter->second.buffer == buffer && 
+                     iter->second.offset == offset && 
+                     iter->second.size == size;
+    countCall( mCounters.bindCalls, redundant );
+    
+    BufferRange range;
+        range.buffer = buffer;
+        range.offset = offset;
+        range.size = size;
+    mState.indexedBuffers[key] = range;
+    // binding to an indexed target also binds the generic target
+    mState.buffers[target] = buffer;
+}
+
+void RecordingRenderDevice::bufferData( GLenum target, GLsizeiptr size, const void *data, GLenum usage )
+{
+    countCall( mCounters.resourceCalls );
+    
+    BufferStorage &storage = getBoundStorage( target );
+    storage.memory.resize( size );
+    if( data ) {
+        std::memcpy( storage.memory.data(), data, size );
+        mCounters.uploadedBytes += size;
+    }
+}
+
+void RecordingRenderDevice::bufferStorage( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags )
+{
+    // the memory stays where it is, so persistent mappings works as they are
+    bufferData( target, size, data, 0 );
+}
+
+GLint RecordingRenderDevice::getBufferParameter( GLenum target, GLenum name )
+{
+    BufferStorage &storage = getBoundStorage( target );
+    switch( name ) {
+    case( GL_BUFFER_MAPPED ):
+        return storage.mapped ? GL_TRUE : GL_FALSE;
+    case( GL_BUFFER_SIZE ):
+        return storage.memory.size();
+    }
+    return 0;
+}
+
+void* RecordingRenderDevice::mapBuffer( GLenum target, GLenum access )
+{
+    BufferStorage &storage = getBoundStorage( target );
+    return mapBufferRange( target, 0, storage.memory.size(), 0 );
+}
+
+void* RecordingRenderDevice::mapBufferRange( GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access )
+{
+    countCall( mCounters.resourceCalls );
+    
+    BufferStorage &storage = getBoundStorage( target );
+    assert( !storage.mapped );
+    assert( (size_t)(offset+length) <= storage.memory.size() );
+    
+    storage.mapped = true;
+    storage.persistent = (access & GL_MAP_PERSISTENT_BIT) != 0;
+    return storage.memory.data() + offset;
+}
+
+void RecordingRenderDevice::flushMappedBufferRange( GLenum target, GLintptr offset, GLsizeiptr length )
+{
+    countCall( mCounters.resourceCalls );
+    
+    assert( getBoundStorage(target).mapped );
+    mCounters.uploadedBytes += length;
+}
+
+void RecordingRenderDevice::unmapBuffer( GLenum target )
+{
+    countCall( mCounters.resourceCalls );
+    
+    BufferStorage &storage = getBoundStorage( target );
+    assert( storage.mapped );
+    storage.mapped = false;
+}
+
+void RecordingRenderDevice::getBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, void *data )
+{
+    countCall( mCounters.resourceCalls );
+    
+    BufferStorage &storage = getBoundStorage( target );
+    // like in gl, only persistent mappings can be read from while they're mapped
+    assert( !storage.mapped || storage.persistent );
+    assert( (size_t)(offset+size) <= storage.memory.size() );
+    
+    std::memcpy( data, storage.memory.data() + offset, size );
+}
+
+GLuint RecordingRenderDevice::genTexture()
+{
+    countCall( mCounters.resourceCalls );
+    return mNextName++;
+}
+
+void RecordingRenderDevice::deleteTexture( GLuint texture )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::activeTexture( GLenum unit )
+{
+    GLuint index = unit - GL_TEXTURE0;
+    countCall( mCounters.bindCalls, mState.activeUnit == index );
+    mState.activeUnit = index;
+}
+
+void RecordingRenderDevice::bindTexture( GLenum target, GLuint texture )
+{
+    GLuint &bound = mState.textures[std::make_pair(mState.activeUnit,target)];
+    countCall( mCounters.bindCalls, bound == texture );
+    bound = texture;
+}
+
+void RecordingRenderDevice::texStorage2D( GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::texSubImage2D( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::texParameteri( GLenum target, GLenum name, GLint param )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::generateMipmap( GLenum target )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::copyImageSubData2D( GLuint src, GLuint dst, GLsizei width, GLsizei height )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::bindImageTexture( GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format )
+{
+    countCall( mCounters.bindCalls );
+}
+
+GLuint RecordingRenderDevice::genFramebuffer()
+{
+    countCall( mCounters.resourceCalls );
+    return mNextName++;
+}
+
+void RecordingRenderDevice::deleteFramebuffer( GLuint framebuffer )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::bindFramebuffer( GLenum target, GLuint framebuffer )
+{
+    countCall( mCounters.bindCalls, mState.framebuffer == framebuffer );
+    mState.framebuffer = framebuffer;
+}
+
+void RecordingRenderDevice::framebufferTexture( GLenum target, GLenum attachment, GLuint texture, GLint level )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+GLenum RecordingRenderDevice::checkFramebufferStatus( GLenum target )
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void RecordingRenderDevice::drawBuffers( GLsizei count, const GLenum *buffers )
+{
+    countCall( mCounters.stateCalls );
+}
+
+GLuint RecordingRenderDevice::genVertexArray()
+{
+    countCall( mCounters.resourceCalls );
+    return mNextName++;
+}
+
+void RecordingRenderDevice::deleteVertexArray( GLuint vao )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::bindVertexArray( GLuint vao )
+{
+    countCall( mCounters.bindCalls, mState.vao == vao );
+    mState.vao = vao;
+    // the element array binding is part of the vao, like in gl
+    mState.buffers[GL_ELEMENT_ARRAY_BUFFER] = mVAOElementBuffers[vao];
+}
+
+void RecordingRenderDevice::enableVertexAttribArray( GLuint index )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::vertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::useProgram( GLuint program )
+{
+    countCall( mCounters.bindCalls, mState.program == program );
+    mState.program = program;
+}
+
+void RecordingRenderDevice::deleteProgram( GLuint program )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+GLint RecordingRenderDevice::getUniformLocation( GLuint program, const char *name )
+{
+    // setting location -1 is ignored by gl as well
+    return -1;
+}
+
+void RecordingRenderDevice::uniform1i( GLint location, GLint value )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::uniform1f( GLint location, GLfloat value )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::enable( GLenum cap )
+{
+    countCall( mCounters.stateCalls, mState.enabled.count(cap) != 0 );
+    mState.enabled.insert( cap );
+}
+
+void RecordingRenderDevice::disable( GLenum cap )
+{
+    countCall( mCounters.stateCalls, mState.enabled.count(cap) == 0 );
+    mState.enabled.erase( cap );
+}
+
+void RecordingRenderDevice::blendFunc( GLenum src, GLenum dst )
+{
+    countCall( mCounters.stateCalls, mState.blendSrc == src && mState.blendDst == dst );
+    mState.blendSrc = src;
+    mState.blendDst = dst;
+}
+
+void RecordingRenderDevice::depthMask( GLboolean write )
+{
+    countCall( mCounters.stateCalls, mState.depthMask == write );
+    mState.depthMask = write;
+}
+
+void RecordingRenderDevice::depthFunc( GLenum func )
+{
+    countCall( mCounters.stateCalls, mState.depthFunc == func );
+    mState.depthFunc = func;
+}
+
+void RecordingRenderDevice::cullFace( GLenum face )
+{
+    countCall( mCounters.stateCalls, mState.cullFace == face );
+    mState.cullFace = face;
+}
+
+void RecordingRenderDevice::colorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    GLboolean *mask = mState.colorMask;
+    countCall( mCounters.stateCalls, mask[0] == r && mask[1] == g && mask[2] == b && mask[3] == a );
+    mask[0] = r; mask[1] = g; mask[2] = b; mask[3] = a;
+}
+
+void RecordingRenderDevice::colorMaski( GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::viewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    GLint *vp = mState.viewport;
+    countCall( mCounters.stateCalls, vp[0] == x && vp[1] == y && vp[2] == width && vp[3] == height );
+    vp[0] = x; vp[1] = y; vp[2] = width; vp[3] = height;
+}
+
+void RecordingRenderDevice::clear( GLbitfield mask )
+{
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawArrays( GLenum mode, GLint first, GLsizei count )
+{
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawElements( GLenum mode, GLsizei count, GLenum type, const void *offset )
+{
+    assert( mState.buffers[GL_ELEMENT_ARRAY_BUFFER] != 0 );
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount )
+{
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount )
+{
+    assert( mState.buffers[GL_ELEMENT_ARRAY_BUFFER] != 0 );
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex )
+{
+    assert( mState.buffers[GL_ELEMENT_ARRAY_BUFFER] != 0 );
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::drawElementsInstancedBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount, GLint baseVertex )
+{
+    assert( mState.buffers[GL_ELEMENT_ARRAY_BUFFER] != 0 );
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::multiDrawElementsIndirect( GLenum mode, GLenum type, const void *offset, GLsizei drawCount, GLsizei stride )
+{
+    assert( mState.buffers[GL_DRAW_INDIRECT_BUFFER] != 0 );
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::dispatchCompute( GLuint x, GLuint y, GLuint z )
+{
+    countCall( mCounters.drawCalls );
+}
+
+void RecordingRenderDevice::memoryBarrier( GLbitfield barriers )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::genQueries( GLsizei count, GLuint *queries )
+{
+    countCall( mCounters.resourceCalls );
+    for( GLsizei i=0; i < count; ++i ) {
+        queries[i] = mNextName++;
+    }
+}
+
+void RecordingRenderDevice::beginQuery( GLenum target, GLuint query )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::endQuery( GLenum target )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::beginConditionalRender( GLuint query, GLenum mode )
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::endConditionalRender()
+{
+    countCall( mCounters.stateCalls );
+}
+
+void RecordingRenderDevice::deleteQueries( GLsizei count, const GLuint *queries )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+void RecordingRenderDevice::queryCounter( GLuint query, GLenum target )
+{
+    countCall( mCounters.stateCalls );
+}
+
+GLint RecordingRenderDevice::getQueryObject( GLuint query, GLenum name )
+{
+    countCall( mCounters.resourceCalls );
+    // nothing is ever waited for, every result is there right away
+    return (name == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+UInt64 RecordingRenderDevice::getQueryObjectui64( GLuint query, GLenum name )
+{
+    countCall( mCounters.resourceCalls );
+    return 0;
+}
+
+GLsync RecordingRenderDevice::fenceSync()
+{
+    countCall( mCounters.stateCalls );
+    // never dereferenced, it only has to be unique & not null
+    return reinterpret_cast<GLsync>( (uintptr_t)mNextName++ );
+}
+
+GLenum RecordingRenderDevice::clientWaitSync( GLsync sync, GLbitfield flags, UInt64 timeout )
+{
+    countCall( mCounters.stateCalls );
+    return GL_ALREADY_SIGNALED;
+}
+
+void RecordingRenderDevice::deleteSync( GLsync sync )
+{
+    countCall( mCounters.resourceCalls );
+}
+
+RecordingRenderDevice::BufferStorage& RecordingRenderDevice::getBoundStorage( GLenum target )
+{
+    GLuint buffer = mState.buffers[target];
+    assert( buffer != 0 && "No buffer bound to the target!" );
+    
+    auto iter = mBuffers.find( buffer );
+    assert( iter != mBuffers.end() );
+    return iter->second;
+}
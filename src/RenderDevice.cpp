@@ -0,0 +1,28 @@
+#include "RenderDevice.h"
+#include "GLRenderDevice.h"
+#include "GLinclude.h"
+
+static RenderDevice *sDevice = nullptr;
+
+static GLRenderDevice* getGLDevice()
+{
+    // the gl device doesn't have any state, so one instance can be shared for the whole program
+    static GLRenderDevice device;
+    return &device;
+}
+
+RenderDevice* RenderDevice::GetDevice()
+{
+    return sDevice ? sDevice : getGLDevice();
+}
+
+void RenderDevice::SetDevice( RenderDevice *device )
+{
+    sDevice = device;
+}
+
+void RenderDevice::bindTextureUnit( GLuint unit, GLenum target, GLuint texture )
+{
+    activeTexture( GL_TEXTURE0 + unit );
+    bindTexture( target, texture );
+}
@@ -0,0 +1,539 @@
+#include "RenderStateCache.h"
+#include "GLinclude.h"
+
+#include <cassert>
+
+RenderStateCache::RenderStateCache( RenderDevice *device ) :
+    mDevice(device)
+{
+    assert( mDevice );
+    invalidate();
+}
+
+void RenderStateCache::setDevice( RenderDevice *device )
+{
+    assert( device );
+    mDevice = device;
+    invalidate();
+}
+
+void RenderStateCache::invalidate()
+{
+    mProgram = UNKNOWN;
+    mFramebuffer = UNKNOWN;
+    mActiveUnit = UNKNOWN;
+    
+    for( int i=0; i < MAX_TEXTURE_UNITS; ++i ) {
+        mTextures[i][0] = UNKNOWN;
+        mTextures[i][1] = UNKNOWN;
+    }
+    for( int i=0; i < MAX_UNIFORM_BINDINGS; ++i ) {
+        mUniformRanges[i].buffer = UNKNOWN;
+        mUniformRanges[i].offset = 0;
+        mUniformRanges[i].size = 0;
+    }
+    
+    mCaps.clear();
+    mBlendSrc = UNKNOWN;
+    mBlendDst = UNKNOWN;
+    mDepthMask = UNKNOWN;
+    mDepthFunc = UNKNOWN;
+    mCullFace = UNKNOWN;
+    mColorMask = UNKNOWN;
+    mViewportKnown = false;
+}
+
+void RenderStateCache::setEnabled( bool enabled )
+{
+    mEnabled = enabled;
+    invalidate();
+}
+
+GLuint* RenderStateCache::getCachedTexture( GLuint unit, GLenum target )
+{
+    if( unit >= (GLuint)MAX_TEXTURE_UNITS ) {
+        return nullptr;
+    }
+    switch( target ) {
+    case( GL_TEXTURE_2D ):
+        return &mTextures[unit][0];
+    case( GL_TEXTURE_CUBE_MAP ):
+        return &mTextures[unit][1];
+    }
+    return nullptr;
+}
+
+GLint RenderStateCache::getInteger( GLenum name )
+{
+    return mDevice->getInteger( name );
+}
+
+GLuint RenderStateCache::genBuffer()
+{
+    return mDevice->genBuffer();
+}
+
+void RenderStateCache::deleteBuffer( GLuint buffer )
+{
+    // the name can be reused by a new buffer
+    for( UniformRange &range : mUniformRanges ) {
+        if( range.buffer == buffer ) {
+            range.buffer = UNKNOWN;
+        }
+    }
+    mDevice->deleteBuffer( buffer );
+}
+
+void RenderStateCache::bindBuffer( GLenum target, GLuint buffer )
+{
+    mDevice->bindBuffer( target, buffer );
+}
+
+void RenderStateCache::bindBufferBase( GLenum target, GLuint index, GLuint buffer )
+{
+    if( target == GL_UNIFORM_BUFFER && index < (GLuint)MAX_UNIFORM_BINDINGS ) {
+        // a base bind is the whole buffer, use a size that a range can't have
+        UniformRange &range = mUniformRanges[index];
+        if( !shouldIssue(range.buffer == buffer && range.offset == 0 && range.size == -1) ) {
+            return;
+        }
+        range.buffer = buffer;
+        range.offset = 0;
+        range.size = -1;
+    }
+    mDevice->bindBufferBase( target, index, buffer );
+}
+
+void RenderStateCache::bindBufferRange( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size )
+{
+    if( target == GL_UNIFORM_BUFFER && index < (GLuint)MAX_UNIFORM_BINDINGS ) {
+        UniformRange &range = mUniformRanges[index];
+        if( !shouldIssue(range.buffer == buffer && range.offset == offset && range.size == size) ) {
+            return;
+        }
+        range.buffer = buffer;
+        range.offset = offset;
+        range.size = size;
+    }
+    mDevice->bindBufferRange( target, index, buffer, offset, size );
+}
+
+void RenderStateCache::bufferData( GLenum target, GLsizeiptr size, const void *data, GLenum usage )
+{
+    mDevice->bufferData( target, size, data, usage );
+}
+
+void RenderStateCache::bufferStorage( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags )
+{
+    mDevice->bufferStorage( target, size, data, flags );
+}
+
+GLint RenderStateCache::getBufferParameter( GLenum target, GLenum name )
+{
+    return mDevice->getBufferParameter( target, name );
+}
+
+void* RenderStateCache::mapBuffer( GLenum target, GLenum access )
+{
+    return mDevice->mapBuffer( target, access );
+}
+
+void* RenderStateCache::mapBufferRange( GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access )
+{
+    return mDevice->mapBufferRange( target, offset, length, access );
+}
+
+void RenderStateCache::flushMappedBufferRange( GLenum target, GLintptr offset, GLsizeiptr length )
+{
+    mDevice->flushMappedBufferRange( target, offset, length );
+}
+
+void RenderStateCache::unmapBuffer( GLenum target )
+{
+    mDevice->unmapBuffer( target );
+}
+
+void RenderStateCache::getBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, void *data )
+{
+    mDevice->getBufferSubData( target, offset, size, data );
+}
+
+GLuint RenderStateCache::genTexture()
+{
+    return mDevice->genTexture();
+}
+
+void RenderStateCache::deleteTexture( GLuint texture )
+{
+    // deleting a bound texture binds 0 in its place
+    for( int i=0; i < MAX_TEXTURE_UNITS; ++i ) {
+        for( GLuint &bound : mTextures[i] ) {
+            if( bound == texture ) {
+                bound = 0;
+            }
+        }
+    }
+    mDevice->deleteTexture( texture );
+}
+
+void RenderStateCache::activeTexture( GLenum unit )
+{
+    GLuint index = unit - GL_TEXTURE0;
+    if( !shouldIssue(mActiveUnit == index) ) {
+        return;
+    }
+    mActiveUnit = index;
+    mDevice->activeTexture( unit );
+}
+
+void RenderStateCache::bindTexture( GLenum target, GLuint texture )
+{
+    GLuint *cached = mActiveUnit != UNKNOWN ? getCachedTexture( mActiveUnit, target ) : nullptr;
+    if( cached ) {
+        if( !shouldIssue(*cached == texture) ) {
+            return;
+        }
+        *cached = texture;
+    }
+    mDevice->bindTexture( target, texture );
+}
+
+void RenderStateCache::bindTextureUnit( GLuint unit, GLenum target, GLuint texture )
+{
+    // the unit is always made active, code after a bind can depend on it (glTexParameter etc.)
+    activeTexture( GL_TEXTURE0 + unit );
+    bindTexture( target, texture );
+}
+
+void RenderStateCache::texStorage2D( GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height )
+{
+    mDevice->texStorage2D( target, levels, internalFormat, width, height );
+}
+
+void RenderStateCache::texSubImage2D( GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels )
+{
+    mDevice->texSubImage2D( target, level, x, y, width, height, format, type, pixels );
+}
+
+void RenderStateCache::texParameteri( GLenum target, GLenum name, GLint param )
+{
+    mDevice->texParameteri( target, name, param );
+}
+
+void RenderStateCache::generateMipmap( GLenum target )
+{
+    mDevice->generateMipmap( target );
+}
+
+void RenderStateCache::copyImageSubData2D( GLuint src, GLuint dst, GLsizei width, GLsizei height )
+{
+    mDevice->copyImageSubData2D( src, dst, width, height );
+}
+
+void RenderStateCache::bindImageTexture( GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format )
+{
+    mDevice->bindImageTexture( unit, texture, level, layered, layer, access, format );
+}
+
+GLuint RenderStateCache::genFramebuffer()
+{
+    return mDevice->genFramebuffer();
+}
+
+void RenderStateCache::deleteFramebuffer( GLuint framebuffer )
+{
+    if( mFramebuffer == framebuffer ) {
+        mFramebuffer = UNKNOWN;
+    }
+    mDevice->deleteFramebuffer( framebuffer );
+}
+
+void RenderStateCache::bindFramebuffer( GLenum target, GLuint framebuffer )
+{
+    if( target == GL_FRAMEBUFFER ) {
+        if( !shouldIssue(mFramebuffer == framebuffer) ) {
+            return;
+        }
+        mFramebuffer = framebuffer;
+    }
+    else {
+        // only one of draw/read changes
+        mFramebuffer = UNKNOWN;
+    }
+    mDevice->bindFramebuffer( target, framebuffer );
+}
+
+void RenderStateCache::framebufferTexture( GLenum target, GLenum attachment, GLuint texture, GLint level )
+{
+    mDevice->framebufferTexture( target, attachment, texture, level );
+}
+
+GLenum RenderStateCache::checkFramebufferStatus( GLenum target )
+{
+    return mDevice->checkFramebufferStatus( target );
+}
+
+void RenderStateCache::drawBuffers( GLsizei count, const GLenum *buffers )
+{
+    mDevice->drawBuffers( count, buffers );
+}
+
+GLuint RenderStateCache::genVertexArray()
+{
+    return mDevice->genVertexArray();
+}
+
+void RenderStateCache::deleteVertexArray( GLuint vao )
+{
+    mDevice->deleteVertexArray( vao );
+}
+
+void RenderStateCache::bindVertexArray( GLuint vao )
+{
+    // not cached, the element array binding is part of the vao state
+    // and GpuBuffer binds it outside of the vao
+    mDevice->bindVertexArray( vao );
+}
+
+void RenderStateCache::enableVertexAttribArray( GLuint index )
+{
+    mDevice->enableVertexAttribArray( index );
+}
+
+void RenderStateCache::vertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *offset )
+{
+    mDevice->vertexAttribPointer( index, size, type, normalized, stride, offset );
+}
+
+void RenderStateCache::useProgram( GLuint program )
+{
+    if( !shouldIssue(mProgram == program) ) {
+        return;
+    }
+    mProgram = program;
+    mDevice->useProgram( program );
+}
+
+void RenderStateCache::deleteProgram( GLuint program )
+{
+    // the name can be reused once the program is deleted
+    if( mProgram == program ) {
+        mProgram = UNKNOWN;
+    }
+    mDevice->deleteProgram( program );
+}
+
+GLint RenderStateCache::getUniformLocation( GLuint program, const char *name )
+{
+    return mDevice->getUniformLocation( program, name );
+}
+
+void RenderStateCache::uniform1i( GLint location, GLint value )
+{
+    mDevice->uniform1i( location, value );
+}
+
+void RenderStateCache::uniform1f( GLint location, GLfloat value )
+{
+    mDevice->uniform1f( location, value );
+}
+
+void RenderStateCache::enable( GLenum cap )
+{
+    auto iter = mCaps.find( cap );
+    if( !shouldIssue(iter != mCaps.end() && iter->second == 1) ) {
+        return;
+    }
+    mCaps[cap] = 1;
+    mDevice->enable( cap );
+}
+
+void RenderStateCache::disable( GLenum cap )
+{
+    auto iter = mCaps.find( cap );
+    if( !shouldIssue(iter != mCaps.end() && iter->second == 0) ) {
+        return;
+    }
+    mCaps[cap] = 0;
+    mDevice->disable( cap );
+}
+
+void RenderStateCache::blendFunc( GLenum src, GLenum dst )
+{
+    if( !shouldIssue(mBlendSrc == src && mBlendDst == dst) ) {
+        return;
+    }
+    mBlendSrc = src;
+    mBlendDst = dst;
+    mDevice->blendFunc( src, dst );
+}
+
+void RenderStateCache::depthMask( GLboolean write )
+{
+    if( !shouldIssue(mDepthMask == write) ) {
+        return;
+    }
+    mDepthMask = write;
+    mDevice->depthMask( write );
+}
+
+void RenderStateCache::depthFunc( GLenum func )
+{
+    if( !shouldIssue(mDepthFunc == func) ) {
+        return;
+    }
+    mDepthFunc = func;
+    mDevice->depthFunc( func );
+}
+
+void RenderStateCache::cullFace( GLenum face )
+{
+    if( !shouldIssue(mCullFace == face) ) {
+        return;
+    }
+    mCullFace = face;
+    mDevice->cullFace( face );
+}
+
+void RenderStateCache::colorMask( GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    GLuint mask = (r ? 1 : 0) | (g ? 2 : 0) | (b ? 4 : 0) | (a ? 8 : 0);
+    if( !shouldIssue(mColorMask == mask) ) {
+        return;
+    }
+    mColorMask = mask;
+    mDevice->colorMask( r, g, b, a );
+}
+
+void RenderStateCache::colorMaski( GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a )
+{
+    // the buffers can have different masks now
+    mColorMask = UNKNOWN;
+    mDevice->colorMaski( index, r, g, b, a );
+}
+
+void RenderStateCache::viewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    bool unchanged = mViewportKnown && 
+                     mViewport[0] == x && mViewport[1] == y && 
+                     mViewport[2] == width && mViewport[3] == height;
+    if( !shouldIssue(unchanged) ) {
+        return;
+    }
+    mViewport[0] = x;
+    mViewport[1] = y;
+    mViewport[2] = width;
+    mViewport[3] = height;
+    mViewportKnown = true;
+    mDevice->viewport( x, y, width, height );
+}
+
+void RenderStateCache::clear( GLbitfield mask )
+{
+    mDevice->clear( mask );
+}
+
+void RenderStateCache::drawArrays( GLenum mode, GLint first, GLsizei count )
+{
+    mDevice->drawArrays( mode, first, count );
+}
+
+void RenderStateCache::drawElements( GLenum mode, GLsizei count, GLenum type, const void *offset )
+{
+    mDevice->drawElements( mode, count, type, offset );
+}
+
+void RenderStateCache::drawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei instanceCount )
+{
+    mDevice->drawArraysInstanced( mode, first, count, instanceCount );
+}
+
+void RenderStateCache::drawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount )
+{
+    mDevice->drawElementsInstanced( mode, count, type, offset, instanceCount );
+}
+
+void RenderStateCache::drawElementsBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLint baseVertex )
+{
+    mDevice->drawElementsBaseVertex( mode, count, type, offset, baseVertex );
+}
+
+void RenderStateCache::drawElementsInstancedBaseVertex( GLenum mode, GLsizei count, GLenum type, const void *offset, GLsizei instanceCount, GLint baseVertex )
+{
+    mDevice->drawElementsInstancedBaseVertex( mode, count, type, offset, instanceCount, baseVertex );
+}
+
+void RenderStateCache::multiDrawElementsIndirect( GLenum mode, GLenum type, const void *offset, GLsizei drawCount, GLsizei stride )
+{
+    mDevice->multiDrawElementsIndirect( mode, type, offset, drawCount, stride );
+}
+
+void RenderStateCache::dispatchCompute( GLuint x, GLuint y, GLuint z )
+{
+    mDevice->dispatchCompute( x, y, z );
+}
+
+void RenderStateCache::memoryBarrier( GLbitfield barriers )
+{
+    mDevice->memoryBarrier( barriers );
+}
+
+void RenderStateCache::genQueries( GLsizei count, GLuint *queries )
+{
+    mDevice->genQueries( count, queries );
+}
+
+void RenderStateCache::beginQuery( GLenum target, GLuint query )
+{
+    mDevice->beginQuery( target, query );
+}
+
+void RenderStateCache::endQuery( GLenum target )
+{
+    mDevice->endQuery( target );
+}
+
+void RenderStateCache::beginConditionalRender( GLuint query, GLenum mode )
+{
+    mDevice->beginConditionalRender( query, mode );
+}
+
+void RenderStateCache::endConditionalRender()
+{
+    mDevice->endConditionalRender();
+}
+
+void RenderStateCache::deleteQueries( GLsizei count, const GLuint *queries )
+{
+    mDevice->deleteQueries( count, queries );
+}
+
+void RenderStateCache::queryCounter( GLuint query, GLenum target )
+{
+    mDevice->queryCounter( query, target );
+}
+
+GLint RenderStateCache::getQueryObject( GLuint query, GLenum name )
+{
+    return mDevice->getQueryObject( query, name );
+}
+
+UInt64 RenderStateCache::getQueryObjectui64( GLuint query, GLenum name )
+{
+    return mDevice->getQueryObjectui64( query, name );
+}
+
+GLsync RenderStateCache::fenceSync()
+{
+    return mDevice->fenceSync();
+}
+
+GLenum RenderStateCache::clientWaitSync( GLsync sync, GLbitfield flags, UInt64 timeout )
+{
+    return mDevice->clientWaitSync( sync, flags, timeout );
+}
+
+void RenderStateCache::deleteSync( GLsync sync )
+{
+    mDevice->deleteSync( sync );
+}
@@ -0,0 +1,91 @@
+#include "RenderThread.h"
+#include "Timer.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+
+RenderThread::RenderThread( SDL_Window *window, SDL_GLContext context, unsigned int frameLatency ) :
+    mWindow(window),
+    mContext(context),
+    mFrameLatency(std::max(frameLatency,1u)),
+    mFrameTime(0.f),
+    mWaitTime(0.f)
+{
+    mThread = std::thread( &RenderThread::threadMain, this );
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mQuit = true;
+    }
+    mTaskCondition.notify_one();
+    mThread.join();
+}
+
+void RenderThread::enqueue( const Task &task )
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mTasks.push_back( task );
+    }
+    mTaskCondition.notify_one();
+}
+
+void RenderThread::endFrame()
+{
+    Timer waitTimer;
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+        
+        // an empty task marks the end of the frame
+        mTasks.push_back( Task() );
+        mQueuedFrames++;
+        mTaskCondition.notify_one();
+        
+        mFrameCondition.wait( lock, [this]{ return mQueuedFrames <= mFrameLatency; } );
+    }
+    mWaitTime = std::chrono::duration_cast<Timer::Millisecond>(waitTimer.getTimeAsDuration()).count();
+}
+
+void RenderThread::threadMain()
+{
+    SDL_GL_MakeCurrent( mWindow, mContext );
+    
+    Timer taskTimer;
+    Timer::Duration frameTime = Timer::Duration::zero();
+    
+    while( true ) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock( mMutex );
+            mTaskCondition.wait( lock, [this]{ return mQuit || !mTasks.empty(); } );
+            if( mTasks.empty() ) {
+                // only quit once everything queued is done
+                break;
+            }
+            task = std::move( mTasks.front() );
+            mTasks.pop_front();
+        }
+        
+        if( task ) {
+            taskTimer.restart();
+            task();
+            frameTime += taskTimer.getTimeAsDuration();
+        }
+        else {
+            mFrameTime = std::chrono::duration_cast<Timer::Millisecond>(frameTime).count();
+            frameTime = Timer::Duration::zero();
+            
+            SDL_GL_SwapWindow( mWindow );
+            
+            std::lock_guard<std::mutex> lock( mMutex );
+            mQueuedFrames--;
+            mFrameCondition.notify_one();
+        }
+    }
+    
+    SDL_GL_MakeCurrent( mWindow, nullptr );
+}
@@ -12,80 +12,213 @@
 #include "UniformBlockDefinitions.h"
 #include "Mesh.h"
 #include "Renderable.h"
+#include "RadixSort.h"
+#include "RenderDevice.h"
+#include "RenderStateCache.h"
+#include "UniformStagingBuffer.h"
+#include "WorkerPool.h"
+#include "Timer.h"
+#include "RenderThread.h"
+#include "GpuPassTimer.h"
+#include "GraphicsManager.h"
 #include <DebugDrawer.h>
 
+#include <stdexcept>
+#include <future>
+
 static const float SHADOW_NEAR_CLIP_PLANE = 0.01f;
+// shader storage binding for the instance matrices
+static const GLuint INSTANCE_MATRIX_BINDING = 0;
+// shader storage binding for the per draw data used with multi draw indirect
+static const GLuint INDIRECT_DRAW_DATA_BINDING = 1;
+// the submission is only split across the worker pool if each thread gets at least this many objects
+static const size_t MIN_OBJECTS_PER_SUBMIT_THREAD = 256;
+// shader storage bindings for the clustered light pass
+static const GLuint CLUSTERED_LIGHT_BINDING = 2;
+static const GLuint CLUSTERED_CLUSTER_BINDING = 3;
+static const GLuint CLUSTERED_INDEX_BINDING = 4;
+// same as for the submission, but binning a light is more work than submitting an object
+static const size_t MIN_LIGHTS_PER_CLUSTER_THREAD = 64;
+
+// the thread running submitRenderer, 0 is the main thread, which adds directly to the renderer.
+// worker thread 'n' adds to mSubmitLists[n-1]
+static thread_local size_t tSubmitThread = 0;
+
+// sort key for a draw, from the most significant bits:
+// pass (4 bits) | program (8) | diffuse texture (10) | normal map (10) | vao (16) | depth (16)
+// gl names are small integers, so they are used directly as ids.
+// if two names alias after masking the draws are just grouped a bit worse.
+static UInt64 makeSortKey( UInt64 pass, UInt64 program, UInt64 diffuse, UInt64 normalMap, UInt64 vao, UInt64 depth )
+{
+    return (pass & 0xF) << 60 | (program & 0xFF) << 52 | (diffuse & 0x3FF) << 42 | 
+           (normalMap & 0x3FF) << 32 | (vao & 0xFFFF) << 16 | (depth & 0xFFFF);
+}
 
 Renderer::Renderer( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mStateCache(new RenderStateCache(RenderDevice::GetDevice())),
+    mDevice(mStateCache),
+    mPassTimer(root->getGraphicsManager()->getPassTimer())
 {
+    // the resources created from here on goes through the cache
+    RenderDevice::SetDevice( mStateCache );
+    
     initGBuffer();
     initSSAO();
     initDeferred();
     initShadows();
     initOther();
+    buildFrameGraph( mUseSSAO );
     
     const Config *config = root->getConfig();
     mWindowSize = glm::uvec2( config->windowWidth, config->windowHeight );
     
     mAllocator = new UniformBufferAllocator;
     
+    mWorkerPool = new WorkerPool;
+    mSubmitLists.resize( mWorkerPool->getThreadCount()-1 );
+    
     mMemUsageHistory.setSize( config->valueHistoryLenght );
+    mUseClusteredLights = config->clusteredLights;
+    mUseInstancing = config->instancing;
+    mUseMultiDrawIndirect = config->multiDrawIndirect;
+    
+    DynamicResolution::Settings dynamicResolution;
+        dynamicResolution.targetTime = config->dynamicResolutionTarget;
+        dynamicResolution.minScale = config->dynamicResolutionMinScale;
+        dynamicResolution.maxScale = config->dynamicResolutionMaxScale;
+    mDynamicResolution.setSettings( dynamicResolution );
+    mUseDynamicResolution = config->dynamicResolution;
 }
 
 Renderer::~Renderer()
 {
+    for( FrameData *frame : mFrames ) {
+        for( UniformStagingBuffer *uniforms : frame->uniforms ) {
+            delete uniforms;
+        }
+        delete frame;
+    }
+    delete mWorkerPool;
     delete mAllocator;
+    
+    // the members are destroyed after this, with the device the cache was in front of
+    RenderDevice::SetDevice( mStateCache->getDevice() );
+    delete mStateCache;
 }
 
 void Renderer::renderScene( Scene *scene, Camera *camera )
 {
-    mPrevFrameStatistics = mCurrentStatistics;
-    mCurrentStatistics = RendererStatistics();
+    FrameData *frame = getRecordFrame();
     
     mCurrentScene = scene;
     mCurrentCamera = camera;
     
-    quaryForObjects( camera->getFrustrum() );
+    mSortViewMatrix = camera->getViewMatrix();
+    mSortDepthScale = 65535.f / camera->getFarPlane();
     
-    for( SceneObject *object : mQuaryResult ) {
-        object->submitRenderer( *this );
-    }
+    quaryForObjects( camera->getFrustrum() );
+    submitObjects();
     
     prepereShadowCasters();
+    if( frame->useClusteredLights ) {
+        buildLightClusters( camera );
+    }
+    sortEntities();
+    sortCustomRenderables();
     
     SceneRenderUniforms sceneUniforms = camera->getSceneUniforms();
     sceneUniforms.windowSize = glm::vec2(mWindowSize.x,mWindowSize.y);
-    mSceneUniforms = aquireUniformBuffer( sceneUniforms );
+    sceneUniforms.renderScale = glm::vec2( frame->renderSize ) / glm::vec2( mGBuffer.frameBufferSize );
+    frame->sceneUniforms = aquireUniformBuffer( sceneUniforms );
     
     AmbientUniforms ambientUniforms = scene->getAmbientUniforms();
-    mAmbientUniforms = aquireUniformBuffer( ambientUniforms );
+    frame->ambientUniforms = aquireUniformBuffer( ambientUniforms );
     
-    render();
+    frame->skybox = scene->getSkyBox();
     
     mCurrentScene = nullptr;
     mCurrentCamera = nullptr;
+    mRecordFrame = nullptr;
+    
+    if( mRenderThread ) {
+        mRenderThread->enqueue( [this,frame]() {
+            renderFrame( frame );
+        } );
+    }
+    else {
+        renderFrame( frame );
+    }
 }
 
 void Renderer::addMesh( const SharedPtr<Mesh> &mesh, const DeferredMaterial &material, const glm::mat4 &modelMatrix )
 {
     EntityInfo info;
-        info.mesh = mesh;
-        info.material = material;
-    
-    auto result = mAllocator->getMemory( sizeof(EntityUniforms) );
-    info.buffer = result.buffer;
-    info.offset = result.offset;
-    
-    EntityUniforms *uniform = reinterpret_cast<EntityUniforms*>( result.memory );
-    uniform->modelMatrix = modelMatrix;
-    
-    mEntities.push_back( info );
+        info.mesh = mesh->getHandle();
+        info.modelMatrix = modelMatrix;
+        info.diffuseTexture = getResourceHandle( material.diffuseTexture );
+        info.normalMap = getResourceHandle( material.normalMap );
+        info.buffer = 0;
+        info.offset = 0;
+    
+    // front to back, by the view space depth of the origin
+    float depth = -(mSortViewMatrix * modelMatrix[3]).z;
+    depth = glm::clamp( depth*mSortDepthScale, 0.f, 65535.f );
+    
+    GLuint program = mDeferred.entityDeferredProgram ? mDeferred.entityDeferredProgram->getGLProgram() : 0;
+    GLuint diffuse = material.diffuseTexture ? material.diffuseTexture->getGLTexture() : 0;
+    GLuint normalMap = material.normalMap ? material.normalMap->getGLTexture() : 0;
+    GLuint vao = mesh->getVertexArrayObject()->getGLVAO();
+    
+    info.sortKey = makeSortKey( 0, program, diffuse, normalMap, vao, (UInt64)depth );
+    
+    size_t mergedDraws = mesh->getMergedDraws();
+    
+    if( tSubmitThread != 0 ) {
+        SubmitList &list = mSubmitLists[tSubmitThread-1];
+        list.entities.push_back( info );
+        if( mergedDraws ) {
+            list.staticBatches++;
+            list.mergedDraws += mergedDraws;
+        }
+    }
+    else {
+        FrameData *frame = getRecordFrame();
+        frame->entities.push_back( info );
+        if( mergedDraws ) {
+            frame->statistics.staticBatches++;
+            frame->statistics.mergedDraws += mergedDraws;
+        }
+    }
 }
 
-void Renderer::addPointLight( UniformBuffer uniforms, const glm::mat4 &modelMatrix, const glm::vec3 &position, float radius, bool shadows )
+void Renderer::addPointLight( const PointLightUniforms &uniforms, const glm::mat4 &modelMatrix, const glm::vec3 &position, float radius, bool shadows, const void *owner )
 {
-    if( shadows ) {
+    // the workers may not open the frame, it's always open while they are submitting
+    FrameData *frame = (tSubmitThread != 0) ? mRecordFrame : getRecordFrame();
+    
+    if( !shadows && frame->useClusteredLights ) {
+        ClusteredPointLight light;
+            light.position = glm::vec3( mSortViewMatrix * glm::vec4(position,1.f) );
+            light.intensity = uniforms.intensity;
+            light.color = uniforms.color;
+            light.innerRadius = uniforms.radius.x;
+            light.outerRadius = uniforms.radius.y;
+            
+        LightClusterBuilder::Light bounds;
+            bounds.position = light.position;
+            bounds.radius = radius;
+            
+        if( tSubmitThread != 0 ) {
+            mSubmitLists[tSubmitThread-1].clusterLights.push_back( bounds );
+            mSubmitLists[tSubmitThread-1].clusteredPointLights.push_back( light );
+        }
+        else {
+            frame->clusterLights.push_back( bounds );
+            frame->clusteredPointLights.push_back( light );
+        }
+    }
+    else if( shadows ) {
         glm::mat4 shadowProjMatrix = glm::perspective( glm::radians(90.f), 1.f, SHADOW_NEAR_CLIP_PLANE, radius );
         glm::mat4 shadowViewMatrix = glm::inverse( modelMatrix );
         
@@ -108,59 +241,314 @@ void Renderer::addPointLight( UniformBuffer uniforms, const glm::mat4 &modelMatr
         shadowUniforms.lightPosition = position;
         
         PointLightInfo info;
-            info.uniforms = uniforms;
+            info.uniforms = aquireUniformBuffer( uniforms );
             info.shadowUniform = aquireUniformBuffer( shadowUniforms ); 
             info.firstShadowCaster = 0;
             info.lastShadowCaster = 0;
+            info.owner = owner;
+            info.shadowSlot = ShadowMapCache::NO_SLOT;
+            info.renderShadowMap = true;
+            info.modelMatrix = modelMatrix;
             info.viewProjMatrix = shadowProjMatrix * shadowViewMatrix;
             info.position = position;
             info.radius = radius;
+            
+        for( int i=0; i < 6; ++i ) {
+            info.faceFrustrums[i] = Frustrum::FromProjectionMatrix( shadowUniforms.viewProjMatrix[i] );
+        }
         
-        mPointLights.push_back( info );
+        if( tSubmitThread != 0 ) {
+            mSubmitLists[tSubmitThread-1].pointLights.push_back( info );
+        }
+        else {
+            frame->pointLights.push_back( info );
+        }
     }
     else {
         PointLightNoShadowInfo info;
-            info.uniforms = uniforms;
-        mPointLightsNoShadow.push_back( info );
-        
+            info.uniforms = aquireUniformBuffer( uniforms );
+            
+        if( tSubmitThread != 0 ) {
+            mSubmitLists[tSubmitThread-1].pointLightsNoShadow.push_back( info );
+        }
+        else {
+            frame->pointLightsNoShadow.push_back( info );
+        }
     }
 }
 
+void Renderer::bindUniformBuffer( GLuint index, const UniformBuffer &buffer )
+{
+    if( buffer.getBuffer() == SB_SceneUniforms ) {
+        bindUniforms( index, mFrame->sceneUniforms );
+        return;
+    }
+    
+    UniformBuffer tmp = buffer;
+    relocateUniforms( tmp );
+    bindUniforms( index, tmp );
+}
+
+Renderer::FrameData* Renderer::getRecordFrame()
+{
+    if( mRecordFrame ) {
+        return mRecordFrame;
+    }
+    
+    for( FrameData *frame : mFrames ) {
+        if( !frame->pending ) {
+            mRecordFrame = frame;
+            break;
+        }
+    }
+    if( !mRecordFrame ) {
+        // all frames are waiting to be rendered
+        mRecordFrame = new FrameData;
+        for( size_t i=0; i < mWorkerPool->getThreadCount(); ++i ) {
+            mRecordFrame->uniforms.push_back( new UniformStagingBuffer(SB_StagedUniforms, mAllocator->getAligment()) );
+        }
+        mFrames.push_back( mRecordFrame );
+    }
+    
+    mRecordFrame->statistics = RendererStatistics();
+    mRecordFrame->useClusteredLights = mUseClusteredLights && mClustered.program;
+    mRecordFrame->useSSAO = mUseSSAO;
+    mRecordFrame->useInstancing = useInstancing();
+    mRecordFrame->useMultiDrawIndirect = mUseMultiDrawIndirect;
+    mRecordFrame->useOcclusionQuaries = mUseOcclusionQuaries;
+    mRecordFrame->renderWireframe = mRenderWireframe;
+    mRecordFrame->pending = true;
+    
+    // rebuilt before anything is recorded, the g-buffer textures are taken by the custom renderables
+    if( mRecordFrame->useSSAO != mFrameGraphSSAO ) {
+        rebuildFrameGraph( mRecordFrame->useSSAO );
+    }
+    
+    // without a render thread the frame is recorded where the allocator is used,
+    // so it can reserve blocks the workers write their uniforms straight into.
+    // With one the allocator is used by the render thread while this frame is recorded,
+    // so everything is staged
+    UniformBlockRegion *blocks = (!mRenderThread && mAllocator->reserveBlocks()) ? mAllocator->getBlockRegion() : nullptr;
+    for( UniformStagingBuffer *uniforms : mRecordFrame->uniforms ) {
+        uniforms->setBlockRegion( blocks );
+    }
+    
+    if( mUseDynamicResolution ) {
+        mRecordFrame->renderSize = mDynamicResolution.getRenderSize( mGBuffer.frameBufferSize );
+        mRecordFrame->statistics.renderScale = mDynamicResolution.getScale();
+    }
+    else {
+        mRecordFrame->renderSize = mGBuffer.frameBufferSize;
+    }
+    
+    return mRecordFrame;
+}
+
+void Renderer::renderFrame( FrameData *frame )
+{
+    mFrame = frame;
+    mCurrentStatistics = frame->statistics;
+    
+    // gl may have been used directly since the last frame (compute updates, imgui)
+    mStateCache->invalidate();
+    mStateCache->resetCounters();
+    
+    uploadStagedUniforms();
+    render();
+    
+    mCurrentStatistics.stateCallsIssued = mStateCache->getCounters().issuedCalls;
+    mCurrentStatistics.stateCallsSkipped = mStateCache->getCounters().skippedCalls;
+    mCurrentStatistics.frameMemory = frame->arena.getUsed();
+    mCurrentStatistics.frameMemoryHighWater = frame->arena.getHighWaterMark();
+    {
+        std::lock_guard<std::mutex> lock( mStatisticsMutex );
+        mPrevFrameStatistics = mCurrentStatistics;
+    }
+    
+    resetFrame( frame );
+    
+    mFrame = nullptr;
+    frame->pending = false;
+}
+
+void Renderer::resetFrame( FrameData *frame )
+{
+    size_t entityCount = releaseFrameVector( frame->entities ),
+           entityOrderCount = releaseFrameVector( frame->entityOrder ),
+           customRenderableCount = releaseFrameVector( frame->customRenderables ),
+           customOrderCount = releaseFrameVector( frame->customOrder ),
+           pointLightCount = releaseFrameVector( frame->pointLights ),
+           pointLightNoShadowCount = releaseFrameVector( frame->pointLightsNoShadow ),
+           shadowMeshCount = releaseFrameVector( frame->shadowMeshes ),
+           clusterLightCount = releaseFrameVector( frame->clusterLights );
+    releaseFrameVector( frame->sortBuffer );
+    releaseFrameVector( frame->clusteredPointLights );
+    
+    frame->arena.reset();
+    
+    // the next frame is most likely about the same, so the lists are sized
+    // up front instead of growing (& leaving the old copies) in the arena
+    frame->entities.reserve( entityCount );
+    frame->entityOrder.reserve( entityOrderCount );
+    // also the scratch buffer for the custom renderables
+    frame->sortBuffer.reserve( std::max(entityOrderCount,customOrderCount) );
+    frame->customRenderables.reserve( customRenderableCount );
+    frame->customOrder.reserve( customOrderCount );
+    frame->pointLights.reserve( pointLightCount );
+    frame->pointLightsNoShadow.reserve( pointLightNoShadowCount );
+    frame->shadowMeshes.reserve( shadowMeshCount );
+    frame->clusterLights.reserve( clusterLightCount );
+    frame->clusteredPointLights.reserve( clusterLightCount );
+    
+    frame->skybox.reset();
+    for( UniformStagingBuffer *uniforms : frame->uniforms ) {
+        uniforms->reset();
+    }
+}
+
+void Renderer::uploadStagedUniforms()
+{
+    for( UniformStagingBuffer *uniforms : mFrame->uniforms ) {
+        uniforms->upload( mAllocator );
+    }
+    
+    for( PointLightInfo &info : mFrame->pointLights ) {
+        relocateUniforms( info.uniforms );
+        relocateUniforms( info.shadowUniform );
+    }
+    for( PointLightNoShadowInfo &info : mFrame->pointLightsNoShadow ) {
+        relocateUniforms( info.uniforms );
+    }
+    for( ShadowMeshInfo &info : mFrame->shadowMeshes ) {
+        relocateUniforms( info.buffer );
+    }
+    for( CustomRenderableSettings &settings : mFrame->customRenderables ) {
+        for( UniformBuffer &buffer : settings.uniforms ) {
+            relocateUniforms( buffer );
+        }
+    }
+    relocateUniforms( mFrame->sceneUniforms );
+    relocateUniforms( mFrame->ambientUniforms );
+    relocateUniforms( mFrame->clusterUniforms );
+}
+
+void Renderer::relocateUniforms( UniformBuffer &buffer )
+{
+    if( buffer.getBuffer() != SB_StagedUniforms ) {
+        return;
+    }
+    for( UniformStagingBuffer *uniforms : mFrame->uniforms ) {
+        if( uniforms->relocate(buffer) ) {
+            return;
+        }
+    }
+    assert( false && "Renderer::relocateUniforms - the buffer wasn't staged in this frame" );
+}
+
 void Renderer::render()
 {   
-    float usage = mAllocator->flushAndReset();
-    mMemUsageHistory.pushValue( usage );
+    if( mFrame->useInstancing ) {
+        buildInstanceGroups();
+        
+        ResourceTablesLock lock;
+        mIndirect.useThisFrame = mFrame->useMultiDrawIndirect && mIndirect.supported && buildIndirectCommands();
+    }
+    if( !mFrame->useInstancing || mFrame->useSSAO ) {
+        // the ssao scene pass draws the entities one by one
+        allocateEntityUniforms();
+    }
+    
+    assert( mFrame->useSSAO == mFrameGraphSSAO );
+    mCurrentStatistics.renderTargetMemory = mFrameGraph.getAllocatedMemory();
+    mCurrentStatistics.unaliasedRenderTargetMemory = mFrameGraph.getTransientMemory();
+    
+    mAllocator->flush();
     
-    bindUniforms( 0, mSceneUniforms.getBuffer(), mSceneUniforms.getOffset(), mSceneUniforms.getSize() );
+    bindUniforms( 0, mFrame->sceneUniforms );
     
-    if( mRenderWireframe ) {
+    // the tables are locked one pass at a time, the main thread destroying a resource
+    // only waits for the pass using it, the handles are resolved with HandleTable::Get
+    if( mFrame->renderWireframe ) {
+        ResourceTablesLock lock;
+        
+        mPassTimer->beginPass( "Wireframes" );
         renderWireframes();
+        mPassTimer->endPass();
+        
+        mPassTimer->beginPass( "Custom" );
+        renderCustom();
+        mPassTimer->endPass();
     }
     else {
-        renderDeferred();
-//         renderSSAO();
-        renderLights();
-        renderOther();
+        for( FrameGraph::PassId pass : mFrameGraph.getExecutionOrder() ) {
+            UInt32 barriers = mFrameGraph.getBarriers( pass );
+            if( barriers != FrameGraph::BARRIER_NONE ) {
+                GLbitfield glBarriers = 0;
+                if( barriers & FrameGraph::BARRIER_FRAMEBUFFER ) glBarriers |= GL_FRAMEBUFFER_BARRIER_BIT;
+                if( barriers & FrameGraph::BARRIER_TEXTURE_FETCH ) glBarriers |= GL_TEXTURE_FETCH_BARRIER_BIT;
+                if( barriers & FrameGraph::BARRIER_IMAGE_ACCESS ) glBarriers |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+                mDevice->memoryBarrier( glBarriers );
+            }
+            
+            // the lights pass includes the shadow maps
+            mPassTimer->beginPass( mFrameGraph.getPassName(pass).c_str() );
+            {
+                ResourceTablesLock lock;
+                mFrameGraph.executePass( pass );
+            }
+            mPassTimer->endPass();
+        }
     }
-    renderCustom();
     
-    mEntities.clear();
-    mCustomRenderable.clear();
-    mPointLights.clear();
-    mPointLightsNoShadow.clear();
+    // the frame's uniforms can be reused once the gpu is past this point
+    float usage = mAllocator->endFrame();
+    {
+        std::lock_guard<std::mutex> lock( mStatisticsMutex );
+        mMemUsageHistory.pushValue( usage );
+    }
 }
 
 UniformBuffer Renderer::aquireUniformBuffer( size_t size )
 {
+    if( tSubmitThread != 0 ) {
+        return mRecordFrame->uniforms[tSubmitThread]->allocate( size );
+    }
+    if( mRenderThread ) {
+        // the allocator's buffers can only be mapped on the render thread
+        return getRecordFrame()->uniforms[0]->allocate( size );
+    }
+    
     auto result = mAllocator->getMemory( size );
     return UniformBuffer( result.buffer, result.memory, size, result.offset );
 }
 
+void Renderer::setUseDynamicResolution( bool useDynamicResolution )
+{
+    if( useDynamicResolution != mUseDynamicResolution ) {
+        mDynamicResolution.reset();
+    }
+    mUseDynamicResolution = useDynamicResolution;
+}
+
+void Renderer::addGpuFrameTime( float gpuTime )
+{
+    if( mUseDynamicResolution ) {
+        mDynamicResolution.addFrameTime( gpuTime );
+    }
+}
+
 void Renderer::addCustomRenderable( const CustomRenderableSettings &settings )
 {
     assert( settings.renderable != nullptr );
-    auto iter = std::lower_bound( mCustomRenderable.begin(), mCustomRenderable.end(), settings );
-    mCustomRenderable.emplace( iter, settings );
+    assert( settings.queue >= -0x8000 && settings.queue < 0x8000 );
+    
+    // sorted once all of them are submitted, see sortCustomRenderables
+    if( tSubmitThread != 0 ) {
+        mSubmitLists[tSubmitThread-1].customRenderables.push_back( settings );
+    }
+    else {
+        getRecordFrame()->customRenderables.push_back( settings );
+    }
 }
 
 void Renderer::addShadowMesh( const SharedPtr<Mesh> &mesh, const glm::mat4 &modelMatrix )
@@ -168,11 +556,17 @@ void Renderer::addShadowMesh( const SharedPtr<Mesh> &mesh, const glm::mat4 &mode
     ShadowCasterUniforms uniforms;
         uniforms.modelMatrix = modelMatrix;
     
+    // same as the scene, the radius is scaled by the largest axis
+    const BoundingSphere &bounds = mesh->getBoundingSphere();
+    float scale = glm::max( glm::length(glm::vec3(modelMatrix[0])), glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))) );
+    
     ShadowMeshInfo info;
-        info.mesh = mesh;
-        info.buffer = aquireUniformBuffer( uniforms );
+        info.mesh = mesh->getHandle();
+        info.modelMatrix = modelMatrix;
+        info.bounds = BoundingSphere( glm::vec3(modelMatrix * glm::vec4(bounds.getCenter(),1.f)), bounds.getRadius()*scale );
+        info.faceMask = 0x3F;
         
-    mShadowMeshes.push_back( info );
+    getRecordFrame()->shadowMeshes.push_back( info );
 }
 
 
@@ -180,23 +574,8 @@ void Renderer::initGBuffer()
 {
     const Config *config = mRoot->getConfig();
     
-    glm::uvec2 gbufferSize( config->defferedBufferWidth, config->defferedBufferHeight );
-    
-    mGBuffer.diffuseTexture = Texture::CreateTexture( TextureType::RGBA, gbufferSize, 1 );
-    mGBuffer.normalTexture = Texture::CreateTexture( TextureType::RGB, gbufferSize, 1 );
-    mGBuffer.depthTexture = Texture::CreateTexture( TextureType::Depth, gbufferSize, 1 );
-    mGBuffer.litDiffuseTexture = Texture::CreateTexture( TextureType::RGB, gbufferSize, 1 );
-    
-    mGBuffer.framebuffer = makeSharedPtr<FrameBuffer>();
-    
-    mGBuffer.framebuffer->attachColorTexture( mGBuffer.diffuseTexture, 0 );
-    mGBuffer.framebuffer->attachColorTexture( mGBuffer.normalTexture, 1 );
-    mGBuffer.framebuffer->setDepthTexture( mGBuffer.depthTexture );
-    
-    mGBuffer.lightFrameBuffer = makeSharedPtr<FrameBuffer>();
-    mGBuffer.lightFrameBuffer->attachColorTexture( mGBuffer.litDiffuseTexture, 0 );
-    
-    mGBuffer.frameBufferSize = gbufferSize;
+    // the textures are made by buildFrameGraph
+    mGBuffer.frameBufferSize = glm::uvec2( config->defferedBufferWidth, config->defferedBufferHeight );
 }
 
 void Renderer::initSSAO()
@@ -208,32 +587,13 @@ void Renderer::initSSAO()
     mSSAO.ssaoProgram = resourceMgr->getGpuProgramAutoPack( "SSAOShader" );
     mSSAO.ssaoBlur = resourceMgr->getGpuProgramAutoPack( "SSAOBlurProgram" );
     
-    glm::uvec2 ssaoSize( config->ssaoBufferWidth, config->ssaoBufferHeight );
-    
-    mSSAO.normalTexture = Texture::CreateTexture( TextureType::RGB, ssaoSize, 1 );
-    mSSAO.depthTexture = Texture::CreateTexture( TextureType::Depth, ssaoSize, 1 );
-    
-    mSSAO.normalTexture->bindTexture(0);
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-    
-    mSSAO.depthTexture->bindTexture(0);
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-    
-    mSSAO.framebuffer = makeSharedPtr<FrameBuffer>();
-    
-    mSSAO.framebuffer->attachColorTexture( mSSAO.normalTexture, 0 );
-    mSSAO.framebuffer->setDepthTexture( mSSAO.depthTexture );
-    
     mSSAO.randTexture = resourceMgr->getTextureAutoPack( "NoiseImage" );
-    mSSAO.ssaoTexture = Texture::CreateTexture( TextureType::Red, ssaoSize, 1 );
-    mSSAO.ssaoBlured = Texture::CreateTexture( TextureType::Red, ssaoSize, 1 );
     
-    mSSAO.ssaoFrameBuffer = makeSharedPtr<FrameBuffer>();
-    mSSAO.ssaoFrameBuffer->attachColorTexture( mSSAO.ssaoTexture, 0 );
+    const UInt8 white[4] = {255, 255, 255, 255};
+    mSSAO.noOcclusionTexture = Texture::LoadTextureFromRawMemory( TextureType::Red, white, 1, 1 );
     
-    mSSAO.frameBufferSize = ssaoSize;
+    // the textures are made by buildFrameGraph
+    mSSAO.frameBufferSize = glm::uvec2( config->ssaoBufferWidth, config->ssaoBufferHeight );
 }
 
 void Renderer::initDeferred()
@@ -241,6 +601,9 @@ void Renderer::initDeferred()
     ResourceManager *resourceMgr = mRoot->getResourceManager();
 
     mDeferred.entityDeferredProgram = resourceMgr->getGpuProgramAutoPack( "DeferredMeshShader" );
+    // optional, the entities are drawn one by one if the pack doesn't have it
+    mDeferred.entityInstancedProgram = resourceMgr->getGpuProgramAutoPack( "DeferredMeshInstancedShader" );
+    mDeferred.entityIndirectProgram = resourceMgr->getGpuProgramAutoPack( "DeferredMeshIndirectShader" );
     mDeferred.pointLightProgram = resourceMgr->getGpuProgramAutoPack( "DeferredPointLightShader" );
     mDeferred.pointLightNoShadowProgram = resourceMgr->getGpuProgramAutoPack( "DeferredPointLightNoShadowShader" );
     mDeferred.ambientLightProgram = resourceMgr->getGpuProgramAutoPack( "DeferredAmbientShader" );
@@ -248,6 +611,30 @@ void Renderer::initDeferred()
     mDeferred.wireFrameProgram = resourceMgr->getGpuProgramAutoPack( "DeferredWireFrameShader" );
     
     mDeferred.sphereMesh = resourceMgr->getMeshAutoPack( "Sphere" );
+    
+    // optional, the lights are drawn one by one without it
+    mClustered.program = resourceMgr->getGpuProgramAutoPack( "DeferredPointLightClusteredShader" );
+    if( mClustered.program ) {
+        mClustered.lightBuffer = GpuBuffer::CreateBuffer( BufferType::ShaderStorage, sizeof(ClusteredPointLight), BufferUsage::WriteOnly, BufferUpdate::Stream );
+        mClustered.clusterBuffer = GpuBuffer::CreateBuffer( BufferType::ShaderStorage, sizeof(LightClusterBuilder::Cluster), BufferUsage::WriteOnly, BufferUpdate::Stream );
+        mClustered.indexBuffer = GpuBuffer::CreateBuffer( BufferType::ShaderStorage, sizeof(UInt32), BufferUsage::WriteOnly, BufferUpdate::Stream );
+    }
+    
+    if( mDeferred.entityInstancedProgram ) {
+        GLuint program = mDeferred.entityInstancedProgram->getGLProgram();
+        mInstancing.instanceOffsetLocation = mDevice->getUniformLocation( program, "InstanceOffset" );
+        mInstancing.matrixBuffer = GpuBuffer::CreateBuffer( BufferType::ShaderStorage, sizeof(glm::mat4), BufferUsage::WriteOnly, BufferUpdate::Stream );
+    }
+    
+    // gl_DrawID needs ARB_shader_draw_parameters
+    mIndirect.supported = mDeferred.entityInstancedProgram && mDeferred.entityIndirectProgram &&
+                          GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_draw_parameters;
+    if( mIndirect.supported ) {
+        GLuint program = mDeferred.entityIndirectProgram->getGLProgram();
+        mIndirect.drawOffsetLocation = mDevice->getUniformLocation( program, "DrawOffset" );
+        mIndirect.commandBuffer = GpuBuffer::CreateBuffer( BufferType::DrawIndirect, sizeof(DrawElementsIndirectCommand), BufferUsage::WriteOnly, BufferUpdate::Stream );
+        mIndirect.drawDataBuffer = GpuBuffer::CreateBuffer( BufferType::ShaderStorage, sizeof(UInt32), BufferUsage::WriteOnly, BufferUpdate::Stream );
+    }
 }
 
 void Renderer::initShadows()
@@ -259,15 +646,23 @@ void Renderer::initShadows()
     
     mShadows.frameBufferSize = shadowMapSize;
     mShadows.pointLightShadowCasterProgram = resourceMgr->getGpuProgramAutoPack( "DeferredPointLightShadowCasterShader" );
-    mShadows.pointLightShadowTexture = Texture::CreateTexture( TextureType::CubeMap_Depth, shadowMapSize, 1 );
+    // CubeMap_Depth is 16 bit depth, 6 faces
+    size_t shadowMapBytes = size_t(shadowMapSize.x) * shadowMapSize.y * 6 * 2;
+    size_t slotCount = (size_t(config->shadowMapCacheSize) * 1024 * 1024) / shadowMapBytes;
+    mShadows.cache.setSlotCount( slotCount );
+    mShadows.useCache = slotCount > 0;
+}
+
+SharedPtr<Texture> Renderer::createShadowMapTexture()
+{
+    SharedPtr<Texture> texture = Texture::CreateTexture( TextureType::CubeMap_Depth, mShadows.frameBufferSize, 1 );
     
-    mShadows.pointLightShadowTexture->bindTexture(0);
-        glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
-        glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
-    mShadows.pointLightShadowTexture->unbindTexture(0);
+    texture->bindTexture(0);
+        mDevice->texParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+        mDevice->texParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+    texture->unbindTexture(0);
     
-    mShadows.pointLightShadowFrameBuffer = makeSharedPtr<FrameBuffer>();
-    mShadows.pointLightShadowFrameBuffer->setDepthTexture( mShadows.pointLightShadowTexture );
+    return texture;
 }
 
 void Renderer::initOther()
@@ -278,87 +673,368 @@ void Renderer::initOther()
     mOther.cubeMesh = resourceMgr->getMeshAutoPack( "Cube" );
 }
 
+void Renderer::buildFrameGraph( bool useSSAO )
+{
+    typedef FrameGraph::Access Access;
+    
+    FrameGraph &graph = mFrameGraph;
+    graph.clear();
+    
+    auto addTexture = [&]( const char *name, TextureType type, glm::uvec2 size ) {
+        FrameGraphTextureDesc desc;
+            desc.type = type;
+            desc.size = size;
+        return graph.addTransient( name, desc );
+    };
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" );
+    
+    FrameGraph::ResourceId diffuse = addTexture( "Diffuse", TextureType::RGBA, mGBuffer.frameBufferSize ),
+                           normal = addTexture( "Normal", TextureType::RGB, mGBuffer.frameBufferSize ),
+                           depth = addTexture( "Depth", TextureType::Depth, mGBuffer.frameBufferSize ),
+                           litDiffuse = addTexture( "Lit Diffuse", TextureType::RGB, mGBuffer.frameBufferSize ),
+                           shadowMap = addTexture( "Shadow Map", TextureType::CubeMap_Depth, mShadows.frameBufferSize );
+    FrameGraph::ResourceId ssaoNormal = FrameGraph::INVALID_ID,
+                           ssaoDepth = FrameGraph::INVALID_ID,
+                           ssao = FrameGraph::INVALID_ID,
+                           ssaoBlured = FrameGraph::INVALID_ID;
+                           
+    // added first so they run before the g-buffer pass, the ssao's targets are free by then
+    // & the g-buffer can reuse them when they are the same size
+    if( useSSAO ) {
+        ssaoNormal = addTexture( "SSAO Normal", TextureType::RGB, mSSAO.frameBufferSize );
+        ssaoDepth = addTexture( "SSAO Depth", TextureType::Depth, mSSAO.frameBufferSize );
+        ssao = addTexture( "SSAO", TextureType::Red, mSSAO.frameBufferSize );
+        ssaoBlured = addTexture( "SSAO Blured", TextureType::Red, mSSAO.frameBufferSize );
+        
+        FrameGraph::PassId scenePass = graph.addPass( "SSAO Scene", [this]() { renderSSAOScene(); } );
+        graph.write( scenePass, ssaoNormal, Access::RenderTarget );
+        graph.write( scenePass, ssaoDepth, Access::RenderTarget );
+        
+        FrameGraph::PassId ssaoPass = graph.addPass( "SSAO", [this]() { renderSSAO(); } );
+        graph.read( ssaoPass, ssaoNormal, Access::Sampled );
+        graph.read( ssaoPass, ssaoDepth, Access::Sampled );
+        graph.write( ssaoPass, ssao, Access::RenderTarget );
+        
+        FrameGraph::PassId blurPass = graph.addPass( "SSAO Blur", [this]() { renderSSAOBlur(); } );
+        graph.read( blurPass, ssao, Access::Image );
+        graph.write( blurPass, ssaoBlured, Access::Image );
+    }
+    
+    FrameGraph::PassId gbufferPass = graph.addPass( "GBuffer", [this]() { renderDeferred(); } );
+    graph.write( gbufferPass, diffuse, Access::RenderTarget );
+    graph.write( gbufferPass, normal, Access::RenderTarget );
+    graph.write( gbufferPass, depth, Access::RenderTarget );
+    
+    // the shadow maps are rendered between the lights, so they are written & read here
+    FrameGraph::PassId lightPass = graph.addPass( "Lights", [this]() { renderLights(); } );
+    graph.read( lightPass, diffuse, Access::Sampled );
+    graph.read( lightPass, normal, Access::Sampled );
+    graph.read( lightPass, depth, Access::Sampled );
+    graph.write( lightPass, shadowMap, Access::RenderTarget );
+    graph.read( lightPass, shadowMap, Access::Sampled );
+    graph.write( lightPass, litDiffuse, Access::RenderTarget );
+    graph.read( lightPass, litDiffuse, Access::Sampled );
+    graph.write( lightPass, window, Access::RenderTarget );
+    if( useSSAO ) {
+        graph.read( lightPass, ssaoBlured, Access::Sampled );
+    }
+    
+    FrameGraph::PassId skyboxPass = graph.addPass( "Skybox", [this]() { renderOther(); } );
+    graph.write( skyboxPass, window, Access::RenderTarget );
+    
+    // the water samples the depth & the lit scene, so they're kept (& not aliased) until it's drawn
+    FrameGraph::PassId customPass = graph.addPass( "Custom", [this]() { renderCustom(); } );
+    graph.read( customPass, depth, Access::Sampled );
+    graph.read( customPass, litDiffuse, Access::Sampled );
+    graph.write( customPass, window, Access::RenderTarget );
+    
+    if( !graph.compile() ) {
+        throw std::runtime_error( "Renderer::buildFrameGraph - the passes depends on each other in a cycle" );
+    }
+    
+    mFrameGraphTextures.clear();
+    for( const FrameGraphTextureDesc &desc : graph.getTextures() ) {
+        mFrameGraphTextures.push_back( createTransientTexture(desc) );
+    }
+    auto getTexture = [&]( FrameGraph::ResourceId resource ) {
+        UInt32 index = (resource != FrameGraph::INVALID_ID) ? graph.getTextureIndex( resource ) : FrameGraph::INVALID_ID;
+        return (index != FrameGraph::INVALID_ID) ? mFrameGraphTextures[index] : SharedPtr<Texture>();
+    };
+    
+    mGBuffer.diffuseTexture = getTexture( diffuse );
+    mGBuffer.normalTexture = getTexture( normal );
+    mGBuffer.depthTexture = getTexture( depth );
+    mGBuffer.litDiffuseTexture = getTexture( litDiffuse );
+    
+    mGBuffer.framebuffer = makeSharedPtr<FrameBuffer>();
+    mGBuffer.framebuffer->attachColorTexture( mGBuffer.diffuseTexture, 0 );
+    mGBuffer.framebuffer->attachColorTexture( mGBuffer.normalTexture, 1 );
+    mGBuffer.framebuffer->setDepthTexture( mGBuffer.depthTexture );
+    
+    mGBuffer.lightFrameBuffer = makeSharedPtr<FrameBuffer>();
+    mGBuffer.lightFrameBuffer->attachColorTexture( mGBuffer.litDiffuseTexture, 0 );
+    
+    mShadows.pointLightShadowTexture = getTexture( shadowMap );
+    mShadows.pointLightShadowFrameBuffer = makeSharedPtr<FrameBuffer>();
+    mShadows.pointLightShadowFrameBuffer->setDepthTexture( mShadows.pointLightShadowTexture );
+    
+    mSSAO.normalTexture = getTexture( ssaoNormal );
+    mSSAO.depthTexture = getTexture( ssaoDepth );
+    mSSAO.ssaoTexture = getTexture( ssao );
+    mSSAO.ssaoBlured = getTexture( ssaoBlured );
+    mSSAO.framebuffer.reset();
+    mSSAO.ssaoFrameBuffer.reset();
+    if( useSSAO ) {
+        mSSAO.framebuffer = makeSharedPtr<FrameBuffer>();
+        mSSAO.framebuffer->attachColorTexture( mSSAO.normalTexture, 0 );
+        mSSAO.framebuffer->setDepthTexture( mSSAO.depthTexture );
+        
+        mSSAO.ssaoFrameBuffer = makeSharedPtr<FrameBuffer>();
+        mSSAO.ssaoFrameBuffer->attachColorTexture( mSSAO.ssaoTexture, 0 );
+    }
+    
+    mFrameGraphSSAO = useSSAO;
+}
+
+void Renderer::rebuildFrameGraph( bool useSSAO )
+{
+    if( !mRenderThread ) {
+        buildFrameGraph( useSSAO );
+        return;
+    }
+    
+    // the textures are made where the context is current, after the frames already queued.
+    // Waiting for it means the render thread never changes the targets while the main thread reads them
+    std::promise<void> built;
+    mRenderThread->enqueue( [this,useSSAO,&built]() {
+        try {
+            buildFrameGraph( useSSAO );
+            built.set_value();
+        }
+        catch( ... ) {
+            built.set_exception( std::current_exception() );
+        }
+    } );
+    built.get_future().get();
+}
+
+SharedPtr<Texture> Renderer::createTransientTexture( const FrameGraphTextureDesc &desc )
+{
+    if( desc.type == TextureType::CubeMap_Depth ) {
+        assert( desc.size == mShadows.frameBufferSize );
+        return createShadowMapTexture();
+    }
+    
+    SharedPtr<Texture> texture = Texture::CreateTexture( desc.type, desc.size, 1 );
+    
+    // the ssao needs its targets clamped, since they can be shared with the g-buffer all of them are
+    texture->bindTexture(0);
+    mDevice->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    mDevice->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    
+    return texture;
+}
+
 
 void Renderer::renderDeferred()
 {
     setBlendMode( BlendMode::Replace );
     mGBuffer.framebuffer->bindFrameBuffer();
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    mDevice->clear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     
-    setViewportSize( mGBuffer.frameBufferSize );
+    setViewportSize( mFrame->renderSize );
     
     mDeferred.entityDeferredProgram->bindProgram();
     
-    if( mUseOcclusionQuaries ) {
-        if( mOcclusionQuaries.size() < mEntities.size() ) {
+    MeshHandle boundMeshHandle;
+    Mesh *boundMesh = nullptr;
+    VertexArrayObject *boundVAO = nullptr;
+    TextureHandle boundDiffuse, 
+                  boundNormalMap;
+            
+    // the entities are sorted by material & mesh, so only bind when they change
+    auto bindMaterial = [&]( const EntityInfo &info ) {
+        if( info.diffuseTexture != boundDiffuse ) {
+            boundDiffuse = info.diffuseTexture;
+            bindTexture( boundDiffuse, 0 );
+            mCurrentStatistics.textureBinds++;
+        }
+        else {
+            mCurrentStatistics.skippedBinds++;
+        }
+        if( info.normalMap != boundNormalMap ) {
+            boundNormalMap = info.normalMap;
+            bindTexture( boundNormalMap, 1 );
+            mCurrentStatistics.textureBinds++;
+        }
+        else {
+            mCurrentStatistics.skippedBinds++;
+        }
+    };
+    // false if the mesh was destroyed after the frame was recorded
+    auto bindEntityMesh = [&]( const EntityInfo &info ) {
+        if( info.mesh != boundMeshHandle ) {
+            boundMeshHandle = info.mesh;
+            boundMesh = HandleTable<Mesh>::Get( info.mesh );
+            
+            // the meshes in the shared buffers only differ by the base vertex,
+            // their vao has the index buffer bound so there is nothing to bind
+            if( boundMesh && !boundMesh->getIndexBuffer() && boundMesh->getVertexArrayObject().get() == boundVAO ) {
+                mCurrentStatistics.skippedBinds++;
+                return true;
+            }
+            
+            if( boundMesh ) {
+                bindMesh( boundMesh );
+                boundVAO = boundMesh->getVertexArrayObject().get();
+            }
+            mCurrentStatistics.meshBinds++;
+        }
+        else {
+            mCurrentStatistics.skippedBinds++;
+        }
+        return boundMesh != nullptr;
+    };
+    auto drawEntity = [&]( const EntityInfo &info ) {
+        if( !bindEntityMesh(info) ) {
+            return;
+        }
+        bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
+        drawSubMeshes( boundMesh );
+    };
+    
+    if( mFrame->useInstancing && mIndirect.useThisFrame ) {
+        mDeferred.entityIndirectProgram->bindProgram();
+        
+        mInstancing.matrixBuffer->setContent( mInstancing.matrices.data(), mInstancing.matrices.size() );
+        mInstancing.matrixBuffer->bindIndexed( INSTANCE_MATRIX_BINDING );
+        
+        const IndirectCommandBuilder &builder = mIndirect.builder;
+        mIndirect.drawDataBuffer->setContent( builder.getDrawData().data(), builder.getDrawData().size() );
+        mIndirect.drawDataBuffer->bindIndexed( INDIRECT_DRAW_DATA_BINDING );
+        mIndirect.commandBuffer->setContent( builder.getCommands().data(), builder.getCommands().size() );
+        mIndirect.commandBuffer->bindBuffer();
+        
+        for( const IndirectCommandBuilder::Bucket &bucket : builder.getBuckets() ) {
+            const InstanceGroup &group = mInstancing.groups[bucket.userData];
+            const EntityInfo &info = mFrame->entities[mFrame->entityOrder[group.first].index];
+            
+            bindMaterial( info );
+            if( !bindEntityMesh(info) ) {
+                continue;
+            }
+            
+            mDevice->uniform1i( mIndirect.drawOffsetLocation, bucket.firstCommand );
+            
+            const GLvoid *offset = reinterpret_cast<GLvoid*>( sizeof(DrawElementsIndirectCommand)*bucket.firstCommand );
+            mDevice->multiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, offset, bucket.commandCount, 0 );
+            
+            mCurrentStatistics.indirectDraws++;
+        }
+        mIndirect.commandBuffer->unbindBuffer();
+        
+        for( const DrawElementsIndirectCommand &command : builder.getCommands() ) {
+            mCurrentStatistics.totDrawnMeshes += command.instanceCount;
+        }
+        mCurrentStatistics.instanceGroups += mInstancing.groups.size();
+    }
+    else if( mFrame->useInstancing ) {
+        mDeferred.entityInstancedProgram->bindProgram();
+        
+        // one upload for the whole frame, the groups index into it
+        mInstancing.matrixBuffer->setContent( mInstancing.matrices.data(), mInstancing.matrices.size() );
+        mInstancing.matrixBuffer->bindIndexed( INSTANCE_MATRIX_BINDING );
+        
+        for( const InstanceGroup &group : mInstancing.groups ) {
+            const EntityInfo &info = mFrame->entities[mFrame->entityOrder[group.first].index];
+            
+            bindMaterial( info );
+            if( !bindEntityMesh(info) ) {
+                continue;
+            }
+            
+            mDevice->uniform1i( mInstancing.instanceOffsetLocation, group.first );
+            drawSubMeshesInstanced( boundMesh, group.count );
+        }
+        mCurrentStatistics.instanceGroups += mInstancing.groups.size();
+    }
+    else if( mFrame->useOcclusionQuaries ) {
+        if( mOcclusionQuaries.size() < mFrame->entities.size() ) {
             size_t oldSize = mOcclusionQuaries.size();
-            mOcclusionQuaries.resize( mEntities.size() );
-            glGenQueries( mEntities.size() - oldSize, &mOcclusionQuaries[oldSize] );
+            mOcclusionQuaries.resize( mFrame->entities.size() );
+            mDevice->genQueries( mFrame->entities.size() - oldSize, &mOcclusionQuaries[oldSize] );
         }
         
-        glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+        mDevice->colorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
         
         int i=0;
-        for( const EntityInfo &info : mEntities ) 
+        for( const SortEntry &entry : mFrame->entityOrder ) 
         {
-            glBeginQuery( GL_ANY_SAMPLES_PASSED, mOcclusionQuaries[i] );
+            const EntityInfo &info = mFrame->entities[entry.index];
+            mDevice->beginQuery( GL_ANY_SAMPLES_PASSED, mOcclusionQuaries[i] );
             
-            bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
-            drawMesh( info.mesh );
+            drawEntity( info );
             
-            glEndQuery( GL_ANY_SAMPLES_PASSED );
+            mDevice->endQuery( GL_ANY_SAMPLES_PASSED );
             ++i;
         }
         
-        glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
-        glDepthFunc( GL_EQUAL );
+        mDevice->colorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+        mDevice->depthFunc( GL_EQUAL );
         
         i=0;
-        for( const EntityInfo &info : mEntities ) 
+        for( const SortEntry &entry : mFrame->entityOrder ) 
         {
-            glBeginConditionalRender( mOcclusionQuaries[i], GL_QUERY_NO_WAIT );
+            const EntityInfo &info = mFrame->entities[entry.index];
+            mDevice->beginConditionalRender( mOcclusionQuaries[i], GL_QUERY_NO_WAIT );
             
-            info.material.diffuseTexture->bindTexture( 0 );
-            info.material.normalMap->bindTexture( 1 );
-            bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
-            drawMesh( info.mesh );
+            bindMaterial( info );
+            drawEntity( info );
             
-            glEndConditionalRender();
+            mDevice->endConditionalRender();
             ++i;
         }
         
-        glDepthFunc( GL_LESS );
+        mDevice->depthFunc( GL_LESS );
     }
     else {
-        for( const EntityInfo &info : mEntities ) 
+        for( const SortEntry &entry : mFrame->entityOrder ) 
         {
-            info.material.diffuseTexture->bindTexture( 0 );
-            info.material.normalMap->bindTexture( 1 );
-            bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
-            drawMesh( info.mesh );
+            const EntityInfo &info = mFrame->entities[entry.index];
+            bindMaterial( info );
+            drawEntity( info );
         }
     }
-    mCurrentStatistics.drawnEntities += mEntities.size();
+    mCurrentStatistics.drawnEntities += mFrame->entities.size();
 }
 
-void Renderer::renderSSAO()
+void Renderer::renderSSAOScene()
 {
     setBlendMode( BlendMode::Replace );
     
     mSSAO.framebuffer->bindFrameBuffer();
     setViewportSize( mSSAO.frameBufferSize );
     
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    mDevice->clear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     
     mSSAO.scenePassProgram->bindProgram();
     
-    for( const EntityInfo &info : mEntities ) 
+    for( const EntityInfo &info : mFrame->entities ) 
     {
+        Mesh *mesh = HandleTable<Mesh>::Get( info.mesh );
+        if( !mesh ) {
+            continue;
+        }
         bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
-        drawMesh( info.mesh );
+        drawMesh( mesh );
     }
-    
+}
+
+void Renderer::renderSSAO()
+{
     mSSAO.ssaoFrameBuffer->bindFrameBuffer();
+    setViewportSize( mSSAO.frameBufferSize );
     
     static float SampleRadius = 0.2, DepthEdge = 0.5;
     
@@ -369,177 +1045,259 @@ void Renderer::renderSSAO()
     ImGui::SliderFloat( "DepthEdge", &DepthEdge, 1e-4f, 1.0f, "%.4g" );
     ImGui::End();
 */
-    GLint loc = glGetUniformLocation( mSSAO.ssaoProgram->getGLProgram(), "SampleRadius" );
-    glUniform1f( loc, SampleRadius );
+    GLint loc = mDevice->getUniformLocation( mSSAO.ssaoProgram->getGLProgram(), "SampleRadius" );
+    mDevice->uniform1f( loc, SampleRadius );
     
-    loc = glGetUniformLocation( mSSAO.ssaoProgram->getGLProgram(), "DepthEdge" );
-    glUniform1f( loc, DepthEdge );
+    loc = mDevice->getUniformLocation( mSSAO.ssaoProgram->getGLProgram(), "DepthEdge" );
+    mDevice->uniform1f( loc, DepthEdge );
     
     mSSAO.normalTexture->bindTexture( 0 );
     mSSAO.depthTexture->bindTexture( 1 );
     mSSAO.randTexture->bindTexture( 2 );
     
-    glDrawArrays( GL_POINTS, 0, 1 );
-    
-    
+    mDevice->drawArrays( GL_POINTS, 0, 1 );
+}
+
+void Renderer::renderSSAOBlur()
+{
     mSSAO.ssaoBlur->bindProgram();
-    glBindImageTexture( 0, mSSAO.ssaoTexture->getGLTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8 );
-    glBindImageTexture( 1, mSSAO.ssaoBlured->getGLTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8 );
+    mDevice->bindImageTexture( 0, mSSAO.ssaoTexture->getGLTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8 );
+    mDevice->bindImageTexture( 1, mSSAO.ssaoBlured->getGLTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8 );
     
-    glDispatchCompute( mSSAO.frameBufferSize.x / 4, mSSAO.frameBufferSize.y, 1 );
+    mDevice->dispatchCompute( mSSAO.frameBufferSize.x / 4, mSSAO.frameBufferSize.y, 1 );
 }
 
 void Renderer::renderLights()
 {
     mGBuffer.lightFrameBuffer->bindFrameBuffer();
-    setViewportSize( mGBuffer.frameBufferSize );
-    glClear( GL_COLOR_BUFFER_BIT );
+    setViewportSize( mFrame->renderSize );
+    mDevice->clear( GL_COLOR_BUFFER_BIT );
     
     setBlendMode( BlendMode::AddjectiveBlend );
     mGBuffer.diffuseTexture->bindTexture( 0 );
     mGBuffer.normalTexture->bindTexture( 1 );
     mGBuffer.depthTexture->bindTexture( 2 );
     
+    mDevice->enable( GL_TEXTURE_CUBE_MAP_SEAMLESS );
+    
     { // point lights
-        for( const PointLightInfo &info : mPointLights ) {
+        for( const PointLightInfo &info : mFrame->pointLights ) {
             bindUniforms( 1, info.uniforms );
             bindUniforms( 2, info.shadowUniform );
             
-            glCullFace( GL_BACK );
-            glDepthMask( GL_TRUE);
-            glEnable( GL_DEPTH_TEST );
-            glEnable( GL_TEXTURE_CUBE_MAP_SEAMLESS );
-            
-            mShadows.pointLightShadowFrameBuffer->bindFrameBuffer();
-            setViewportSize( mShadows.frameBufferSize );
-            mShadows.pointLightShadowCasterProgram->bindProgram();
-            renderPointLightShadowMap( info.firstShadowCaster, info.lastShadowCaster );
+            SharedPtr<Texture> shadowTexture = mShadows.pointLightShadowTexture;
+            SharedPtr<FrameBuffer> shadowFrameBuffer = mShadows.pointLightShadowFrameBuffer;
+            if( info.shadowSlot != ShadowMapCache::NO_SLOT ) {
+                if( info.shadowSlot >= mShadows.cachedTextures.size() ) {
+                    mShadows.cachedTextures.resize( info.shadowSlot+1 );
+                    mShadows.cachedFrameBuffers.resize( info.shadowSlot+1 );
+                }
+                if( !mShadows.cachedTextures[info.shadowSlot] ) {
+                    // the cache always renders a slot the first time it's handed out
+                    mShadows.cachedTextures[info.shadowSlot] = createShadowMapTexture();
+                    mShadows.cachedFrameBuffers[info.shadowSlot] = makeSharedPtr<FrameBuffer>();
+                    mShadows.cachedFrameBuffers[info.shadowSlot]->setDepthTexture( mShadows.cachedTextures[info.shadowSlot] );
+                }
+                shadowTexture = mShadows.cachedTextures[info.shadowSlot];
+                shadowFrameBuffer = mShadows.cachedFrameBuffers[info.shadowSlot];
+            }
             
-            mGBuffer.lightFrameBuffer->bindFrameBuffer();
-            setViewportSize( mGBuffer.frameBufferSize );
+            if( info.renderShadowMap ) {
+                mDevice->cullFace( GL_BACK );
+                mDevice->depthMask( GL_TRUE);
+                mDevice->enable( GL_DEPTH_TEST );
+                
+                shadowFrameBuffer->bindFrameBuffer();
+                setViewportSize( mShadows.frameBufferSize );
+                mShadows.pointLightShadowCasterProgram->bindProgram();
+                mPassTimer->beginPass( "Shadow Maps" );
+                renderPointLightShadowMap( info.firstShadowCaster, info.lastShadowCaster );
+                mPassTimer->endPass();
+                
+                mGBuffer.lightFrameBuffer->bindFrameBuffer();
+                setViewportSize( mFrame->renderSize );
+                
+                mCurrentStatistics.renderedShadowMaps++;
+            }
+            else {
+                mCurrentStatistics.cachedShadowMaps++;
+            }
             
-            mShadows.pointLightShadowTexture->bindTexture(3);
+            shadowTexture->bindTexture(3);
             
             mDeferred.pointLightProgram->bindProgram();
             
-            glDepthMask( GL_FALSE );
-            glCullFace( GL_FRONT );
-            glDisable( GL_DEPTH_TEST );
-            drawMesh( mDeferred.sphereMesh );
-            mShadows.pointLightShadowTexture->unbindTexture(3);
+            mDevice->depthMask( GL_FALSE );
+            mDevice->cullFace( GL_FRONT );
+            mDevice->disable( GL_DEPTH_TEST );
+            drawMesh( mDeferred.sphereMesh.get() );
+            shadowTexture->unbindTexture(3);
         }
         
-        glDepthMask( GL_FALSE );
-        glCullFace( GL_FRONT );
-        glDisable( GL_DEPTH_TEST );
-        mDeferred.pointLightNoShadowProgram->bindProgram();
+        mDevice->depthMask( GL_FALSE );
+        mDevice->cullFace( GL_FRONT );
+        mDevice->disable( GL_DEPTH_TEST );
         
-        for( const PointLightNoShadowInfo &info : mPointLightsNoShadow ) {
-            bindUniforms( 1, info.uniforms.getBuffer(), info.uniforms.getOffset(), info.uniforms.getSize() );
+        if( mFrame->useClusteredLights ) {
+            renderClusteredLights();
+        }
+        else {
+            mDeferred.pointLightNoShadowProgram->bindProgram();
             
-            drawMesh( mDeferred.sphereMesh );
+            for( const PointLightNoShadowInfo &info : mFrame->pointLightsNoShadow ) {
+                bindUniforms( 1, info.uniforms.getBuffer(), info.uniforms.getOffset(), info.uniforms.getSize() );
+                
+                drawMesh( mDeferred.sphereMesh.get() );
+            }
         }
     }
     
-    mCurrentStatistics.drawnPointLights += mPointLights.size();
-    mCurrentStatistics.drawnPointLightsNoShadow += mPointLightsNoShadow.size();
+    mCurrentStatistics.drawnPointLights += mFrame->pointLights.size();
+    mCurrentStatistics.drawnPointLightsNoShadow += mFrame->pointLightsNoShadow.size() + mFrame->clusteredPointLights.size();
     
     /*draw lights here */
     
-    glCullFace( GL_BACK );
+    mDevice->cullFace( GL_BACK );
     { // ambient
-        bindUniforms( 1, mAmbientUniforms.getBuffer(), mAmbientUniforms.getOffset(), mAmbientUniforms.getSize() );
+        bindUniforms( 1, mFrame->ambientUniforms.getBuffer(), mFrame->ambientUniforms.getOffset(), mFrame->ambientUniforms.getSize() );
         mDeferred.ambientLightProgram->bindProgram();
         mGBuffer.diffuseTexture->bindTexture( 0 );
-        mSSAO.ssaoBlured->bindTexture( 1 );
+        const SharedPtr<Texture> &occlusion = mSSAO.ssaoBlured ? mSSAO.ssaoBlured : mSSAO.noOcclusionTexture;
+        occlusion->bindTexture( 1 );
         
-        glDrawArrays( GL_POINTS, 0, 1 );
+        mDevice->drawArrays( GL_POINTS, 0, 1 );
     }
     
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    mDevice->bindFramebuffer( GL_FRAMEBUFFER, 0 );
     setViewportSize( mWindowSize );
     setBlendMode( BlendMode::Replace );
-    glDepthMask( GL_TRUE );
-    glEnable( GL_DEPTH_TEST );
+    mDevice->depthMask( GL_TRUE );
+    mDevice->enable( GL_DEPTH_TEST );
     
-    { // copy the lit diffuse & depth to the window    
+    { // copy the lit diffuse & depth to the window, the rendered part is scaled up to the window by the scene uniforms render scale
         mDeferred.copyToWindowProgram->bindProgram();
         mGBuffer.litDiffuseTexture->bindTexture( 0 );
         mGBuffer.depthTexture->bindTexture( 1 );
         
-        glDrawArrays( GL_POINTS, 0, 1 );
+        mDevice->drawArrays( GL_POINTS, 0, 1 );
     }
     
 }
 
+void Renderer::renderClusteredLights()
+{
+    const LightClusterBuilder &clusters = mFrame->lightClusters;
+    const std::vector<UInt32> &lightIndices = clusters.getLightIndices();
+    
+    if( lightIndices.empty() ) {
+        // no light touches the view
+        return;
+    }
+    
+    mClustered.lightBuffer->setContent( mFrame->clusteredPointLights.data(), mFrame->clusteredPointLights.size() );
+    mClustered.clusterBuffer->setContent( clusters.getClusters().data(), clusters.getClusters().size() );
+    mClustered.indexBuffer->setContent( lightIndices.data(), lightIndices.size() );
+    
+    mClustered.lightBuffer->bindIndexed( CLUSTERED_LIGHT_BINDING );
+    mClustered.clusterBuffer->bindIndexed( CLUSTERED_CLUSTER_BINDING );
+    mClustered.indexBuffer->bindIndexed( CLUSTERED_INDEX_BINDING );
+    
+    bindUniforms( 1, mFrame->clusterUniforms );
+    mClustered.program->bindProgram();
+    
+    // one full screen pass, every pixel shades the lights in its cluster
+    mDevice->drawArrays( GL_POINTS, 0, 1 );
+}
+
 void Renderer::renderOther()
 {
-    if( mCurrentScene ) {
-        SharedPtr<Texture> skybox = mCurrentScene->getSkyBox();
+    {
+        const SharedPtr<Texture> &skybox = mFrame->skybox;
         if( skybox ) {
             mOther.skyboxProgram->bindProgram();
             skybox->bindTexture( 0 );
-            glDisable( GL_CULL_FACE );
-            glDepthMask( GL_FALSE );
-            drawMesh( mOther.cubeMesh );
-            glDepthMask( GL_TRUE );
-            glEnable( GL_CULL_FACE );
+            mDevice->disable( GL_CULL_FACE );
+            mDevice->depthMask( GL_FALSE );
+            drawMesh( mOther.cubeMesh.get() );
+            mDevice->depthMask( GL_TRUE );
+            mDevice->enable( GL_CULL_FACE );
         }
     }
 }
 
 void Renderer::renderCustom()
 {
-    for( const CustomRenderableSettings &entry : mCustomRenderable ) 
+    for( const SortEntry &order : mFrame->customOrder ) 
     {
-        entry.program->bindProgram();
-        if( entry.indexbuffer ) {
-            entry.indexbuffer->bindBuffer();
+        const CustomRenderableSettings &entry = mFrame->customRenderables[order.index];
+        GpuProgram *program = HandleTable<GpuProgram>::Get( entry.program );
+        GpuBuffer *indexbuffer = HandleTable<GpuBuffer>::Get( entry.indexbuffer );
+        VertexArrayObject *vao = HandleTable<VertexArrayObject>::Get( entry.vao );
+        Texture *textures[8];
+        
+        // skip the entry if something it was recorded with is gone
+        bool valid = program && (indexbuffer || !entry.indexbuffer) && (vao || !entry.vao);
+        for( int i=0; i < 8; ++i ) {
+            textures[i] = HandleTable<Texture>::Get( entry.textures[i] );
+            valid = valid && (textures[i] || !entry.textures[i]);
+        }
+        if( !valid ) {
+            continue;
+        }
+        
+        program->bindProgram();
+        if( indexbuffer ) {
+            indexbuffer->bindBuffer();
         }
-        if( entry.vao ) {
-            entry.vao->bindVAO();
+        if( vao ) {
+            vao->bindVAO();
         }
         for( int i=0; i < 8; ++i ) {
-            if( entry.textures[i] ) {
-                entry.textures[i]->bindTexture( i );
+            if( textures[i] ) {
+                textures[i]->bindTexture( i );
             }
         }
         for( int i=0; i < 8; ++i ) {
-            GLuint buffer = entry.uniforms[i].getBuffer();
-            if( buffer & SB_SpecailBuffer_Bit ) {
-                switch( buffer ) {
-                case( SB_SceneUniforms ):
-                    bindUniforms( i, mSceneUniforms );
-                }
-            }
-            else if( buffer != 0 ) {
-                bindUniforms( i, entry.uniforms[i] );
+            if( entry.uniforms[i].getBuffer() != 0 ) {
+                bindUniformBuffer( i, entry.uniforms[i] );
             }
         }
         
         setBlendMode( entry.blendMode );
         entry.renderable->render( *this );
+        // custom renderables calls gl directly
+        mStateCache->invalidate();
     }
     
-    mCurrentStatistics.customRenderables += mCustomRenderable.size();
+    mCurrentStatistics.customRenderables += mFrame->customRenderables.size();
 }
 
 void Renderer::renderWireframes()
 {
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    mDevice->bindFramebuffer( GL_FRAMEBUFFER, 0 );
     setViewportSize( mWindowSize );
     
     mDeferred.wireFrameProgram->bindProgram();
     
-    for( const EntityInfo &info : mEntities ) 
+    for( const EntityInfo &info : mFrame->entities ) 
     {
+        Mesh *mesh = HandleTable<Mesh>::Get( info.mesh );
+        if( !mesh ) {
+            continue;
+        }
         bindUniforms( 1, info.buffer, info.offset, sizeof(EntityUniforms) );
-        drawMesh( info.mesh );
+        drawMesh( mesh );
     }
     
 }
 
-void Renderer::drawMesh( const SharedPtr<Mesh> &mesh )
+void Renderer::drawMesh( Mesh *mesh )
+{
+    bindMesh( mesh );
+    drawSubMeshes( mesh );
+}
+
+void Renderer::bindMesh( Mesh *mesh )
 {
     GpuBuffer *indexBuffer = mesh->getIndexBuffer().get();
     VertexArrayObject *vao = mesh->getVertexArrayObject().get();
@@ -548,78 +1306,380 @@ void Renderer::drawMesh( const SharedPtr<Mesh> &mesh )
     if( indexBuffer ) {
         indexBuffer->bindBuffer();
     }
+}
+
+void Renderer::bindTexture( TextureHandle texture, int unit )
+{
+    Texture *resolved = HandleTable<Texture>::Get( texture );
+    if( resolved ) {
+        resolved->bindTexture( unit );
+    }
+    else {
+        // destroyed after the frame was recorded
+        mDevice->bindTextureUnit( unit, GL_TEXTURE_2D, 0 );
+    }
+}
+
+void Renderer::drawSubMeshes( Mesh *mesh )
+{
+    bool indexed = mesh->isIndexed();
     
     for( const SubMesh &submesh : mesh->getSubMeshes() )
     {
-        if( indexBuffer ) {
-            glDrawElements( GL_TRIANGLES, submesh.vertexCount, GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(sizeof(GLuint)* submesh.vertexStart) );
+        if( indexed ) {
+            mDevice->drawElementsBaseVertex( GL_TRIANGLES, submesh.vertexCount, GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(sizeof(GLuint)* submesh.vertexStart), submesh.baseVertex );
         }
         else {
-            glDrawArrays( GL_TRIANGLES, submesh.vertexStart, submesh.vertexCount );
+            mDevice->drawArrays( GL_TRIANGLES, submesh.vertexStart, submesh.vertexCount );
         }
         
         mCurrentStatistics.totDrawnMeshes++;
     }
+}
+
+void Renderer::drawSubMeshesInstanced( Mesh *mesh, GLsizei instanceCount )
+{
+    bool indexed = mesh->isIndexed();
     
+    for( const SubMesh &submesh : mesh->getSubMeshes() )
+    {
+        if( indexed ) {
+            mDevice->drawElementsInstancedBaseVertex( GL_TRIANGLES, submesh.vertexCount, GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(sizeof(GLuint)* submesh.vertexStart), instanceCount, submesh.baseVertex );
+        }
+        else {
+            mDevice->drawArraysInstanced( GL_TRIANGLES, submesh.vertexStart, submesh.vertexCount, instanceCount );
+        }
+        
+        mCurrentStatistics.totDrawnMeshes += instanceCount;
+    }
 }
 
 void Renderer::setBlendMode( BlendMode mode )
 {
     switch( mode ) {
     case( BlendMode::Replace ):
-        glBlendFunc( GL_ONE, GL_ZERO );
+        mDevice->blendFunc( GL_ONE, GL_ZERO );
         break;
     case( BlendMode::AlphaBlend ):
-        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+        mDevice->blendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
         break;
     case( BlendMode::AddjectiveBlend ):
-        glBlendFunc( GL_ONE, GL_ONE );
+        mDevice->blendFunc( GL_ONE, GL_ONE );
         break;
     }
 }
 
 void Renderer::bindUniforms( GLuint index, GLuint buffer, GLuint offset, GLuint size )
 {
-    glBindBufferRange( GL_UNIFORM_BUFFER, index, buffer, offset, size );
+    mDevice->bindBufferRange( GL_UNIFORM_BUFFER, index, buffer, offset, size );
 }
 
 void Renderer::setViewportSize( glm::uvec2 size )
 {
-    glViewport( 0, 0, size.x, size.y );
+    mDevice->viewport( 0, 0, size.x, size.y );
 }
 
 void Renderer::prepereShadowCasters()
 {
-    for( PointLightInfo &light : mPointLights ) {
+    FrameData *frame = getRecordFrame();
+    mShadows.cache.beginFrame();
+    
+    for( PointLightInfo &light : frame->pointLights ) {
         glm::mat4 frustrumMat = glm::ortho(-light.radius, light.radius,-light.radius, light.radius,-light.radius, light.radius);
         frustrumMat = glm::translate( frustrumMat,-light.position );
         
         Frustrum frustrum = Frustrum::FromProjectionMatrix( frustrumMat );
         quaryForObjects( frustrum );
         
-        light.firstShadowCaster = mShadowMeshes.size();
+        light.firstShadowCaster = frame->shadowMeshes.size();
         
-        for( SceneObject *object : mQuaryResult ) {
-            object->submitShadowCasters( *this );
+        for( const SceneSnapshot::ObjectEntry *entry : mQuaryResult ) {
+            entry->object->submitShadowCasters( *this, *entry );
         }
         
-        light.lastShadowCaster = mShadowMeshes.size();
+        light.lastShadowCaster = frame->shadowMeshes.size();
+        
+        cullShadowCasterFaces( light );
+        
+        if( mShadows.useCache && light.owner ) {
+            // the map only depends on the light & where the casters are, a rotated light renders its faces in other directions
+            UInt64 signature = ShadowMapCache::HashBytes( &light.modelMatrix, sizeof(glm::mat4) );
+            signature = ShadowMapCache::HashBytes( &light.position, sizeof(glm::vec3), signature );
+            signature = ShadowMapCache::HashBytes( &light.radius, sizeof(float), signature );
+            for( unsigned int i=light.firstShadowCaster; i < light.lastShadowCaster; ++i ) {
+                const ShadowMeshInfo &caster = frame->shadowMeshes[i];
+                signature = ShadowMapCache::HashBytes( &caster.mesh, sizeof(MeshHandle), signature );
+                signature = ShadowMapCache::HashBytes( &caster.modelMatrix, sizeof(glm::mat4), signature );
+            }
+            
+            ShadowMapCache::Request request = mShadows.cache.aquireSlot( light.owner, signature );
+            light.shadowSlot = request.slot;
+            light.renderShadowMap = request.render;
+        }
+        
+        if( light.renderShadowMap ) {
+            for( unsigned int i=light.firstShadowCaster; i < light.lastShadowCaster; ++i ) {
+                ShadowCasterUniforms uniforms;
+                    uniforms.modelMatrix = frame->shadowMeshes[i].modelMatrix;
+                    uniforms.faceMask = frame->shadowMeshes[i].faceMask;
+                frame->shadowMeshes[i].buffer = aquireUniformBuffer( uniforms );
+            }
+        }
+        else {
+            // the cached map is still valid, the casters aren't needed
+            frame->shadowMeshes.resize( light.firstShadowCaster );
+            light.lastShadowCaster = light.firstShadowCaster;
+        }
     }
 }
 
+void Renderer::cullShadowCasterFaces( PointLightInfo &light )
+{
+    FrameData *frame = getRecordFrame();
+    
+    // the casters come from a box around the light, the ones in the corners
+    // touch no face & are dropped. The order of the rest is kept.
+    unsigned int last = light.firstShadowCaster;
+    for( unsigned int i=light.firstShadowCaster; i < light.lastShadowCaster; ++i ) {
+        ShadowMeshInfo &info = frame->shadowMeshes[i];
+        
+        UInt32 faceMask = 0;
+        for( int face=0; face < 6; ++face ) {
+            if( light.faceFrustrums[face].isInside(info.bounds) != Frustrum::TestStatus::Outside ) {
+                faceMask |= 1 << face;
+            }
+        }
+        
+        if( faceMask != 0 ) {
+            info.faceMask = faceMask;
+            frame->shadowMeshes[last++] = info;
+        }
+    }
+    
+    frame->shadowMeshes.resize( last );
+    light.lastShadowCaster = last;
+}
+
 void Renderer::renderPointLightShadowMap( unsigned int first, unsigned int last )
 {
-    glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
+    mDevice->clear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
     for( unsigned int i=first; i < last; ++i ) {
-        ShadowMeshInfo &info = mShadowMeshes[i];
+        ShadowMeshInfo &info = mFrame->shadowMeshes[i];
+        Mesh *mesh = HandleTable<Mesh>::Get( info.mesh );
+        if( !mesh ) {
+            continue;
+        }
         bindUniforms( 3, info.buffer );
         
-        drawMesh( info.mesh );
+        drawMesh( mesh );
+        
+        for( UInt32 mask=info.faceMask; mask != 0; mask &= mask-1 ) {
+            mCurrentStatistics.flaggedShadowFaces++;
+        }
     }
     
     mCurrentStatistics.drawnPointShadowMap += last - first; 
 }
 
+void Renderer::sortEntities()
+{
+    FrameData *frame = getRecordFrame();
+    
+    frame->entityOrder.clear();
+    for( size_t i=0; i < frame->entities.size(); ++i ) {
+        SortEntry entry;
+            entry.key = frame->entities[i].sortKey;
+            entry.index = i;
+        frame->entityOrder.push_back( entry );
+    }
+    
+    radixSort( frame->entityOrder, frame->sortBuffer, []( const SortEntry &entry ) {
+        return entry.key;
+    } );
+}
+
+void Renderer::sortCustomRenderables()
+{
+    FrameData *frame = getRecordFrame();
+    
+    // by queue, then blend mode so the opaque ones in a queue are drawn first, then program.
+    // The sort is stable, so the submission order is kept for equal keys
+    frame->customOrder.clear();
+    for( size_t i=0; i < frame->customRenderables.size(); ++i ) {
+        const CustomRenderableSettings &settings = frame->customRenderables[i];
+        
+        UInt64 queue = UInt64(settings.queue + 0x8000) & 0xFFFF,
+               blendMode = UInt64(settings.blendMode) & 0xFF,
+               program = settings.program.value;
+               
+        SortEntry entry;
+            entry.key = (queue << 40) | (blendMode << 32) | program;
+            entry.index = i;
+        frame->customOrder.push_back( entry );
+    }
+    
+    radixSort( frame->customOrder, frame->sortBuffer, []( const SortEntry &entry ) {
+        return entry.key;
+    }, 56 );
+}
+
+bool Renderer::useInstancing()
+{
+    // the occlusion quaries & wireframes needs to draw the entities one by one,
+    // only called when a frame is opened, the frame keeps the result
+    return mUseInstancing && mDeferred.entityInstancedProgram && !mUseOcclusionQuaries && !mRenderWireframe;
+}
+
+void Renderer::allocateEntityUniforms()
+{
+    for( EntityInfo &info : mFrame->entities ) {
+        auto result = mAllocator->getMemory( sizeof(EntityUniforms) );
+        info.buffer = result.buffer;
+        info.offset = result.offset;
+        
+        EntityUniforms *uniform = reinterpret_cast<EntityUniforms*>( result.memory );
+        uniform->modelMatrix = info.modelMatrix;
+    }
+}
+
+void Renderer::buildInstanceGroups()
+{
+    mInstancing.matrices.clear();
+    mInstancing.groups.clear();
+    
+    const EntityInfo *prev = nullptr;
+    for( UInt32 i=0; i < mFrame->entityOrder.size(); ++i ) {
+        const EntityInfo &info = mFrame->entities[mFrame->entityOrder[i].index];
+        mInstancing.matrices.push_back( info.modelMatrix );
+        
+        // the entities are sorted, so equal mesh & material are next to each other
+        bool sameGroup = prev && 
+                         prev->mesh == info.mesh &&
+                         prev->diffuseTexture == info.diffuseTexture &&
+                         prev->normalMap == info.normalMap;
+                         
+        if( sameGroup ) {
+            mInstancing.groups.back().count++;
+        }
+        else {
+            InstanceGroup group;
+                group.first = i;
+                group.count = 1;
+            mInstancing.groups.push_back( group );
+        }
+        prev = &info;
+    }
+}
+
+bool Renderer::buildIndirectCommands()
+{
+    IndirectCommandBuilder &builder = mIndirect.builder;
+    builder.clear();
+    
+    for( UInt32 i=0; i < mInstancing.groups.size(); ++i ) {
+        const InstanceGroup &group = mInstancing.groups[i];
+        const EntityInfo &info = mFrame->entities[mFrame->entityOrder[group.first].index];
+        Mesh *mesh = HandleTable<Mesh>::Get( info.mesh );
+        
+        if( !mesh || !mesh->isIndexed() ) {
+            // can't be drawn with glMultiDrawElementsIndirect, the instanced path skips destroyed meshes
+            return false;
+        }
+        
+        // a bucket can continue as long as the material, vao & index buffer is the same,
+        // the meshes in the shared buffers can be in the same bucket
+        IndirectCommandBuilder::BucketState state;
+            state.diffuseTexture = info.diffuseTexture.value;
+            state.normalMap = info.normalMap.value;
+            state.vao = mesh->getVertexArrayObject().get();
+            state.indexBuffer = mesh->getIndexGLBuffer();
+        builder.addGroup( state, mesh->getSubMeshes(), group.count, group.first, i );
+    }
+    return true;
+}
+
+void Renderer::submitObjects()
+{
+    Timer timer;
+    
+    size_t threadCount = std::min( mWorkerPool->getThreadCount(), mQuaryResult.size() / MIN_OBJECTS_PER_SUBMIT_THREAD );
+    
+    if( !mUseParallelSubmission || threadCount < 2 ) {
+        for( const SceneSnapshot::ObjectEntry *entry : mQuaryResult ) {
+            entry->object->submitRenderer( *this, *entry );
+        }
+        mRecordFrame->statistics.submitThreads = 1;
+    }
+    else {
+        // the ranges are in order, so merging the lists by thread keeps the serial submission order
+        mWorkerPool->parallelFor( mQuaryResult.size(), 
+            [this]( size_t first, size_t last, size_t thread ) {
+                tSubmitThread = thread;
+                for( size_t i=first; i < last; ++i ) {
+                    mQuaryResult[i]->object->submitRenderer( *this, *mQuaryResult[i] );
+                }
+                tSubmitThread = 0;
+            }
+        );
+        mergeSubmitLists();
+        mRecordFrame->statistics.submitThreads = mWorkerPool->getThreadCount();
+    }
+    
+    mRecordFrame->statistics.submitTime = std::chrono::duration_cast<Timer::Millisecond>(timer.getTimeAsDuration()).count();
+}
+
+void Renderer::mergeSubmitLists()
+{
+    // the staged uniforms are uploaded & relocated when the frame is rendered
+    FrameData *frame = getRecordFrame();
+    for( SubmitList &list : mSubmitLists ) {
+        frame->entities.insert( frame->entities.end(), list.entities.begin(), list.entities.end() );
+        frame->pointLights.insert( frame->pointLights.end(), list.pointLights.begin(), list.pointLights.end() );
+        frame->pointLightsNoShadow.insert( frame->pointLightsNoShadow.end(), list.pointLightsNoShadow.begin(), list.pointLightsNoShadow.end() );
+        frame->clusterLights.insert( frame->clusterLights.end(), list.clusterLights.begin(), list.clusterLights.end() );
+        frame->clusteredPointLights.insert( frame->clusteredPointLights.end(), list.clusteredPointLights.begin(), list.clusteredPointLights.end() );
+        
+        frame->customRenderables.insert( frame->customRenderables.end(), list.customRenderables.begin(), list.customRenderables.end() );
+        
+        frame->statistics.staticBatches += list.staticBatches;
+        frame->statistics.mergedDraws += list.mergedDraws;
+        
+        list.entities.clear();
+        list.pointLights.clear();
+        list.pointLightsNoShadow.clear();
+        list.clusterLights.clear();
+        list.clusteredPointLights.clear();
+        list.customRenderables.clear();
+        list.staticBatches = 0;
+        list.mergedDraws = 0;
+    }
+}
+
+void Renderer::buildLightClusters( Camera *camera )
+{
+    Timer clusterTimer;
+    
+    FrameData *frame = getRecordFrame();
+    LightClusterBuilder &clusters = frame->lightClusters;
+    
+    WorkerPool *pool = nullptr;
+    if( mUseParallelSubmission && frame->clusterLights.size() >= 2*MIN_LIGHTS_PER_CLUSTER_THREAD ) {
+        pool = mWorkerPool;
+    }
+    clusters.build( frame->clusterLights.data(), frame->clusterLights.size(), camera->getProjectionMatrix(), camera->getNearPlane(), camera->getFarPlane(), pool );
+    
+    glm::uvec3 gridSize = clusters.getGridSize();
+    
+    ClusteredLightUniforms uniforms;
+        uniforms.gridSize = glm::uvec4( gridSize, 0 );
+        uniforms.tileSize = glm::vec2( frame->renderSize ) / glm::vec2( gridSize.x, gridSize.y );
+        uniforms.sliceScaleBias = glm::vec2( clusters.getSliceScale(), clusters.getSliceBias() );
+    frame->clusterUniforms = aquireUniformBuffer( uniforms );
+    
+    frame->statistics.clusteredLightIndices = clusters.getLightIndices().size();
+    frame->statistics.lightClusterTime = std::chrono::duration_cast<Timer::Millisecond>(clusterTimer.getTimeAsDuration()).count();
+}
+
 void Renderer::quaryForObjects( const Frustrum &frustrum )
 {
     mQuaryResult.clear();
@@ -11,6 +11,7 @@
 #include "Root.h"
 #include "Config.h"
 #include "Log.h"
+#include "StaticMeshBuffers.h"
 
 #include "yaml-cxx/YamlCxx.h"
 
@@ -28,6 +29,8 @@ bool ResourceManager::init( Root *root )
     
     mResourcePaths = config->resourcePaths;
     
+    mStaticMeshBuffers = new StaticMeshBuffers;
+    
     loadResourcePack( "core" );
     
     StartupMesurements *mesurements = mRoot->getStartupMesurements();
@@ -39,6 +42,10 @@ bool ResourceManager::init( Root *root )
 void ResourceManager::destroy()
 {
     unloadAllResourcePacks();
+    
+    delete mStaticMeshBuffers;
+    mStaticMeshBuffers = nullptr;
+    
     mLog = nullptr;
 }
 
@@ -96,6 +96,11 @@ void Root::run()
     Timer::Duration targetFrameTime = std::chrono::duration_cast<Timer::Duration>(Timer::Seconds(1.f/targetFrameRate));
     
     float dt = 1.f/targetFrameRate;
+    
+    if( mConfig->renderThread ) {
+        mGraphicsManager->startRenderThread( mConfig->frameLatency );
+    }
+    
     while( mRunning ) {
         frameTimer.restart();
         
@@ -119,6 +124,9 @@ void Root::run()
         }
         mFrameRateHistory.pushValue( 1.f/dt );
     }
+    
+    // everything after this expects the gl context on the main thread
+    mGraphicsManager->stopRenderThread();
 }
 
 void Root::quit()
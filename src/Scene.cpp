@@ -38,15 +38,15 @@ void Scene::update( float dt )
     mSceneGraph->update( dt );
 }
 
-void Scene::quarySceneObjects( const Frustrum &frustrum, std::vector<SceneObject*> &result )
+void Scene::quarySceneObjects( const Frustrum &frustrum, std::vector<const SceneSnapshot::ObjectEntry*> &result )
 {
+    // use the published snapshot, so quaries doesn't depend on the graph
+    // being left alone for the rest of the frame
     if( mUseFrustumCulling ) {
-        mSceneGraph->quaryObjects( frustrum, result );
+        mSceneGraph->getSnapshot()->quaryObjects( frustrum, result );
     }
     else {
-        mSceneGraph->forEachObject( [&](SceneObject *object ) {
-            result.push_back( object );
-        } );
+        mSceneGraph->getSnapshot()->getObjects( result );
     }
 }
 
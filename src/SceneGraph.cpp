@@ -1,6 +1,8 @@
 #include "SceneGraph.h"
 #include "SceneObject.h"
 #include "Frustrum.h"
+#include "RadixSort.h"
+#include "Log.h"
 #include <Root.h>
 
 #include <glm/exponential.hpp>
@@ -8,11 +10,26 @@
 #include <cassert>
 #include <algorithm>
 
+namespace {
+    /// In order to fast determenate that children is releative to its parent,
+    /// we are expecting a certan order to then:
+    const glm::vec3 CHILD_OFFSETS[8] {
+        {-1.f,-1.f,-1.f},
+        { 1.f,-1.f,-1.f},
+        {-1.f, 1.f,-1.f},
+        { 1.f, 1.f,-1.f},
+        {-1.f,-1.f, 1.f},
+        { 1.f,-1.f, 1.f},
+        {-1.f, 1.f, 1.f},
+        { 1.f, 1.f, 1.f}
+    };
+}
+
 SceneGraph::SceneGraph( Root *root, const BoundingSphere &rootBounds ) :
     mRoot(root)
 {
     mRootNode.reset( new SceneNode );
-    mRootNode->_init( this, nullptr );
+    mRootNode->_init( this, nullptr, 0 );
     
     glm::vec3 center = rootBounds.getCenter();
     float radius = rootBounds.getRadius();
@@ -23,9 +40,18 @@ SceneGraph::SceneGraph( Root *root, const BoundingSphere &rootBounds ) :
     
     mRootNode->_setBounds( BoundingSphere(center, radius) );
     mSceneNodes.push_back( mRootNode.get() );
+    mNodeChanges.push_back( 0 );
     
     mMaxNodeLevel = ((int)maxNodeLevel) - 1;
     mRootPosition = rootBounds.getCenter();
+    
+    int depth = mMaxNodeLevel - mMinNodeLevel;
+    if( depth > NODE_KEY_MAX_LEVEL ) {
+        float minRadius = radius / float(1 << NODE_KEY_MAX_LEVEL);
+        mRoot->getDefaultLog()->stream(LogSeverity::Warning, "SceneGraph")
+            << "The scene bounds needs " << depth << " node levels but the node keys only fits " << NODE_KEY_MAX_LEVEL
+            << ", objects with a radius below " << minRadius << " are kept in nodes bigger than them";
+    }
 }
 
 SceneGraph::~SceneGraph()
@@ -33,6 +59,10 @@ SceneGraph::~SceneGraph()
     for( SceneNode *node : mSceneNodes ) {
         node->_destroy();
     }
+    // objects that never joined the graph still lives in our pool
+    for( SceneObject *object : mNewObjects ) {
+        object->_setPool( SceneObjectPool::GetDetachedPool() );
+    }
 }
 
 
@@ -40,6 +70,7 @@ void SceneGraph::addObject( SceneObject *object )
 {
     assert( object->_getParent() == nullptr );
     
+    object->_setPool( &mObjectPool );
     mNewObjects.push_back( object );
 }
 
@@ -53,10 +84,13 @@ void SceneGraph::removeObject( SceneObject *object )
             // if so remove it from the queue.
             std::swap( *iter, mNewObjects.back() );
             mNewObjects.pop_back();
+            
+            object->_setPool( SceneObjectPool::GetDetachedPool() );
         }
         return;
     }
     parent->removeObject( object );
+    recordObjectRemoved( object );
 
     cleanEmptyNodes( parent );
     object->_setParent( nullptr );
@@ -67,14 +101,16 @@ void SceneGraph::removeObject( SceneObject *object )
         mDirtyObjects.pop_back();
     }
     
+    object->_setPool( SceneObjectPool::GetDetachedPool() );
     object->_objectRemovedFromGraph( this );
 }
 
 void SceneGraph::update( float dt )
 {
+    updateTransforms( mDirtyObjects );
+    
     for( SceneObject *object : mDirtyObjects ) {
-        object->_updateTransform();
-        const BoundingSphere &bounds = object->getTransformedBoundingSphere();
+        const BoundingSphere &bounds = mObjectPool.getTransformedBoundingSphere( object->_getHandle() );
         
         SceneNode *parent = object->_getParent();
         SceneNode *newParent = getOrCreateNodeForBound( bounds );
@@ -86,23 +122,156 @@ void SceneGraph::update( float dt )
             
             cleanEmptyNodes( parent );
         }
+        recordObjectChange( object, newParent );
     }
     mDirtyObjects.clear();
     
+    insertNewObjects();
+    
+    for( SceneNode *node : mSceneNodes ) {
+        node->update( dt );
+    }
+    
+    publishSnapshot();
+}
+
+void SceneGraph::insertNewObjects()
+{
     auto newObjects = std::move( mNewObjects );
     mNewObjects.clear();
     
+    if( newObjects.empty() ) {
+        return;
+    }
+    
+    updateTransforms( newObjects );
+    
+    mNewObjectInfos.clear();
     for( SceneObject *object : newObjects ) {
-        SceneNode *parent = getOrCreateNodeForBound( object->getTransformedBoundingSphere() );
-        parent->addObject( object );
-        object->_setParent( parent );
+        NewObjectInfo info;
+            info.key = getNodeKey( mObjectPool.getTransformedBoundingSphere(object->_getHandle()) );
+            info.object = object;
+        mNewObjectInfos.push_back( info );
+    }
+    
+    radixSort( mNewObjectInfos, mNewObjectSortBuffer, []( const NewObjectInfo &info ) {
+        return info.key;
+    } );
+    
+    // the objects are sorted by there path, so the path walked for the previous
+    // key can be reused up to the first level that differs.
+    SceneNode *path[NODE_KEY_MAX_LEVEL+1];
+    path[0] = mRootNode.get();
+    int pathLevel = 0;
+    NodeKey prevKey = 0;
+    
+    size_t first = 0;
+    while( first < mNewObjectInfos.size() ) {
+        NodeKey key = mNewObjectInfos[first].key;
+        int level = key & ((1<<NODE_KEY_LEVEL_BITS)-1);
+        
+        int commonLevel = 0;
+        int maxCommonLevel = glm::min( level, pathLevel );
+        while( commonLevel < maxCommonLevel ) {
+            int shift = NODE_KEY_LEVEL_BITS + 3*(NODE_KEY_MAX_LEVEL-1-commonLevel);
+            if( ((key >> shift) & 7) != ((prevKey >> shift) & 7) ) {
+                break;
+            }
+            commonLevel++;
+        }
         
+        for( int i=commonLevel; i < level; ++i ) {
+            SceneNode *children = path[i]->getChildren();
+            if( !children ) {
+                children = createChildrenForNode( path[i] );
+            }
+            int shift = NODE_KEY_LEVEL_BITS + 3*(NODE_KEY_MAX_LEVEL-1-i);
+            path[i+1] = &children[(key >> shift) & 7];
+        }
+        pathLevel = level;
+        prevKey = key;
+        
+        SceneNode *node = path[level];
+        
+        mNodeObjects.clear();
+        for( ; first < mNewObjectInfos.size() && mNewObjectInfos[first].key == key; ++first ) {
+            SceneObject *object = mNewObjectInfos[first].object;
+            object->_setParent( node );
+            mNodeObjects.push_back( object );
+            recordObjectChange( object, node );
+        }
+        node->addObjects( mNodeObjects.data(), mNodeObjects.size() );
+    }
+    
+    for( SceneObject *object : newObjects ) {
         object->_objectAddedToGraph( this );
     }
+}
+
+void SceneGraph::updateTransforms( const std::vector<SceneObject*> &objects )
+{
+    // gather the dirty entries so the pool can update them in one go
+    mDirtyHandles.clear();
+    for( SceneObject *object : objects ) {
+        if( object->isDirty() ) {
+            assert( object->_getPool() == &mObjectPool );
+            mDirtyHandles.push_back( object->_getHandle() );
+            object->_clearDirty();
+        }
+    }
     
-    for( SceneNode *node : mSceneNodes ) {
-        node->update( dt );
+    mObjectPool.updateTransforms( mDirtyHandles.data(), mDirtyHandles.size() );
+}
+
+void SceneGraph::recordObjectChange( SceneObject *object, SceneNode *node )
+{
+    SceneObjectPool::Handle handle = object->_getHandle();
+    
+    SnapshotObjectChange change;
+        change.handle = handle;
+        change.entry.object = object;
+        change.entry.transform = mObjectPool.getTransform( handle );
+        change.entry.bounds = mObjectPool.getTransformedBoundingSphere( handle );
+        change.entry.node = node->getIndex();
+    mObjectChanges.push_back( change );
+}
+
+void SceneGraph::recordObjectRemoved( SceneObject *object )
+{
+    SnapshotObjectChange change;
+        change.handle = object->_getHandle();
+    mObjectChanges.push_back( change );
+}
+
+void SceneGraph::publishSnapshot()
+{
+    // the back snapshot was published the frame before,
+    // so it's missing the changes from both that frame and this one
+    SceneSnapshot &back = mSnapshots[1-mFrontSnapshot];
+    
+    for( const std::vector<SnapshotObjectChange> *changes : {&mPrevObjectChanges, &mObjectChanges} ) {
+        for( const SnapshotObjectChange &change : *changes ) {
+            back._setObject( change.handle, change.entry );
+        }
+    }
+    for( const std::vector<UInt32> *changes : {&mPrevNodeChanges, &mNodeChanges} ) {
+        for( UInt32 index : *changes ) {
+            SceneNode *node = mSceneNodes[index];
+            SceneNode *children = node->getChildren();
+            
+            SceneSnapshot::NodeEntry entry;
+                entry.bounds = node->getBounds();
+                entry.firstChild = children ? children->getIndex() : SceneSnapshot::INVALID_NODE;
+            back._setNode( index, entry );
+        }
     }
+    
+    mFrontSnapshot = 1-mFrontSnapshot;
+    
+    std::swap( mPrevObjectChanges, mObjectChanges );
+    mObjectChanges.clear();
+    std::swap( mPrevNodeChanges, mNodeChanges );
+    mNodeChanges.clear();
 }
 
 void SceneGraph::forEachObject( const std::function<void(SceneObject*)> &callback )
@@ -161,9 +330,9 @@ void SceneGraph::nodePartalyInsideFrusturm( SceneNode *node, const Frustrum &fru
     const auto &objects = node->getObjects();
     for( const auto &info: objects ) {
         if( info.isDead ) continue;
-        SceneObject *object = info.object;
-        if( frustrum.isInside(object->getTransformedBoundingSphere()) != Frustrum::TestStatus::Outside ) {
-            result.push_back( object );
+        const BoundingSphere &bounds = mObjectPool.getTransformedBoundingSphere( info.handle );
+        if( frustrum.isInside(bounds) != Frustrum::TestStatus::Outside ) {
+            result.push_back( info.object );
         }
     }
     
@@ -176,7 +345,7 @@ void SceneGraph::nodePartalyInsideFrusturm( SceneNode *node, const Frustrum &fru
 }
 
 
-SceneNode* SceneGraph::getOrCreateNodeForBound( const BoundingSphere &bounds )
+SceneGraph::NodeKey SceneGraph::getNodeKey( const BoundingSphere &bounds )
 {
     float radius = bounds.getRadius();
     glm::vec3 position = bounds.getCenter() - mRootPosition;
@@ -188,49 +357,56 @@ SceneNode* SceneGraph::getOrCreateNodeForBound( const BoundingSphere &bounds )
     if( radius == std::numeric_limits<float>::infinity() ) {
         level = 0;
     }
+    // bigger than the root goes in the root, too deep for the key is warned about in the constructor
+    level = glm::clamp( level, 0, NODE_KEY_MAX_LEVEL );
     
-    SceneNode *root = mRootNode.get();
+    NodeKey key = level;
+    float nodeRadius = mRootNode->getBounds().getRadius();
     
-    while( level > 0 ) {
+    for( int i=0; i < level; ++i ) {
         glm::bvec3 greaterThan0 = glm::greaterThan( glm::sign(position), glm::vec3(0.f) );
-        int index = greaterThan0.x | greaterThan0.y<<1 | greaterThan0.z<<2;
+        NodeKey index = greaterThan0.x | greaterThan0.y<<1 | greaterThan0.z<<2;
+        
+        // same offset as used by createChildrenForNode
+        nodeRadius /= 2.f;
+        float hsize = nodeRadius*glm::one_over_root_two<float>()/2.f;
+        position -= CHILD_OFFSETS[index] * hsize;
         
+        key |= index << (NODE_KEY_LEVEL_BITS + 3*(NODE_KEY_MAX_LEVEL-1-i));
+    }
+    
+    return key;
+}
+
+SceneNode* SceneGraph::getOrCreateNodeForKey( NodeKey key )
+{
+    int level = key & ((1<<NODE_KEY_LEVEL_BITS)-1);
+    
+    SceneNode *root = mRootNode.get();
+    for( int i=0; i < level; ++i ) {
         SceneNode *children = root->getChildren();
         if( !children ) {
             children = createChildrenForNode( root );
         }
         
-        position -= children[index].getBounds().getCenter() - root->getBounds().getCenter();
-//         position /= 2.f;
-        
-        root = &children[index];
-        level--;
+        int shift = NODE_KEY_LEVEL_BITS + 3*(NODE_KEY_MAX_LEVEL-1-i);
+        root = &children[(key >> shift) & 7];
     }
     
     return root;
 }
 
+SceneNode* SceneGraph::getOrCreateNodeForBound( const BoundingSphere &bounds )
+{
+    return getOrCreateNodeForKey( getNodeKey(bounds) );
+}
+
 SceneNode* SceneGraph::createChildrenForNode( SceneNode *node )
 {
     assert( node->getChildren() == nullptr );
     
     BoundingSphere bounds = node->getBounds();
     
-    /// In order to fast determenate that children is releative to its parent,
-    /// we are expecting a certan order to then:
-    
-    glm::vec3 offets[8] {
-        {-1.f,-1.f,-1.f},
-        { 1.f,-1.f,-1.f},
-        {-1.f, 1.f,-1.f},
-        { 1.f, 1.f,-1.f},
-        {-1.f,-1.f, 1.f},
-        { 1.f,-1.f, 1.f},
-        {-1.f, 1.f, 1.f},
-        { 1.f, 1.f, 1.f}
-    };
-    
-    
     glm::vec3 position = bounds.getCenter();
     float hradius = bounds.getRadius() / 2.f;
 
@@ -242,11 +418,13 @@ SceneNode* SceneGraph::createChildrenForNode( SceneNode *node )
     
     
     for( int i=0; i < 8; ++i ) {
-        children[i]._init( this, node );
-        children[i]._setBounds( BoundingSphere(position+offets[i]*hsize, hradius) );
+        children[i]._init( this, node, mSceneNodes.size() );
+        children[i]._setBounds( BoundingSphere(position+CHILD_OFFSETS[i]*hsize, hradius) );
+        mNodeChanges.push_back( mSceneNodes.size() );
         mSceneNodes.push_back( &children[i] );
     }
     node->_setChildren( children );
+    mNodeChanges.push_back( node->getIndex() );
     
     return children;
 }
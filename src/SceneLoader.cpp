@@ -8,6 +8,9 @@
 #include "ResourceManager.h"
 #include "SceneObjectFactory.h"
 #include "GlmStream.h"
+#include "Timer.h"
+#include "StartupMesurements.h"
+#include "StaticBatcher.h"
 
 #include "yaml-cxx/YamlCxx.h"
 
@@ -19,6 +22,7 @@ SceneLoader::SceneLoader( Root *root ) :
 
 
 SceneObject* createObject( Log *log, SceneManager *sceneMgr, const Yaml::Node &objectNode );
+bool isStaticObject( const Yaml::Node &objectNode );
 
 void SceneLoader::loadFile( const std::string &filename )
 {
@@ -42,13 +46,23 @@ void SceneLoader::loadFile( const std::string &filename )
     SharedPtr<Texture> skybox = resourceMgr->getTextureAutoPack( skyboxName );
     mScene->setSkyBox( skybox );
     
+    // the static objects are kept until the rest of the scene is loaded, so they can be batched
+    bool staticBatching = sceneCfg.getFirstValue("StaticBatching",false).asValue().getValue<bool>();
+    float batchChunkSize = sceneCfg.getFirstValue("StaticBatchChunkSize",false).asValue().getValue<float>(DEFAULT_STATIC_BATCH_CHUNK_SIZE);
+    std::vector<SceneObject*> staticObjects;
+    
     auto objectList = sceneCfg.getValues("Object");
     for( Yaml::Node objectNode : objectList ) {
         
         SceneObject *object = createObject( log, sceneMgr, objectNode );
         
         if( object ) {
-            mScene->addObject( object, true );
+            if( staticBatching && isStaticObject(objectNode) ) {
+                staticObjects.push_back( object );
+            }
+            else {
+                mScene->addObject( object, true );
+            }
         }
     }
     
@@ -60,6 +74,7 @@ void SceneLoader::loadFile( const std::string &filename )
         glm::vec3 spacing = config.getFirstValue("Spacing",false).asValue().getValue<glm::vec3>();
         
         Yaml::Node objectNode = config.getFirstValue("Object",false);
+        bool isStatic = staticBatching && isStaticObject( objectNode );
         
         for( int z=0; z < count.z; ++z ) {
             for( int y=0; y < count.y; ++y ) {
@@ -71,12 +86,49 @@ void SceneLoader::loadFile( const std::string &filename )
                         pos += glm::vec3(x,y,z) * spacing;
                         object->setPosition( pos );
                         
-                        mScene->addObject( object, true );
+                        if( isStatic ) {
+                            staticObjects.push_back( object );
+                        }
+                        else {
+                            mScene->addObject( object, true );
+                        }
                     }
                 }
             }
         }
     }
+    
+    StartupMesurements *mesurements = mRoot->getStartupMesurements();
+    
+    if( staticBatching ) {
+        Timer batchTimer;
+        
+        size_t objectCount = staticObjects.size();
+        StaticBatcher batcher( mRoot, batchChunkSize );
+        batcher.batchObjects( staticObjects );
+        
+        for( SceneObject *object : staticObjects ) {
+            mScene->addObject( object, true );
+        }
+        
+        mesurements->staticBatching += batchTimer.getTimeAsSeconds();
+        log->stream(LogSeverity::Information, "SceneLoader") << "Merged " << batcher.getMergedEntities() << " of " << objectCount 
+                                                              << " static objects into " << batcher.getBatchCount() << " batches";
+    }
+    
+    // build the scene graph for all the loaded objects in one go
+    Timer buildTimer;
+    mScene->getSceneGraph()->insertNewObjects();
+    
+    mesurements->sceneGraphBuild += buildTimer.getTimeAsSeconds();
+}
+
+bool isStaticObject( const Yaml::Node &objectNode )
+{
+    // objects are only batched when they say they are static ("Static: true"),
+    // anything else may be moved after it's loaded
+    Yaml::MappingNode config = objectNode.asMapping();
+    return config.getFirstValue("Static",false).asValue().getValue<bool>();
 }
 
 SceneObject *createObject( Log *log, SceneManager *sceneMgr, const Yaml::Node &objectNode )
@@ -96,6 +148,7 @@ SceneObject *createObject( Log *log, SceneManager *sceneMgr, const Yaml::Node &o
         if( object ) {
             Yaml::ValueNode positionNode = config.getFirstValue("Position",false).asValue(),
                             orientationNode = config.getFirstValue("Orientation",false).asValue(),
+                            scaleNode = config.getFirstValue("Scale",false).asValue(),
                             renderqueueNode = config.getFirstValue("RenderQueue",false).asValue();
             bool succes;
             
@@ -109,6 +162,11 @@ SceneObject *createObject( Log *log, SceneManager *sceneMgr, const Yaml::Node &o
                 object->setOrientation( glm::quat(orientation) );
             }
             
+            glm::vec3 scale = scaleNode.getValue<glm::vec3>(&succes);
+            if( succes ) {
+                object->setScale( scale );
+            }
+            
             std::string renderQueueStr = renderqueueNode.getValue();
             if( !renderQueueStr.empty() ) {
                 unsigned int renderQueue = renderQueueFromString(renderQueueStr);
@@ -38,11 +38,16 @@ void SceneManager::postInit()
 {
     const Config *config = mRoot->getConfig();
     
+    Timer loadTimer;
+    
     SceneLoader loader( mRoot );
     mScene = loader.getScene();
     
     loader.loadFile( config->startScene );
     
+    StartupMesurements *mesurements = mRoot->getStartupMesurements();
+    mesurements->sceneLoad = loadTimer.getTimeAsSeconds();
+    
     auto controller = makeSharedPtr<FlyingController>( mRoot->getInputManager() );
     
     controller->loadFromConfig( config->freeCamera );
@@ -114,5 +119,11 @@ SceneObjectFactory* SceneManager::getFactory( const std::string &type )
     return nullptr;
 }
 
+void SceneManager::forEachFactory( const std::function<void(const std::string&,SceneObjectFactory*)> &callback )
+{
+    for( const auto &entry : mSceneObjectFactories ) {
+        callback( entry.first, entry.second.factory );
+    }
+}
 
 
@@ -12,6 +12,7 @@ void SceneNode::_destroy()
         if( info.isDead ) continue;
         SceneObject *object = info.object;
         object->_setParent( nullptr );
+        object->_setPool( SceneObjectPool::GetDetachedPool() );
         object->_objectRemovedFromGraph( mGraph );
         if( object->_getAutoDelete() ) {
             object->getFactory()->destroyObject( object );
@@ -25,10 +26,28 @@ void SceneNode::addObject( SceneObject *object )
     auto iter = std::lower_bound( mObjects.begin(), mObjects.end(), object );
     ObjectInfo info;
         info.object = object;
+        info.handle = object->_getHandle();
         info.isDead = false;
     mObjects.insert( iter, info );
 }
 
+void SceneNode::addObjects( SceneObject *const *objects, size_t count )
+{
+    size_t prevSize = mObjects.size();
+    
+    for( size_t i=0; i < count; ++i ) {
+        ObjectInfo info;
+            info.object = objects[i];
+            info.handle = objects[i]->_getHandle();
+            info.isDead = false;
+        mObjects.push_back( info );
+    }
+    
+    auto middle = mObjects.begin() + prevSize;
+    std::sort( middle, mObjects.end() );
+    std::inplace_merge( mObjects.begin(), middle, mObjects.end() );
+}
+
 void SceneNode::removeObject( SceneObject *object )
 {
     auto iter = std::lower_bound( mObjects.begin(), mObjects.end(), object );
@@ -1,7 +1,17 @@
 #include "SceneObject.h"
 #include "SceneObjectFactory.h"
 
-#include <glm/gtx/transform.hpp>
+SceneObject::SceneObject( SceneObjectFactory *factory ) :
+    mFactory(factory)
+{
+    mPool = SceneObjectPool::GetDetachedPool();
+    mHandle = mPool->allocate( this );
+}
+
+SceneObject::~SceneObject()
+{
+    mPool->release( mHandle );
+}
 
 SceneObject* SceneObject::clone()
 {
@@ -10,12 +20,18 @@ SceneObject* SceneObject::clone()
 
 void SceneObject::_updateTransform()
 {
-    mTransform = glm::translate(mPosition) * glm::mat4_cast(mOrientation);
-    glm::vec3 center( mTransform * glm::vec4(mBoundingSphere.getCenter(),1.0f) );
-    mTransformedBoundingSphere = BoundingSphere( center, mBoundingSphere.getRadius() );
-    
+    mPool->updateTransforms( &mHandle, 1 );
     mDirty = false;
 }
 
+void SceneObject::_setPool( SceneObjectPool *pool )
+{
+    if( pool == mPool ) {
+        return;
+    }
+    mHandle = pool->moveFrom( mPool, mHandle );
+    mPool = pool;
+}
+
 
 
@@ -21,7 +21,12 @@ void SceneObjectFactory::destroyObject( SceneObject *object )
 }
 
 DeferredEntityFactory::DeferredEntityFactory( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mEntityPool( makeUniquePtr<ObjectPool<DeferredEntity>>() )
+{
+}
+
+DeferredEntityFactory::~DeferredEntityFactory()
 {
 }
 
@@ -43,7 +48,7 @@ SceneObject* DeferredEntityFactory::createObject( const Yaml::Node &node )
     material.normalMap = resourceMgr->getTextureAutoPack( normalMapName );
     
     if( mesh ) {
-        DeferredEntity *entity = new DeferredEntity( this, mRoot, mesh, material );
+        DeferredEntity *entity = mEntityPool->create( this, mRoot, mesh, material );
         
         return entity;
     }
@@ -56,16 +61,39 @@ SceneObject* DeferredEntityFactory::cloneObject( SceneObject *object )
     DeferredEntity *entity = dynamic_cast<DeferredEntity*>( object );
     assert( entity );
     
-    DeferredEntity *clone = new DeferredEntity( this, mRoot, entity->getMesh(), entity->getMaterial() );
+    DeferredEntity *clone = mEntityPool->create( this, mRoot, entity->getMesh(), entity->getMaterial() );
     clone->setCastShadow( entity->getCastShadow() );
     clone->setOrientation( entity->getOrientation() );
     clone->setPosition( entity->getPosition() );
+    clone->setScale( entity->getScale() );
     return clone;
 }
 
+void DeferredEntityFactory::destroyObject( SceneObject *object )
+{
+    DeferredEntity *entity = dynamic_cast<DeferredEntity*>( object );
+    assert( entity );
+    mEntityPool->destroy( entity );
+}
+
+DeferredEntity* DeferredEntityFactory::createEntity( const SharedPtr<Mesh> &mesh, const DeferredMaterial &material )
+{
+    return mEntityPool->create( this, mRoot, mesh, material );
+}
+
+ObjectPoolStatistics DeferredEntityFactory::getPoolStatistics()
+{
+    return mEntityPool->getStatistics();
+}
+
 
 ComputeParticleFactory::ComputeParticleFactory( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mParticleSystemPool( makeUniquePtr<ObjectPool<ComputeParticleSystem>>() )
+{
+}
+
+ComputeParticleFactory::~ComputeParticleFactory()
 {
 }
 
@@ -73,7 +101,7 @@ SceneObject* ComputeParticleFactory::createObject( const Yaml::Node &node )
 {
     Yaml::MappingNode config = node.asMapping();
     
-    ComputeParticleSystem *particleSys = new ComputeParticleSystem( this, mRoot );
+    ComputeParticleSystem *particleSys = mParticleSystemPool->create( this, mRoot );
 
     return particleSys;
 }
@@ -83,7 +111,7 @@ SceneObject* ComputeParticleFactory::cloneObject( SceneObject *object )
     ComputeParticleSystem *particleSys = dynamic_cast<ComputeParticleSystem*>( object );
     assert( particleSys );
     
-    ComputeParticleSystem *clone = new ComputeParticleSystem( this, mRoot );
+    ComputeParticleSystem *clone = mParticleSystemPool->create( this, mRoot );
     
     clone->setSpeed( particleSys->getSpeed() );
     clone->setDistMod( particleSys->getDistMod() );
@@ -102,9 +130,27 @@ SceneObject* ComputeParticleFactory::cloneObject( SceneObject *object )
     return clone;
 }
 
+void ComputeParticleFactory::destroyObject( SceneObject *object )
+{
+    ComputeParticleSystem *particleSys = dynamic_cast<ComputeParticleSystem*>( object );
+    assert( particleSys );
+    mParticleSystemPool->destroy( particleSys );
+}
+
+ObjectPoolStatistics ComputeParticleFactory::getPoolStatistics()
+{
+    return mParticleSystemPool->getStatistics();
+}
+
 
 LightFactory::LightFactory( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mPointLightPool( makeUniquePtr<ObjectPool<PointLight>>() ),
+    mSpotLightPool( makeUniquePtr<ObjectPool<SpotLight>>() )
+{
+}
+
+LightFactory::~LightFactory()
 {
 }
 
@@ -116,7 +162,7 @@ SceneObject* LightFactory::createObject( const Yaml::Node &node )
     bool castShadow = config.getFirstValue("CastShadow",false).asValue().getValue<bool>(true);
     
     if( StringUtils::equalCaseInsensitive(lightType,"Point") ) {
-        PointLight *light = new PointLight( this, mRoot );
+        PointLight *light = mPointLightPool->create( this, mRoot );
         
         float innerRadius = config.getFirstValue("InnerRadius",false).asValue().getValue<float>(light->getInnerRadius());
         float outerRadius = config.getFirstValue("OuterRadius",false).asValue().getValue<float>(light->getOuterRadius());
@@ -131,7 +177,7 @@ SceneObject* LightFactory::createObject( const Yaml::Node &node )
         return light;
     }
     if( StringUtils::equalCaseInsensitive(lightType,"Spot") ) {
-        SpotLight *light = new SpotLight( this, mRoot );
+        SpotLight *light = mSpotLightPool->create( this, mRoot );
         
         float innerAngle = config.getFirstValue("InnerAngle",false).asValue().getValue<float>(light->getInnerAngle());
         float outerAngle = config.getFirstValue("OuterAngle",false).asValue().getValue<float>(light->getOuterAngle());
@@ -156,7 +202,7 @@ SceneObject* LightFactory::createObject( const Yaml::Node &node )
 SceneObject* LightFactory::cloneObject( SceneObject *object )
 {
     if( PointLight *light = dynamic_cast<PointLight*>(object) ) {
-        PointLight *clone = new PointLight( this, mRoot );
+        PointLight *clone = mPointLightPool->create( this, mRoot );
         
         clone->setColor( light->getColor() );
         clone->setOuterRadius( light->getOuterRadius() );
@@ -168,7 +214,7 @@ SceneObject* LightFactory::cloneObject( SceneObject *object )
         return clone;
     }
     if( SpotLight *light = dynamic_cast<SpotLight*>(object) ) {
-        SpotLight *clone = new SpotLight( this, mRoot );
+        SpotLight *clone = mSpotLightPool->create( this, mRoot );
         
         clone->setColor( light->getColor() );
         clone->setInnerAngle( light->getInnerAngle() );
@@ -186,8 +232,41 @@ SceneObject* LightFactory::cloneObject( SceneObject *object )
     throw std::runtime_error( "Can't clone object, not a light! (are you sure it was created by this factory?)" );
 }
 
+void LightFactory::destroyObject( SceneObject *object )
+{
+    if( PointLight *light = dynamic_cast<PointLight*>(object) ) {
+        mPointLightPool->destroy( light );
+        return;
+    }
+    if( SpotLight *light = dynamic_cast<SpotLight*>(object) ) {
+        mSpotLightPool->destroy( light );
+        return;
+    }
+    
+    throw std::runtime_error( "Can't destroy object, not a light! (are you sure it was created by this factory?)" );
+}
+
+ObjectPoolStatistics LightFactory::getPoolStatistics()
+{
+    // combined statistics for both light types
+    const ObjectPoolStatistics &pointStatistics = mPointLightPool->getStatistics(),
+                               &spotStatistics = mSpotLightPool->getStatistics();
+                               
+    ObjectPoolStatistics statistics;
+    statistics.liveObjects = pointStatistics.liveObjects + spotStatistics.liveObjects;
+    statistics.peakObjects = pointStatistics.peakObjects + spotStatistics.peakObjects;
+    statistics.slabCount = pointStatistics.slabCount + spotStatistics.slabCount;
+    
+    return statistics;
+}
+
 RandomMovingObjectFactory::RandomMovingObjectFactory( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mObjectsPool( makeUniquePtr<ObjectPool<RandomMovingObjects>>() )
+{
+}
+
+RandomMovingObjectFactory::~RandomMovingObjectFactory()
 {
 }
 
@@ -195,7 +274,7 @@ SceneObject *RandomMovingObjectFactory::createObject( const Yaml::Node &node )
 {
     Yaml::MappingNode config = node.asMapping();
     
-    RandomMovingObjects *randomMovingObjects = new RandomMovingObjects( this, mRoot );
+    RandomMovingObjects *randomMovingObjects = mObjectsPool->create( this, mRoot );
     
     float radius = config.getFirstValue("Radius", false).asValue().getValue<float>( randomMovingObjects->getRadius() );
     randomMovingObjects->setRadius( radius );
@@ -226,7 +305,7 @@ SceneObject *RandomMovingObjectFactory::createObject( const Yaml::Node &node )
 SceneObject *RandomMovingObjectFactory::cloneObject( SceneObject *object )
 {
     RandomMovingObjects *randomMovingObjects = dynamic_cast<RandomMovingObjects*>( object );
-    RandomMovingObjects *clone = new RandomMovingObjects( this, mRoot );
+    RandomMovingObjects *clone = mObjectsPool->create( this, mRoot );
     
     clone->setTemplate( randomMovingObjects->getTemplate()->clone() );
     clone->setPosition( randomMovingObjects->getPosition() );
@@ -236,8 +315,25 @@ SceneObject *RandomMovingObjectFactory::cloneObject( SceneObject *object )
     return clone;
 }
 
-PulsingObjectFactory::PulsingObjectFactory( Root *root ) : 
-    mRoot(root)
+void RandomMovingObjectFactory::destroyObject( SceneObject *object )
+{
+    RandomMovingObjects *randomMovingObjects = dynamic_cast<RandomMovingObjects*>( object );
+    assert( randomMovingObjects );
+    mObjectsPool->destroy( randomMovingObjects );
+}
+
+ObjectPoolStatistics RandomMovingObjectFactory::getPoolStatistics()
+{
+    return mObjectsPool->getStatistics();
+}
+
+PulsingObjectFactory::PulsingObjectFactory( Root *root ) :
+    mRoot(root),
+    mPulsingObjectPool( makeUniquePtr<ObjectPool<PulsingObject>>() )
+{
+}
+
+PulsingObjectFactory::~PulsingObjectFactory()
 {
 }
 
@@ -259,7 +355,7 @@ SceneObject *PulsingObjectFactory::createObject( const Yaml::Node &node )
     material.normalMap = resourceMgr->getTextureAutoPack( normalMapName );
     
     if( mesh ) {
-        PulsingObject *object = new PulsingObject( this, mRoot, mesh, material );
+        PulsingObject *object = mPulsingObjectPool->create( this, mRoot, mesh, material );
         
         float maxScale = config.getFirstValue( "MaxScale", false ).asValue().getValue<float>( object->getMaxScale() );
         float minScale = config.getFirstValue( "MinScale", false ).asValue().getValue<float>( object->getMinScale() );
@@ -278,7 +374,7 @@ SceneObject *PulsingObjectFactory::cloneObject( SceneObject *object )
     PulsingObject *pulsingObject = dynamic_cast<PulsingObject*>( object );
     assert( pulsingObject );
     
-    PulsingObject *clone = new PulsingObject( this, mRoot, pulsingObject->getMesh(), pulsingObject->getMaterial() );
+    PulsingObject *clone = mPulsingObjectPool->create( this, mRoot, pulsingObject->getMesh(), pulsingObject->getMaterial() );
     
     clone->setMaxScale( pulsingObject->getMaxScale() );
     clone->setMinScale( pulsingObject->getMinScale() );
@@ -286,8 +382,25 @@ SceneObject *PulsingObjectFactory::cloneObject( SceneObject *object )
     return clone;
 }
 
+void PulsingObjectFactory::destroyObject( SceneObject *object )
+{
+    PulsingObject *pulsingObject = dynamic_cast<PulsingObject*>( object );
+    assert( pulsingObject );
+    mPulsingObjectPool->destroy( pulsingObject );
+}
+
+ObjectPoolStatistics PulsingObjectFactory::getPoolStatistics()
+{
+    return mPulsingObjectPool->getStatistics();
+}
+
 ComputeWaterFactory::ComputeWaterFactory( Root *root ) :
-    mRoot(root)
+    mRoot(root),
+    mWaterPool( makeUniquePtr<ObjectPool<ComputeWater>>() )
+{
+}
+
+ComputeWaterFactory::~ComputeWaterFactory()
 {
 }
 
@@ -295,7 +408,7 @@ SceneObject* ComputeWaterFactory::createObject( const Yaml::Node &node )
 {
     Yaml::MappingNode config = node.asMapping();
     
-    ComputeWater *water = new ComputeWater( this, mRoot );
+    ComputeWater *water = mWaterPool->create( this, mRoot );
     
     float depthFalloff = config.getFirstValue("DepthFalloff",false).asValue().getValue<float>( water->getDepthFalloff() );
     float heightScale = config.getFirstValue("HeightScale",false).asValue().getValue<float>( water->getHeightScale() );
@@ -316,11 +429,23 @@ SceneObject* ComputeWaterFactory::cloneObject( SceneObject *object )
 {
     ComputeWater *water = dynamic_cast<ComputeWater*>( object );
     assert( water );
-    ComputeWater *clone = new ComputeWater( this, mRoot );
+    ComputeWater *clone = mWaterPool->create( this, mRoot );
     
     return clone;
 }
 
+void ComputeWaterFactory::destroyObject( SceneObject *object )
+{
+    ComputeWater *water = dynamic_cast<ComputeWater*>( object );
+    assert( water );
+    mWaterPool->destroy( water );
+}
+
+ObjectPoolStatistics ComputeWaterFactory::getPoolStatistics()
+{
+    return mWaterPool->getStatistics();
+}
+
 
 
 
@@ -0,0 +1,182 @@
+#include "SceneObjectPool.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <cassert>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+SceneObjectPool* SceneObjectPool::GetDetachedPool()
+{
+    static SceneObjectPool pool;
+    return &pool;
+}
+
+SceneObjectPool::Handle SceneObjectPool::allocate( SceneObject *owner )
+{
+    assert( owner != nullptr );
+    
+    if( !mFreeHandles.empty() ) {
+        Handle handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+        
+        mOwners[handle] = owner;
+        mPositions[handle] = glm::vec3();
+        mScales[handle] = glm::vec3( 1.f );
+        mOrientations[handle] = glm::quat();
+        mTransforms[handle] = glm::mat4();
+        mBounds[handle] = BoundingSphere();
+        mTransformedBounds[handle] = BoundingSphere();
+        
+        return handle;
+    }
+    
+    Handle handle = mOwners.size();
+    
+    mOwners.push_back( owner );
+    mPositions.emplace_back();
+    mScales.emplace_back( 1.f );
+    mOrientations.emplace_back();
+    mTransforms.emplace_back();
+    mBounds.emplace_back();
+    mTransformedBounds.emplace_back();
+    
+    return handle;
+}
+
+void SceneObjectPool::release( Handle handle )
+{
+    assert( handle < mOwners.size() );
+    assert( mOwners[handle] != nullptr );
+    
+    mOwners[handle] = nullptr;
+    mFreeHandles.push_back( handle );
+}
+
+SceneObjectPool::Handle SceneObjectPool::moveFrom( SceneObjectPool *pool, Handle handle )
+{
+    assert( pool != this );
+    
+    Handle newHandle = allocate( pool->mOwners[handle] );
+    
+    mPositions[newHandle] = pool->mPositions[handle];
+    mScales[newHandle] = pool->mScales[handle];
+    mOrientations[newHandle] = pool->mOrientations[handle];
+    mTransforms[newHandle] = pool->mTransforms[handle];
+    mBounds[newHandle] = pool->mBounds[handle];
+    mTransformedBounds[newHandle] = pool->mTransformedBounds[handle];
+    
+    pool->release( handle );
+    
+    return newHandle;
+}
+
+void SceneObjectPool::updateTransforms( const Handle *handles, size_t count )
+{
+    size_t i = 0;
+#ifdef __SSE__
+    for( ; i+4 <= count; i += 4 ) {
+        updateTransforms4( handles+i );
+    }
+#endif
+    for( ; i < count; ++i ) {
+        updateTransform( handles[i] );
+    }
+}
+
+void SceneObjectPool::updateTransform( Handle handle )
+{
+    const glm::vec3 &scale = mScales[handle];
+    glm::mat4 transform = glm::translate(mPositions[handle]) * glm::mat4_cast(mOrientations[handle]) * glm::scale(scale);
+    const BoundingSphere &bounds = mBounds[handle];
+    
+    glm::vec3 center( transform * glm::vec4(bounds.getCenter(),1.0f) );
+    glm::vec3 absScale = glm::abs( scale );
+    float maxScale = glm::max( absScale.x, glm::max(absScale.y, absScale.z) );
+    
+    mTransforms[handle] = transform;
+    mTransformedBounds[handle] = BoundingSphere( center, bounds.getRadius()*maxScale );
+}
+
+#ifdef __SSE__
+void SceneObjectPool::updateTransforms4( const Handle *handles )
+{
+    // gather the inputs so that every register holds one component for all 4 entries
+    alignas(16) float qx[4], qy[4], qz[4], qw[4],
+                      sx[4], sy[4], sz[4],
+                      px[4], py[4], pz[4],
+                      cx[4], cy[4], cz[4], r[4];
+                      
+    for( int i=0; i < 4; ++i ) {
+        Handle handle = handles[i];
+        
+        const glm::quat &orientation = mOrientations[handle];
+        const glm::vec3 &scale = mScales[handle],
+                        &position = mPositions[handle],
+                        &center = mBounds[handle].getCenter();
+        
+        qx[i] = orientation.x; qy[i] = orientation.y; qz[i] = orientation.z; qw[i] = orientation.w;
+        sx[i] = scale.x; sy[i] = scale.y; sz[i] = scale.z;
+        px[i] = position.x; py[i] = position.y; pz[i] = position.z;
+        cx[i] = center.x; cy[i] = center.y; cz[i] = center.z;
+        r[i] = mBounds[handle].getRadius();
+    }
+    
+    __m128 x = _mm_load_ps(qx), y = _mm_load_ps(qy), z = _mm_load_ps(qz), w = _mm_load_ps(qw);
+    __m128 one = _mm_set1_ps( 1.f ), two = _mm_set1_ps( 2.f );
+    
+    __m128 xx = _mm_mul_ps(x,x), yy = _mm_mul_ps(y,y), zz = _mm_mul_ps(z,z),
+           xy = _mm_mul_ps(x,y), xz = _mm_mul_ps(x,z), yz = _mm_mul_ps(y,z),
+           wx = _mm_mul_ps(w,x), wy = _mm_mul_ps(w,y), wz = _mm_mul_ps(w,z);
+           
+    // rotation matrix, same layout as glm::mat3_cast (m<column><row>)
+    __m128 m00 = _mm_sub_ps( one, _mm_mul_ps(two, _mm_add_ps(yy,zz)) ),
+           m01 = _mm_mul_ps( two, _mm_add_ps(xy,wz) ),
+           m02 = _mm_mul_ps( two, _mm_sub_ps(xz,wy) ),
+           m10 = _mm_mul_ps( two, _mm_sub_ps(xy,wz) ),
+           m11 = _mm_sub_ps( one, _mm_mul_ps(two, _mm_add_ps(xx,zz)) ),
+           m12 = _mm_mul_ps( two, _mm_add_ps(yz,wx) ),
+           m20 = _mm_mul_ps( two, _mm_add_ps(xz,wy) ),
+           m21 = _mm_mul_ps( two, _mm_sub_ps(yz,wx) ),
+           m22 = _mm_sub_ps( one, _mm_mul_ps(two, _mm_add_ps(xx,yy)) );
+           
+    // apply the scale to the columns
+    __m128 scaleX = _mm_load_ps(sx), scaleY = _mm_load_ps(sy), scaleZ = _mm_load_ps(sz);
+    m00 = _mm_mul_ps(m00,scaleX); m01 = _mm_mul_ps(m01,scaleX); m02 = _mm_mul_ps(m02,scaleX);
+    m10 = _mm_mul_ps(m10,scaleY); m11 = _mm_mul_ps(m11,scaleY); m12 = _mm_mul_ps(m12,scaleY);
+    m20 = _mm_mul_ps(m20,scaleZ); m21 = _mm_mul_ps(m21,scaleZ); m22 = _mm_mul_ps(m22,scaleZ);
+    
+    __m128 posX = _mm_load_ps(px), posY = _mm_load_ps(py), posZ = _mm_load_ps(pz);
+    __m128 centerX = _mm_load_ps(cx), centerY = _mm_load_ps(cy), centerZ = _mm_load_ps(cz);
+    
+    __m128 worldX = _mm_add_ps( _mm_add_ps(_mm_mul_ps(m00,centerX), _mm_mul_ps(m10,centerY)), _mm_add_ps(_mm_mul_ps(m20,centerZ), posX) ),
+           worldY = _mm_add_ps( _mm_add_ps(_mm_mul_ps(m01,centerX), _mm_mul_ps(m11,centerY)), _mm_add_ps(_mm_mul_ps(m21,centerZ), posY) ),
+           worldZ = _mm_add_ps( _mm_add_ps(_mm_mul_ps(m02,centerX), _mm_mul_ps(m12,centerY)), _mm_add_ps(_mm_mul_ps(m22,centerZ), posZ) );
+           
+    // the radius is scaled by the largest absolute scale
+    __m128 signMask = _mm_set1_ps( -0.f );
+    __m128 maxScale = _mm_max_ps( _mm_andnot_ps(signMask,scaleX), _mm_max_ps(_mm_andnot_ps(signMask,scaleY), _mm_andnot_ps(signMask,scaleZ)) );
+    __m128 radius = _mm_mul_ps( _mm_load_ps(r), maxScale );
+    
+    alignas(16) float out[12][4];
+    _mm_store_ps( out[0], m00 ); _mm_store_ps( out[1], m01 ); _mm_store_ps( out[2], m02 );
+    _mm_store_ps( out[3], m10 ); _mm_store_ps( out[4], m11 ); _mm_store_ps( out[5], m12 );
+    _mm_store_ps( out[6], m20 ); _mm_store_ps( out[7], m21 ); _mm_store_ps( out[8], m22 );
+    _mm_store_ps( out[9], worldX ); _mm_store_ps( out[10], worldY ); _mm_store_ps( out[11], worldZ );
+    _mm_store_ps( r, radius );
+    
+    for( int i=0; i < 4; ++i ) {
+        Handle handle = handles[i];
+        
+        mTransforms[handle] = glm::mat4(
+            out[0][i], out[1][i], out[2][i], 0.f,
+            out[3][i], out[4][i], out[5][i], 0.f,
+            out[6][i], out[7][i], out[8][i], 0.f,
+            px[i],     py[i],     pz[i],     1.f
+        );
+        mTransformedBounds[handle] = BoundingSphere( glm::vec3(out[9][i],out[10][i],out[11][i]), r[i] );
+    }
+}
+#endif
@@ -0,0 +1,130 @@
+#include "SceneSnapshot.h"
+#include "Frustrum.h"
+
+#include <cassert>
+
+void SceneSnapshot::quaryObjects( const Frustrum &frustrum, std::vector<const ObjectEntry*> &result ) const
+{
+    if( mNodes.empty() ) {
+        return;
+    }
+    
+    quaryNode( 0, frustrum, result );
+}
+
+void SceneSnapshot::getObjects( std::vector<const ObjectEntry*> &result ) const
+{
+    for( const ObjectEntry &entry : mObjects ) {
+        if( entry.object ) {
+            result.push_back( &entry );
+        }
+    }
+}
+
+void SceneSnapshot::_setObject( SceneObjectPool::Handle handle, const ObjectEntry &entry )
+{
+    if( handle >= mObjects.size() ) {
+        mObjects.resize( handle+1 );
+        mNextInNode.resize( handle+1, SceneObjectPool::INVALID_HANDLE );
+        mPrevInNode.resize( handle+1, SceneObjectPool::INVALID_HANDLE );
+    }
+    
+    if( mObjects[handle].object ) {
+        mObjectCount--;
+        unlinkObject( handle );
+    }
+    
+    mObjects[handle] = entry;
+    
+    if( entry.object ) {
+        mObjectCount++;
+        linkObject( handle, entry.node );
+    }
+}
+
+void SceneSnapshot::_setNode( UInt32 index, const NodeEntry &entry )
+{
+    if( index >= mNodes.size() ) {
+        mNodes.resize( index+1 );
+    }
+    mNodes[index] = entry;
+}
+
+void SceneSnapshot::quaryNode( UInt32 index, const Frustrum &frustrum, std::vector<const ObjectEntry*> &result ) const
+{
+    const NodeEntry &node = mNodes[index];
+    Frustrum::TestStatus status = frustrum.isInside( node.bounds );
+    
+    switch( status ) {
+    case( Frustrum::TestStatus::Outside ):
+        return;
+    case( Frustrum::TestStatus::Inside ):
+        addSubtree( index, result );
+        return;
+    case( Frustrum::TestStatus::Intersecting ):
+        if( index < mFirstInNode.size() ) {
+            for( SceneObjectPool::Handle handle = mFirstInNode[index]; handle != SceneObjectPool::INVALID_HANDLE; handle = mNextInNode[handle] ) {
+                const ObjectEntry &entry = mObjects[handle];
+                if( frustrum.isInside(entry.bounds) != Frustrum::TestStatus::Outside ) {
+                    result.push_back( &entry );
+                }
+            }
+        }
+        if( node.firstChild != INVALID_NODE ) {
+            for( UInt32 i=0; i < 8; ++i ) {
+                quaryNode( node.firstChild+i, frustrum, result );
+            }
+        }
+        return;
+    }
+}
+
+void SceneSnapshot::addSubtree( UInt32 index, std::vector<const ObjectEntry*> &result ) const
+{
+    if( index < mFirstInNode.size() ) {
+        for( SceneObjectPool::Handle handle = mFirstInNode[index]; handle != SceneObjectPool::INVALID_HANDLE; handle = mNextInNode[handle] ) {
+            result.push_back( &mObjects[handle] );
+        }
+    }
+    
+    const NodeEntry &node = mNodes[index];
+    if( node.firstChild != INVALID_NODE ) {
+        for( UInt32 i=0; i < 8; ++i ) {
+            addSubtree( node.firstChild+i, result );
+        }
+    }
+}
+
+void SceneSnapshot::linkObject( SceneObjectPool::Handle handle, UInt32 node )
+{
+    assert( node != INVALID_NODE );
+    
+    // the objects are set before the nodes they're in
+    if( node >= mFirstInNode.size() ) {
+        mFirstInNode.resize( node+1, SceneObjectPool::INVALID_HANDLE );
+    }
+    
+    SceneObjectPool::Handle first = mFirstInNode[node];
+    mPrevInNode[handle] = SceneObjectPool::INVALID_HANDLE;
+    mNextInNode[handle] = first;
+    if( first != SceneObjectPool::INVALID_HANDLE ) {
+        mPrevInNode[first] = handle;
+    }
+    mFirstInNode[node] = handle;
+}
+
+void SceneSnapshot::unlinkObject( SceneObjectPool::Handle handle )
+{
+    SceneObjectPool::Handle prev = mPrevInNode[handle],
+                            next = mNextInNode[handle];
+                            
+    if( prev != SceneObjectPool::INVALID_HANDLE ) {
+        mNextInNode[prev] = next;
+    }
+    else {
+        mFirstInNode[mObjects[handle].node] = next;
+    }
+    if( next != SceneObjectPool::INVALID_HANDLE ) {
+        mPrevInNode[next] = prev;
+    }
+}
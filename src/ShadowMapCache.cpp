@@ -0,0 +1,71 @@
+#include "ShadowMapCache.h"
+
+void ShadowMapCache::setSlotCount( size_t slotCount )
+{
+    mSlots.clear();
+    mSlots.resize( slotCount );
+    mLightSlots.clear();
+}
+
+void ShadowMapCache::beginFrame()
+{
+    mFrame++;
+}
+
+ShadowMapCache::Request ShadowMapCache::aquireSlot( const void *light, UInt64 signature )
+{
+    Request request;
+        request.slot = NO_SLOT;
+        request.render = true;
+        
+    auto iter = mLightSlots.find( light );
+    if( iter != mLightSlots.end() ) {
+        Slot &slot = mSlots[iter->second];
+        
+        request.slot = iter->second;
+        request.render = !slot.valid || slot.signature != signature;
+        
+        slot.signature = signature;
+        slot.lastUsed = mFrame;
+        slot.valid = true;
+        return request;
+    }
+    
+    // the least recently used slot that isn't used this frame
+    UInt32 oldest = NO_SLOT;
+    for( UInt32 i=0; i < mSlots.size(); ++i ) {
+        if( mSlots[i].lastUsed == mFrame ) {
+            continue;
+        }
+        if( oldest == NO_SLOT || mSlots[i].lastUsed < mSlots[oldest].lastUsed ) {
+            oldest = i;
+        }
+    }
+    if( oldest == NO_SLOT ) {
+        return request;
+    }
+    
+    Slot &slot = mSlots[oldest];
+    if( slot.light ) {
+        mLightSlots.erase( slot.light );
+    }
+    
+    slot.light = light;
+    slot.signature = signature;
+    slot.lastUsed = mFrame;
+    slot.valid = true;
+    mLightSlots[light] = oldest;
+    
+    request.slot = oldest;
+    return request;
+}
+
+UInt64 ShadowMapCache::HashBytes( const void *data, size_t size, UInt64 hash )
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>( data );
+    for( size_t i=0; i < size; ++i ) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
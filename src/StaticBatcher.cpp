@@ -0,0 +1,240 @@
+#include "StaticBatcher.h"
+#include "Root.h"
+#include "SceneManager.h"
+#include "SceneObjectFactory.h"
+#include "DeferredEntity.h"
+#include "ResourceManager.h"
+#include "StaticMeshBuffers.h"
+#include "Texture.h"
+#include "Config.h"
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/detail/func_matrix.hpp>
+
+#include <tuple>
+#include <cassert>
+
+// material, render queue, cast shadow & the chunk
+typedef std::tuple<Texture*,Texture*,unsigned int,bool,int,int,int> BatchKey;
+// mesh & material, the entities the renderer draws with one instanced draw
+typedef std::tuple<Mesh*,Texture*,Texture*> InstanceKey;
+
+static BoundingSphere calculateBounds( const std::vector<Mesh::Vertex> &vertexes )
+{
+    assert( !vertexes.empty() );
+    if( vertexes.empty() ) {
+        return BoundingSphere( glm::vec3(0.f), 0.f );
+    }
+    
+    glm::vec3 min = vertexes[0].position, max = vertexes[0].position;
+    
+    for( const Mesh::Vertex &vertex : vertexes ) {
+        min = glm::min( min, vertex.position );
+        max = glm::max( max, vertex.position );
+    }
+    
+    glm::vec3 center = (min + max) / 2.f;
+    float radius = 0.f;
+    
+    for( const Mesh::Vertex &vertex : vertexes ) {
+        radius = glm::max( radius, glm::distance(center,vertex.position) );
+    }
+    
+    return BoundingSphere( center, radius );
+}
+
+StaticBatcher::StaticBatcher( Root *root, float chunkSize ) :
+    mRoot(root),
+    mChunkSize(chunkSize)
+{
+    assert( mChunkSize > 0.f );
+    
+    mFactory = dynamic_cast<DeferredEntityFactory*>( mRoot->getSceneManager()->getFactory("DeferredEntity") );
+    mStaticBuffers = mRoot->getResourceManager()->getStaticMeshBuffers();
+    mSkipInstanced = mRoot->getConfig()->instancing;
+}
+
+void StaticBatcher::batchObjects( std::vector<SceneObject*> &objects )
+{
+    if( !mFactory || !mStaticBuffers ) {
+        return;
+    }
+    
+    std::vector<SceneObject*> result;
+    std::vector<DeferredEntity*> candidates;
+    std::map<InstanceKey,size_t> instanceCounts;
+    
+    for( SceneObject *object : objects ) {
+        if( !canBatch(object) ) {
+            result.push_back( object );
+            continue;
+        }
+        
+        DeferredEntity *entity = static_cast<DeferredEntity*>( object );
+        const DeferredMaterial &material = entity->getMaterial();
+        candidates.push_back( entity );
+        instanceCounts[InstanceKey(entity->getMesh().get(), material.diffuseTexture.get(), material.normalMap.get())]++;
+    }
+    
+    std::map<BatchKey,std::vector<DeferredEntity*>> groups;
+    
+    for( DeferredEntity *entity : candidates ) {
+        const DeferredMaterial &material = entity->getMaterial();
+        Mesh *mesh = entity->getMesh().get();
+        
+        // already drawn together by one instanced draw, merging them would only cost memory
+        if( mSkipInstanced && instanceCounts[InstanceKey(mesh, material.diffuseTexture.get(), material.normalMap.get())] > 1 ) {
+            result.push_back( entity );
+            continue;
+        }
+        
+        // nothing to merge, & the bounds can't be calculated from it
+        const Geometry &geometry = getGeometry( mesh );
+        if( geometry.vertexes.empty() || geometry.indexes.empty() ) {
+            result.push_back( entity );
+            continue;
+        }
+        
+        if( entity->isDirty() ) {
+            entity->_updateTransform();
+        }
+        
+        glm::vec3 chunk = glm::floor( entity->getTransformedBoundingSphere().getCenter() / mChunkSize );
+        
+        BatchKey key( material.diffuseTexture.get(), material.normalMap.get(),
+                      entity->getRenderQueue(), entity->getCastShadow(),
+                      (int)chunk.x, (int)chunk.y, (int)chunk.z );
+        groups[key].push_back( entity );
+    }
+    
+    std::vector<DeferredEntity*> batch;
+    size_t batchVertexes = 0;
+    auto flushBatch = [&]() {
+        if( batch.size() == 1 ) {
+            // nothing to merge with
+            result.push_back( batch[0] );
+        }
+        else if( !batch.empty() ) {
+            result.push_back( mergeEntities(batch) );
+            
+            for( DeferredEntity *entity : batch ) {
+                mFactory->destroyObject( entity );
+            }
+        }
+        batch.clear();
+        batchVertexes = 0;
+    };
+    
+    for( auto &entry : groups ) {
+        for( DeferredEntity *entity : entry.second ) {
+            size_t vertexes = getGeometry(entity->getMesh().get()).vertexes.size();
+            if( batchVertexes + vertexes > MAX_STATIC_BATCH_VERTEXES ) {
+                flushBatch();
+            }
+            
+            batch.push_back( entity );
+            batchVertexes += vertexes;
+        }
+        flushBatch();
+    }
+    
+    // the geometry is only needed while merging
+    mGeometry.clear();
+    
+    objects.swap( result );
+}
+
+bool StaticBatcher::canBatch( SceneObject *object )
+{
+    // objects made by other factories can derive from DeferredEntity & move or animate
+    if( object->getFactory() != mFactory ) {
+        return false;
+    }
+    
+    DeferredEntity *entity = static_cast<DeferredEntity*>( object );
+    SharedPtr<Mesh> mesh = entity->getMesh();
+    
+    return mesh && mesh->getSharedVertexes().isValid() && mesh->getSharedIndexes().isValid();
+}
+
+const StaticBatcher::Geometry& StaticBatcher::getGeometry( Mesh *mesh )
+{
+    auto iter = mGeometry.find( mesh );
+    if( iter != mGeometry.end() ) {
+        return iter->second;
+    }
+    
+    Geometry &geometry = mGeometry[mesh];
+    mStaticBuffers->readGeometry( mesh, geometry.vertexes, geometry.indexes );
+    
+    return geometry;
+}
+
+DeferredEntity* StaticBatcher::mergeEntities( const std::vector<DeferredEntity*> &entities )
+{
+    assert( !entities.empty() );
+    
+    std::vector<Mesh::Vertex> vertexes;
+    std::vector<GLuint> indexes;
+    size_t mergedDraws = 0;
+    
+    for( DeferredEntity *entity : entities ) {
+        SharedPtr<Mesh> mesh = entity->getMesh();
+        const Geometry &geometry = getGeometry( mesh.get() );
+        
+        const glm::mat4 &transform = entity->getTransform();
+        glm::mat3 tangentTransform = glm::mat3( transform ),
+                  normalTransform = glm::transpose( glm::inverse(tangentTransform) );
+                  
+        GLuint firstVertex = vertexes.size();
+        for( const Mesh::Vertex &vertex : geometry.vertexes ) {
+            Mesh::Vertex result;
+                result.position = glm::vec3( transform * glm::vec4(vertex.position, 1.f) );
+                result.normal = glm::normalize( normalTransform * vertex.normal );
+                result.tangent = glm::normalize( tangentTransform * vertex.tangent );
+                result.bitangent = glm::normalize( tangentTransform * vertex.bitangent );
+                result.texcoord = vertex.texcoord;
+            vertexes.push_back( result );
+        }
+        
+        // a mirroring scale turns the triangles inside out, so the winding is flipped back
+        bool mirrored = glm::determinant( tangentTransform ) < 0.f;
+        for( size_t i=0; i+2 < geometry.indexes.size(); i += 3 ) {
+            indexes.push_back( firstVertex + geometry.indexes[i] );
+            indexes.push_back( firstVertex + geometry.indexes[mirrored ? i+2 : i+1] );
+            indexes.push_back( firstVertex + geometry.indexes[mirrored ? i+1 : i+2] );
+        }
+        
+        mergedDraws += mesh->getSubMeshes().size();
+    }
+    
+    // batchObjects leaves out the entities without geometry
+    assert( !vertexes.empty() && !indexes.empty() );
+    
+    StaticMeshBuffers::Allocation allocation = mStaticBuffers->addGeometry( vertexes, indexes );
+    
+    SubMesh submesh;
+        submesh.vertexStart = allocation.firstIndex;
+        submesh.vertexCount = indexes.size();
+        submesh.baseVertex = allocation.baseVertex;
+        
+    std::vector<SubMesh> submeshes( 1, submesh );
+    SharedPtr<Mesh> mesh = makeSharedPtr<Mesh>( allocation.vao, allocation.vertexes, allocation.indexes, submeshes, calculateBounds(vertexes) );
+    mesh->setName( "StaticBatch" );
+    mesh->setMergedDraws( mergedDraws );
+    
+    DeferredEntity *first = entities.front();
+    DeferredEntity *batch = mFactory->createEntity( mesh, first->getMaterial() );
+    batch->setCastShadow( first->getCastShadow() );
+    batch->setRenderQueue( first->getRenderQueue() );
+    
+    mBatchCount++;
+    mMergedEntities += entities.size();
+    
+    return batch;
+}
@@ -0,0 +1,83 @@
+#include "StaticMeshBuffers.h"
+#include "VertexArrayObject.h"
+#include "RenderDevice.h"
+#include "GLinclude.h"
+
+#include <cassert>
+#include <cstddef>
+
+StaticMeshBuffers::StaticMeshBuffers( size_t vertexBufferSize, size_t indexBufferSize ) :
+    mVertexAllocator(GL_STATIC_DRAW, vertexBufferSize),
+    mIndexAllocator(GL_STATIC_DRAW, indexBufferSize)
+{
+}
+
+StaticMeshBuffers::Allocation StaticMeshBuffers::addGeometry( const std::vector<Mesh::Vertex> &vertexes, const std::vector<GLuint> &indexes )
+{
+    assert( !vertexes.empty() && !indexes.empty() );
+    
+    // aligned to the vertex size, so the offset is a whole number of vertexes
+    Allocation allocation;
+        allocation.vertexes = mVertexAllocator.allocateBuffer( sizeof(Mesh::Vertex)*vertexes.size(), sizeof(Mesh::Vertex) );
+        allocation.indexes = mIndexAllocator.allocateBuffer( sizeof(GLuint)*indexes.size(), sizeof(GLuint) );
+        allocation.baseVertex = allocation.vertexes.getOffset() / sizeof(Mesh::Vertex);
+        allocation.firstIndex = allocation.indexes.getOffset() / sizeof(GLuint);
+        
+    allocation.vertexes.setContent( vertexes.data(), sizeof(Mesh::Vertex)*vertexes.size() );
+    allocation.indexes.setContent( indexes.data(), sizeof(GLuint)*indexes.size() );
+    
+    // the mesh can be drawn right away
+    mVertexAllocator.flush();
+    mIndexAllocator.flush();
+    
+    allocation.vao = getVAO( allocation.vertexes.getGLBuffer(), allocation.indexes.getGLBuffer() );
+    
+    return allocation;
+}
+
+void StaticMeshBuffers::readGeometry( Mesh *mesh, std::vector<Mesh::Vertex> &vertexes, std::vector<GLuint> &indexes )
+{
+    const GpuSubBuffer &vertexBuffer = mesh->getSharedVertexes(),
+                       &indexBuffer = mesh->getSharedIndexes();
+    assert( vertexBuffer.isValid() && indexBuffer.isValid() );
+    
+    vertexes.resize( vertexBuffer.getSize() / sizeof(Mesh::Vertex) );
+    indexes.resize( indexBuffer.getSize() / sizeof(GLuint) );
+    
+    // addGeometry flushes, so the buffers aren't mapped.
+    // Read through the copy target, so the bound vao isn't changed
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->bindBuffer( GL_COPY_READ_BUFFER, vertexBuffer.getGLBuffer() );
+    device->getBufferSubData( GL_COPY_READ_BUFFER, vertexBuffer.getOffset(), vertexBuffer.getSize(), vertexes.data() );
+    device->bindBuffer( GL_COPY_READ_BUFFER, indexBuffer.getGLBuffer() );
+    device->getBufferSubData( GL_COPY_READ_BUFFER, indexBuffer.getOffset(), indexBuffer.getSize(), indexes.data() );
+    device->bindBuffer( GL_COPY_READ_BUFFER, 0 );
+}
+
+const SharedPtr<VertexArrayObject>& StaticMeshBuffers::getVAO( GLuint vertexBuffer, GLuint indexBuffer )
+{
+    SharedPtr<VertexArrayObject> &vao = mVAOs[std::make_pair(vertexBuffer,indexBuffer)];
+    if( vao ) {
+        return vao;
+    }
+    
+    vao = makeSharedPtr<VertexArrayObject>();
+    RenderDevice *device = RenderDevice::GetDevice();
+    
+    vao->bindVAO();
+    device->bindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
+    // the index buffer binding is part of the vao
+    device->bindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBuffer );
+    
+    vao->setVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof(Mesh::Vertex), offsetof(Mesh::Vertex, position) );
+    vao->setVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof(Mesh::Vertex), offsetof(Mesh::Vertex, normal) );
+    vao->setVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, sizeof(Mesh::Vertex), offsetof(Mesh::Vertex, texcoord) );
+    
+    vao->setVertexAttribPointer( 3, 3, GL_FLOAT, GL_FALSE, sizeof(Mesh::Vertex), offsetof(Mesh::Vertex, tangent) );
+    vao->setVertexAttribPointer( 4, 3, GL_FLOAT, GL_FALSE, sizeof(Mesh::Vertex), offsetof(Mesh::Vertex, bitangent) );
+    
+    vao->unbindVAO();
+    device->bindBuffer( GL_ARRAY_BUFFER, 0 );
+    
+    return vao;
+}
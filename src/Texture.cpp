@@ -1,6 +1,7 @@
 #include "Texture.h"
 #include "StringUtils.h"
 #include "GLinclude.h"
+#include "RenderDevice.h"
 
 #include <stdexcept>
 #include <cerrno>
@@ -10,15 +11,11 @@
 
 GLint getBoundTexture2D()
 {
-    GLint boundTexture;
-    glGetIntegerv( GL_TEXTURE_BINDING_2D, &boundTexture );
-    return boundTexture;
+    return RenderDevice::GetDevice()->getInteger( GL_TEXTURE_BINDING_2D );
 }
 GLint getBoundTextureCube()
 {
-    GLint boundTexture;
-    glGetIntegerv( GL_TEXTURE_BINDING_CUBE_MAP, &boundTexture );
-    return boundTexture;
+    return RenderDevice::GetDevice()->getInteger( GL_TEXTURE_BINDING_CUBE_MAP );
 }
 
 TextureType stringToTextureType( const std::string &str )
@@ -135,40 +132,43 @@ Texture::Texture( TextureType type, const glm::uvec2& size, GLuint glTexture ) :
     mType(type),
     mSize(size)
 {
+    mHandle = HandleTable<Texture>::Add( this );
 }
 
 Texture::~Texture()
 {
-    glDeleteTextures( 1, &mGLTexture );
+    HandleTable<Texture>::Remove( mHandle );
+    RenderDevice::GetDevice()->deleteTexture( mGLTexture );
 }
 
 void Texture::bindTexture( int unit )
 {
     assert( unit >= 0 && unit < 15 );
-    glActiveTexture( GL_TEXTURE0 + unit );
+    RenderDevice *device = RenderDevice::GetDevice();
     if( isTypeCubeMap(mType) ) {
-        glBindTexture( GL_TEXTURE_CUBE_MAP, mGLTexture );
+        device->bindTextureUnit( unit, GL_TEXTURE_CUBE_MAP, mGLTexture );
     }
     else {
-        glBindTexture( GL_TEXTURE_2D, mGLTexture );
+        device->bindTextureUnit( unit, GL_TEXTURE_2D, mGLTexture );
     }
 }
 
 void Texture::unbindTexture( int unit )
 {    
     assert( unit >= 0 && unit < 15 );
-    glActiveTexture( GL_TEXTURE0 + unit );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->activeTexture( GL_TEXTURE0 + unit );
     if( isTypeCubeMap(mType) ) {
 #ifdef USE_DEBUG_NORMAL
         assert( getBoundTextureCube() == mGLTexture );
 #endif
-        glBindTexture( GL_TEXTURE_CUBE_MAP, mGLTexture );
+        device->bindTextureUnit( unit, GL_TEXTURE_CUBE_MAP, mGLTexture );
     }
     else {
 #ifdef USE_DEBUG_NORMAL
         assert( getBoundTexture2D() == mGLTexture );
 #endif
-        glBindTexture( GL_TEXTURE_2D, 0 );
+        device->bindTextureUnit( unit, GL_TEXTURE_2D, 0 );
     }
 }
 
@@ -183,7 +183,7 @@ void Texture::copyTexture( const SharedPtr<Texture> &texture )
     assert( texture && texture->isCubeMap() == false );
     
     glm::uvec2 size = texture->getSize();
-    glCopyImageSubData( texture->getGLTexture(), GL_TEXTURE_2D, 0, 0, 0, 0, mGLTexture, GL_TEXTURE_2D, 0, 0, 0, 0, size.x, size.y, 1 );
+    RenderDevice::GetDevice()->copyImageSubData2D( texture->getGLTexture(), mGLTexture, size.x, size.y );
 }
 
 /// @todo FIXME this code needs some serius clean up....
@@ -198,7 +198,7 @@ bool loadImageToGLTexture( GLint target, FIBITMAP *image, const glm::uvec2 &size
     }
     BYTE *bits = FreeImage_GetBits( image );
     
-    glTexSubImage2D( target, 0, 0, 0, size.x, size.y, GL_BGRA, GL_UNSIGNED_BYTE, bits );
+    RenderDevice::GetDevice()->texSubImage2D( target, 0, 0, 0, size.x, size.y, GL_BGRA, GL_UNSIGNED_BYTE, bits );
     FreeImage_Unload( image );
     
     return true;
@@ -210,20 +210,20 @@ SharedPtr<Texture> createTextureFromFipImage( TextureType type, FIBITMAP *image
     GLint mipmaps = mipmapForSize( size );
     GLint internalFormat = typeToGLFormat( type );
     
-    GLuint glTexture;
-    glGenTextures( 1, &glTexture );
-    glBindTexture( GL_TEXTURE_2D, glTexture );
+    RenderDevice *device = RenderDevice::GetDevice();
+    GLuint glTexture = device->genTexture();
+    device->bindTexture( GL_TEXTURE_2D, glTexture );
     
-    glTexStorage2D( GL_TEXTURE_2D, mipmaps, internalFormat, size.x, size.y );
+    device->texStorage2D( GL_TEXTURE_2D, mipmaps, internalFormat, size.x, size.y );
     
     if( !loadImageToGLTexture(GL_TEXTURE_2D, image, size) ) {
-        glDeleteTextures( 1, &glTexture );
+        device->deleteTexture( glTexture );
         return SharedPtr<Texture>();
     }
     
-    glGenerateMipmap( GL_TEXTURE_2D );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    device->generateMipmap( GL_TEXTURE_2D );
+    device->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    device->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     
     return std::make_shared<Texture>( type, size, glTexture );
 }
@@ -262,9 +262,9 @@ SharedPtr<Texture> createCubeMapTexture( TextureType type, const std::string &fi
     static const std::string FACE_NAMES[6] = 
         {"Right", "Left", "Top", "Bottom", "Front", "Back"};
         
-    GLuint texture;
-    glGenTextures( 1, &texture );
-    glBindTexture( GL_TEXTURE_CUBE_MAP, texture );
+    RenderDevice *device = RenderDevice::GetDevice();
+    GLuint texture = device->genTexture();
+    device->bindTexture( GL_TEXTURE_CUBE_MAP, texture );
     
     bool createdTexture = false;
     glm::uvec2 size;
@@ -283,31 +283,31 @@ SharedPtr<Texture> createCubeMapTexture( TextureType type, const std::string &fi
             
             if( size.x != size.y ) {
                 FreeImage_Unload( image );
-                glDeleteTextures( 1, &texture );
+                device->deleteTexture( texture );
                 throw std::runtime_error( "Invalid image size! - a cube map only accepts square textures." );
             }
             
             GLint mipmaps = mipmapForSize( size );
-            glTexStorage2D( GL_TEXTURE_CUBE_MAP, mipmaps, internalFormat, size.x, size.y );
+            device->texStorage2D( GL_TEXTURE_CUBE_MAP, mipmaps, internalFormat, size.x, size.y );
             createdTexture = true;
         }
         
         if( size.x != FreeImage_GetWidth(image) || size.y != FreeImage_GetHeight(image) ) {
             FreeImage_Unload( image );
-            glDeleteTextures( 1, &texture );
+            device->deleteTexture( texture );
             throw std::runtime_error( "Invalid image size! - all images in the cubemap must have the same size." );
         }
         
         if( !loadImageToGLTexture(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i, image, size) ) {
             FreeImage_Unload( image );
-            glDeleteTextures( 1, &texture );
+            device->deleteTexture( texture );
             throw std::runtime_error( "Failed to load image to cube face!" );
         }
         
         FreeImage_Unload( image );
     }
     
-    glGenerateMipmap( GL_TEXTURE_CUBE_MAP );
+    device->generateMipmap( GL_TEXTURE_CUBE_MAP );
     return makeSharedPtr<Texture>( type, size, texture );
 }
 
@@ -361,21 +361,21 @@ SharedPtr<Texture> Texture::LoadTextureFromMemory( TextureType type, const void
 
 SharedPtr<Texture> Texture::LoadTextureFromRawMemory( TextureType type, const void *pixels, size_t width, size_t height )
 {
-    GLuint glTexture;
-    glGenTextures( 1, &glTexture );
-    glBindTexture( GL_TEXTURE_2D, glTexture );
+    RenderDevice *device = RenderDevice::GetDevice();
+    GLuint glTexture = device->genTexture();
+    device->bindTexture( GL_TEXTURE_2D, glTexture );
     
     GLint internalFormat = typeToGLFormat( type );
     
     glm::uvec2 size(width,height);
     int mipmaps = mipmapForSize( size );
     
-    glTexStorage2D( GL_TEXTURE_2D, mipmaps, internalFormat, size.x, size.y );
-    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
+    device->texStorage2D( GL_TEXTURE_2D, mipmaps, internalFormat, size.x, size.y );
+    device->texSubImage2D( GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
 
-    glGenerateMipmap( GL_TEXTURE_2D );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    device->generateMipmap( GL_TEXTURE_2D );
+    device->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    device->texParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
     return makeSharedPtr<Texture>( type, size, glTexture );
 }
@@ -390,22 +390,23 @@ SharedPtr<Texture> Texture::CreateTexture( TextureType type, const glm::uvec2& s
         target = GL_TEXTURE_CUBE_MAP;
     }
     
-    glGenTextures( 1, &glTexture );
-    glBindTexture( target, glTexture );
+    RenderDevice *device = RenderDevice::GetDevice();
+    glTexture = device->genTexture();
+    device->bindTexture( target, glTexture );
     
     if( mipmaps == 0 ) {
         mipmaps = mipmapForSize( size );
     }
     
-    glTexStorage2D( target, mipmaps, internalFormat, size.x, size.y );
+    device->texStorage2D( target, mipmaps, internalFormat, size.x, size.y );
     
     if( mipmaps > 1 ) {
-        glTexParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-        glTexParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        device->texParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+        device->texParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     }
     else {
-        glTexParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-        glTexParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        device->texParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        device->texParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     }
     
     return std::make_shared<Texture>( type, size, glTexture );
@@ -14,8 +14,9 @@ const UniformBlockLayout& SceneRenderUniforms::GetUniformBlockLayout()
         {
             static const size_t ExpectedSize = 
                                     4*4 * 6 + // we have 6 mat4
-                                    2*1 + // 1 vec2
+                                    2*2 + // 2 vec2
                                     3*1 + // 1 vec3
+                                    2*1 + // render scale
                                     3; // allignment dummies
                                         
             // just to make sure we don't forget to update this function
@@ -34,6 +35,7 @@ const UniformBlockLayout& SceneRenderUniforms::GetUniformBlockLayout()
             
             SetUniform( "ClippingPlanes", Vec2, clippingPlanes );
             SetUniform( "CameraPosition", Vec3, cameraPosition );
+            SetUniform( "RenderScale", Vec2, renderScale );
 #undef UNIFORM_BLOCK
             
         }
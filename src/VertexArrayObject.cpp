@@ -2,42 +2,50 @@
 #include "GLinclude.h"
 
 #include "DebugLevel.h"
+#include "RenderDevice.h"
 
 #include <cassert>
 
 GLuint getBoundVAO()
 {
-    GLint boundVAO;
-    glGetIntegerv( GL_VERTEX_ARRAY_BINDING, &boundVAO );
-    return boundVAO;
+    return RenderDevice::GetDevice()->getInteger( GL_VERTEX_ARRAY_BINDING );
+}
+
+VertexArrayObject::VertexArrayObject()
+{
+    mHandle = HandleTable<VertexArrayObject>::Add( this );
 }
 
 VertexArrayObject::VertexArrayObject( VertexArrayObject &&move ) :
     mVAO(move.mVAO)
 {
     move.mVAO = 0;
+    mHandle = HandleTable<VertexArrayObject>::Add( this );
 }
 
 VertexArrayObject::~VertexArrayObject()
 {
+    HandleTable<VertexArrayObject>::Remove( mHandle );
     destroyVAO();
 }
 
 void VertexArrayObject::createVAO()
 {
     assert( mVAO == 0 );
-    glGenVertexArrays( 1, &mVAO );
+    mVAO = RenderDevice::GetDevice()->genVertexArray();
 }
 
 void VertexArrayObject::destroyVAO()
 {
-    glDeleteVertexArrays( 1, &mVAO );
+    if( mVAO != 0 ) {
+        RenderDevice::GetDevice()->deleteVertexArray( mVAO );
+    }
 }
 
 void VertexArrayObject::bindVAO()
 {
     if( mVAO == 0 ) createVAO();
-    glBindVertexArray( mVAO );
+    RenderDevice::GetDevice()->bindVertexArray( mVAO );
 }
 
 void VertexArrayObject::unbindVAO()
@@ -45,7 +53,7 @@ void VertexArrayObject::unbindVAO()
 #ifdef USE_DEBUG_NORMAL
     assert( getBoundVAO() == mVAO );
 #endif
-    glBindVertexArray( 0 );
+    RenderDevice::GetDevice()->bindVertexArray( 0 );
 }
 
 void VertexArrayObject::setVertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, GLuint offset )
@@ -54,6 +62,7 @@ void VertexArrayObject::setVertexAttribPointer( GLuint index, GLint size, GLenum
     assert( getBoundVAO() == mVAO );
 #endif
     
-    glEnableVertexAttribArray( index );
-    glVertexAttribPointer( index, size, type, normalized, stride, reinterpret_cast<const void*>(offset) );
+    RenderDevice *device = RenderDevice::GetDevice();
+    device->enableVertexAttribArray( index );
+    device->vertexAttribPointer( index, size, type, normalized, stride, reinterpret_cast<const void*>(offset) );
 }
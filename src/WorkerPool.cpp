@@ -0,0 +1,92 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool( size_t threadCount )
+{
+    if( threadCount == 0 ) {
+        threadCount = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+    
+    for( size_t i=1; i < threadCount; ++i ) {
+        mWorkers.emplace_back( &WorkerPool::workerMain, this, i );
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mQuit = true;
+    }
+    mStartCondition.notify_all();
+    
+    for( std::thread &worker : mWorkers ) {
+        worker.join();
+    }
+}
+
+void WorkerPool::parallelFor( size_t count, const Job &job )
+{
+    if( count == 0 ) {
+        return;
+    }
+    if( mWorkers.empty() ) {
+        job( 0, count, 0 );
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mJob = &job;
+        mCount = count;
+        mPending = mWorkers.size();
+        mGeneration++;
+    }
+    mStartCondition.notify_all();
+    
+    runRange( 0 );
+    
+    std::unique_lock<std::mutex> lock( mMutex );
+    mDoneCondition.wait( lock, [this]{ return mPending == 0; } );
+    mJob = nullptr;
+}
+
+void WorkerPool::workerMain( size_t thread )
+{
+    size_t generation = 0;
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock( mMutex );
+            mStartCondition.wait( lock, [&]{ return mQuit || mGeneration != generation; } );
+            if( mQuit ) {
+                return;
+            }
+            generation = mGeneration;
+        }
+        
+        runRange( thread );
+        
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            done = (--mPending == 0);
+        }
+        if( done ) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runRange( size_t thread )
+{
+    size_t threadCount = getThreadCount();
+    size_t rangeSize = (mCount + threadCount - 1) / threadCount;
+    
+    size_t first = std::min( mCount, thread*rangeSize ),
+           last = std::min( mCount, first+rangeSize );
+           
+    if( first < last ) {
+        (*mJob)( first, last, thread );
+    }
+}
@@ -0,0 +1,126 @@
+#include "RadixSort.h"
+#include "ResourceHandle.h"
+#include "UniformBuffer.h"
+#include "SharedEnums.h"
+#include "Timer.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+static const size_t RENDERABLE_COUNT = 10000,
+                    QUEUE_COUNT = 12,
+                    PROGRAM_COUNT = 40,
+                    ITERATIONS = 20;
+                    
+// the result, so the work isn't optimized away
+static volatile size_t sSink = 0;
+
+// the layout of CustomRenderableSettings, without the glm dependent Renderer.h
+struct Settings {
+    GpuProgramHandle program;
+    TextureHandle textures[8];
+    VertexArrayHandle vao;
+    GpuBufferHandle indexbuffer;
+    UniformBuffer uniforms[8];
+    
+    BlendMode blendMode = BlendMode::Replace;
+    void *renderable = nullptr;
+    int queue = 0;
+};
+
+struct SortEntry {
+    UInt64 key;
+    UInt32 index;
+};
+
+// what addCustomRenderable did before, each renderable is inserted in front of the
+// ones already in its queue
+static size_t insertSorted( const std::vector<Settings> &submitted )
+{
+    std::vector<Settings> renderables;
+    for( const Settings &settings : submitted ) {
+        auto pos = std::lower_bound( renderables.begin(), renderables.end(), settings.queue,
+            []( const Settings &entry, int queue ) {
+                return entry.queue < queue;
+            }
+        );
+        renderables.insert( pos, settings );
+    }
+    return renderables.size() + renderables.front().queue;
+}
+
+// what it does now, appended & sorted once as in Renderer::sortCustomRenderables
+static size_t appendAndSort( const std::vector<Settings> &submitted, std::vector<Settings> &renderables,
+                             std::vector<SortEntry> &order, std::vector<SortEntry> &sortBuffer )
+{
+    renderables.clear();
+    for( const Settings &settings : submitted ) {
+        renderables.push_back( settings );
+    }
+    
+    order.clear();
+    for( size_t i=0; i < renderables.size(); ++i ) {
+        const Settings &settings = renderables[i];
+        
+        UInt64 queue = UInt64(settings.queue + 0x8000) & 0xFFFF,
+               blendMode = UInt64(settings.blendMode) & 0xFF,
+               program = settings.program.value;
+               
+        SortEntry entry;
+            entry.key = (queue << 40) | (blendMode << 32) | program;
+            entry.index = i;
+        order.push_back( entry );
+    }
+    
+    radixSort( order, sortBuffer, []( const SortEntry &entry ) {
+        return entry.key;
+    }, 56 );
+    
+    return order.size() + renderables[order.front().index].queue;
+}
+
+int main()
+{
+    std::mt19937 generator( 1542 );
+    
+    std::vector<Settings> submitted( RENDERABLE_COUNT );
+    for( Settings &settings : submitted ) {
+        settings.queue = int(generator() % QUEUE_COUNT) - 2;
+        settings.blendMode = (generator() % 4 == 0) ? BlendMode::AddjectiveBlend : BlendMode::Replace;
+        // handles with a generation, as they are when the programs are loaded
+        settings.program.value = (1u << 20) | (generator() % PROGRAM_COUNT);
+    }
+    
+    Timer timer;
+    size_t insertResult = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        insertResult += insertSorted( submitted );
+    }
+    float insertTime = timer.getTimeAsSeconds();
+    
+    std::vector<Settings> renderables;
+    std::vector<SortEntry> order, sortBuffer;
+    
+    timer.restart();
+    size_t sortResult = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        sortResult += appendAndSort( submitted, renderables, order, sortBuffer );
+    }
+    float sortTime = timer.getTimeAsSeconds();
+    sSink = insertResult + sortResult;
+    
+    // the queues must come out in order & stable within equal keys
+    bool sorted = true;
+    for( size_t i=1; i < order.size(); ++i ) {
+        sorted = sorted && (order[i-1].key < order[i].key || (order[i-1].key == order[i].key && order[i-1].index < order[i].index));
+    }
+    
+    std::printf( "%zu custom renderables over %zu queues, %zu iterations\n", RENDERABLE_COUNT, QUEUE_COUNT, ITERATIONS );
+    std::printf( "  lower_bound + insert: %8.3f ms/frame\n", insertTime*1000.f/ITERATIONS );
+    std::printf( "  append + radix sort:  %8.3f ms/frame\n", sortTime*1000.f/ITERATIONS );
+    std::printf( "  sorted: %s\n", sorted ? "yes" : "no" );
+    
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "DynamicResolution.h"
+#include "TestUtils.h"
+
+#include <deque>
+#include <cmath>
+
+// a gpu where the time grows with the pixel count, the result of a frame
+// comes back 'latency' frames later like the timer queries
+class SimulatedGpu {
+public:
+    SimulatedGpu( float fixedTime, float pixelTime, size_t latency = 3 ) :
+        mFixedTime(fixedTime),
+        mPixelTime(pixelTime),
+        mLatency(latency)
+    {}
+    
+    void setPixelTime( float pixelTime ) {
+        mPixelTime = pixelTime;
+    }
+    
+    // the time of a frame at 'scale'
+    float getTime( float scale ) const {
+        return mFixedTime + mPixelTime * scale * scale;
+    }
+    
+    // renders a frame & feeds the finished one, 0 until the first one is done
+    float runFrame( DynamicResolution &resolution ) {
+        mPending.push_back( getTime(resolution.getScale()) );
+        
+        float finished = 0.f;
+        if( mPending.size() > mLatency ) {
+            finished = mPending.front();
+            mPending.pop_front();
+        }
+        return resolution.addFrameTime( finished );
+    }
+    
+private:
+    float mFixedTime, mPixelTime;
+    size_t mLatency;
+    std::deque<float> mPending;
+};
+
+static void testUnderBudget()
+{
+    DynamicResolution resolution;
+    resolution.setSettings( DynamicResolution::Settings() );
+    
+    SimulatedGpu gpu( 2.f, 8.f );
+    for( int i=0; i < 300; ++i ) {
+        gpu.runFrame( resolution );
+    }
+    TEST_CHECK( resolution.getScale() == 1.f );
+}
+
+static void testIgnoresMissingTimes()
+{
+    DynamicResolution resolution;
+    resolution.setSettings( DynamicResolution::Settings() );
+    
+    for( int i=0; i < 100; ++i ) {
+        resolution.addFrameTime( 0.f );
+        resolution.addFrameTime( -1.f );
+    }
+    TEST_CHECK( resolution.getScale() == 1.f );
+    TEST_CHECK( resolution.getSmoothedTime() == 0.f );
+}
+
+static void testSingleSpike()
+{
+    DynamicResolution resolution;
+    resolution.setSettings( DynamicResolution::Settings() );
+    
+    for( int i=0; i < 50; ++i ) {
+        resolution.addFrameTime( 10.f );
+    }
+    // one slow frame isn't enough to drop, the smoothed time is only over for a frame or two
+    resolution.addFrameTime( 40.f );
+    for( int i=0; i < 50; ++i ) {
+        resolution.addFrameTime( 10.f );
+    }
+    TEST_CHECK( resolution.getScale() == 1.f );
+}
+
+static void testConverges()
+{
+    DynamicResolution::Settings settings;
+    DynamicResolution resolution;
+    resolution.setSettings( settings );
+    
+    // 30 ms at full size, about 0.7 brings it into the band
+    SimulatedGpu gpu( 2.f, 28.f );
+    
+    float previous = resolution.getScale();
+    size_t changes = 0;
+    for( int i=0; i < 600; ++i ) {
+        float scale = gpu.runFrame( resolution );
+        
+        TEST_CHECK( std::fabs(scale - previous) <= settings.maxStep + 1e-5f );
+        TEST_CHECK( scale >= settings.minScale && scale <= settings.maxScale );
+        if( scale != previous ) {
+            changes++;
+        }
+        previous = scale;
+    }
+    
+    float time = gpu.getTime( resolution.getScale() );
+    TEST_CHECK( resolution.getScale() < 1.f );
+    TEST_CHECK( time <= settings.targetTime );
+    TEST_CHECK( time >= settings.targetTime * settings.raiseThreshold );
+    // it settles instead of going back & forth
+    TEST_CHECK( changes < 10 );
+    
+    float settled = resolution.getScale();
+    for( int i=0; i < 300; ++i ) {
+        gpu.runFrame( resolution );
+    }
+    TEST_CHECK( resolution.getScale() == settled );
+    
+    // the load goes away, it's raised back to the max
+    gpu.setPixelTime( 6.f );
+    for( int i=0; i < 600; ++i ) {
+        gpu.runFrame( resolution );
+    }
+    TEST_CHECK( resolution.getScale() == settings.maxScale );
+}
+
+static void testClampsToMinScale()
+{
+    DynamicResolution::Settings settings;
+        settings.minScale = 0.6f;
+    DynamicResolution resolution;
+    resolution.setSettings( settings );
+    
+    // too slow even at the min scale
+    SimulatedGpu gpu( 5.f, 100.f );
+    for( int i=0; i < 300; ++i ) {
+        gpu.runFrame( resolution );
+    }
+    TEST_CHECK( resolution.getScale() == settings.minScale );
+    
+    resolution.reset();
+    TEST_CHECK( resolution.getScale() == settings.maxScale );
+    TEST_CHECK( resolution.getSmoothedTime() == 0.f );
+}
+
+static void testRenderSize()
+{
+    DynamicResolution::Settings settings;
+        settings.minScale = 0.1f;
+    DynamicResolution resolution;
+    resolution.setSettings( settings );
+    
+    TEST_CHECK( resolution.getRenderSize(glm::uvec2(1280,720)) == glm::uvec2(1280,720) );
+    
+    // drop to the min scale
+    for( int i=0; i < 300; ++i ) {
+        resolution.addFrameTime( 1000.f );
+    }
+    TEST_CHECK( resolution.getScale() == settings.minScale );
+    TEST_CHECK( resolution.getRenderSize(glm::uvec2(1280,720)) == glm::uvec2(128,72) );
+    TEST_CHECK( resolution.getRenderSize(glm::uvec2(4,4)) == glm::uvec2(1,1) );
+}
+
+int main()
+{
+    testUnderBudget();
+    testIgnoresMissingTimes();
+    testSingleSpike();
+    testConverges();
+    testClampsToMinScale();
+    testRenderSize();
+    
+    return sTestFailures;
+}
@@ -0,0 +1,251 @@
+#include "FrameGraph.h"
+#include "TestUtils.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+static const glm::uvec2 SIZE( 64, 64 );
+
+static FrameGraphTextureDesc makeDesc( TextureType type, const glm::uvec2 &size = SIZE )
+{
+    FrameGraphTextureDesc desc;
+        desc.type = type;
+        desc.size = size;
+    return desc;
+}
+
+// the passes record their names when executed
+class PassLog {
+public:
+    FrameGraph::PassId addPass( FrameGraph &graph, const std::string &name ) {
+        return graph.addPass( name, [this,name]() {
+            mExecuted.push_back( name );
+        } );
+    }
+    
+    void execute( const FrameGraph &graph ) {
+        mExecuted.clear();
+        for( FrameGraph::PassId pass : graph.getExecutionOrder() ) {
+            graph.executePass( pass );
+        }
+    }
+    
+    const std::vector<std::string>& getExecuted() const {
+        return mExecuted;
+    }
+    
+private:
+    std::vector<std::string> mExecuted;
+};
+
+static void testOrdering()
+{
+    FrameGraph graph;
+    PassLog log;
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" ),
+                           color = graph.addTransient( "Color", makeDesc(TextureType::RGBA) ),
+                           history = graph.addTransient( "History", makeDesc(TextureType::RGBA) );
+    graph.markOutput( history );
+    
+    // added before the pass writing what it reads, so it's moved after it
+    FrameGraph::PassId resolve = log.addPass( graph, "Resolve" );
+    graph.read( resolve, color, FrameGraph::Access::Sampled );
+    graph.write( resolve, window, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId scene = log.addPass( graph, "Scene" );
+    graph.write( scene, color, FrameGraph::Access::RenderTarget );
+    graph.write( scene, history, FrameGraph::Access::RenderTarget );
+    
+    // reads the history written by Scene, not the one written by Overwrite after it
+    FrameGraph::PassId reader = log.addPass( graph, "Reader" );
+    graph.read( reader, history, FrameGraph::Access::Sampled );
+    graph.write( reader, window, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId overwrite = log.addPass( graph, "Overwrite" );
+    graph.write( overwrite, history, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( graph.compile() );
+    log.execute( graph );
+    
+    std::vector<std::string> expected = { "Scene", "Resolve", "Reader", "Overwrite" };
+    TEST_CHECK( log.getExecuted() == expected );
+}
+
+static void testCulling()
+{
+    FrameGraph graph;
+    PassLog log;
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" ),
+                           used = graph.addTransient( "Used", makeDesc(TextureType::RGBA) ),
+                           unused = graph.addTransient( "Unused", makeDesc(TextureType::RGBA) ),
+                           unusedResult = graph.addTransient( "Unused Result", makeDesc(TextureType::RGBA) ),
+                           output = graph.addTransient( "Output", makeDesc(TextureType::Red) );
+    graph.markOutput( output );
+    
+    FrameGraph::PassId producer = log.addPass( graph, "Producer" );
+    graph.write( producer, used, FrameGraph::Access::RenderTarget );
+    
+    // only leads to a resource nothing reads, both are culled
+    FrameGraph::PassId deadProducer = log.addPass( graph, "Dead Producer" );
+    graph.write( deadProducer, unused, FrameGraph::Access::RenderTarget );
+    FrameGraph::PassId deadConsumer = log.addPass( graph, "Dead Consumer" );
+    graph.read( deadConsumer, unused, FrameGraph::Access::Sampled );
+    graph.write( deadConsumer, unusedResult, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId present = log.addPass( graph, "Present" );
+    graph.read( present, used, FrameGraph::Access::Sampled );
+    graph.write( present, window, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId outputPass = log.addPass( graph, "Output" );
+    graph.write( outputPass, output, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( graph.compile() );
+    log.execute( graph );
+    
+    std::vector<std::string> expected = { "Producer", "Present", "Output" };
+    TEST_CHECK( log.getExecuted() == expected );
+    TEST_CHECK( !graph.isCulled(producer) && !graph.isCulled(present) && !graph.isCulled(outputPass) );
+    TEST_CHECK( graph.isCulled(deadProducer) && graph.isCulled(deadConsumer) );
+    
+    // the culled passes resources get no texture
+    TEST_CHECK( graph.getTextureIndex(unused) == FrameGraph::INVALID_ID );
+    TEST_CHECK( graph.getTextureIndex(unusedResult) == FrameGraph::INVALID_ID );
+    TEST_CHECK( graph.getTextureIndex(window) == FrameGraph::INVALID_ID );
+}
+
+static void testAliasing()
+{
+    FrameGraph graph;
+    PassLog log;
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" ),
+                           first = graph.addTransient( "First", makeDesc(TextureType::RGBA) ),
+                           second = graph.addTransient( "Second", makeDesc(TextureType::RGBA) ),
+                           third = graph.addTransient( "Third", makeDesc(TextureType::RGBA) ),
+                           otherSize = graph.addTransient( "Other Size", makeDesc(TextureType::RGBA, glm::uvec2(32,32)) ),
+                           otherType = graph.addTransient( "Other Type", makeDesc(TextureType::RGB) );
+                           
+    // a chain where each pass reads the last ones result, First is free once Second is made
+    FrameGraph::PassId pass0 = log.addPass( graph, "0" );
+    graph.write( pass0, first, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId pass1 = log.addPass( graph, "1" );
+    graph.read( pass1, first, FrameGraph::Access::Sampled );
+    graph.write( pass1, second, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId pass2 = log.addPass( graph, "2" );
+    graph.read( pass2, second, FrameGraph::Access::Sampled );
+    graph.write( pass2, third, FrameGraph::Access::RenderTarget );
+    graph.write( pass2, otherSize, FrameGraph::Access::RenderTarget );
+    graph.write( pass2, otherType, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId pass3 = log.addPass( graph, "3" );
+    graph.read( pass3, third, FrameGraph::Access::Sampled );
+    graph.read( pass3, otherSize, FrameGraph::Access::Sampled );
+    graph.read( pass3, otherType, FrameGraph::Access::Sampled );
+    graph.write( pass3, window, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( graph.compile() );
+    
+    UInt32 firstTexture = graph.getTextureIndex( first ),
+           secondTexture = graph.getTextureIndex( second ),
+           thirdTexture = graph.getTextureIndex( third );
+    TEST_CHECK( firstTexture != FrameGraph::INVALID_ID && secondTexture != FrameGraph::INVALID_ID );
+    TEST_CHECK( thirdTexture == firstTexture );
+    TEST_CHECK( secondTexture != firstTexture );
+    
+    // only the same type & size can share
+    TEST_CHECK( graph.getTextureIndex(otherSize) != firstTexture && graph.getTextureIndex(otherSize) != secondTexture );
+    TEST_CHECK( graph.getTextureIndex(otherType) != firstTexture && graph.getTextureIndex(otherType) != secondTexture );
+    TEST_CHECK( graph.getTextures().size() == 4 );
+    
+    size_t rgba = FrameGraph::GetTextureMemory( makeDesc(TextureType::RGBA) ),
+           small = FrameGraph::GetTextureMemory( makeDesc(TextureType::RGBA, glm::uvec2(32,32)) ),
+           rgb = FrameGraph::GetTextureMemory( makeDesc(TextureType::RGB) );
+    TEST_CHECK( rgba == 64*64*4 && small == 32*32*4 );
+    TEST_CHECK( graph.getTransientMemory() == 3*rgba + small + rgb );
+    TEST_CHECK( graph.getAllocatedMemory() == 2*rgba + small + rgb );
+}
+
+static void testBarriers()
+{
+    FrameGraph graph;
+    PassLog log;
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" ),
+                           image = graph.addTransient( "Image", makeDesc(TextureType::RGBA) ),
+                           target = graph.addTransient( "Target", makeDesc(TextureType::RGBA) );
+                           
+    FrameGraph::PassId compute = log.addPass( graph, "Compute" );
+    graph.write( compute, image, FrameGraph::Access::Image );
+    
+    FrameGraph::PassId sample = log.addPass( graph, "Sample" );
+    graph.read( sample, image, FrameGraph::Access::Sampled );
+    graph.write( sample, target, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId imageRead = log.addPass( graph, "Image Read" );
+    graph.read( imageRead, image, FrameGraph::Access::Image );
+    graph.read( imageRead, target, FrameGraph::Access::Sampled );
+    graph.write( imageRead, window, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId sampleAgain = log.addPass( graph, "Sample Again" );
+    graph.read( sampleAgain, image, FrameGraph::Access::Sampled );
+    graph.write( sampleAgain, window, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( graph.compile() );
+    
+    TEST_CHECK( graph.getBarriers(compute) == FrameGraph::BARRIER_NONE );
+    // the first read of each kind after the image write needs its barrier, once
+    TEST_CHECK( graph.getBarriers(sample) == FrameGraph::BARRIER_TEXTURE_FETCH );
+    TEST_CHECK( graph.getBarriers(imageRead) == FrameGraph::BARRIER_IMAGE_ACCESS );
+    TEST_CHECK( graph.getBarriers(sampleAgain) == FrameGraph::BARRIER_NONE );
+}
+
+static void testCycle()
+{
+    FrameGraph graph;
+    PassLog log;
+    
+    FrameGraph::ResourceId window = graph.addImported( "Window" ),
+                           a = graph.addTransient( "A", makeDesc(TextureType::RGBA) ),
+                           b = graph.addTransient( "B", makeDesc(TextureType::RGBA) );
+                           
+    // reads B before anything added before it writes it, so it waits for Second, which reads A
+    FrameGraph::PassId first = log.addPass( graph, "First" );
+    graph.read( first, b, FrameGraph::Access::Sampled );
+    graph.write( first, a, FrameGraph::Access::RenderTarget );
+    
+    FrameGraph::PassId second = log.addPass( graph, "Second" );
+    graph.read( second, a, FrameGraph::Access::Sampled );
+    graph.write( second, b, FrameGraph::Access::RenderTarget );
+    graph.write( second, window, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( !graph.compile() );
+    TEST_CHECK( graph.getExecutionOrder().empty() );
+    
+    // a pass reading its own target isn't a cycle
+    graph.clear();
+    FrameGraph::ResourceId target = graph.addTransient( "Target", makeDesc(TextureType::RGBA) );
+    window = graph.addImported( "Window" );
+    FrameGraph::PassId feedback = log.addPass( graph, "Feedback" );
+    graph.write( feedback, target, FrameGraph::Access::RenderTarget );
+    graph.read( feedback, target, FrameGraph::Access::Sampled );
+    graph.write( feedback, window, FrameGraph::Access::RenderTarget );
+    
+    TEST_CHECK( graph.compile() );
+    TEST_CHECK( graph.getExecutionOrder().size() == 1 );
+}
+
+int main()
+{
+    testOrdering();
+    testCulling();
+    testAliasing();
+    testBarriers();
+    testCycle();
+    
+    return sTestFailures;
+}
@@ -0,0 +1,121 @@
+#include "IndirectDraw.h"
+#include "Mesh.h"
+#include "TestUtils.h"
+
+#include <vector>
+
+static SubMesh makeSubMesh( size_t firstIndex, size_t indexCount, size_t baseVertex )
+{
+    SubMesh submesh;
+        submesh.vertexStart = firstIndex;
+        submesh.vertexCount = indexCount;
+        submesh.baseVertex = baseVertex;
+    return submesh;
+}
+
+static IndirectCommandBuilder::BucketState makeState( UInt32 diffuse, UInt32 normalMap, const VertexArrayObject *vao, UInt32 indexBuffer )
+{
+    IndirectCommandBuilder::BucketState state;
+        state.diffuseTexture = diffuse;
+        state.normalMap = normalMap;
+        state.vao = vao;
+        state.indexBuffer = indexBuffer;
+    return state;
+}
+
+static void testCommandFields()
+{
+    IndirectCommandBuilder builder;
+    
+    // two submeshes in the shared buffers, the second one after the first
+    std::vector<SubMesh> submeshes = { makeSubMesh(0, 36, 100), makeSubMesh(36, 12, 124) };
+    builder.beginBucket( 7 );
+    builder.addDraw( submeshes, 5, 40 );
+    
+    const std::vector<DrawElementsIndirectCommand> &commands = builder.getCommands();
+    TEST_CHECK( commands.size() == 2 );
+    if( commands.size() == 2 ) {
+        TEST_CHECK( commands[0].count == 36 && commands[0].firstIndex == 0 && commands[0].baseVertex == 100 );
+        TEST_CHECK( commands[1].count == 12 && commands[1].firstIndex == 36 && commands[1].baseVertex == 124 );
+        
+        // the instances are found through the draw data, not baseInstance
+        TEST_CHECK( commands[0].instanceCount == 5 && commands[1].instanceCount == 5 );
+        TEST_CHECK( commands[0].baseInstance == 0 && commands[1].baseInstance == 0 );
+    }
+    TEST_CHECK( builder.getDrawData() == std::vector<UInt32>({40, 40}) );
+    
+    TEST_CHECK( builder.getBuckets().size() == 1 );
+    if( builder.getBuckets().size() == 1 ) {
+        TEST_CHECK( builder.getBuckets()[0].firstCommand == 0 );
+        TEST_CHECK( builder.getBuckets()[0].commandCount == 2 );
+        TEST_CHECK( builder.getBuckets()[0].userData == 7 );
+    }
+    
+    builder.clear();
+    TEST_CHECK( builder.getCommands().empty() && builder.getDrawData().empty() && builder.getBuckets().empty() );
+}
+
+static void testBucketSplits()
+{
+    // only the addresses are compared
+    const VertexArrayObject *sharedVao = reinterpret_cast<const VertexArrayObject*>( 0x10 ),
+                            *otherVao = reinterpret_cast<const VertexArrayObject*>( 0x20 );
+                            
+    std::vector<SubMesh> cube = { makeSubMesh(0, 36, 0) },
+                         tree = { makeSubMesh(36, 60, 24), makeSubMesh(96, 30, 24) },
+                         rock = { makeSubMesh(0, 18, 0) };
+                         
+    IndirectCommandBuilder builder;
+    // the instance groups as the renderer sorts them, by material
+    builder.addGroup( makeState(1, 2, sharedVao, 3), cube, 10, 0, 0 );
+    // same material & shared buffers, continues the bucket
+    builder.addGroup( makeState(1, 2, sharedVao, 3), tree, 4, 10, 1 );
+    // another material
+    builder.addGroup( makeState(5, 2, sharedVao, 3), cube, 2, 14, 2 );
+    // same material, but a mesh with buffers of its own
+    builder.addGroup( makeState(5, 2, otherVao, 9), rock, 1, 16, 3 );
+    // another normal map
+    builder.addGroup( makeState(5, 6, otherVao, 9), rock, 3, 17, 4 );
+    
+    const std::vector<IndirectCommandBuilder::Bucket> &buckets = builder.getBuckets();
+    TEST_CHECK( buckets.size() == 4 );
+    if( buckets.size() == 4 ) {
+        // the user data is the first group of the bucket
+        TEST_CHECK( buckets[0].userData == 0 && buckets[0].firstCommand == 0 && buckets[0].commandCount == 3 );
+        TEST_CHECK( buckets[1].userData == 2 && buckets[1].firstCommand == 3 && buckets[1].commandCount == 1 );
+        TEST_CHECK( buckets[2].userData == 3 && buckets[2].firstCommand == 4 && buckets[2].commandCount == 1 );
+        TEST_CHECK( buckets[3].userData == 4 && buckets[3].firstCommand == 5 && buckets[3].commandCount == 1 );
+    }
+    
+    // the buckets covers the commands in order
+    UInt32 next = 0;
+    for( const IndirectCommandBuilder::Bucket &bucket : buckets ) {
+        TEST_CHECK( bucket.firstCommand == next );
+        next += bucket.commandCount;
+    }
+    TEST_CHECK( next == builder.getCommands().size() );
+    
+    // gl_DrawID + the first command of the bucket gives the first instance of the command
+    TEST_CHECK( builder.getDrawData() == std::vector<UInt32>({0, 10, 10, 14, 16, 17}) );
+    TEST_CHECK( builder.getDrawData().size() == builder.getCommands().size() );
+    
+    const std::vector<DrawElementsIndirectCommand> &commands = builder.getCommands();
+    if( commands.size() == 6 ) {
+        TEST_CHECK( commands[1].firstIndex == 36 && commands[1].count == 60 && commands[1].baseVertex == 24 );
+        TEST_CHECK( commands[2].firstIndex == 96 && commands[2].count == 30 && commands[2].instanceCount == 4 );
+        TEST_CHECK( commands[5].count == 18 && commands[5].instanceCount == 3 );
+    }
+    
+    // a cleared builder starts a new bucket for the same state
+    builder.clear();
+    builder.addGroup( makeState(5, 6, otherVao, 9), rock, 1, 0, 0 );
+    TEST_CHECK( builder.getBuckets().size() == 1 );
+}
+
+int main()
+{
+    testCommandFields();
+    testBucketSplits();
+    
+    return sTestFailures;
+}
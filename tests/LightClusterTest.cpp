@@ -0,0 +1,225 @@
+#include "LightClusters.h"
+#include "WorkerPool.h"
+#include "TestUtils.h"
+
+#include <glm/common.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+static const float NEAR_PLANE = 0.5f,
+                   FAR_PLANE = 100.f;
+                   
+static glm::mat4 getProjection()
+{
+    return glm::perspective( 1.2f, 16.f/9.f, NEAR_PLANE, FAR_PLANE );
+}
+
+struct ClusterBounds {
+    // view space, with the depth as a positive distance
+    glm::vec3 boxMin, boxMax;
+    // points in the part of the frustum the cluster covers
+    std::vector<glm::vec3> samples;
+};
+
+// the clusters are built from the projection here, without the builder
+static std::vector<ClusterBounds> getClusterBounds( const LightClusterBuilder &builder, const glm::mat4 &projection )
+{
+    glm::uvec3 grid = builder.getGridSize();
+    std::vector<ClusterBounds> result( grid.x*grid.y*grid.z );
+    
+    auto sliceDepth = [&]( float slice ) {
+        return NEAR_PLANE * std::pow( FAR_PLANE / NEAR_PLANE, slice / grid.z );
+    };
+    auto tileEdgeX = [&]( float x ) {
+        return (2.f * x / grid.x - 1.f) / projection[0][0];
+    };
+    auto tileEdgeY = [&]( float y ) {
+        return (2.f * y / grid.y - 1.f) / projection[1][1];
+    };
+    
+    const float fractions[3] = { 0.05f, 0.5f, 0.95f };
+    
+    for( UInt32 z=0; z < grid.z; ++z ) {
+        for( UInt32 y=0; y < grid.y; ++y ) {
+            for( UInt32 x=0; x < grid.x; ++x ) {
+                ClusterBounds &bounds = result[builder.getClusterIndex(x,y,z)];
+                
+                float nearDepth = sliceDepth( z ), farDepth = sliceDepth( z+1 );
+                bounds.boxMin = glm::vec3( std::min(tileEdgeX(x)*nearDepth, tileEdgeX(x)*farDepth), std::min(tileEdgeY(y)*nearDepth, tileEdgeY(y)*farDepth), nearDepth );
+                bounds.boxMax = glm::vec3( std::max(tileEdgeX(x+1)*nearDepth, tileEdgeX(x+1)*farDepth), std::max(tileEdgeY(y+1)*nearDepth, tileEdgeY(y+1)*farDepth), farDepth );
+                
+                for( float fz : fractions ) {
+                    for( float fy : fractions ) {
+                        for( float fx : fractions ) {
+                            float depth = sliceDepth( z+fz );
+                            bounds.samples.push_back( glm::vec3(tileEdgeX(x+fx)*depth, tileEdgeY(y+fy)*depth, depth) );
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static bool hasLight( const LightClusterBuilder &builder, size_t cluster, UInt32 light )
+{
+    const LightClusterBuilder::Cluster &entry = builder.getClusters()[cluster];
+    const UInt32 *first = builder.getLightIndices().data() + entry.offset;
+    return std::find( first, first+entry.count, light ) != first+entry.count;
+}
+
+static void testSlices()
+{
+    LightClusterBuilder builder;
+    builder.build( nullptr, 0, getProjection(), NEAR_PLANE, FAR_PLANE );
+    
+    UInt32 slices = builder.getGridSize().z;
+    TEST_CHECK( builder.getSlice(NEAR_PLANE) == 0 );
+    TEST_CHECK( builder.getSlice(NEAR_PLANE*0.5f) == 0 );
+    TEST_CHECK( builder.getSlice(FAR_PLANE*0.999f) == slices-1 );
+    TEST_CHECK( builder.getSlice(FAR_PLANE*2.f) == slices-1 );
+    
+    // exponentially spaced, every slice covers the same depth ratio
+    for( UInt32 z=0; z < slices; ++z ) {
+        float center = NEAR_PLANE * std::pow( FAR_PLANE / NEAR_PLANE, (z+0.5f) / slices );
+        TEST_CHECK( builder.getSlice(center) == z );
+    }
+    
+    TEST_CHECK( builder.getClusters().size() == size_t(builder.getGridSize().x*builder.getGridSize().y*slices) );
+    TEST_CHECK( builder.getLightIndices().empty() );
+}
+
+static void testSmallLight()
+{
+    LightClusterBuilder builder;
+    builder.setGridSize( glm::uvec3(8,4,16) );
+    glm::mat4 projection = getProjection();
+    
+    // the center of cluster (5,1,9)
+    float nearDepth = NEAR_PLANE * std::pow( FAR_PLANE / NEAR_PLANE, 9.f / 16.f ),
+          farDepth = NEAR_PLANE * std::pow( FAR_PLANE / NEAR_PLANE, 10.f / 16.f ),
+          depth = (nearDepth + farDepth) / 2.f;
+    float x = (2.f * 5.5f / 8.f - 1.f) / projection[0][0] * depth,
+          y = (2.f * 1.5f / 4.f - 1.f) / projection[1][1] * depth;
+          
+    LightClusterBuilder::Light light;
+        light.position = glm::vec3( x, y, -depth );
+        light.radius = 0.01f;
+    builder.build( &light, 1, projection, NEAR_PLANE, FAR_PLANE );
+    
+    TEST_CHECK( builder.getLightIndices().size() == 1 );
+    TEST_CHECK( hasLight(builder, builder.getClusterIndex(5,1,9), 0) );
+}
+
+static void testCulledLights()
+{
+    LightClusterBuilder builder;
+    
+    std::vector<LightClusterBuilder::Light> lights( 4 );
+        // behind the camera
+        lights[0].position = glm::vec3( 0.f, 0.f, 5.f );
+        lights[0].radius = 1.f;
+        // past the far plane
+        lights[1].position = glm::vec3( 0.f, 0.f, -FAR_PLANE-5.f );
+        lights[1].radius = 1.f;
+        // outside the sides of the frustum
+        lights[2].position = glm::vec3( 100.f, 0.f, -10.f );
+        lights[2].radius = 1.f;
+        lights[3].position = glm::vec3( 0.f, -100.f, -10.f );
+        lights[3].radius = 1.f;
+        
+    builder.build( lights.data(), lights.size(), getProjection(), NEAR_PLANE, FAR_PLANE );
+    TEST_CHECK( builder.getLightIndices().empty() );
+}
+
+static void testRandomLights()
+{
+    std::mt19937 generator( 1542 );
+    std::uniform_real_distribution<float> side( -60.f, 60.f ), depth( -110.f, 2.f ), radius( 0.1f, 8.f );
+    
+    std::vector<LightClusterBuilder::Light> lights( 500 );
+    for( LightClusterBuilder::Light &light : lights ) {
+        light.position = glm::vec3( side(generator), side(generator), depth(generator) );
+        light.radius = radius( generator );
+    }
+    
+    glm::mat4 projection = getProjection();
+    LightClusterBuilder builder;
+    builder.build( lights.data(), lights.size(), projection, NEAR_PLANE, FAR_PLANE );
+    
+    std::vector<ClusterBounds> bounds = getClusterBounds( builder, projection );
+    const std::vector<LightClusterBuilder::Cluster> &clusters = builder.getClusters();
+    const std::vector<UInt32> &indices = builder.getLightIndices();
+    TEST_CHECK( clusters.size() == bounds.size() );
+    
+    size_t unsorted = 0, missing = 0, outside = 0, offset = 0;
+    for( size_t i=0; i < clusters.size() && i < bounds.size(); ++i ) {
+        // the clusters are packed in order
+        TEST_CHECK( clusters[i].offset == offset );
+        offset += clusters[i].count;
+        
+        const UInt32 *first = indices.data() + clusters[i].offset,
+                     *last = first + clusters[i].count;
+        if( !std::is_sorted(first, last) ) {
+            unsorted++;
+        }
+        
+        for( UInt32 j=0; j < lights.size(); ++j ) {
+            glm::vec3 position( lights[j].position.x, lights[j].position.y, -lights[j].position.z );
+            float radius2 = lights[j].radius * lights[j].radius;
+            bool assigned = std::find( first, last, j ) != last;
+            
+            // a light that reaches a point in the cluster must be in it
+            bool reaches = false;
+            for( const glm::vec3 &sample : bounds[i].samples ) {
+                glm::vec3 delta = sample - position;
+                reaches = reaches || (delta.x*delta.x + delta.y*delta.y + delta.z*delta.z <= radius2);
+            }
+            if( reaches && !assigned ) {
+                missing++;
+            }
+            
+            // & a light in it must touch the clusters bounding box
+            glm::vec3 delta = glm::clamp( position, bounds[i].boxMin, bounds[i].boxMax ) - position;
+            if( assigned && delta.x*delta.x + delta.y*delta.y + delta.z*delta.z > radius2*1.001f ) {
+                outside++;
+            }
+        }
+    }
+    TEST_CHECK( offset == indices.size() );
+    TEST_CHECK( unsorted == 0 );
+    TEST_CHECK( missing == 0 );
+    TEST_CHECK( outside == 0 );
+    TEST_CHECK( !indices.empty() );
+    
+    // split across threads gives the same result
+    WorkerPool pool( 4 );
+    LightClusterBuilder parallel;
+    parallel.build( lights.data(), lights.size(), projection, NEAR_PLANE, FAR_PLANE, &pool );
+    
+    TEST_CHECK( parallel.getLightIndices() == indices );
+    TEST_CHECK( parallel.getClusters().size() == clusters.size() );
+    
+    size_t differs = 0;
+    for( size_t i=0; i < clusters.size() && i < parallel.getClusters().size(); ++i ) {
+        if( parallel.getClusters()[i].offset != clusters[i].offset || parallel.getClusters()[i].count != clusters[i].count ) {
+            differs++;
+        }
+    }
+    TEST_CHECK( differs == 0 );
+}
+
+int main()
+{
+    testSlices();
+    testSmallLight();
+    testCulledLights();
+    testRandomLights();
+    
+    return sTestFailures;
+}
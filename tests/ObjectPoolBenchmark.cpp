@@ -0,0 +1,87 @@
+#include "ObjectPool.h"
+#include "Timer.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+static const size_t OBJECT_COUNT = 100000,
+                    ROUNDS = 20;
+                    
+// about the size of a DeferredEntity
+class SpawnedObject {
+public:
+    SpawnedObject( int value ) :
+        mValue(value)
+    {}
+    virtual ~SpawnedObject() = default;
+    
+    virtual int update() {
+        return mValue;
+    }
+    
+private:
+    int mValue;
+    char mData[240];
+};
+
+static volatile int sSink = 0;
+
+// spawns every object, despawns a random half, spawns it again & then despawns everything,
+// the order of the despawns is shuffled as objects don't die in the order they were made
+template< typename Create, typename Destroy >
+float spawnDespawn( Create create, Destroy destroy )
+{
+    std::mt19937 generator( 1542 );
+    std::vector<SpawnedObject*> objects( OBJECT_COUNT );
+    
+    Timer timer;
+    for( size_t round=0; round < ROUNDS; ++round ) {
+        for( size_t i=0; i < OBJECT_COUNT; ++i ) {
+            objects[i] = create( int(i) );
+        }
+        std::shuffle( objects.begin(), objects.end(), generator );
+        
+        for( size_t i=0; i < OBJECT_COUNT/2; ++i ) {
+            destroy( objects[i] );
+        }
+        for( size_t i=0; i < OBJECT_COUNT/2; ++i ) {
+            objects[i] = create( int(i) );
+        }
+        
+        int sum = 0;
+        for( SpawnedObject *object : objects ) {
+            sum += object->update();
+        }
+        sSink = sum;
+        
+        for( SpawnedObject *object : objects ) {
+            destroy( object );
+        }
+    }
+    return timer.getTimeAsSeconds();
+}
+
+int main()
+{
+    float heapTime = spawnDespawn(
+        []( int value ) { return new SpawnedObject(value); },
+        []( SpawnedObject *object ) { delete object; }
+    );
+    
+    ObjectPool<SpawnedObject> pool;
+    float poolTime = spawnDespawn(
+        [&]( int value ) { return pool.create(value); },
+        [&]( SpawnedObject *object ) { pool.destroy(object); }
+    );
+    
+    // 2 spawns & 2 despawns for every other object, 1 of each for the rest
+    double operations = double(OBJECT_COUNT) * 3 * ROUNDS;
+    std::printf( "%zu objects, %zu rounds of spawn & despawn\n", OBJECT_COUNT, ROUNDS );
+    std::printf( "  new/delete:  %8.2f ms %6.2f M spawns & despawns/s\n", heapTime*1000.f, operations / heapTime / 1e6 );
+    std::printf( "  ObjectPool:  %8.2f ms %6.2f M spawns & despawns/s\n", poolTime*1000.f, operations / poolTime / 1e6 );
+    std::printf( "  pool slabs: %zu, peak objects: %zu\n", pool.getStatistics().slabCount, pool.getStatistics().peakObjects );
+    
+    return 0;
+}
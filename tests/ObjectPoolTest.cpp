@@ -0,0 +1,122 @@
+#include "ObjectPool.h"
+#include "TestUtils.h"
+
+#include <stdexcept>
+#include <set>
+
+static int sLiveTestObjects = 0;
+
+struct TestObject {
+    TestObject( int value ) :
+        value(value)
+    {
+        if( value < 0 ) {
+            throw std::runtime_error( "TestObject - negative value" );
+        }
+        sLiveTestObjects++;
+    }
+    ~TestObject() {
+        sLiveTestObjects--;
+    }
+    
+    int value;
+    char padding[20];
+};
+
+struct alignas(16) AlignedObject {
+    float values[4];
+};
+
+static void testCreateDestroy()
+{
+    ObjectPool<TestObject,4> pool;
+    
+    std::set<TestObject*> objects;
+    for( int i=0; i < 10; ++i ) {
+        TestObject *object = pool.create( i );
+        TEST_CHECK( object->value == i );
+        objects.insert( object );
+    }
+    TEST_CHECK( objects.size() == 10 );
+    TEST_CHECK( sLiveTestObjects == 10 );
+    TEST_CHECK( pool.getStatistics().liveObjects == 10 );
+    TEST_CHECK( pool.getStatistics().peakObjects == 10 );
+    TEST_CHECK( pool.getStatistics().slabCount == 3 );
+    
+    for( TestObject *object : objects ) {
+        pool.destroy( object );
+    }
+    TEST_CHECK( sLiveTestObjects == 0 );
+    TEST_CHECK( pool.getStatistics().liveObjects == 0 );
+    TEST_CHECK( pool.getStatistics().peakObjects == 10 );
+    
+    // the memory is reused, no new slabs
+    for( int i=0; i < 10; ++i ) {
+        TestObject *object = pool.create( i );
+        TEST_CHECK( objects.count(object) == 1 );
+        pool.destroy( object );
+    }
+    TEST_CHECK( pool.getStatistics().slabCount == 3 );
+    
+    pool.destroy( nullptr );
+    TEST_CHECK( pool.getStatistics().liveObjects == 0 );
+}
+
+static void testReuseLastDestroyed()
+{
+    ObjectPool<TestObject,8> pool;
+    
+    TestObject *a = pool.create( 1 ),
+               *b = pool.create( 2 );
+    // a new slab hands out its slots in memory order
+    TEST_CHECK( b == a+1 );
+    
+    pool.destroy( a );
+    TEST_CHECK( pool.create(3) == a );
+    
+    pool.destroy( a );
+    pool.destroy( b );
+}
+
+static void testThrowingConstructor()
+{
+    ObjectPool<TestObject,4> pool;
+    
+    TestObject *first = pool.create( 1 );
+    bool thrown = false;
+    try {
+        pool.create( -1 );
+    } catch( const std::runtime_error& ) {
+        thrown = true;
+    }
+    TEST_CHECK( thrown );
+    TEST_CHECK( pool.getStatistics().liveObjects == 1 );
+    TEST_CHECK( sLiveTestObjects == 1 );
+    
+    // the slot of the failed create is handed out again
+    TestObject *second = pool.create( 2 );
+    TEST_CHECK( second == first+1 );
+    
+    pool.destroy( first );
+    pool.destroy( second );
+}
+
+static void testAlignment()
+{
+    ObjectPool<AlignedObject,3> pool;
+    
+    for( int i=0; i < 7; ++i ) {
+        AlignedObject *object = pool.create();
+        TEST_CHECK( reinterpret_cast<size_t>(object) % alignof(AlignedObject) == 0 );
+    }
+}
+
+int main()
+{
+    testCreateDestroy();
+    testReuseLastDestroyed();
+    testThrowingConstructor();
+    testAlignment();
+    
+    return sTestFailures;
+}
@@ -0,0 +1,106 @@
+#include "RadixSort.h"
+#include "TestUtils.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+struct Entry {
+    UInt64 key;
+    size_t index;
+};
+
+static UInt64 getKey( const Entry &entry )
+{
+    return entry.key;
+}
+
+// the entries are numbered in their original order, so the stability can be checked
+static std::vector<Entry> makeEntries( size_t count, UInt64 keyMask, std::mt19937_64 &generator )
+{
+    std::vector<Entry> entries( count );
+    for( size_t i=0; i < count; ++i ) {
+        entries[i].key = generator() & keyMask;
+        entries[i].index = i;
+    }
+    return entries;
+}
+
+static bool isSortedAndStable( const std::vector<Entry> &entries, UInt64 keyMask )
+{
+    for( size_t i=1; i < entries.size(); ++i ) {
+        UInt64 previous = entries[i-1].key & keyMask,
+               current = entries[i].key & keyMask;
+        if( previous > current || (previous == current && entries[i-1].index > entries[i].index) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testSortsLikeStableSort()
+{
+    std::mt19937_64 generator( 1542 );
+    std::vector<Entry> temp;
+    
+    // full keys, keys with a few distinct values & keys where most bytes are the same for every entry
+    const UInt64 masks[] = { ~UInt64(0), 0x7, 0xFF00000000FF00 };
+    for( UInt64 mask : masks ) {
+        std::vector<Entry> entries = makeEntries( 5000, mask, generator ),
+                           expected = entries;
+                           
+        std::stable_sort( expected.begin(), expected.end(), []( const Entry &a, const Entry &b ) {
+            return a.key < b.key;
+        });
+        radixSort( entries, temp, getKey );
+        
+        TEST_CHECK( entries.size() == expected.size() );
+        TEST_CHECK( isSortedAndStable(entries, mask) );
+        TEST_CHECK( std::equal(entries.begin(), entries.end(), expected.begin(), []( const Entry &a, const Entry &b ) {
+            return a.index == b.index;
+        }));
+    }
+}
+
+static void testKeyBits()
+{
+    std::mt19937_64 generator( 26 );
+    std::vector<Entry> entries = makeEntries( 1000, ~UInt64(0), generator ),
+                       temp;
+                       
+    // only the lowest 16 bits are sorted on, the rest keeps the original order
+    radixSort( entries, temp, getKey, 16 );
+    TEST_CHECK( isSortedAndStable(entries, 0xFFFF) );
+}
+
+static void testSmallInputs()
+{
+    std::vector<Entry> entries, temp;
+    radixSort( entries, temp, getKey );
+    TEST_CHECK( entries.empty() );
+    
+    entries.push_back( Entry{42, 0} );
+    radixSort( entries, temp, getKey );
+    TEST_CHECK( entries.size() == 1 && entries[0].key == 42 );
+    
+    entries.push_back( Entry{7, 1} );
+    radixSort( entries, temp, getKey );
+    TEST_CHECK( entries[0].key == 7 && entries[1].key == 42 );
+    
+    // all the same key, every pass is skipped
+    std::vector<Entry> same( 100, Entry{0x0102030405060708, 0} );
+    for( size_t i=0; i < same.size(); ++i ) {
+        same[i].index = i;
+    }
+    radixSort( same, temp, getKey );
+    TEST_CHECK( isSortedAndStable(same, ~UInt64(0)) );
+}
+
+int main()
+{
+    testSortsLikeStableSort();
+    testKeyBits();
+    testSmallInputs();
+    
+    return sTestFailures;
+}
@@ -0,0 +1,158 @@
+#include "RecordingRenderDevice.h"
+#include "RenderStateCache.h"
+#include "UniformBufferAllocator.h"
+#include "GLinclude.h"
+#include "TestUtils.h"
+
+#include <vector>
+#include <cstring>
+
+// what the g-buffer pass needs for one entity
+struct DrawItem {
+    GLuint program, vao, texture;
+    GLenum blendSrc, blendDst;
+    GLsizei indexCount;
+    float uniforms[4];
+    
+    // where the uniforms ended up
+    GLuint uniformBuffer;
+    size_t uniformOffset;
+};
+
+static const GLuint ENTITY_UNIFORM_BINDING = 1;
+
+static GLuint createVAO( RenderDevice *device, GLuint *elementBuffer )
+{
+    GLuint vao = device->genVertexArray();
+    device->bindVertexArray( vao );
+    
+    *elementBuffer = device->genBuffer();
+    device->bindBuffer( GL_ELEMENT_ARRAY_BUFFER, *elementBuffer );
+    device->bufferData( GL_ELEMENT_ARRAY_BUFFER, 36*sizeof(GLuint), nullptr, GL_STATIC_DRAW );
+    
+    device->bindVertexArray( 0 );
+    return vao;
+}
+
+// records a frame the way the renderer does, the uniforms are written first,
+// then flushed & drawn sorted by program, mesh & material
+static void recordFrame( RenderDevice *device, UniformBufferAllocator &allocator, std::vector<DrawItem> &items )
+{
+    for( DrawItem &item : items ) {
+        UniformBufferAllocator::AllocationResult result = allocator.getMemory( sizeof(item.uniforms) );
+        std::memcpy( result.memory, item.uniforms, sizeof(item.uniforms) );
+        item.uniformBuffer = result.buffer;
+        item.uniformOffset = result.offset;
+    }
+    allocator.flush();
+    
+    device->viewport( 0, 0, 1280, 720 );
+    device->enable( GL_DEPTH_TEST );
+    device->depthMask( GL_TRUE );
+    device->clear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    
+    for( const DrawItem &item : items ) {
+        device->useProgram( item.program );
+        device->bindVertexArray( item.vao );
+        device->bindTextureUnit( 0, GL_TEXTURE_2D, item.texture );
+        device->blendFunc( item.blendSrc, item.blendDst );
+        device->bindBufferRange( GL_UNIFORM_BUFFER, ENTITY_UNIFORM_BINDING, item.uniformBuffer, item.uniformOffset, sizeof(item.uniforms) );
+        device->drawElements( GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, nullptr );
+    }
+    
+    allocator.endFrame();
+}
+
+static void testReplayFrame( RecordingRenderDevice &recording, RenderStateCache *cache )
+{
+    RenderDevice *device = RenderDevice::GetDevice();
+    
+    GLuint elementBuffers[2];
+    GLuint vaos[2] = { createVAO(device, &elementBuffers[0]), createVAO(device, &elementBuffers[1]) };
+    GLuint textures[2] = { device->genTexture(), device->genTexture() };
+    GLuint programs[2] = { 1000, 1001 };
+    
+    // the element array binding belongs to the vao
+    device->bindVertexArray( vaos[1] );
+    TEST_CHECK( (GLuint)device->getInteger(GL_ELEMENT_ARRAY_BUFFER_BINDING) == elementBuffers[1] );
+    device->bindVertexArray( vaos[0] );
+    TEST_CHECK( (GLuint)device->getInteger(GL_ELEMENT_ARRAY_BUFFER_BINDING) == elementBuffers[0] );
+    
+    std::vector<DrawItem> items;
+    for( GLuint program : programs ) {
+        for( int mesh=0; mesh < 2; ++mesh ) {
+            for( int i=0; i < 50; ++i ) {
+                DrawItem item;
+                    item.program = program;
+                    item.vao = vaos[mesh];
+                    item.texture = textures[i % 2];
+                    item.blendSrc = GL_ONE;
+                    item.blendDst = GL_ZERO;
+                    item.indexCount = 36;
+                    item.uniforms[0] = float(items.size());
+                    item.uniforms[1] = float(program);
+                    item.uniforms[2] = float(mesh);
+                    item.uniforms[3] = float(i);
+                items.push_back( item );
+            }
+        }
+    }
+    
+    UniformBufferAllocator allocator;
+    
+    // the same frame without & with the cache in front of the device
+    cache->setEnabled( false );
+    recording.resetCounters();
+    recordFrame( device, allocator, items );
+    RenderDeviceCounters uncached = recording.getCounters();
+    RecordingRenderDevice::State uncachedState = recording.getState();
+    
+    cache->setEnabled( true );
+    cache->resetCounters();
+    recording.resetCounters();
+    recordFrame( device, allocator, items );
+    RenderDeviceCounters cached = recording.getCounters();
+    RecordingRenderDevice::State cachedState = recording.getState();
+    
+    // every entity is drawn & the clear is counted as a draw
+    TEST_CHECK( uncached.drawCalls == items.size() + 1 );
+    TEST_CHECK( cached.drawCalls == uncached.drawCalls );
+    
+    // the program, textures, blending & uniform ranges repeat between the entities
+    TEST_CHECK( uncached.redundantCalls > 0 );
+    TEST_CHECK( cached.redundantCalls < uncached.redundantCalls );
+    TEST_CHECK( cached.totalCalls < uncached.totalCalls );
+    TEST_CHECK( cache->getCounters().skippedCalls > 0 );
+    
+    // the state at the end of the frame doesn't depend on the cache
+    TEST_CHECK( cachedState.program == uncachedState.program );
+    TEST_CHECK( cachedState.vao == uncachedState.vao );
+    TEST_CHECK( cachedState.textures == uncachedState.textures );
+    TEST_CHECK( cachedState.blendSrc == GL_ONE && cachedState.blendDst == GL_ZERO );
+    TEST_CHECK( cachedState.viewport[2] == 1280 && cachedState.viewport[3] == 720 );
+    
+    // the uniforms written through the allocator are in the buffers the draws used
+    for( const DrawItem &item : items ) {
+        float uniforms[4];
+        device->bindBuffer( GL_UNIFORM_BUFFER, item.uniformBuffer );
+        device->getBufferSubData( GL_UNIFORM_BUFFER, item.uniformOffset, sizeof(uniforms), uniforms );
+        TEST_CHECK( std::memcmp(uniforms, item.uniforms, sizeof(uniforms)) == 0 );
+        TEST_CHECK( item.uniformOffset % allocator.getAligment() == 0 );
+    }
+    device->bindBuffer( GL_UNIFORM_BUFFER, 0 );
+}
+
+int main()
+{
+    // everything is created & destroyed while the recording device is set, behind
+    // a cache the way the renderer sets it up
+    RecordingRenderDevice recording;
+    RenderStateCache cache( &recording );
+    RenderDevice::SetDevice( &cache );
+    
+    testReplayFrame( recording, &cache );
+    
+    RenderDevice::SetDevice( nullptr );
+    
+    return sTestFailures;
+}
@@ -0,0 +1,108 @@
+#include "RingAllocator.h"
+#include "TestUtils.h"
+
+static void testAlignedOffsets()
+{
+    RingAllocator ring( 1024, 64 );
+    
+    TEST_CHECK( ring.allocate(10) == 0 );
+    TEST_CHECK( ring.allocate(10) == 64 );
+    TEST_CHECK( ring.allocate(64) == 128 );
+    TEST_CHECK( ring.allocate(1) == 192 );
+    
+    // the padding before each allocation is used as well
+    TEST_CHECK( ring.getUsed() == 193 );
+    TEST_CHECK( ring.endFrame() == 193 );
+    TEST_CHECK( ring.getFramesInFlight() == 1 );
+    TEST_CHECK( ring.getUsed() == 193 );
+}
+
+static void testWrapAround()
+{
+    RingAllocator ring( 256, 16 );
+    
+    TEST_CHECK( ring.allocate(100) == 0 );
+    TEST_CHECK( ring.endFrame() == 100 );
+    
+    TEST_CHECK( ring.allocate(100) == 112 );
+    TEST_CHECK( ring.endFrame() == 112 );
+    ring.releaseFrame();
+    
+    // 224 + 64 is past the end, so it wraps & the 44 bytes after 212 are charged to the frame
+    TEST_CHECK( ring.allocate(64) == 0 );
+    TEST_CHECK( ring.endFrame() == 44 + 64 );
+    TEST_CHECK( ring.getUsed() == 112 + 108 );
+}
+
+static void testFull()
+{
+    RingAllocator ring( 256, 16 );
+    
+    TEST_CHECK( ring.allocate(128) == 0 );
+    ring.endFrame();
+    TEST_CHECK( ring.allocate(96) == 128 );
+    ring.endFrame();
+    
+    // would overwrite the frames in flight
+    TEST_CHECK( ring.allocate(64) == RingAllocator::INVALID_OFFSET );
+    TEST_CHECK( ring.getUsed() == 224 );
+    
+    // a failed allocation doesn't change anything, the rest still fits
+    TEST_CHECK( ring.allocate(32) == 224 );
+    TEST_CHECK( ring.allocate(1) == RingAllocator::INVALID_OFFSET );
+    TEST_CHECK( ring.endFrame() == 32 );
+    
+    // the first frame is done, its memory can be reused
+    ring.releaseFrame();
+    TEST_CHECK( ring.allocate(64) == 0 );
+}
+
+static void testReleaseOrder()
+{
+    RingAllocator ring( 1024, 16 );
+    
+    ring.allocate( 100 );
+    TEST_CHECK( ring.endFrame() == 100 );
+    ring.allocate( 200 );
+    TEST_CHECK( ring.endFrame() == 12 + 200 );
+    ring.allocate( 48 );
+    TEST_CHECK( ring.endFrame() == 8 + 48 );
+    
+    TEST_CHECK( ring.getFramesInFlight() == 3 );
+    TEST_CHECK( ring.getUsed() == 100 + 212 + 56 );
+    
+    // the oldest frame is released first
+    ring.releaseFrame();
+    TEST_CHECK( ring.getUsed() == 212 + 56 );
+    ring.releaseFrame();
+    TEST_CHECK( ring.getUsed() == 56 );
+    ring.releaseFrame();
+    TEST_CHECK( ring.getUsed() == 0 );
+    TEST_CHECK( ring.getFramesInFlight() == 0 );
+}
+
+static void testHeadReset()
+{
+    RingAllocator ring( 256, 16 );
+    
+    TEST_CHECK( ring.allocate(100) == 0 );
+    ring.endFrame();
+    ring.releaseFrame();
+    
+    // nothing is in use so it starts over, from the old head it would have to wrap
+    // & the skipped bytes wouldn't leave room for it
+    TEST_CHECK( ring.allocate(200) == 0 );
+    TEST_CHECK( ring.getUsed() == 200 );
+    TEST_CHECK( ring.endFrame() == 200 );
+}
+
+int main()
+{
+    testAlignedOffsets();
+    testWrapAround();
+    testFull();
+    testReleaseOrder();
+    testHeadReset();
+    
+    return sTestFailures;
+}
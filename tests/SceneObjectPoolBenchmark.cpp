@@ -0,0 +1,113 @@
+#include "SceneObjectPool.h"
+#include "Frustrum.h"
+#include "Timer.h"
+
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+static const size_t OBJECT_COUNT = 100000,
+                    ITERATIONS = 50;
+                    
+// the result, so the work isn't optimized away
+static volatile size_t sSink = 0;
+
+// the layout scene objects had before the pools, every object is its own heap allocation &
+// the fields the update & culling needs are spread out between the rest of the object
+class HeapObject {
+public:
+    virtual ~HeapObject() = default;
+    
+    virtual void update( float dt ) {}
+    
+    void updateTransform() {
+        mTransform = glm::translate(mPosition) * glm::mat4_cast(mOrientation) * glm::scale(mScale);
+        glm::vec3 center( mTransform * glm::vec4(mBoundingSphere.getCenter(), 1.f) );
+        mTransformedBoundingSphere = BoundingSphere( center, mBoundingSphere.getRadius() * glm::max(mScale.x, glm::max(mScale.y, mScale.z)) );
+    }
+    
+public:
+    void *mParent = nullptr, *mFactory = nullptr;
+    glm::vec3 mPosition, mScale = glm::vec3(1.f);
+    glm::quat mOrientation;
+    glm::mat4 mTransform;
+    unsigned int mRenderQueue = 0;
+    bool mDirty = true;
+    BoundingSphere mBoundingSphere,
+                   mTransformedBoundingSphere;
+    // what a DeferredEntity adds, mesh, material & flags
+    char mDerivedData[96];
+};
+
+int main()
+{
+    std::mt19937 generator( 1542 );
+    std::uniform_real_distribution<float> position( -500.f, 500.f );
+    
+    Frustrum frustrum = Frustrum::FromProjectionMatrix( glm::perspective(1.2f, 16.f/9.f, 0.1f, 300.f) );
+    
+    std::vector<std::unique_ptr<HeapObject>> heapObjects;
+    std::vector<HeapObject*> heapOrder;
+    // the allocations are interleaved with others of different sizes, as they are when a scene is loaded
+    std::vector<std::unique_ptr<char[]>> otherAllocations;
+    for( size_t i=0; i < OBJECT_COUNT; ++i ) {
+        heapObjects.emplace_back( new HeapObject );
+        heapObjects.back()->mPosition = glm::vec3( position(generator), position(generator), position(generator) );
+        heapObjects.back()->mBoundingSphere = BoundingSphere( glm::vec3(), 1.f );
+        heapOrder.push_back( heapObjects.back().get() );
+        
+        otherAllocations.emplace_back( new char[16 + (generator() % 256)] );
+    }
+    // the dirty list & the scene nodes doesn't keep the objects in allocation order
+    std::shuffle( heapOrder.begin(), heapOrder.end(), generator );
+    
+    SceneObjectPool pool;
+    std::vector<SceneObjectPool::Handle> handles;
+    for( size_t i=0; i < OBJECT_COUNT; ++i ) {
+        // the owner is only stored
+        SceneObjectPool::Handle handle = pool.allocate( reinterpret_cast<SceneObject*>(heapObjects[i].get()) );
+        pool.setPosition( handle, heapObjects[i]->mPosition );
+        pool.setBoundingSphere( handle, BoundingSphere(glm::vec3(), 1.f) );
+        handles.push_back( handle );
+    }
+    
+    Timer timer;
+    size_t heapVisible = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        for( HeapObject *object : heapOrder ) {
+            object->updateTransform();
+        }
+        for( HeapObject *object : heapOrder ) {
+            if( frustrum.isInside(object->mTransformedBoundingSphere) != Frustrum::TestStatus::Outside ) {
+                heapVisible++;
+            }
+        }
+    }
+    float heapTime = timer.getTimeAsSeconds();
+    
+    timer.restart();
+    size_t poolVisible = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        pool.updateTransforms( handles.data(), handles.size() );
+        for( SceneObjectPool::Handle handle : handles ) {
+            if( frustrum.isInside(pool.getTransformedBoundingSphere(handle)) != Frustrum::TestStatus::Outside ) {
+                poolVisible++;
+            }
+        }
+    }
+    float poolTime = timer.getTimeAsSeconds();
+    sSink = heapVisible + poolVisible;
+    
+    float scale = 1e9f / (OBJECT_COUNT * ITERATIONS);
+    std::printf( "%zu objects, update transforms & cull, %zu iterations\n", OBJECT_COUNT, ITERATIONS );
+    std::printf( "  heap objects: %8.2f ms/frame %6.2f ns/object\n", heapTime*1000.f/ITERATIONS, heapTime*scale );
+    std::printf( "  pool:         %8.2f ms/frame %6.2f ns/object\n", poolTime*1000.f/ITERATIONS, poolTime*scale );
+    std::printf( "  visible: %zu / %zu\n", heapVisible/ITERATIONS, poolVisible/ITERATIONS );
+    
+    return 0;
+}
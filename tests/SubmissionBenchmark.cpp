@@ -0,0 +1,182 @@
+#include "WorkerPool.h"
+#include "UniformStagingBuffer.h"
+#include "FixedSizeTypes.h"
+#include "Timer.h"
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static const size_t OBJECT_COUNT = 50000,
+                    ITERATIONS = 100,
+                    UNIFORM_ALIGMENT = 256;
+                    
+// stands in for SB_StagedUniforms
+static const GLuint STAGED_BUFFER = ~0u;
+
+// the result, so the work isn't optimized away
+static volatile UInt64 sSink = 0;
+
+// 0 on the main thread, set while the workers submits
+static thread_local size_t tSubmitThread = 0;
+
+// what Renderer::addMesh records for an entity
+struct EntityInfo {
+    UInt32 mesh;
+    float modelMatrix[16];
+    GLuint buffer, offset;
+    UInt32 diffuseTexture, normalMap;
+    UInt64 sortKey;
+};
+
+// the submission side of the Renderer, the add functions go to the frame on the
+// main thread & to a list per worker, the same way as Renderer::submitObjects
+class Submitter {
+public:
+    Submitter( size_t threadCount ) :
+        mLists(threadCount)
+    {
+        for( size_t i=0; i < threadCount; ++i ) {
+            mUniforms.emplace_back( new UniformStagingBuffer(STAGED_BUFFER, UNIFORM_ALIGMENT) );
+        }
+    }
+    
+    void addMesh( UInt32 mesh, UInt32 diffuse, UInt32 normalMap, const float (&modelMatrix)[16] )
+    {
+        EntityInfo info;
+            info.mesh = mesh;
+            std::copy( modelMatrix, modelMatrix+16, info.modelMatrix );
+            info.diffuseTexture = diffuse;
+            info.normalMap = normalMap;
+            info.buffer = 0;
+            info.offset = 0;
+            
+        // the view space depth of the origin, the view is the identity
+        float depth = std::min( std::max(-modelMatrix[14]*100.f, 0.f), 65535.f );
+        info.sortKey = (UInt64)(mesh & 0xFFFF) << 48 | (UInt64)(diffuse & 0x3FF) << 38 |
+                       (UInt64)(normalMap & 0x3FF) << 28 | (UInt64)depth;
+                       
+        (tSubmitThread == 0 ? mEntities : mLists[tSubmitThread]).push_back( info );
+    }
+    
+    // a light or custom renderable, its uniforms are staged
+    void addUniforms( const float (&modelMatrix)[16] )
+    {
+        UniformBuffer buffer = mUniforms[tSubmitThread]->allocate( sizeof(modelMatrix) );
+        std::copy( modelMatrix, modelMatrix+16, (float*)buffer.getMemory() );
+    }
+    
+    void merge()
+    {
+        for( size_t i=1; i < mLists.size(); ++i ) {
+            mEntities.insert( mEntities.end(), mLists[i].begin(), mLists[i].end() );
+            mLists[i].clear();
+        }
+    }
+    
+    UInt64 endFrame()
+    {
+        UInt64 result = mEntities.size();
+        for( const EntityInfo &info : mEntities ) {
+            result += info.sortKey;
+        }
+        
+        mEntities.clear();
+        for( auto &uniforms : mUniforms ) {
+            uniforms->reset();
+        }
+        return result;
+    }
+    
+private:
+    // mLists[0] is unused, thread 0 adds to the frame
+    std::vector<EntityInfo> mEntities;
+    std::vector<std::vector<EntityInfo>> mLists;
+    std::vector<std::unique_ptr<UniformStagingBuffer>> mUniforms;
+};
+
+class SubmittedObject {
+public:
+    SubmittedObject( UInt32 mesh, UInt32 diffuse, bool light, float depth ) :
+        mMesh(mesh),
+        mDiffuse(diffuse),
+        mLight(light)
+    {
+        for( int i=0; i < 16; ++i ) {
+            mTransform[i] = (i % 5 == 0) ? 1.f : 0.f;
+        }
+        mTransform[14] = -depth;
+    }
+    virtual ~SubmittedObject() = default;
+    
+    virtual void submitRenderer( Submitter &submitter )
+    {
+        if( mLight ) {
+            submitter.addUniforms( mTransform );
+        }
+        else {
+            submitter.addMesh( mMesh, mDiffuse, mDiffuse+1, mTransform );
+        }
+    }
+    
+private:
+    UInt32 mMesh, mDiffuse;
+    bool mLight;
+    float mTransform[16];
+};
+
+// the thread count can be given, by default it's one per hardware thread
+int main( int argc, char **argv )
+{
+    std::mt19937 generator( 1542 );
+    std::uniform_real_distribution<float> depth( 0.1f, 300.f );
+    
+    // about one light per 20 entities
+    std::vector<std::unique_ptr<SubmittedObject>> objects;
+    std::vector<SubmittedObject*> visible;
+    for( size_t i=0; i < OBJECT_COUNT; ++i ) {
+        objects.emplace_back( new SubmittedObject(generator() % 64, generator() % 32, generator() % 20 == 0, depth(generator)) );
+        visible.push_back( objects.back().get() );
+    }
+    
+    WorkerPool pool( argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0 );
+    Submitter serial( 1 ), parallel( pool.getThreadCount() );
+    
+    Timer timer;
+    UInt64 serialResult = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        for( SubmittedObject *object : visible ) {
+            object->submitRenderer( serial );
+        }
+        serialResult += serial.endFrame();
+    }
+    float serialTime = timer.getTimeAsSeconds();
+    
+    timer.restart();
+    UInt64 parallelResult = 0;
+    for( size_t i=0; i < ITERATIONS; ++i ) {
+        pool.parallelFor( visible.size(),
+            [&]( size_t first, size_t last, size_t thread ) {
+                tSubmitThread = thread;
+                for( size_t j=first; j < last; ++j ) {
+                    visible[j]->submitRenderer( parallel );
+                }
+                tSubmitThread = 0;
+            }
+        );
+        parallel.merge();
+        parallelResult += parallel.endFrame();
+    }
+    float parallelTime = timer.getTimeAsSeconds();
+    sSink = serialResult + parallelResult;
+    
+    std::printf( "%zu visible objects, submission & merge, %zu iterations\n", OBJECT_COUNT, ITERATIONS );
+    std::printf( "  serial:              %8.3f ms/frame\n", serialTime*1000.f/ITERATIONS );
+    std::printf( "  parallel, %2zu threads: %8.3f ms/frame\n", pool.getThreadCount(), parallelTime*1000.f/ITERATIONS );
+    std::printf( "  same result: %s\n", serialResult == parallelResult ? "yes" : "no" );
+    
+    return 0;
+}
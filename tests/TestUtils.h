@@ -0,0 +1,15 @@
+#pragma once
+
+#include <iostream>
+
+// the number of failed checks, returned from the test's main
+static int sTestFailures = 0;
+
+#define TEST_CHECK( condition ) \
+    do { \
+        if( !(condition) ) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            sTestFailures++; \
+        } \
+    } while( false )
+    
\ No newline at end of file
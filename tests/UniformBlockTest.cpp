@@ -0,0 +1,160 @@
+#include "UniformBlockRegion.h"
+#include "UniformStagingBuffer.h"
+#include "TestUtils.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+static const size_t ALIGMENT = 256,
+                    REGION_OFFSET = 4096,
+                    THREAD_COUNT = 8,
+                    UNIFORMS_PER_THREAD = 400;
+                    
+// stands in for the ring buffer & SB_StagedUniforms
+static const GLuint REGION_BUFFER = 7,
+                    STAGED_BUFFER = ~0u;
+                    
+struct Allocation {
+    GLuint buffer;
+    size_t offset, size;
+    const char *memory;
+    unsigned char thread;
+};
+
+static void testRegion()
+{
+    std::vector<char> memory( 4*ALIGMENT );
+    UniformBlockRegion region( ALIGMENT );
+    TEST_CHECK( !region.isReserved() );
+    
+    region.reserve( REGION_BUFFER, REGION_OFFSET, memory.data(), memory.size() );
+    TEST_CHECK( region.isReserved() );
+    
+    // the blocks are rounded up to the aligment
+    UniformBlockRegion::Block first = region.aquireBlock( 10 ),
+                              second = region.aquireBlock( ALIGMENT+1 );
+    TEST_CHECK( first.buffer == REGION_BUFFER && first.offset == REGION_OFFSET && first.memory == memory.data() );
+    TEST_CHECK( second.offset == REGION_OFFSET+ALIGMENT && second.memory == memory.data()+ALIGMENT );
+    TEST_CHECK( region.getUnused() == ALIGMENT );
+    
+    // doesn't fit in what's left
+    UniformBlockRegion::Block third = region.aquireBlock( 2*ALIGMENT );
+    TEST_CHECK( third.memory == nullptr );
+    TEST_CHECK( region.getUnused() == 0 );
+    TEST_CHECK( region.getAsked() == 5*ALIGMENT );
+    
+    // the cursor is kept, so the next region can be sized from it
+    region.clear();
+    TEST_CHECK( !region.isReserved() );
+    TEST_CHECK( region.getAsked() == 5*ALIGMENT );
+    
+    region.reserve( REGION_BUFFER, REGION_OFFSET, memory.data(), memory.size() );
+    TEST_CHECK( region.getAsked() == 0 );
+}
+
+static void testConcurrentBlocks()
+{
+    // room for about half of what the threads write, the rest is staged
+    const size_t regionSize = 32*DEFAULT_UNIFORM_BLOCK_SIZE;
+    std::vector<char> memory( regionSize );
+    UniformBlockRegion region( ALIGMENT );
+    region.reserve( REGION_BUFFER, REGION_OFFSET, memory.data(), memory.size() );
+    
+    std::vector<std::vector<Allocation>> allocations( THREAD_COUNT );
+    std::atomic<size_t> waiting( THREAD_COUNT );
+    
+    std::vector<std::thread> threads;
+    for( size_t i=0; i < THREAD_COUNT; ++i ) {
+        threads.emplace_back( [&,i]() {
+            UniformStagingBuffer staging( STAGED_BUFFER, ALIGMENT );
+            staging.setBlockRegion( &region );
+            
+            // start together so the blocks are aquired at the same time
+            waiting--;
+            while( waiting.load() != 0 ) {
+                std::this_thread::yield();
+            }
+            
+            for( size_t j=0; j < UNIFORMS_PER_THREAD; ++j ) {
+                size_t size = 64 + ((i*131 + j*17) % 5)*80;
+                UniformBuffer buffer = staging.allocate( size );
+                
+                // tagged with the thread, any overlap is overwritten by another thread
+                std::memset( buffer.getMemory(), int(i+1), size );
+                
+                Allocation allocation;
+                    allocation.buffer = buffer.getBuffer();
+                    allocation.offset = buffer.getOffset();
+                    allocation.size = size;
+                    allocation.memory = (const char*)buffer.getMemory();
+                    allocation.thread = (unsigned char)(i+1);
+                allocations[i].push_back( allocation );
+            }
+        } );
+    }
+    for( std::thread &thread : threads ) {
+        thread.join();
+    }
+    
+    std::vector<Allocation> inRegion;
+    size_t staged = 0, blockAfterStaged = 0, misaligned = 0, outside = 0, overwritten = 0;
+    
+    for( const std::vector<Allocation> &list : allocations ) {
+        bool staging = false;
+        for( const Allocation &allocation : list ) {
+            if( allocation.buffer == STAGED_BUFFER ) {
+                staged++;
+                staging = true;
+                continue;
+            }
+            
+            // once a thread has fallen back to staging it stays there for the frame
+            if( staging ) {
+                blockAfterStaged++;
+            }
+            if( allocation.offset % ALIGMENT != 0 ) {
+                misaligned++;
+            }
+            if( allocation.offset < REGION_OFFSET || allocation.offset+allocation.size > REGION_OFFSET+regionSize ||
+                allocation.memory != memory.data() + (allocation.offset-REGION_OFFSET) ) {
+                outside++;
+            }
+            else if( std::count(allocation.memory, allocation.memory+allocation.size, (char)allocation.thread) != (long)allocation.size ) {
+                overwritten++;
+            }
+            inRegion.push_back( allocation );
+        }
+    }
+    
+    std::sort( inRegion.begin(), inRegion.end(), []( const Allocation &a1, const Allocation &a2 ) {
+        return a1.offset < a2.offset;
+    } );
+    size_t overlapping = 0;
+    for( size_t i=1; i < inRegion.size(); ++i ) {
+        if( inRegion[i-1].offset + inRegion[i-1].size > inRegion[i].offset ) {
+            overlapping++;
+        }
+    }
+    
+    TEST_CHECK( !inRegion.empty() );
+    TEST_CHECK( staged > 0 );
+    TEST_CHECK( blockAfterStaged == 0 );
+    TEST_CHECK( misaligned == 0 );
+    TEST_CHECK( outside == 0 );
+    TEST_CHECK( overwritten == 0 );
+    TEST_CHECK( overlapping == 0 );
+    
+    // the blocks that didn't fit are counted, so the next region is made bigger
+    TEST_CHECK( region.getAsked() > region.getSize() );
+}
+
+int main()
+{
+    testRegion();
+    testConcurrentBlocks();
+    
+    return sTestFailures;
+}